@@ -0,0 +1,874 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "network_socket.h"
+#include "network_message.h"
+#include "stats.h"
+
+/* Load generator for 3D-ICE-Server: every client runs in its own thread,  */
+/* with its own session, and makes requests drawn at random from the mix.  */
+/* The latency of every request is recorded and, at the end, summarized    */
+/* per type of request (percentiles and a histogram) in a JSON file.       */
+
+#define MAX_SERVER_IP 50
+#define DEFAULT_MIX     "insert:1,slot:1,output:1"
+#define DEFAULT_RESULTS "bench_results.json"
+
+/* The requests of the mix ****************************************************/
+
+typedef enum
+{
+    BENCH_INSERT = 0,  // TDICE_INSERT_POWERS
+    BENCH_STEP,        // TDICE_SIMULATE_STEP
+    BENCH_SLOT,        // TDICE_SIMULATE_SLOT
+    BENCH_OUTPUT,      // TDICE_SEND_OUTPUT
+    BENCH_FILES,       // TDICE_SEND_OUTPUT_FILES
+    BENCH_TICK,        // TDICE_SIMULATE_AND_SEND_OUTPUT
+    BENCH_PRINT,       // TDICE_PRINT_OUTPUT
+    BENCH_NREQUESTS
+} BenchRequest_t ;
+
+static const char *request_names [BENCH_NREQUESTS] =
+
+    { "insert", "step", "slot", "output", "files", "tick", "print" } ;
+
+/* The latency of a request, in nanoseconds */
+
+typedef struct
+{
+    BenchRequest_t Request ;
+    uint64_t       Latency ;
+} Sample_t ;
+
+typedef struct
+{
+    pthread_t   Thread ;
+    Socket_t    Socket ;
+    Quantity_t  Nflpel ;
+    Quantity_t  Version ;
+    unsigned    Seed ;
+    int         Connected ;
+
+    Sample_t   *Samples ;
+    Quantity_t  NSamples ;
+    Quantity_t  Errors ;
+
+    Quantity_t  Queued ;    // Slots of power values inserted and not simulated
+    int         InSlot ;    // A slot started with steps is not completed
+    int         Printed ;   // Output printed and not transferred
+} Client_t ;
+
+/* Configuration shared by the clients */
+
+static char        server_ip [MAX_SERVER_IP] ;
+static Quantity_t  server_port ;
+static Quantity_t  nrequests ;
+static Quantity_t  weights [BENCH_NREQUESTS] ;
+static Quantity_t  total_weight ;
+static char       *stack_file ;
+
+/* The clients start the requests together, once all of them are connected */
+
+static pthread_barrier_t start_barrier ;
+
+/******************************************************************************/
+
+static void print_usage (char *exe_name)
+{
+    fprintf (stderr,
+        "Usage: \"%s server_ip server_port nclients nrequests [--mix=spec] [--results=file] [--stack=file]\"\n",
+        exe_name) ;
+    fprintf (stderr,
+        "       spec is a list of request:weight among %s, %s, %s, %s, %s, %s and %s (default %s)\n",
+        request_names [BENCH_INSERT], request_names [BENCH_STEP],
+        request_names [BENCH_SLOT],   request_names [BENCH_OUTPUT],
+        request_names [BENCH_FILES],  request_names [BENCH_TICK],
+        request_names [BENCH_PRINT],  DEFAULT_MIX) ;
+    fprintf (stderr,
+        "       the server must accept at least nclients sessions\n") ;
+}
+
+/******************************************************************************/
+
+static Error_t parse_mix (char *spec)
+{
+    char *copy = strdup (spec), *saveptr, *item ;
+
+    if (copy == NULL)
+
+        return TDICE_FAILURE ;
+
+    memset (weights, 0, sizeof (weights)) ;
+
+    total_weight = 0u ;
+
+    for (item = strtok_r (copy, ",", &saveptr) ; item != NULL ;
+         item = strtok_r (NULL, ",", &saveptr))
+    {
+        char *colon = strchr (item, ':') ;
+        int request ;
+
+        if (colon != NULL)
+
+            *colon = '\0' ;
+
+        for (request = 0 ; request != BENCH_NREQUESTS ; request++)
+
+            if (strcmp (item, request_names [request]) == 0)
+
+                break ;
+
+        if (request == BENCH_NREQUESTS)
+        {
+            fprintf (stderr, "Unknown request %s in the mix\n", item) ;
+
+            free (copy) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        weights [request] = colon != NULL ? (Quantity_t) atoi (colon + 1) : 1u ;
+
+        total_weight += weights [request] ;
+    }
+
+    free (copy) ;
+
+    if (total_weight == 0u)
+    {
+        fprintf (stderr, "The mix %s has no requests\n", spec) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static BenchRequest_t draw_request (Client_t *client)
+{
+    Quantity_t value = (Quantity_t) rand_r (&client->Seed) % total_weight ;
+    int request ;
+
+    for (request = 0 ; value >= weights [request] ; request++)
+
+        value -= weights [request] ;
+
+    return (BenchRequest_t) request ;
+}
+
+/******************************************************************************/
+
+/* Sends a request and waits for its reply, that must have the same type */
+
+static Error_t exchange
+(
+    Client_t         *client,
+    NetworkMessage_t *request,
+    NetworkMessage_t *reply
+)
+{
+    MessageType_t type = *request->MType ;
+
+    Error_t error = send_message_to_socket (&client->Socket, request) ;
+
+    network_message_destroy (request) ;
+
+    if (error != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    network_message_init (reply) ;
+
+    if (receive_message_from_socket (&client->Socket, reply) != TDICE_SUCCESS
+        || *reply->MType != type)
+    {
+        network_message_destroy (reply) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void insert_powers (Client_t *client, NetworkMessage_t *request)
+{
+    Quantity_t index ;
+
+    insert_message_word (request, &client->Nflpel) ;
+
+    for (index = 0u ; index != client->Nflpel ; index++)
+    {
+        float power = 0.5f + (float) rand_r (&client->Seed) / RAND_MAX ;
+
+        insert_message_word (request, &power) ;
+    }
+}
+
+/******************************************************************************/
+
+/* Makes a request and returns, in result, the word 0 of the reply */
+
+static Error_t make_request
+(
+    Client_t       *client,
+    BenchRequest_t  type,
+    MessageWord_t  *result
+)
+{
+    NetworkMessage_t request, reply ;
+
+    OutputInstant_t   instant  = TDICE_OUTPUT_INSTANT_SLOT ;
+    OutputType_t      otype    = TDICE_OUTPUT_TYPE_TFLP ;
+    OutputQuantity_t  quantity = TDICE_OUTPUT_QUANTITY_AVERAGE ;
+
+    network_message_init (&request) ;
+
+    switch (type)
+    {
+        case BENCH_INSERT :
+
+            build_message_head (&request, TDICE_INSERT_POWERS) ;
+
+            insert_powers (client, &request) ;
+
+            break ;
+
+        case BENCH_STEP :
+
+            build_message_head (&request, TDICE_SIMULATE_STEP) ;
+
+            break ;
+
+        case BENCH_SLOT :
+
+            build_message_head (&request, TDICE_SIMULATE_SLOT) ;
+
+            break ;
+
+        case BENCH_OUTPUT :
+
+            build_message_head  (&request, TDICE_SEND_OUTPUT) ;
+            insert_message_word (&request, &instant) ;
+            insert_message_word (&request, &otype) ;
+            insert_message_word (&request, &quantity) ;
+
+            break ;
+
+        case BENCH_FILES :
+        {
+            OutputFilesMode_t mode = TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST ;
+            Quantity_t zero = 0u ;
+
+            // All the files, no limit on the bytes, no offset (two words)
+
+            build_message_head  (&request, TDICE_SEND_OUTPUT_FILES) ;
+            insert_message_word (&request, &mode) ;
+            insert_message_word (&request, &zero) ;
+            insert_message_word (&request, &zero) ;
+            insert_message_word (&request, &zero) ;
+            insert_message_word (&request, &zero) ;
+
+            break ;
+        }
+
+        case BENCH_TICK :
+        {
+            MessageType_t unit = TDICE_SIMULATE_SLOT ;
+            Quantity_t count = 1u, noutputs = 1u ;
+
+            build_message_head  (&request, TDICE_SIMULATE_AND_SEND_OUTPUT) ;
+
+            insert_powers (client, &request) ;
+
+            insert_message_word (&request, &unit) ;
+            insert_message_word (&request, &count) ;
+            insert_message_word (&request, &noutputs) ;
+            insert_message_word (&request, &instant) ;
+            insert_message_word (&request, &otype) ;
+            insert_message_word (&request, &quantity) ;
+
+            break ;
+        }
+
+        case BENCH_PRINT :
+        {
+            // The server does not reply, only the time to send is measured
+
+            build_message_head  (&request, TDICE_PRINT_OUTPUT) ;
+            insert_message_word (&request, &instant) ;
+
+            Error_t error = send_message_to_socket (&client->Socket, &request) ;
+
+            network_message_destroy (&request) ;
+
+            *result = TDICE_SUCCESS ;
+
+            return error ;
+        }
+
+        default :
+
+            network_message_destroy (&request) ;
+
+            return TDICE_FAILURE ;
+    }
+
+    if (exchange (client, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    *result = 0u ;
+
+    extract_message_word (&reply, result, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+/* Makes a request, records its latency and checks its result. It also      */
+/* keeps track of the power values queued in the session, since simulating  */
+/* a step or a slot with no power values ends the session                   */
+
+static Error_t timed_request (Client_t *client, BenchRequest_t type)
+{
+    MessageWord_t result ;
+    uint64_t start = stats_now ( ) ;
+
+    if (make_request (client, type, &result) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    client->Samples [client->NSamples].Request = type ;
+    client->Samples [client->NSamples].Latency = stats_now ( ) - start ;
+    client->NSamples++ ;
+
+    switch (type)
+    {
+        case BENCH_INSERT :
+
+            client->Queued++ ;
+
+            return result == TDICE_SUCCESS ? TDICE_SUCCESS : TDICE_FAILURE ;
+
+        case BENCH_TICK :
+
+            client->Queued++ ;
+
+            // fallthrough
+
+        case BENCH_STEP :
+        case BENCH_SLOT :
+
+            if (client->InSlot == 0)
+
+                client->Queued-- ;
+
+            client->InSlot = result == TDICE_STEP_DONE ;
+
+            return result == TDICE_STEP_DONE || result == TDICE_SLOT_DONE
+                   ? TDICE_SUCCESS : TDICE_FAILURE ;
+
+        case BENCH_PRINT :
+
+            client->Printed = 1 ;
+
+            return TDICE_SUCCESS ;
+
+        case BENCH_FILES :
+
+            client->Printed = 0 ;
+
+            return TDICE_SUCCESS ;
+
+        default :
+
+            return TDICE_SUCCESS ;
+    }
+}
+
+/******************************************************************************/
+
+/* Opens the session: the time to build the model is not measured */
+
+static Error_t open_client (Client_t *client)
+{
+    NetworkMessage_t request, reply ;
+
+    socket_init (&client->Socket) ;
+
+    if (open_client_socket (&client->Socket) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (connect_client_to_server (&client->Socket, (String_t) server_ip, server_port) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    client->Connected = 1 ;
+
+    if (negotiate_protocol (&client->Socket, &client->Version) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (weights [BENCH_FILES] != 0u && client->Version < 4u)
+    {
+        fprintf (stderr, "The server does not send parts of the output files\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (stack_file != NULL)
+    {
+        Quantity_t path_length = strlen (stack_file), index ;
+        Error_t result = TDICE_FAILURE ;
+
+        if (client->Version < 9u)
+        {
+            fprintf (stderr, "The server does not host many stacks\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_SELECT_MODEL) ;
+        insert_message_word  (&request, &path_length) ;
+
+        for (index = 0u ; index < path_length ; index += sizeof (MessageWord_t))
+        {
+            MessageWord_t word = 0u ;
+            Quantity_t remaining = path_length - index ;
+
+            memcpy (&word, stack_file + index,
+                    remaining < sizeof (MessageWord_t) ? remaining : sizeof (MessageWord_t)) ;
+
+            insert_message_word (&request, &word) ;
+        }
+
+        if (exchange (client, &request, &reply) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        extract_message_word (&reply, &result, 0) ;
+
+        network_message_destroy (&reply) ;
+
+        if (result != TDICE_SUCCESS)
+        {
+            fprintf (stderr, "The server cannot select the stack %s\n", stack_file) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS) ;
+
+    if (exchange (client, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &client->Nflpel, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void *run_client (void *arg)
+{
+    Client_t *client = (Client_t *) arg ;
+    Quantity_t index ;
+
+    Error_t error = open_client (client) ;
+
+    pthread_barrier_wait (&start_barrier) ;
+
+    for (index = 0u ; error == TDICE_SUCCESS && index != nrequests ; index++)
+    {
+        BenchRequest_t type = draw_request (client) ;
+
+        // Power values for the next slot are inserted (and measured)
+        // before a step or a slot that would find none
+
+        if (   (type == BENCH_STEP || type == BENCH_SLOT)
+            && client->InSlot == 0 && client->Queued == 0u)
+
+            error = timed_request (client, BENCH_INSERT) ;
+
+        // The output files are printed (and measured) before they are
+        // transferred, as the server creates them at the first print
+
+        if (type == BENCH_FILES && client->Printed == 0)
+
+            error = timed_request (client, BENCH_PRINT) ;
+
+        if (error == TDICE_SUCCESS)
+
+            error = timed_request (client, type) ;
+    }
+
+    if (error != TDICE_SUCCESS)
+
+        client->Errors++ ;
+
+    if (client->Connected != 0)
+    {
+        NetworkMessage_t request ;
+
+        network_message_init   (&request) ;
+        build_message_head     (&request, TDICE_EXIT_SIMULATION) ;
+        send_message_to_socket (&client->Socket, &request) ;
+        network_message_destroy (&request) ;
+
+        socket_close (&client->Socket) ;
+    }
+
+    return NULL ;
+}
+
+/******************************************************************************/
+
+static int compare_latency (const void *a, const void *b)
+{
+    uint64_t la = *(const uint64_t *) a, lb = *(const uint64_t *) b ;
+
+    return (la > lb) - (la < lb) ;
+}
+
+/******************************************************************************/
+
+/* Nearest rank percentile of sorted latencies, in microseconds */
+
+static double percentile (uint64_t *latencies, Quantity_t n, double p)
+{
+    Quantity_t rank = (Quantity_t) (p * n + 0.999999) ;
+
+    if (rank == 0u)
+
+        rank = 1u ;
+
+    return latencies [rank - 1u] / 1000.0 ;
+}
+
+/******************************************************************************/
+
+static void print_summary
+(
+    FILE       *json,
+    const char *name,
+    uint64_t   *latencies,
+    Quantity_t  n,
+    int         last
+)
+{
+    Quantity_t       index, bucket, nbuckets = 0u ;
+    StatsHistogram_t histogram ;
+
+    qsort (latencies, n, sizeof (uint64_t), compare_latency) ;
+
+    // The histogram of the statistics of the server, with power of two
+    // buckets: the bucket i counts the latencies below 2^i us (and not
+    // below 2^(i-1) us)
+
+    stats_histogram_init (&histogram) ;
+
+    for (index = 0u ; index != n ; index++)
+
+        stats_histogram_add (&histogram, latencies [index]) ;
+
+    for (bucket = 0u ; bucket != TDICE_STATS_NBUCKETS ; bucket++)
+
+        if (histogram.Buckets [bucket] != 0u)
+
+            nbuckets = bucket + 1u ;
+
+    fprintf (json, "    \"%s\": { \"count\": %u", name, n) ;
+
+    if (n != 0u)
+    {
+        fprintf (json, ", \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f",
+            latencies [0] / 1000.0, (double) histogram.Sum / n / 1000.0,
+            percentile (latencies, n, 0.5),
+            percentile (latencies, n, 0.99),
+            percentile (latencies, n, 0.999),
+            latencies [n - 1u] / 1000.0) ;
+
+        fprintf (stdout, "%-8s %10u %12.1f %12.1f %12.1f %12.1f\n", name, n,
+            percentile (latencies, n, 0.5),
+            percentile (latencies, n, 0.99),
+            percentile (latencies, n, 0.999),
+            latencies [n - 1u] / 1000.0) ;
+    }
+
+    fprintf (json, ",\n      \"histogram\": [") ;
+
+    for (bucket = 0u ; bucket != nbuckets ; bucket++)
+
+        fprintf (json, "%s[%llu, %llu]", bucket == 0u ? "" : ", ",
+            (unsigned long long) 1u << bucket,
+            (unsigned long long) histogram.Buckets [bucket]) ;
+
+    fprintf (json, "] }%s\n", last ? "" : ",") ;
+}
+
+/******************************************************************************/
+
+int main (int argc, char** argv)
+{
+    Client_t *clients ;
+    Quantity_t nclients, index, request, nsamples, nerrors ;
+    uint64_t *latencies, *all_latencies, start, elapsed ;
+    char *mix, *results_file ;
+    int arg_index ;
+    FILE *json ;
+
+    /* Checks if all arguments are there **************************************/
+
+#define NARGC_MIN    5
+#define NARGC_MAX    8
+#define EXE_NAME     argv[0]
+#define SERVER_IP    argv[1]
+#define SERVER_PORT  argv[2]
+#define NCLIENTS     argv[3]
+#define NREQUESTS    argv[4]
+
+    if (argc < NARGC_MIN || argc > NARGC_MAX)
+    {
+        print_usage (EXE_NAME) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    if (strlen (SERVER_IP) > MAX_SERVER_IP - 1)
+    {
+        fprintf (stderr, "Server ip %s too long !!!\n", SERVER_IP) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    strcpy (server_ip, SERVER_IP) ;
+
+    server_port = atoi (SERVER_PORT) ;
+    nclients    = atoi (NCLIENTS) ;
+    nrequests   = atoi (NREQUESTS) ;
+
+    mix          = DEFAULT_MIX ;
+    results_file = DEFAULT_RESULTS ;
+    stack_file   = NULL ;
+
+    for (arg_index = NARGC_MIN ; arg_index < argc ; arg_index++)
+    {
+        if (strncmp (argv [arg_index], "--mix=", 6) == 0)
+
+            mix = argv [arg_index] + 6 ;
+
+        else if (strncmp (argv [arg_index], "--results=", 10) == 0)
+
+            results_file = argv [arg_index] + 10 ;
+
+        else if (strncmp (argv [arg_index], "--stack=", 8) == 0)
+
+            stack_file = argv [arg_index] + 8 ;
+
+        else
+        {
+            fprintf (stderr, "Unknown option %s\n", argv [arg_index]) ;
+            print_usage (EXE_NAME) ;
+
+            return EXIT_FAILURE ;
+        }
+    }
+
+    if (nclients == 0u || nrequests == 0u)
+    {
+        fprintf (stderr, "nclients and nrequests must be positive\n") ;
+
+        return EXIT_FAILURE ;
+    }
+
+    if (parse_mix (mix) != TDICE_SUCCESS)
+
+        return EXIT_FAILURE ;
+
+    /* Runs the clients *******************************************************/
+
+    // Every request can be preceded by an insertion of power values
+
+    clients = (Client_t *) calloc (nclients, sizeof (Client_t)) ;
+
+    if (clients == NULL)
+
+        return EXIT_FAILURE ;
+
+    for (index = 0u ; index != nclients ; index++)
+    {
+        clients [index].Samples = (Sample_t *) malloc (2u * nrequests * sizeof (Sample_t)) ;
+
+        if (clients [index].Samples == NULL)
+
+            return EXIT_FAILURE ;
+
+        clients [index].Seed = (unsigned) time (NULL) ^ (index * 2654435761u) ;
+    }
+
+    pthread_barrier_init (&start_barrier, NULL, nclients + 1u) ;
+
+    fprintf (stdout, "Running %u clients, %u requests each (%s) ... ", nclients, nrequests, mix) ;
+    fflush (stdout) ;
+
+    for (index = 0u ; index != nclients ; index++)
+
+        if (pthread_create (&clients [index].Thread, NULL, run_client, clients + index) != 0)
+        {
+            fprintf (stderr, "Cannot create client thread\n") ;
+
+            return EXIT_FAILURE ;
+        }
+
+    pthread_barrier_wait (&start_barrier) ;
+
+    start = stats_now ( ) ;
+
+    for (index = 0u ; index != nclients ; index++)
+
+        pthread_join (clients [index].Thread, NULL) ;
+
+    elapsed = stats_now ( ) - start ;
+
+    pthread_barrier_destroy (&start_barrier) ;
+
+    fprintf (stdout, "done !\n") ;
+
+    /* Writes the results *****************************************************/
+
+    nsamples = nerrors = 0u ;
+
+    for (index = 0u ; index != nclients ; index++)
+    {
+        nsamples += clients [index].NSamples ;
+        nerrors  += clients [index].Errors ;
+    }
+
+    latencies     = (uint64_t *) malloc ((nsamples + 1u) * sizeof (uint64_t)) ;
+    all_latencies = (uint64_t *) malloc ((nsamples + 1u) * sizeof (uint64_t)) ;
+
+    json = fopen (results_file, "w") ;
+
+    if (latencies == NULL || all_latencies == NULL || json == NULL)
+    {
+        fprintf (stderr, "Cannot write the results in %s\n", results_file) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    fprintf (stdout, "%u requests in %.3f s: %.1f requests/s, %u clients failed\n",
+        nsamples, elapsed / 1e9, nsamples / (elapsed / 1e9), nerrors) ;
+
+    fprintf (stdout, "%-8s %10s %12s %12s %12s %12s\n",
+        "request", "count", "p50 (us)", "p99 (us)", "p999 (us)", "max (us)") ;
+
+    fprintf (json, "{\n") ;
+    fprintf (json, "  \"clients\": %u,\n", nclients) ;
+    fprintf (json, "  \"requests_per_client\": %u,\n", nrequests) ;
+    fprintf (json, "  \"mix\": \"%s\",\n", mix) ;
+    fprintf (json, "  \"failed_clients\": %u,\n", nerrors) ;
+    fprintf (json, "  \"requests\": %u,\n", nsamples) ;
+    fprintf (json, "  \"seconds\": %.6f,\n", elapsed / 1e9) ;
+    fprintf (json, "  \"throughput\": %.3f,\n", nsamples / (elapsed / 1e9)) ;
+    fprintf (json, "  \"latency_us\": {\n") ;
+
+    for (request = 0u ; request != BENCH_NREQUESTS ; request++)
+    {
+        Quantity_t n = 0u, sample ;
+
+        for (index = 0u ; index != nclients ; index++)
+
+            for (sample = 0u ; sample != clients [index].NSamples ; sample++)
+
+                if (clients [index].Samples [sample].Request == (BenchRequest_t) request)
+
+                    latencies [n++] = clients [index].Samples [sample].Latency ;
+
+        if (n != 0u)
+
+            print_summary (json, request_names [request], latencies, n, 0) ;
+    }
+
+    nsamples = 0u ;
+
+    for (index = 0u ; index != nclients ; index++)
+    {
+        Quantity_t sample ;
+
+        for (sample = 0u ; sample != clients [index].NSamples ; sample++)
+
+            all_latencies [nsamples++] = clients [index].Samples [sample].Latency ;
+
+        free (clients [index].Samples) ;
+    }
+
+    print_summary (json, "all", all_latencies, nsamples, 1) ;
+
+    fprintf (json, "  }\n}\n") ;
+
+    fclose (json) ;
+
+    fprintf (stdout, "Results written in %s\n", results_file) ;
+
+    free (latencies) ;
+    free (all_latencies) ;
+    free (clients) ;
+
+    return nerrors == 0u ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
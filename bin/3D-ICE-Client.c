@@ -357,15 +357,15 @@ int main (int argc, char** argv)
 {
     Socket_t client_socket ;
 
-    NetworkMessage_t client_nflp, client_powers, client_temperatures, client_cores ;
-    NetworkMessage_t client_tmap, client_simulate, client_close_sim, server_reply ;
+    NetworkMessage_t client_nflp, client_tick, client_close_sim, server_reply ;
 
     Quantity_t nflpel, index, index2, nslots, nresults, server_port, slot_index ;
+    Quantity_t count, noutputs, protocol_version ;
 
     char server_ip [MAX_SERVER_IP] ;
 
-    SimResult_t sim_result ;
-    Error_t error ;
+    SimResult_t   sim_result ;
+    MessageType_t unit ;
 
     OutputInstant_t  instant ;
     OutputType_t     type ;
@@ -555,15 +555,21 @@ int main (int argc, char** argv)
 
     network_message_destroy (&client_nflp) ;
 
+    /* Negotiates the version of the protocol *********************************/
+
+    negotiate_protocol (&client_socket, &protocol_version) ;
+
+    fprintf (stdout, "Protocol version %u\n", protocol_version) ;
+
     for (slot_index = 0u ; unlimited_slots != 0 || nslots != 0u ; slot_index++)
     {
         int termination_slot = (terminate_on_sentinel != 0) ;
 
-        /* client sends power values ******************************************/
+        /* client sends powers, simulation and outputs requests at once *******/
 
-        network_message_init (&client_powers) ;
-        build_message_head   (&client_powers, TDICE_INSERT_POWERS) ;
-        insert_message_word  (&client_powers, &nflpel) ;
+        network_message_init (&client_tick) ;
+        build_message_head   (&client_tick, TDICE_SIMULATE_AND_SEND_OUTPUT) ;
+        insert_message_word  (&client_tick, &nflpel) ;
 
         for (index = 0 ; index != nflpel ; index++)
         {
@@ -572,7 +578,7 @@ int main (int argc, char** argv)
                 if (read_power_trace_value
                     (power_trace, follow_power_trace, slot_index, index, &power) != TDICE_SUCCESS)
                 {
-                    network_message_destroy (&client_powers) ;
+                    network_message_destroy (&client_tick) ;
 
                     fclose (tmap) ;
                     fclose (power_trace) ;
@@ -590,7 +596,7 @@ int main (int argc, char** argv)
 
                 termination_slot = 0 ;
 
-            insert_message_word (&client_powers, &power) ;
+            insert_message_word (&client_tick, &power) ;
         }
 
         if (termination_slot != 0)
@@ -599,56 +605,57 @@ int main (int argc, char** argv)
                 "Received all-minus-one termination slot at slot %u; stopping simulation.\n",
                 (unsigned int) slot_index) ;
 
-            network_message_destroy (&client_powers) ;
+            network_message_destroy (&client_tick) ;
 
             break ;
         }
 
-        send_message_to_socket (&client_socket, &client_powers) ;
+        // One slot, then the thermal sensors, the thermal maps and the cores
 
-        network_message_destroy (&client_powers) ;
-
-        /* Client waits for power insertion result ****************************/
-
-        network_message_init (&server_reply) ;
+        unit     = TDICE_SIMULATE_SLOT ;
+        count    = 1u ;
+        noutputs = 3u ;
 
-        receive_message_from_socket (&client_socket, &server_reply) ;
-
-        extract_message_word (&server_reply, &error, 0) ;
-
-        if (error != TDICE_SUCCESS)
-        {
-            network_message_destroy (&server_reply) ;
+        insert_message_word (&client_tick, &unit) ;
+        insert_message_word (&client_tick, &count) ;
+        insert_message_word (&client_tick, &noutputs) ;
 
-            fclose (tmap) ;
-            if (power_trace != NULL)
-                fclose (power_trace) ;
+        instant  = TDICE_OUTPUT_INSTANT_SLOT ;
+        type     = TDICE_OUTPUT_TYPE_TCELL ;
+        quantity = TDICE_OUTPUT_QUANTITY_NONE ;
 
-            socket_close (&client_socket) ;
+        insert_message_word (&client_tick, &instant) ;
+        insert_message_word (&client_tick, &type) ;
+        insert_message_word (&client_tick, &quantity) ;
 
-            return EXIT_FAILURE ;
-        }
+        type     = TDICE_OUTPUT_TYPE_TMAP ;
 
-        network_message_destroy (&server_reply) ;
+        insert_message_word (&client_tick, &instant) ;
+        insert_message_word (&client_tick, &type) ;
+        insert_message_word (&client_tick, &quantity) ;
 
-        /* client sends request for slot simlation ****************************/
+        type     = TDICE_OUTPUT_TYPE_TFLPEL ;
+        quantity = TDICE_OUTPUT_QUANTITY_AVERAGE ;
 
-        network_message_init (&client_simulate) ;
-        build_message_head   (&client_simulate, TDICE_SIMULATE_SLOT) ;
+        insert_message_word (&client_tick, &instant) ;
+        insert_message_word (&client_tick, &type) ;
+        insert_message_word (&client_tick, &quantity) ;
 
-        send_message_to_socket (&client_socket, &client_simulate) ;
+        send_message_to_socket (&client_socket, &client_tick) ;
 
-        network_message_destroy (&client_simulate) ;
+        network_message_destroy (&client_tick) ;
 
-        /* Client waits for simulation result *********************************/
+        /* Client waits for simulation result and outputs *********************/
 
         network_message_init (&server_reply) ;
 
         receive_message_from_socket (&client_socket, &server_reply) ;
 
         extract_message_word (&server_reply, &sim_result, 0) ;
+        extract_message_word (&server_reply, &time,       1) ;
+        extract_message_word (&server_reply, &noutputs,   2) ;
 
-        if (sim_result != TDICE_SLOT_DONE)
+        if (sim_result != TDICE_SLOT_DONE || noutputs != 3u)
         {
             network_message_destroy (&server_reply) ;
 
@@ -661,81 +668,26 @@ int main (int argc, char** argv)
             return EXIT_FAILURE ;
         }
 
-        network_message_destroy (&server_reply) ;
-
-        if (request_tflp_slot_outputs (&client_socket, slot_index) != TDICE_SUCCESS)
-        {
-            fclose (tmap) ;
-            if (power_trace != NULL)
-                fclose (power_trace) ;
-
-            socket_close (&client_socket) ;
-
-            return EXIT_FAILURE ;
-        }
-
-        /* Client sends temperatures request for thermal sensors **************/
+        /* Temperatures of the thermal sensors ********************************/
 
-        instant  = TDICE_OUTPUT_INSTANT_SLOT ;
-        type     = TDICE_OUTPUT_TYPE_TCELL ;
-        quantity = TDICE_OUTPUT_QUANTITY_NONE ;
-
-        network_message_init (&client_temperatures) ;
-        build_message_head   (&client_temperatures, TDICE_SEND_OUTPUT) ;
-        insert_message_word  (&client_temperatures, &instant) ;
-        insert_message_word  (&client_temperatures, &type) ;
-        insert_message_word  (&client_temperatures, &quantity) ;
-
-        send_message_to_socket (&client_socket, &client_temperatures) ;
+        index = 3 ;
 
-        network_message_destroy (&client_temperatures) ;
-
-        /* Client receives temperatures ***************************************/
-
-        network_message_init (&server_reply) ;
-
-        receive_message_from_socket (&client_socket, &server_reply) ;
-
-        extract_message_word (&server_reply, &time,     0) ;
-        extract_message_word (&server_reply, &nresults, 1) ;
+        extract_message_word (&server_reply, &nresults, index++) ;
 
         fprintf (stdout, "%5.2f sec : \t", time) ;
 
-        for (index = 2, nresults += 2 ; index != nresults ; index++)
+        for (nresults += index ; index != nresults ; index++)
         {
             extract_message_word (&server_reply, &temperature, index) ;
 
             fprintf (stdout, "%5.2f K \t", temperature) ;
         }
 
-        network_message_destroy (&server_reply) ;
-
-        /* Client sends thermal maps request **********************************/
-
-        instant  = TDICE_OUTPUT_INSTANT_SLOT ;
-        type     = TDICE_OUTPUT_TYPE_TMAP ;
-        quantity = TDICE_OUTPUT_QUANTITY_NONE ;
-
-        network_message_init (&client_tmap) ;
-        build_message_head   (&client_tmap, TDICE_SEND_OUTPUT) ;
-        insert_message_word  (&client_tmap, &instant) ;
-        insert_message_word  (&client_tmap, &type) ;
-        insert_message_word  (&client_tmap, &quantity) ;
+        /* Thermal maps *******************************************************/
 
-        send_message_to_socket (&client_socket, &client_tmap) ;
+        extract_message_word (&server_reply, &nresults, index++) ;
 
-        network_message_destroy (&client_tmap) ;
-
-        /* Client receives thermal maps ***************************************/
-
-        network_message_init (&server_reply) ;
-
-        receive_message_from_socket (&client_socket, &server_reply) ;
-
-        extract_message_word (&server_reply, &time,     0) ;
-        extract_message_word (&server_reply, &nresults, 1) ;
-
-        for (index = 2, index2 = 0 ; index2 != nresults ; index2++)
+        for (index2 = 0 ; index2 != nresults ; index2++)
         {
             extract_message_word (&server_reply, &nrows,    index++) ;
             extract_message_word (&server_reply, &ncolumns, index++) ;
@@ -753,34 +705,11 @@ int main (int argc, char** argv)
             fprintf (tmap, "\n") ;
         }
 
-        network_message_destroy (&server_reply) ;
+        /* Temperatures of the cores ******************************************/
 
-        /* Client sends temperatures request for cores ************************/
+        extract_message_word (&server_reply, &nresults, index++) ;
 
-        instant  = TDICE_OUTPUT_INSTANT_SLOT ;
-        type     = TDICE_OUTPUT_TYPE_TFLPEL ;
-        quantity = TDICE_OUTPUT_QUANTITY_AVERAGE ;
-
-        network_message_init (&client_cores) ;
-        build_message_head   (&client_cores, TDICE_SEND_OUTPUT) ;
-        insert_message_word  (&client_cores, &instant) ;
-        insert_message_word  (&client_cores, &type) ;
-        insert_message_word  (&client_cores, &quantity) ;
-
-        send_message_to_socket (&client_socket, &client_cores) ;
-
-        network_message_destroy (&client_cores) ;
-
-        /* Client receives cores temperatures  ********************************/
-
-        network_message_init (&server_reply) ;
-
-        receive_message_from_socket (&client_socket, &server_reply) ;
-
-        extract_message_word (&server_reply, &time,     0) ;
-        extract_message_word (&server_reply, &nresults, 1) ;
-
-        for (index = 2, nresults += 2 ; index != nresults ; index++)
+        for (nresults += index ; index != nresults ; index++)
         {
             extract_message_word (&server_reply, &temperature, index) ;
 
@@ -791,6 +720,17 @@ int main (int argc, char** argv)
 
         network_message_destroy (&server_reply) ;
 
+        if (request_tflp_slot_outputs (&client_socket, slot_index) != TDICE_SUCCESS)
+        {
+            fclose (tmap) ;
+            if (power_trace != NULL)
+                fclose (power_trace) ;
+
+            socket_close (&client_socket) ;
+
+            return EXIT_FAILURE ;
+        }
+
         if (unlimited_slots == 0)
 
             nslots-- ;
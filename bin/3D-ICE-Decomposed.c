@@ -0,0 +1,223 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <time.h>
+
+#include "stack_file_parser.h"
+
+#include "stack_description.h"
+#include "domain_decomposition.h"
+#include "halo_transport.h"
+#include "output.h"
+#include "analysis.h"
+
+int main(int argc, char** argv)
+{
+    StackDescription_t    stkd ;
+    Analysis_t            analysis ;
+    Output_t              output ;
+    HaloTransport_t       transport ;
+    DomainDecomposition_t domain ;
+
+    SimResult_t (*emulate) (DomainDecomposition_t*, Dimensions_t*, Analysis_t*) ;
+
+    Error_t error ;
+
+    // Checks if there are the all the arguments
+    ////////////////////////////////////////////////////////////////////////////
+
+#define NARGC        4
+#define EXE_NAME     argv[0]
+#define STK_FILE     argv[1]
+#define RANK         argv[2]
+#define ADDRESS      argv[3]
+
+    if (argc != NARGC)
+    {
+        fprintf (stderr, "Usage: \"%s file.stk rank address\"\n", EXE_NAME) ;
+        fprintf (stderr, "  start one process per tile, with rank 0 .. tiles - 1\n") ;
+        fprintf (stderr, "  address is shm:name or tcp:ip:port (same for all)\n") ;
+        return EXIT_FAILURE ;
+    }
+
+    Quantity_t rank = (Quantity_t) atoi (RANK) ;
+
+    // Init StackDescription and parse the input file
+    ////////////////////////////////////////////////////////////////////////////
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    stack_description_init (&stkd) ;
+    analysis_init          (&analysis) ;
+    output_init            (&output) ;
+
+    error = parse_stack_description_file (STK_FILE, &stkd, &analysis, &output) ;
+
+    if (error != TDICE_SUCCESS)    return EXIT_FAILURE ;
+
+    if (analysis.TileRows == 0u)
+    {
+        fprintf (stderr, "%s: no tiles given in the solver section\n", STK_FILE) ;
+
+        stack_description_destroy (&stkd) ;
+        output_destroy            (&output) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    if (analysis.AnalysisType == TDICE_ANALYSIS_TYPE_TRANSIENT)
+
+        emulate = &domain_decomposition_emulate_step ;
+
+    else
+
+        emulate = &domain_decomposition_emulate_steady ;
+
+    // Only the process 0 writes the output files
+    ////////////////////////////////////////////////////////////////////////////
+
+    if (rank == 0u)
+    {
+        error = generate_output_headers (&output, stkd.Dimensions, (String_t)"% ") ;
+
+        if (error != TDICE_SUCCESS)
+        {
+            fprintf (stderr, "error in initializing output files \n ");
+
+            stack_description_destroy (&stkd) ;
+            output_destroy            (&output) ;
+
+            return EXIT_FAILURE ;
+        }
+    }
+
+    // Connect to the other processes and build the subdomain of the tile
+    ////////////////////////////////////////////////////////////////////////////
+
+    halo_transport_init       (&transport) ;
+    domain_decomposition_init (&domain) ;
+
+    error = halo_transport_connect
+
+        (&transport, ADDRESS, rank, analysis.TileRows * analysis.TileColumns) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = domain_decomposition_build
+
+            (&domain, &transport, &stkd.StackElements, stkd.Dimensions, &analysis) ;
+
+    if (error != TDICE_SUCCESS)
+    {
+        halo_transport_destroy    (&transport) ;
+        stack_description_destroy (&stkd) ;
+        output_destroy            (&output) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    fprintf (stdout, "Tile %d: rows %d-%d, columns %d-%d, %d cells in the subdomain\n",
+        rank, domain.FirstRow, domain.LastRow, domain.FirstColumn, domain.LastColumn,
+        domain.Size) ;
+
+    // Run the simulation and print the output
+    ////////////////////////////////////////////////////////////////////////////
+
+    SimResult_t sim_result ;
+
+    do
+    {
+        sim_result = emulate (&domain, stkd.Dimensions, &analysis) ;
+
+        if (rank != 0u)
+
+            continue ;
+
+        if (sim_result == TDICE_STEP_DONE || sim_result == TDICE_SLOT_DONE)
+        {
+            fprintf (stdout, "%.3f (%d iterations)\r",
+                get_simulated_time (&analysis), domain.NIterations) ;
+
+            fflush (stdout) ;
+
+            generate_output (&output, stkd.Dimensions,
+                             domain.Temperatures, domain.PowerGrid.Sources,
+                             get_simulated_time (&analysis),
+                             analysis.CurrentTime,
+                             analysis.SlotLength,
+                             TDICE_OUTPUT_INSTANT_STEP) ;
+        }
+
+        if (sim_result == TDICE_SLOT_DONE)
+        {
+            fprintf (stdout, "\n") ;
+
+            generate_output (&output, stkd.Dimensions,
+                             domain.Temperatures, domain.PowerGrid.Sources,
+                             get_simulated_time (&analysis),
+                             analysis.CurrentTime,
+                             analysis.SlotLength,
+                             TDICE_OUTPUT_INSTANT_SLOT) ;
+        }
+
+    } while (sim_result != TDICE_END_OF_SIMULATION && sim_result != TDICE_SOLVER_ERROR) ;
+
+    if (rank == 0u)
+
+        generate_output (&output, stkd.Dimensions,
+                         domain.Temperatures, domain.PowerGrid.Sources,
+                         get_simulated_time (&analysis),
+                         analysis.CurrentTime,
+                         analysis.SlotLength,
+                         TDICE_OUTPUT_INSTANT_FINAL) ;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fprintf (stdout, "\nTile %d: emulation took %.3f sec\n", rank,
+        (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9 ) ;
+
+    // free all data
+    ////////////////////////////////////////////////////////////////////////////
+
+    domain_decomposition_destroy (&domain) ;
+    halo_transport_destroy       (&transport) ;
+    stack_description_destroy    (&stkd) ;
+    output_destroy               (&output) ;
+
+    return sim_result == TDICE_SOLVER_ERROR ? EXIT_FAILURE : EXIT_SUCCESS ;
+}
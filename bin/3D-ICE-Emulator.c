@@ -42,6 +42,9 @@
 
 #include "stack_description.h"
 #include "thermal_data.h"
+#include "parareal.h"
+#include "submodel.h"
+#include "controller.h"
 #include "output.h"
 #include "analysis.h"
 
@@ -54,10 +57,20 @@ int main(int argc, char** argv)
     Analysis_t         analysis ;
     Output_t           output ;
     ThermalData_t      tdata ;
+    Parareal_t         parareal ;
+
+    StackDescription_t sub_stkd ;
+    Analysis_t         sub_analysis ;
+    Output_t           sub_output ;
+    Submodel_t         submodel ;
+
+    Controller_t       controller ;
 
     SimResult_t (*emulate) (ThermalData_t*, Dimensions_t*, Analysis_t*) ;
     ///  Pointer to function
 
+    SimResult_t (*sub_emulate) (Submodel_t*, Dimensions_t*, Analysis_t*, Temperature_t*) ;
+
     Error_t error ;
 
     // Checks if there are the all the arguments
@@ -66,10 +79,12 @@ int main(int argc, char** argv)
 #define NARGC        2
 #define EXE_NAME     argv[0]
 #define STK_FILE     argv[1]
+#define CONTROLLER   argv[2]
+#define CTRL_ARGS    (argc > NARGC + 1 ? argv[3] : "")
 
-    if (argc != NARGC)
+    if (argc < NARGC || argc > NARGC + 2)
     {
-        fprintf(stderr, "Usage: \"%s file.stk\"\n", EXE_NAME) ;
+        fprintf(stderr, "Usage: \"%s file.stk [controller.so [args]]\"\n", EXE_NAME) ;
         return EXIT_FAILURE ;
     }
 
@@ -92,12 +107,15 @@ int main(int argc, char** argv)
     if (error != TDICE_SUCCESS)    return EXIT_FAILURE ;
 
     if (analysis.AnalysisType == TDICE_ANALYSIS_TYPE_TRANSIENT)
-
-        emulate = &emulate_step ;
-
+    {
+        emulate     = &emulate_step ;
+        sub_emulate = &submodel_emulate_step ;
+    }
     else if (analysis.AnalysisType == TDICE_ANALYSIS_TYPE_STEADY)
-
-        emulate = &emulate_steady ;
+    {
+        emulate     = &emulate_steady ;
+        sub_emulate = &submodel_emulate_steady ;
+    }
 
     else
     {
@@ -150,6 +168,99 @@ int main(int argc, char** argv)
         return EXIT_FAILURE ;
     }
 
+    // Prepare the coarse propagator if slots are integrated in parallel
+    ////////////////////////////////////////////////////////////////////////////
+
+    parareal_init (&parareal) ;
+
+    if (analysis.PararealWindows != 0u)
+    {
+        error = parareal_build (&parareal, &tdata, stkd.Dimensions, &analysis) ;
+
+        if (error != TDICE_SUCCESS)
+        {
+            thermal_data_destroy      (&tdata) ;
+            stack_description_destroy (&stkd) ;
+            output_destroy            (&output) ;
+
+            return EXIT_FAILURE ;
+        }
+    }
+
+    // Prepare the fine model of the region of interest. It is described by
+    // the same stack file, parsed a second time and then overridden.
+    ////////////////////////////////////////////////////////////////////////////
+
+    stack_description_init (&sub_stkd) ;
+    analysis_init          (&sub_analysis) ;
+    output_init            (&sub_output) ;
+    submodel_init          (&submodel) ;
+
+    if (analysis.SubmodelLength != 0.0)
+    {
+        error = parse_stack_description_file (STK_FILE, &sub_stkd, &sub_analysis, &sub_output) ;
+
+        if (error == TDICE_SUCCESS)
+
+            error = submodel_build (&submodel, &sub_stkd, &sub_analysis, &sub_output, stkd.Dimensions) ;
+
+        if (error == TDICE_SUCCESS)
+
+            error = generate_output_headers (&sub_output, sub_stkd.Dimensions, (String_t)"% ") ;
+
+        if (error != TDICE_SUCCESS)
+        {
+            submodel_destroy          (&submodel) ;
+            stack_description_destroy (&sub_stkd) ;
+            output_destroy            (&sub_output) ;
+            parareal_destroy          (&parareal) ;
+            thermal_data_destroy      (&tdata) ;
+            stack_description_destroy (&stkd) ;
+            output_destroy            (&output) ;
+
+            return EXIT_FAILURE ;
+        }
+    }
+
+    // Load the thermal management controller, called after every step
+    ////////////////////////////////////////////////////////////////////////////
+
+    controller_init (&controller) ;
+
+    if (argc > NARGC)
+    {
+        // The submodel replays the power trace of its own stack, so it would
+        // ignore the power values set by the controller
+
+        if (analysis.AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT
+            || analysis.PararealWindows != 0u
+            || analysis.SubmodelLength  != 0.0)
+        {
+            fprintf (stderr, "controller plugin requires a transient analysis without parareal or submodel\n") ;
+
+            error = TDICE_FAILURE ;
+        }
+        else
+
+            error = controller_build
+
+                (&controller, CONTROLLER, CTRL_ARGS, &stkd, &analysis, &output) ;
+
+        if (error != TDICE_SUCCESS)
+        {
+            controller_destroy        (&controller) ;
+            submodel_destroy          (&submodel) ;
+            stack_description_destroy (&sub_stkd) ;
+            output_destroy            (&sub_output) ;
+            parareal_destroy          (&parareal) ;
+            thermal_data_destroy      (&tdata) ;
+            stack_description_destroy (&stkd) ;
+            output_destroy            (&output) ;
+
+            return EXIT_FAILURE ;
+        }
+    }
+
     // Run the simulation and print the output
     ////////////////////////////////////////////////////////////////////////////
 
@@ -157,7 +268,36 @@ int main(int argc, char** argv)
 
     do
     {
-        sim_result = emulate (&tdata, stkd.Dimensions, &analysis) ;
+        if (analysis.PararealWindows != 0u)
+
+            sim_result = emulate_parareal (&parareal, &tdata, stkd.Dimensions, &analysis) ;
+
+        else
+
+            sim_result = emulate (&tdata, stkd.Dimensions, &analysis) ;
+
+        // The submodel takes its boundary temperatures from the coarse
+        // model just solved
+
+        if (analysis.SubmodelLength != 0.0 && sim_result != TDICE_SOLVER_ERROR)
+        {
+            SimResult_t sub_result = sub_emulate
+
+                (&submodel, sub_stkd.Dimensions, &sub_analysis, tdata.Temperatures) ;
+
+            if (sub_result == TDICE_SOLVER_ERROR)
+
+                sim_result = TDICE_SOLVER_ERROR ;
+        }
+
+        // The controller sees the temperatures just computed and sets
+        // the powers and the flow rate of the next steps
+
+        if (controller.Handle != NULL
+            && controller_run (&controller, &tdata, stkd.Dimensions,
+                               &analysis, &output, sim_result) != TDICE_SUCCESS)
+
+            sim_result = TDICE_SOLVER_ERROR ;
 
         // printf("Temperature grid info:\n");
         // for(CellIndex_t i = 0; i < stkd.Dimensions->Grid.NCells; i++)
@@ -192,6 +332,15 @@ int main(int argc, char** argv)
                              analysis.CurrentTime,
                              analysis.SlotLength,
                              TDICE_OUTPUT_INSTANT_STEP) ;
+
+            if (analysis.SubmodelLength != 0.0)
+
+                generate_output (&sub_output, sub_stkd.Dimensions,
+                                 submodel.Temperatures, submodel.PowerGrid.Sources,
+                                 get_simulated_time (&sub_analysis),
+                                 sub_analysis.CurrentTime,
+                                 sub_analysis.SlotLength,
+                                 TDICE_OUTPUT_INSTANT_STEP) ;
         }
 
         if (sim_result == TDICE_SLOT_DONE)
@@ -204,6 +353,15 @@ int main(int argc, char** argv)
                              analysis.CurrentTime,
                              analysis.SlotLength,
                              TDICE_OUTPUT_INSTANT_SLOT) ;
+
+            if (analysis.SubmodelLength != 0.0)
+
+                generate_output (&sub_output, sub_stkd.Dimensions,
+                                 submodel.Temperatures, submodel.PowerGrid.Sources,
+                                 get_simulated_time (&sub_analysis),
+                                 sub_analysis.CurrentTime,
+                                 sub_analysis.SlotLength,
+                                 TDICE_OUTPUT_INSTANT_SLOT) ;
         }
 
     } while (sim_result != TDICE_END_OF_SIMULATION && sim_result != TDICE_SOLVER_ERROR) ;
@@ -215,6 +373,15 @@ int main(int argc, char** argv)
                      analysis.SlotLength,
                      TDICE_OUTPUT_INSTANT_FINAL) ;
 
+    if (analysis.SubmodelLength != 0.0)
+
+        generate_output (&sub_output, sub_stkd.Dimensions,
+                         submodel.Temperatures, submodel.PowerGrid.Sources,
+                         get_simulated_time (&sub_analysis),
+                         sub_analysis.CurrentTime,
+                         sub_analysis.SlotLength,
+                         TDICE_OUTPUT_INSTANT_FINAL) ;
+
     /// Present time consumption for test
     clock_gettime(CLOCK_MONOTONIC, &end);
     fprintf (stdout, "\nEmulation took %.3f sec\n",
@@ -238,6 +405,11 @@ int main(int argc, char** argv)
     // free all data
     ////////////////////////////////////////////////////////////////////////////
 
+    controller_destroy        (&controller) ;
+    submodel_destroy          (&submodel) ;
+    stack_description_destroy (&sub_stkd) ;
+    output_destroy            (&sub_output) ;
+    parareal_destroy          (&parareal) ;
     thermal_data_destroy      (&tdata) ;
     stack_description_destroy (&stkd) ;
     output_destroy            (&output) ;
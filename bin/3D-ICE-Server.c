@@ -40,6 +40,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
 
 #include "types.h"
 #include "network_socket.h"
@@ -50,602 +59,2637 @@
 #include "analysis.h"
 #include "output.h"
 #include "powers_queue.h"
+#include "stats.h"
+#include "snapshot_pool.h"
+#include "model_registry.h"
 
-#define MAX_OUTPUT_FILES_TO_TRANSFER 1024u
+/* A session serves one client: in a multi-session server, every session has
+ * its own analysis clock, temperatures, power queues and output files while
+ * the stack, the system matrix and its factors are shared by all sessions */
 
-static void insert_message_bytes
+typedef struct Worker_t  Worker_t ;
+typedef struct Session_t Session_t ;
+
+/* An output file of a session. While it is part of a transfer, its bytes
+ * are streamed from the file to the client */
+
+typedef struct
+{
+    String_t   FileName ;
+
+    /* The first byte not sent yet, for the transfers "since last request" */
+
+    off_t      Sent ;
+
+    /* The file (open only during a transfer) and the bytes to send */
+
+    int        Fd ;
+    bool       Pending ;
+    off_t      Offset ;
+    size_t     Remaining ;
+    Quantity_t Padding ;
+
+} OutputFile_t ;
+
+/* The values of the last delta encoded thermal map of a stack element sent
+ * to the client */
+
+typedef struct
+{
+    StackElement_t  *StackElement ;
+    BulkReference_t  Reference ;
+
+} MapReference_t ;
+
+struct Session_t
+{
+    Quantity_t          Id ;
+    Socket_t            Client ;
+    Worker_t           *Worker ;
+    StackDescription_t *Stkd ;
+    ThermalData_t      *TData ;
+    Analysis_t         *Analysis ;
+    Output_t           *Output ;
+
+    /* The model selected, whether the session got it and the next one of
+     * the sessions of the worker waiting for it */
+
+    Model_t            *Model ;
+    bool                Attached ;
+    bool                Waiting ;
+    Session_t          *NextWaiting ;
+
+    /* The private copies used by a session of a multi-session server */
+
+    ThermalData_t       SessionTData ;
+    Analysis_t          SessionAnalysis ;
+    Output_t            SessionOutput ;
+
+    /* Requests received but not served yet and replies not sent yet */
+
+    SocketBuffer_t      Requests, Replies ;
+
+    bool                WaitingWrite ;
+    bool                Closing ;
+    bool                Headers ;
+    bool                Verbose ;
+    Quantity_t          SlotCounter ;
+
+    /* The version of the protocol negotiated with the client */
+
+    Quantity_t          Version ;
+
+    /* The output files and the one being streamed (NOutputFiles if none).
+     * The requests that follow a transfer wait until it is over */
+
+    OutputFile_t       *OutputFiles ;
+    Quantity_t          NOutputFiles ;
+    Quantity_t          Streaming ;
+    bool                StreamOffsets ;
+
+    /* The resolution and the last values of the delta encoded sections */
+
+    double              BulkResolution ;
+    BulkReference_t     StateReference ;
+    MapReference_t     *MapReferences ;
+    Quantity_t          NMapReferences ;
+
+    /* The step simulated ahead while waiting for the client: the state
+     * after the step (the one of the session is not changed), its result
+     * and whether it used a repeat of the last power values, not received
+     * yet. The base is the memory used to go back to the current state */
+
+    bool                Speculate ;
+    bool                Speculated ;
+    bool                SpeculatedPowers ;
+    SimResult_t         SpeculatedResult ;
+    ThermalSnapshot_t   SpeculatedState ;
+    ThermalSnapshot_t   SpeculationBase ;
+    float              *LastPowers ;
+    Quantity_t          NLastPowers ;
+
+} ;
+
+/* A worker thread serves, within its event loop, the sessions assigned to it.
+ * A client can pipeline its requests: they are served in order, as soon as
+ * they are received, and the replies are sent when the socket is writable */
+
+struct Worker_t
+{
+    pthread_t  Thread ;
+    int        EpollId ;
+    Quantity_t NSessions ;
+    bool       Single ;
+    Error_t    Result ;
+    Session_t *Waiting ;
+} ;
+
+#define MAX_EPOLL_EVENTS 64
+
+/* The largest number of file bytes carried by a reply to a request of the
+ * output files: the client asks again for the rest */
+
+#define MAX_OUTPUT_FILES_BYTES (1024u * 1024u * 1024u)
+
+/* The limit on the concurrent sessions */
+
+static Quantity_t      max_sessions, active_sessions = 0u ;
+static pthread_mutex_t sessions_lock = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t  sessions_cond = PTHREAD_COND_INITIALIZER ;
+
+/* The models hosted. The sessions that do not select a model use the one
+ * of the stack file given to the server */
+
+static ModelRegistry_t model_registry ;
+static String_t        default_stk_file ;
+
+/* The thermal states saved by the sessions. Their memory counts in the
+ * budget of the models */
+
+static SnapshotPool_t  snapshot_pool ;
+
+/* The statistics of the server: the durations of the requests served, by
+ * type, and of the phases of the simulation, recorded without locks by all
+ * the sessions, and the high-water marks of the sessions and of the memory.
+ * They are sent to the clients that ask for them and, if the server is
+ * given a file, written to it periodically in the text format of Prometheus */
+
+static Stats_t      stats ;
+static Quantity_t   sessions_peak = 0u ; // Under sessions_lock
+static String_t     stats_file    = NULL ;
+static unsigned int stats_period  = 10u ;
+
+/* Makes a session use the model of a stack file, instead of the one it
+ * used so far (if any) */
+
+static Error_t select_model (Session_t *session, String_t stk_file)
+{
+    Model_t *model = model_registry_acquire (&model_registry, stk_file) ;
+
+    if (model == NULL)
+
+        return TDICE_FAILURE ;
+
+    if (session->Model != NULL)
+
+        model_registry_release (&model_registry, session->Model) ;
+
+    session->Model = model ;
+
+    return TDICE_SUCCESS ;
+}
+
+/* Adds the session id before the extension of the output files, so that
+ * concurrent sessions do not write on the same files */
+
+static Error_t rename_output_files_in_list
+(
+    InspectionPointList_t *list,
+    Quantity_t             id
+)
+{
+    InspectionPointListNode_t *ipn ;
+
+    for (ipn  = inspection_point_list_begin (list) ;
+         ipn != NULL ;
+         ipn  = inspection_point_list_next (ipn))
+    {
+        InspectionPoint_t *ipoint = inspection_point_list_data (ipn) ;
+
+        String_t old_name = ipoint->FileName ;
+        char    *dot      = strrchr (old_name, '.') ;
+        size_t   base     = dot != NULL ? (size_t) (dot - old_name) : strlen (old_name) ;
+
+        char *new_name = (char *) malloc (strlen (old_name) + 32u) ;
+
+        if (new_name == NULL)
+
+            return TDICE_FAILURE ;
+
+        sprintf (new_name, "%.*s_%u%s", (int) base, old_name, id, old_name + base) ;
+
+        string_copy_cstr (&ipoint->FileName, new_name) ;
+
+        free (new_name) ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+static Error_t rename_output_files (Output_t *output, Quantity_t id)
+{
+    if (rename_output_files_in_list (&output->InspectionPointListFinal, id) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (rename_output_files_in_list (&output->InspectionPointListSlot, id) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    return rename_output_files_in_list (&output->InspectionPointListStep, id) ;
+}
+
+/* Saves the thermal state of a session and returns its handle (0 if it
+ * cannot be saved) */
+
+static Quantity_t save_snapshot (Session_t *session)
+{
+    size_t      models_memory = 0u ;
+    Snapshot_t *snapshot      = snapshot_pool_take (&snapshot_pool, session->Id) ;
+
+    if (snapshot == NULL)
+
+        return 0u ;
+
+    // The copy is made without the lock: the snapshot is not shared yet
+
+    if (save_thermal_state (session->TData, session->Analysis, &snapshot->State) != TDICE_SUCCESS)
+    {
+        snapshot_pool_give_back (&snapshot_pool, snapshot) ;
+
+        return 0u ;
+    }
+
+    // The models without users give room to the state, if needed
+
+    if (model_registry.Budget != 0u)
+    {
+        model_registry_evict (&model_registry) ;
+
+        model_registry_usage (&model_registry, NULL, &models_memory, NULL) ;
+    }
+
+    return snapshot_pool_add
+
+        (&snapshot_pool, snapshot, session->Model->Id, session->Id,
+         model_registry.Budget, models_memory) ;
+}
+
+/* Simulates ahead the next time step of a session into its speculated
+ * state. At the end of a slot with no power values left, the step uses a
+ * repeat of the last power values received */
+
+static void speculate_step (Session_t *session)
+{
+    ThermalData_t *tdata    = session->TData ;
+    Analysis_t    *analysis = session->Analysis ;
+
+    if (   session->Speculate  == false
+        || session->Speculated == true
+        || session->Closing    == true)
+
+        return ;
+
+    if (save_thermal_state (tdata, analysis, &session->SpeculationBase) != TDICE_SUCCESS)
+
+        return ;
+
+    bool        repeat = false ;
+    SimResult_t result = emulate_step (tdata, session->Stkd->Dimensions, analysis) ;
+
+    if (result == TDICE_END_OF_SIMULATION && session->NLastPowers != 0u)
+    {
+        PowersQueue_t queue ;
+        Quantity_t    index ;
+
+        restore_thermal_state (tdata, analysis, &session->SpeculationBase) ;
+
+        powers_queue_init  (&queue) ;
+        powers_queue_build (&queue, session->NLastPowers) ;
+
+        for (index = 0u ; index != session->NLastPowers ; index++)
+
+            put_into_powers_queue (&queue, session->LastPowers [index]) ;
+
+        if (insert_power_values (&tdata->PowerGrid, &queue) == TDICE_SUCCESS)
+        {
+            result = emulate_step (tdata, session->Stkd->Dimensions, analysis) ;
+            repeat = true ;
+        }
+
+        powers_queue_destroy (&queue) ;
+    }
+
+    if (   (result == TDICE_STEP_DONE || result == TDICE_SLOT_DONE)
+        && save_thermal_state (tdata, analysis, &session->SpeculatedState) == TDICE_SUCCESS)
+    {
+        session->Speculated       = true ;
+        session->SpeculatedPowers = repeat ;
+        session->SpeculatedResult = result ;
+    }
+
+    restore_thermal_state (tdata, analysis, &session->SpeculationBase) ;
+}
+
+/* Tells if the step simulated ahead is still valid after a request that
+ * inserts power values. Those used by the step must be the same, while the
+ * others are queued after the ones used, in the speculated state too */
+
+static bool speculation_holds (Session_t *session, NetworkMessage_t *request)
+{
+    Quantity_t nflpel, index ;
+
+    extract_message_word (request, &nflpel, 0) ;
+
+    if (session->SpeculatedPowers == false)
+    {
+        ThermalSnapshot_t *state = &session->SpeculatedState ;
+
+        if (nflpel != state->NPowerQueues)
+
+            return false ;
+
+        for (index = 0u ; index != nflpel ; index++)
+        {
+            float power_value ;
+
+            extract_message_word (request, &power_value, index + 1u) ;
+
+            put_into_powers_queue (&state->PowerQueues [index], power_value) ;
+        }
+
+        return true ;
+    }
+
+    if (nflpel != session->NLastPowers)
+
+        return false ;
+
+    for (index = 0u ; index != nflpel ; index++)
+    {
+        float power_value ;
+
+        extract_message_word (request, &power_value, index + 1u) ;
+
+        if (power_value != session->LastPowers [index])
+
+            return false ;
+    }
+
+    session->SpeculatedPowers = false ;
+
+    return true ;
+}
+
+/* Appends to a message a bulk section of the given type. A delta encoded
+ * section refers to the last values sent in \a reference */
+
+static Error_t insert_bulk
 (
     NetworkMessage_t *message,
-    unsigned char    *bytes,
-    Quantity_t        nbytes
+    BulkType_t        type,
+    BulkReference_t  *reference,
+    double            resolution,
+    double           *values,
+    Quantity_t        nvalues
 )
+{
+    if (type != TDICE_BULK_DELTA)
+    {
+        insert_message_bulk (message, type, values, nvalues) ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    return insert_message_bulk_delta
+
+        (message, reference, resolution, values, nvalues) ;
+}
+
+/* Returns the reference of the delta encoded thermal maps of a stack element
+ * sent to the client of a session, adding it if it is the first one */
+
+static BulkReference_t *find_map_reference (Session_t *session, StackElement_t *stkel)
 {
     Quantity_t index ;
 
-    for (index = 0u ; index < nbytes ; index += sizeof (MessageWord_t))
+    for (index = 0u ; index != session->NMapReferences ; index++)
+
+        if (session->MapReferences [index].StackElement == stkel)
+
+            return &session->MapReferences [index].Reference ;
+
+    MapReference_t *tmp = (MapReference_t *) realloc
+
+        (session->MapReferences, (index + 1u) * sizeof (MapReference_t)) ;
+
+    if (tmp == NULL)
+
+        return NULL ;
+
+    session->MapReferences = tmp ;
+    session->NMapReferences++ ;
+
+    tmp [index].StackElement = stkel ;
+
+    bulk_reference_init (&tmp [index].Reference) ;
+
+    return &tmp [index].Reference ;
+}
+
+/* Appends to a message the size and the temperatures of the thermal map of a
+ * stack element, as a bulk section */
+
+static Error_t insert_thermal_map
+(
+    NetworkMessage_t *message,
+    StackElement_t   *stkel,
+    Dimensions_t     *dimensions,
+    Temperature_t    *temperatures,
+    BulkType_t        type,
+    BulkReference_t  *reference,
+    double            resolution
+)
+{
+    CellIndex_t nrows = 0u, ncolumns = 0u ;
+
+    if (stkel == NULL)
+    {
+        BulkReference_t empty ;
+        Error_t         error ;
+
+        bulk_reference_init (&empty) ;
+
+        insert_message_word (message, &nrows) ;
+        insert_message_word (message, &ncolumns) ;
+
+        error = insert_bulk (message, type, &empty, resolution, NULL, 0u) ;
+
+        bulk_reference_destroy (&empty) ;
+
+        return error ;
+    }
+
+    CellIndex_t layer_offset = get_source_layer_offset (stkel) ;
+
+    if (dimensions->NonUniform != 1)
+    {
+        // The map of a layer is contiguous in the temperature array
+
+        nrows    = get_number_of_rows    (dimensions) ;
+        ncolumns = get_number_of_columns (dimensions) ;
+
+        insert_message_word (message, &nrows) ;
+        insert_message_word (message, &ncolumns) ;
+
+        return insert_bulk
+
+            (message, type, reference, resolution,
+             temperatures + get_cell_offset_in_stack
+                            (dimensions, layer_offset,
+                             first_row (dimensions), first_column (dimensions)),
+             nrows * ncolumns) ;
+    }
+
+    Temperature_t *map = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * get_number_of_cells (dimensions)) ;
+
+    if (map == NULL)
+    {
+        fprintf (stderr, "Cannot malloc thermal map\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    Quantity_t index = 0u ;
+
+    for (Non_uniform_cellListNode_t *cell_i = dimensions->Cell_list.First ;
+         cell_i != NULL ;
+         cell_i = cell_i->Next, index++)
+
+        if (cell_i->Data.layer_info == layer_offset)
+
+            map [ncolumns++] = temperatures [index] ;
+
+    nrows = 1u ;
+
+    insert_message_word (message, &nrows) ;
+    insert_message_word (message, &ncolumns) ;
+
+    Error_t error = insert_bulk (message, type, reference, resolution, map, ncolumns) ;
+
+    free (map) ;
+
+    return error ;
+}
+
+/* Extracts the string sent as | length | bytes | starting at the word index
+ * of a message. The string returned must be freed */
+
+static char *extract_message_string (NetworkMessage_t *message, Quantity_t index)
+{
+    Quantity_t length, word ;
+
+    extract_message_word (message, &length, index) ;
+
+    char *string = (char *) calloc (length + sizeof (MessageWord_t), 1u) ;
+
+    if (string == NULL)
+    {
+        fprintf (stderr, "Cannot malloc message string\n") ;
+
+        return NULL ;
+    }
+
+    for (word = 0u ; word * sizeof (MessageWord_t) < length ; word++)
+
+        extract_message_word (message, string + word * sizeof (MessageWord_t), index + 1u + word) ;
+
+    string [length] = '\0' ;
+
+    return string ;
+}
+
+/* Collects the output files of a session, each one once */
+
+static Error_t collect_output_files_in_list
+(
+    Session_t             *session,
+    InspectionPointList_t *list
+)
+{
+    InspectionPointListNode_t *ipn ;
+    Quantity_t                 index ;
+
+    for (ipn  = inspection_point_list_begin (list) ;
+         ipn != NULL ;
+         ipn  = inspection_point_list_next (ipn))
+    {
+        String_t file_name = inspection_point_list_data (ipn)->FileName ;
+
+        if (file_name == NULL || file_name [0] == '\0')
+
+            continue ;
+
+        for (index = 0u ; index != session->NOutputFiles ; index++)
+
+            if (strcmp (file_name, session->OutputFiles [index].FileName) == 0)
+
+                break ;
+
+        if (index != session->NOutputFiles)
+
+            continue ;
+
+        OutputFile_t *tmp = (OutputFile_t *) realloc
+
+            (session->OutputFiles, (index + 1u) * sizeof (OutputFile_t)) ;
+
+        if (tmp == NULL)
+        {
+            fprintf (stderr, "Cannot malloc output files\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        session->OutputFiles = tmp ;
+
+        tmp [index].FileName  = file_name ;
+        tmp [index].Sent      = 0 ;
+        tmp [index].Fd        = -1 ;
+        tmp [index].Pending   = false ;
+        tmp [index].Offset    = 0 ;
+        tmp [index].Remaining = 0u ;
+        tmp [index].Padding   = 0u ;
+
+        session->NOutputFiles++ ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+static Error_t collect_output_files (Session_t *session)
+{
+    Output_t *output = session->Output ;
+
+    if (   collect_output_files_in_list (session, &output->InspectionPointListFinal) != TDICE_SUCCESS
+        || collect_output_files_in_list (session, &output->InspectionPointListSlot)  != TDICE_SUCCESS
+        || collect_output_files_in_list (session, &output->InspectionPointListStep)  != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    session->Streaming = session->NOutputFiles ;
+
+    return TDICE_SUCCESS ;
+}
+
+static bool streaming_output_files (Session_t *session)
+{
+    return session->Streaming != session->NOutputFiles ;
+}
+
+#define WORDS(nbytes) (((nbytes) + sizeof (MessageWord_t) - 1u) / sizeof (MessageWord_t))
+
+/* Opens the output files requested and queues the head of the reply. Their
+ * bytes are sent later on, one file after the other, by send_replies */
+
+static Error_t start_output_files_transfer
+
+    (Session_t *session, NetworkMessage_t *request)
+{
+    OutputFilesMode_t mode      = TDICE_OUTPUT_FILES_WHOLE ;
+    Quantity_t        max_bytes = 0u, index ;
+    uint64_t          offset    = 0u ;
+    size_t            budget    = MAX_OUTPUT_FILES_BYTES ;
+    char             *name      = NULL ;
+
+    MessageWord_t head [3] = { 3u, TDICE_SEND_OUTPUT_FILES, 0u } ;
+
+    // A request without payload is the one of the version 1
+
+    session->StreamOffsets = *request->Length > 2u ;
+
+    if (session->StreamOffsets == true)
+    {
+        extract_message_word (request, &mode,      0) ;
+        extract_message_word (request, &max_bytes, 1) ;
+        extract_message_word (request, (MessageWord_t *) &offset,     2) ;
+        extract_message_word (request, (MessageWord_t *) &offset + 1, 3) ;
+
+        name = extract_message_string (request, 4) ;
+
+        if (name == NULL)
+
+            return TDICE_FAILURE ;
+    }
+
+    for (index = 0u ; index != session->NOutputFiles ; index++)
+    {
+        OutputFile_t *file = &session->OutputFiles [index] ;
+        struct stat   status ;
+
+        if (name != NULL && name [0] != '\0' && strcmp (name, file->FileName) != 0)
+
+            continue ;
+
+        file->Fd = open (file->FileName, O_RDONLY) ;
+
+        if (file->Fd < 0)
+        {
+            fprintf (stderr, "warning: cannot open output file %s for transfer\n", file->FileName) ;
+
+            continue ;
+        }
+
+        if (fstat (file->Fd, &status) != 0)
+        {
+            perror ("ERROR :: output file size") ;
+
+            close (file->Fd) ;
+
+            file->Fd = -1 ;
+
+            continue ;
+        }
+
+        // The size is taken now: the bytes written later on are left for
+        // the next request
+
+        off_t  start = 0 ;
+        size_t bytes ;
+
+        if (mode == TDICE_OUTPUT_FILES_FROM_OFFSET)
+
+            start = (off_t) offset ;
+
+        else if (mode == TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST)
+
+            start = file->Sent ;
+
+        if (start > status.st_size)
+
+            start = status.st_size ;
+
+        bytes = (size_t) (status.st_size - start) ;
+
+        if (max_bytes != 0u && bytes > max_bytes)
+
+            bytes = max_bytes ;
+
+        if (bytes > budget)
+
+            bytes = budget ;
+
+        budget -= bytes ;
+
+        file->Pending   = true ;
+        file->Offset    = start ;
+        file->Remaining = bytes ;
+        file->Padding   = WORDS (bytes) * sizeof (MessageWord_t) - bytes ;
+        file->Sent      = start + (off_t) bytes ;
+
+        head [0] += (session->StreamOffsets == true ? 4u : 2u)
+                    + WORDS (strlen (file->FileName)) + WORDS (bytes) ;
+        head [2]++ ;
+    }
+
+    free (name) ;
+
+    session->Streaming = 0u ;
+
+    return append_bytes_to_buffer (&session->Replies, head, sizeof (head)) ;
+}
+
+/* Queues the head of an output file, followed by its name */
+
+static Error_t queue_output_file_head (Session_t *session, OutputFile_t *file)
+{
+    static const unsigned char zeros [sizeof (MessageWord_t)] = { 0 } ;
+
+    MessageWord_t name_length = (MessageWord_t) strlen (file->FileName) ;
+    MessageWord_t file_length = (MessageWord_t) file->Remaining ;
+    uint64_t      offset      = (uint64_t) file->Offset ;
+
+    Error_t error = append_bytes_to_buffer (&session->Replies, &name_length, sizeof (name_length)) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = append_bytes_to_buffer (&session->Replies, &file_length, sizeof (file_length)) ;
+
+    if (error == TDICE_SUCCESS && session->StreamOffsets == true)
+
+        error = append_bytes_to_buffer (&session->Replies, &offset, sizeof (offset)) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = append_bytes_to_buffer (&session->Replies, file->FileName, name_length) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = append_bytes_to_buffer
+
+            (&session->Replies, zeros,
+             WORDS (name_length) * sizeof (MessageWord_t) - name_length) ;
+
+    file->Pending = false ;
+
+    return error ;
+}
+
+/* Sends the replies queued and the output files being transferred, until
+ * the socket would block or everything has been sent */
+
+static Error_t send_replies (Session_t *session)
+{
+    static const unsigned char zeros [sizeof (MessageWord_t)] = { 0 } ;
+
+    Error_t error = TDICE_SUCCESS ;
+
+    while (streaming_output_files (session) == true)
+    {
+        OutputFile_t *file = &session->OutputFiles [session->Streaming] ;
+
+        if (file->Fd < 0)
+        {
+            session->Streaming++ ;
+
+            continue ;
+        }
+
+        if (file->Pending == true)
+
+            error = queue_output_file_head (session, file) ;
+
+        if (error == TDICE_SUCCESS)
+
+            error = write_socket_buffer (&session->Client, &session->Replies) ;
+
+        if (error != TDICE_SUCCESS || socket_buffer_is_empty (&session->Replies) == false)
+
+            return error ;
+
+        error = send_file_to_socket
+
+            (&session->Client, file->Fd, &file->Offset, &file->Remaining) ;
+
+        if (error != TDICE_SUCCESS || file->Remaining != 0u)
+
+            return error ;
+
+        close (file->Fd) ;
+
+        file->Fd = -1 ;
+
+        error = append_bytes_to_buffer (&session->Replies, zeros, file->Padding) ;
+
+        if (error != TDICE_SUCCESS)
+
+            return error ;
+
+        session->Streaming++ ;
+    }
+
+    return write_socket_buffer (&session->Client, &session->Replies) ;
+}
+
+/* Gathers the state of the server printed with its statistics */
+
+static void get_stats_gauges (StatsGauges_t *gauges)
+{
+    pthread_mutex_lock   (&sessions_lock) ;
+    gauges->Sessions     = active_sessions ;
+    gauges->SessionsPeak = sessions_peak ;
+    pthread_mutex_unlock (&sessions_lock) ;
+
+    model_registry_usage
+
+        (&model_registry, &gauges->Models,
+         &gauges->ModelsMemory, &gauges->ModelsMemoryPeak) ;
+
+    gauges->SavedStatesMemory = snapshot_pool_memory (&snapshot_pool) ;
+}
+
+/* Queues the reply to a request of the statistics: their text, padded to
+ * a whole number of words */
+
+static Error_t queue_stats (Session_t *session)
+{
+    static const unsigned char zeros [sizeof (MessageWord_t)] = { 0 } ;
+
+    StatsGauges_t gauges ;
+
+    char  *text   = NULL ;
+    size_t length = 0u ;
+    FILE  *stream = open_memstream (&text, &length) ;
+
+    if (stream == NULL)
+
+        return TDICE_FAILURE ;
+
+    get_stats_gauges (&gauges) ;
+
+    stats_print (&stats, stream, &gauges) ;
+
+    fclose (stream) ;
+
+    MessageWord_t head [3] ;
+
+    head [0] = (MessageWord_t) (3u + WORDS (length)) ;
+    head [1] = (MessageWord_t) TDICE_GET_STATS ;
+    head [2] = (MessageWord_t) length ;
+
+    Error_t error = append_bytes_to_buffer (&session->Replies, head, sizeof (head)) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = append_bytes_to_buffer (&session->Replies, text, length) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = append_bytes_to_buffer
+
+            (&session->Replies, zeros,
+             WORDS (length) * sizeof (MessageWord_t) - length) ;
+
+    free (text) ;
+
+    return error ;
+}
+
+/* Sends the replies queued as send_replies does, recording the time spent
+ * if there was anything to send */
+
+static Error_t send_replies_timed (Session_t *session)
+{
+    bool pending = streaming_output_files (session) == true
+                   || socket_buffer_is_empty (&session->Replies) == false ;
+
+    uint64_t start = stats_now ( ) ;
+
+    Error_t error = send_replies (session) ;
+
+    if (pending == true)
+
+        stats_histogram_add_since (&stats.Phases [TDICE_STATS_MESSAGE_IO], start) ;
+
+    return error ;
+}
+
+/* Serves one request of a client, queueing its reply. The session is marked
+ * as closing when the client exits or the simulation ends */
+
+static Error_t serve_request (Session_t *session, NetworkMessage_t *request)
+{
+    StackDescription_t *stkd     = session->Stkd ;
+    ThermalData_t      *tdata    = session->TData ;
+    Analysis_t         *analysis = session->Analysis ;
+    Output_t           *output   = session->Output ;
+
+    NetworkMessage_t reply ;
+
+    Error_t error = TDICE_SUCCESS ;
+
+    MessageType_t request_type = *request->MType ;
+    uint64_t      start        = stats_now ( ) ;
+
+    network_message_init (&reply) ;
+
+    // The requests that change the state of the session make the step
+    // simulated ahead useless. The others see the state before the step
+
+    if (session->Speculated == true)
+    {
+        switch (*request->MType)
+        {
+            case TDICE_INSERT_POWERS :
+
+                session->Speculated = speculation_holds (session, request) ;
+
+                break ;
+
+            case TDICE_SIMULATE_STEP :
+
+                session->Speculated = session->SpeculatedPowers == false ;
+
+                break ;
+
+            case TDICE_RESET_THERMAL_STATE :
+            case TDICE_SIMULATE_SLOT :
+            case TDICE_SIMULATE_AND_SEND_OUTPUT :
+            case TDICE_RESTORE_THERMAL_STATE :
+            case TDICE_SPECULATE_STEPS :
+
+                session->Speculated = false ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+
+    switch (*request->MType)
+    {
+
+    /**************************************************************************/
+
+        case TDICE_EXIT_SIMULATION :
+        {
+            session->Closing = true ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_RESET_THERMAL_STATE :
+        {
+            reset_thermal_state (tdata, analysis) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS :
+        {
+            build_message_head (&reply, TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS) ;
+
+            Quantity_t nflpel = get_total_number_of_floorplan_elements (stkd) ;
+
+            insert_message_word (&reply, &nflpel) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_INSERT_POWERS :
+        {
+            Quantity_t nflpel, index ;
+
+            PowersQueue_t queue ;
+
+            powers_queue_init (&queue) ;
+
+            extract_message_word (request, &nflpel, 0) ;
+
+            powers_queue_build (&queue, nflpel) ;
+
+            // The last power values are kept to speculate the steps
+
+            if (session->Speculate == true && nflpel != session->NLastPowers)
+            {
+                float *tmp = (float *) realloc (session->LastPowers, sizeof (float) * nflpel) ;
+
+                if (tmp != NULL)
+                {
+                    session->LastPowers  = tmp ;
+                    session->NLastPowers = nflpel ;
+                }
+                else
+
+                    session->NLastPowers = 0u ;
+            }
+
+            for (index = 1, nflpel++ ; index != nflpel ; index++)
+            {
+                float power_value ;
+
+                extract_message_word (request, &power_value, index) ;
+
+                put_into_powers_queue (&queue, power_value) ;
+
+                if (index <= session->NLastPowers)
+
+                    session->LastPowers [index - 1] = power_value ;
+            }
+
+            error = insert_power_values (&tdata->PowerGrid, &queue) ;
+
+            powers_queue_destroy (&queue) ;
+
+            if (error != TDICE_SUCCESS)
+            {
+                fprintf (stderr, "error: insert power values\n") ;
+
+                break ;
+            }
+
+            build_message_head  (&reply, TDICE_INSERT_POWERS) ;
+            insert_message_word (&reply, &error) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SEND_OUTPUT :
+        {
+            OutputInstant_t  instant ;
+            OutputType_t     type ;
+            OutputQuantity_t quantity ;
+
+            extract_message_word (request, &instant,  0) ;
+            extract_message_word (request, &type,     1) ;
+            extract_message_word (request, &quantity, 2) ;
+
+            build_message_head (&reply, TDICE_SEND_OUTPUT) ;
+
+            float   time = get_simulated_time (analysis) ;
+            Quantity_t n = get_number_of_inspection_points (output, instant, type, quantity) ;
+
+            insert_message_word (&reply, &time) ;
+            insert_message_word (&reply, &n) ;
+
+            if (n > 0)
+            {
+                uint64_t output_start = stats_now ( ) ;
+
+                error = fill_output_message
+
+                    (output, stkd->Dimensions,
+                     tdata->Temperatures, tdata->PowerGrid.Sources,
+                     instant, type, quantity, &reply) ;
+
+                stats_histogram_add_since (&stats.Phases [TDICE_STATS_OUTPUT], output_start) ;
+
+                if (error != TDICE_SUCCESS)
+                {
+                    fprintf (stderr, "error: generate message content\n") ;
+
+                    break ;
+                }
+            }
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_PRINT_OUTPUT :
+        {
+            OutputInstant_t  instant ;
+
+            extract_message_word (request, &instant,  0) ;
+
+            if (session->Headers == false)
+            {
+                error = generate_output_headers
+
+                    (output, stkd->Dimensions, (String_t)"% ") ;
+
+                if (error != TDICE_SUCCESS)
+                {
+                    fprintf (stderr, "error in initializing output files \n ");
+
+                    break ;
+                }
+
+                session->Headers = true ;
+            }
+
+            uint64_t output_start = stats_now ( ) ;
+
+            generate_output
+
+                (output, stkd->Dimensions,
+                 tdata->Temperatures, tdata->PowerGrid.Sources,
+                 get_simulated_time (analysis), analysis->CurrentTime,
+                 analysis->SlotLength, instant) ;
+
+            stats_histogram_add_since (&stats.Phases [TDICE_STATS_OUTPUT], output_start) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SEND_OUTPUT_FILES :
+        {
+            error = start_output_files_transfer (session, request) ;
+
+            if (error != TDICE_SUCCESS)
+
+                fprintf (stderr, "error: start output files transfer\n") ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SIMULATE_SLOT :
+        {
+            build_message_head (&reply, TDICE_SIMULATE_SLOT) ;
+
+            SimResult_t result = emulate_slot (tdata, stkd->Dimensions, analysis) ;
+
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            if (result == TDICE_END_OF_SIMULATION)
+            {
+                session->Closing = true ;
+
+                break ;
+            }
+            else if (result != TDICE_SLOT_DONE)
+            {
+                fprintf (stderr, "error %d: emulate slot\n", result) ;
+
+                error = TDICE_FAILURE ;
+
+                break ;
+            }
+
+            if (session->Verbose == false)
+
+                break ;
+
+            fprintf (stdout, "%.3f ", get_simulated_time (analysis)) ;
+
+            fflush (stdout) ;
+
+            if (++session->SlotCounter == 10)
+            {
+                fprintf (stdout, "\n") ;
+
+                session->SlotCounter = 0 ;
+            }
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SIMULATE_STEP :
+        {
+            build_message_head (&reply, TDICE_SIMULATE_STEP) ;
+
+            SimResult_t result = session->SpeculatedResult ;
+
+            if (session->Speculated == true)
+            {
+                if (restore_thermal_state (tdata, analysis, &session->SpeculatedState) != TDICE_SUCCESS)
+
+                    result = TDICE_SOLVER_ERROR ;
+
+                session->Speculated = false ;
+            }
+            else
+
+                result = emulate_step (tdata, stkd->Dimensions, analysis) ;
+
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            if (result == TDICE_END_OF_SIMULATION)
+            {
+                session->Closing = true ;
+
+                break ;
+            }
+            else if (result != TDICE_STEP_DONE && result != TDICE_SLOT_DONE)
+            {
+                fprintf (stderr, "error %d: emulate step\n", result) ;
+
+                error = TDICE_FAILURE ;
+
+                break ;
+            }
+
+            if (session->Verbose == false)
+
+                break ;
+
+            fprintf (stdout, "%.3f ", get_simulated_time (analysis)) ;
+
+            fflush (stdout) ;
+
+            if (slot_completed (analysis))
+
+                fprintf (stdout, "\n") ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SIMULATE_AND_SEND_OUTPUT :
+        {
+            Quantity_t    nflpel, count, noutputs, index, word = 0u ;
+            MessageType_t unit ;
+            SimResult_t   result ;
+
+            extract_message_word (request, &nflpel, word++) ;
+
+            if (nflpel != 0u)
+            {
+                PowersQueue_t queue ;
+
+                powers_queue_init  (&queue) ;
+                powers_queue_build (&queue, nflpel) ;
+
+                for (index = 0u ; index != nflpel ; index++)
+                {
+                    float power_value ;
+
+                    extract_message_word (request, &power_value, word++) ;
+
+                    put_into_powers_queue (&queue, power_value) ;
+                }
+
+                error = insert_power_values (&tdata->PowerGrid, &queue) ;
+
+                powers_queue_destroy (&queue) ;
+
+                if (error != TDICE_SUCCESS)
+                {
+                    fprintf (stderr, "error: insert power values\n") ;
+
+                    break ;
+                }
+            }
+
+            extract_message_word (request, &unit,     word++) ;
+            extract_message_word (request, &count,    word++) ;
+            extract_message_word (request, &noutputs, word++) ;
+
+            if (unit != TDICE_SIMULATE_SLOT && unit != TDICE_SIMULATE_STEP)
+            {
+                fprintf (stderr, "error: unknown simulation unit %d\n", unit) ;
+
+                error = TDICE_FAILURE ;
+
+                break ;
+            }
+
+            result = unit == TDICE_SIMULATE_SLOT ? TDICE_SLOT_DONE : TDICE_STEP_DONE ;
+
+            for (index = 0u ; index != count ; index++)
+            {
+                if (unit == TDICE_SIMULATE_SLOT)
+
+                    result = emulate_slot (tdata, stkd->Dimensions, analysis) ;
+
+                else
+
+                    result = emulate_step (tdata, stkd->Dimensions, analysis) ;
+
+                if (result != TDICE_STEP_DONE && result != TDICE_SLOT_DONE)
+
+                    break ;
+            }
+
+            if (result != TDICE_STEP_DONE && result != TDICE_SLOT_DONE)
+
+                noutputs = 0u ;
+
+            build_message_head (&reply, TDICE_SIMULATE_AND_SEND_OUTPUT) ;
+
+            float time = get_simulated_time (analysis) ;
+
+            insert_message_word (&reply, &result) ;
+            insert_message_word (&reply, &time) ;
+            insert_message_word (&reply, &noutputs) ;
+
+            for (index = 0u ; index != noutputs ; index++)
+            {
+                OutputInstant_t  instant ;
+                OutputType_t     type ;
+                OutputQuantity_t quantity ;
+
+                extract_message_word (request, &instant,  word++) ;
+                extract_message_word (request, &type,     word++) ;
+                extract_message_word (request, &quantity, word++) ;
+
+                Quantity_t n = get_number_of_inspection_points (output, instant, type, quantity) ;
+
+                insert_message_word (&reply, &n) ;
+
+                if (n == 0u)
+
+                    continue ;
+
+                uint64_t output_start = stats_now ( ) ;
+
+                error = fill_output_message
+
+                    (output, stkd->Dimensions,
+                     tdata->Temperatures, tdata->PowerGrid.Sources,
+                     instant, type, quantity, &reply) ;
+
+                stats_histogram_add_since (&stats.Phases [TDICE_STATS_OUTPUT], output_start) ;
+
+                if (error != TDICE_SUCCESS)
+                {
+                    fprintf (stderr, "error: generate message content\n") ;
+
+                    break ;
+                }
+            }
+
+            if (error != TDICE_SUCCESS)
+
+                break ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            if (result == TDICE_END_OF_SIMULATION)
+            {
+                session->Closing = true ;
+
+                break ;
+            }
+            else if (result != TDICE_STEP_DONE && result != TDICE_SLOT_DONE)
+            {
+                fprintf (stderr, "error %d: emulate %s\n", result,
+                         unit == TDICE_SIMULATE_SLOT ? "slot" : "step") ;
+
+                error = TDICE_FAILURE ;
+
+                break ;
+            }
+
+            if (session->Verbose == false || count == 0u)
+
+                break ;
+
+            fprintf (stdout, "%.3f ", get_simulated_time (analysis)) ;
+
+            fflush (stdout) ;
+
+            if (unit == TDICE_SIMULATE_STEP ? slot_completed (analysis) : ++session->SlotCounter == 10)
+            {
+                fprintf (stdout, "\n") ;
+
+                session->SlotCounter = 0 ;
+            }
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_NEGOTIATE_PROTOCOL :
+        {
+            Quantity_t version ;
+
+            extract_message_word (request, &version, 0) ;
+
+            session->Version = version < TDICE_PROTOCOL_VERSION ? version : TDICE_PROTOCOL_VERSION ;
+
+            build_message_head  (&reply, TDICE_NEGOTIATE_PROTOCOL) ;
+            insert_message_word (&reply, &session->Version) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SEND_THERMAL_STATE :
+        {
+            BulkType_t bulk_type ;
+
+            extract_message_word (request, &bulk_type, 0) ;
+
+            float time = get_simulated_time (analysis) ;
+
+            build_message_head  (&reply, TDICE_SEND_THERMAL_STATE) ;
+            insert_message_word (&reply, &time) ;
+
+            error = insert_bulk
+
+                (&reply, bulk_type, &session->StateReference, session->BulkResolution,
+                 tdata->Temperatures, tdata->Size) ;
+
+            if (error != TDICE_SUCCESS)
+
+                break ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SEND_THERMAL_MAP :
+        {
+            BulkType_t bulk_type ;
+
+            extract_message_word (request, &bulk_type, 0) ;
+
+            StackElement_t stack_element, *stkel = NULL ;
+
+            char *name = extract_message_string (request, 1) ;
+
+            if (name == NULL)
+            {
+                error = TDICE_FAILURE ;
+
+                break ;
+            }
+
+            stack_element_init (&stack_element) ;
+
+            string_copy_cstr (&stack_element.Id, name) ;
+
+            stkel = stack_element_list_find (&stkd->StackElements, &stack_element) ;
+
+            stack_element_destroy (&stack_element) ;
+
+            free (name) ;
+
+            BulkReference_t *reference = NULL ;
+
+            if (bulk_type == TDICE_BULK_DELTA && stkel != NULL)
+            {
+                reference = find_map_reference (session, stkel) ;
+
+                if (reference == NULL)
+                {
+                    error = TDICE_FAILURE ;
+
+                    break ;
+                }
+            }
+
+            float time = get_simulated_time (analysis) ;
+
+            build_message_head  (&reply, TDICE_SEND_THERMAL_MAP) ;
+            insert_message_word (&reply, &time) ;
+
+            error = insert_thermal_map
+
+                (&reply, stkel, stkd->Dimensions, tdata->Temperatures,
+                 bulk_type, reference, session->BulkResolution) ;
+
+            if (error != TDICE_SUCCESS)
+
+                break ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_OPEN_SHARED_MEMORY :
+        {
+            Error_t result = TDICE_FAILURE ;
+
+            char *name = extract_message_string (request, 0) ;
+
+            SharedMemory_t *shm = (SharedMemory_t *) malloc (sizeof (SharedMemory_t)) ;
+
+            if (name != NULL && shm != NULL)
+            {
+                shared_memory_init (shm) ;
+
+                result = shared_memory_attach (shm, name, session->Client.Id) ;
+            }
+
+            free (name) ;
+
+            build_message_head  (&reply, TDICE_OPEN_SHARED_MEMORY) ;
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            // This reply, and the ones queued before, still go through the
+            // socket. The following ones go through the shared memory
+
+            if (error == TDICE_SUCCESS && result == TDICE_SUCCESS)
+            {
+                error = socket_set_blocking (&session->Client) ;
+
+                if (error == TDICE_SUCCESS)
+
+                    error = write_socket_buffer (&session->Client, &session->Replies) ;
+
+                if (error == TDICE_SUCCESS)
+                {
+                    session->Client.SharedMemory = shm ;
+
+                    break ;
+                }
+            }
+
+            if (shm != NULL)
+            {
+                shared_memory_destroy (shm) ;
+
+                free (shm) ;
+            }
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SAVE_THERMAL_STATE :
+        {
+            Quantity_t handle = save_snapshot (session) ;
+            Error_t    result = handle != 0u ? TDICE_SUCCESS : TDICE_FAILURE ;
+
+            build_message_head  (&reply, TDICE_SAVE_THERMAL_STATE) ;
+            insert_message_word (&reply, &result) ;
+            insert_message_word (&reply, &handle) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_RESTORE_THERMAL_STATE :
+        case TDICE_DELETE_THERMAL_STATE :
+        {
+            Quantity_t handle ;
+
+            extract_message_word (request, &handle, 0) ;
+
+            Error_t result = *request->MType == TDICE_RESTORE_THERMAL_STATE
+
+                ? snapshot_pool_restore
+
+                    (&snapshot_pool, handle, session->Model->Id,
+                     session->TData, session->Analysis)
+
+                : snapshot_pool_delete (&snapshot_pool, handle) ;
+
+            build_message_head  (&reply, (MessageType_t) *request->MType) ;
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SPECULATE_STEPS :
+        {
+            Quantity_t speculate ;
+            Error_t    result = TDICE_FAILURE ;
+
+            extract_message_word (request, &speculate, 0) ;
+
+            if (analysis->AnalysisType == TDICE_ANALYSIS_TYPE_TRANSIENT)
+            {
+                session->Speculate = speculate != 0u ;
+
+                result = TDICE_SUCCESS ;
+            }
+
+            build_message_head  (&reply, TDICE_SPECULATE_STEPS) ;
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SET_BULK_RESOLUTION :
+        {
+            Error_t result = TDICE_FAILURE ;
+            float   resolution ;
+
+            extract_message_word (request, &resolution, 0) ;
+
+            // The maps sent with the previous resolution are not references
+            // anymore: the next ones are sent in full
+
+            if (isfinite (resolution) && resolution >= TDICE_BULK_MIN_RESOLUTION)
+            {
+                session->BulkResolution = resolution ;
+
+                result = TDICE_SUCCESS ;
+            }
+
+            build_message_head  (&reply, TDICE_SET_BULK_RESOLUTION) ;
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SEND_MODEL_STATUS :
+        {
+            float        times [TDICE_MODEL_READY] = { 0.0f } ;
+            ModelPhase_t phase = TDICE_MODEL_FAILED ;
+            Quantity_t   index ;
+
+            if (session->Model != NULL || select_model (session, default_stk_file) == TDICE_SUCCESS)
+
+                phase = model_registry_status (&model_registry, session->Model, times) ;
+
+            build_message_head  (&reply, TDICE_SEND_MODEL_STATUS) ;
+            insert_message_word (&reply, &phase) ;
+
+            for (index = 0u ; index != TDICE_MODEL_READY ; index++)
+
+                insert_message_word (&reply, &times [index]) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_SELECT_MODEL :
+        {
+            Error_t result = TDICE_FAILURE ;
+
+            // The model cannot change once the session uses it
+
+            char *stk_file = extract_message_string (request, 0u) ;
+
+            if (stk_file != NULL && session->Attached == false)
+
+                result = select_model (session, stk_file) ;
+
+            else if (stk_file != NULL)
+
+                fprintf (stderr, "error: session %u: the model is in use\n", session->Id) ;
+
+            free (stk_file) ;
+
+            build_message_head  (&reply, TDICE_SELECT_MODEL) ;
+            insert_message_word (&reply, &result) ;
+
+            error = append_message_to_buffer (&session->Replies, &reply) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        case TDICE_GET_STATS :
+        {
+            error = queue_stats (session) ;
+
+            break ;
+        }
+
+    /**************************************************************************/
+
+        default :
+
+            fprintf (stderr, "ERROR :: received unknown message type") ;
+    }
+
+    network_message_destroy (&reply) ;
+
+    stats_add_request (&stats, request_type, start, error) ;
+
+    return error ;
+}
+
+/* Gives the model selected (the one of the stack file of the server, if
+ * none) to a session, with its private copies if the server is
+ * multi-session. If the model is not ready yet, the session waits for it in
+ * the list of its worker */
+
+static Error_t attach_model (Session_t *session)
+{
+    ModelPhase_t phase ;
+
+    if (session->Model == NULL && select_model (session, default_stk_file) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    Model_t *model = session->Model ;
+
+    phase = model_registry_status (&model_registry, model, NULL) ;
+
+    if (phase == TDICE_MODEL_FAILED)
+    {
+        fprintf (stderr, "error: session %u: the model is not available\n", session->Id) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (phase != TDICE_MODEL_READY)
+    {
+        if (session->Waiting == false)
+        {
+            session->Waiting     = true ;
+            session->NextWaiting = session->Worker->Waiting ;
+
+            session->Worker->Waiting = session ;
+        }
+
+        return TDICE_SUCCESS ;
+    }
+
+    session->Stkd = &model->Stkd ;
+
+    if (session->Worker->Single == true)
+    {
+        session->TData    = &model->TData ;
+        session->Analysis = &model->Analysis ;
+        session->Output   = &model->Output ;
+    }
+    else
+    {
+        session->TData    = &session->SessionTData ;
+        session->Analysis = &session->SessionAnalysis ;
+        session->Output   = &session->SessionOutput ;
+
+        analysis_copy (session->Analysis, &model->Analysis) ;
+        output_copy   (session->Output,   &model->Output) ;
+
+        Error_t error = TDICE_SUCCESS ;
+
+        if (session->Id != 0u)
+
+            error = rename_output_files (session->Output, session->Id) ;
+
+        if (error == TDICE_SUCCESS)
+
+            error = thermal_data_share (session->TData, &model->TData, session->Analysis) ;
+
+        if (error != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+    }
+
+    if (collect_output_files (session) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    session->TData->Phases = stats.Phases ;
+    session->Attached      = true ;
+
+    return TDICE_SUCCESS ;
+}
+
+/* Serves, in order, all the complete requests received so far */
+
+static Error_t serve_requests (Session_t *session)
+{
+    NetworkMessage_t request ;
+
+    Error_t error = TDICE_SUCCESS ;
+
+    network_message_init (&request) ;
+
+    while (   session->Closing == false
+           && session->Client.SharedMemory == NULL
+           && streaming_output_files (session) == false)
+    {
+        MessageType_t type ;
+        bool          complete ;
+
+        // The requests that need the model wait for it, in order
+
+        if (   session->Attached == false
+            && peek_message_type_in_buffer (&session->Requests, &type) == true
+            && type != TDICE_EXIT_SIMULATION
+            && type != TDICE_NEGOTIATE_PROTOCOL
+            && type != TDICE_SEND_MODEL_STATUS
+            && type != TDICE_SELECT_MODEL
+            && type != TDICE_GET_STATS)
+        {
+            error = attach_model (session) ;
+
+            if (error != TDICE_SUCCESS || session->Attached == false)
+
+                break ;
+        }
+
+        error = extract_message_from_buffer (&session->Requests, &request, &complete) ;
+
+        if (error != TDICE_SUCCESS || complete == false)
+
+            break ;
+
+        error = serve_request (session, &request) ;
+
+        if (error != TDICE_SUCCESS)
+
+            break ;
+    }
+
+    network_message_destroy (&request) ;
+
+    return error ;
+}
+
+/* Registers (or updates) the events the worker of a session waits for */
+
+static Error_t watch_session (Session_t *session, int operation)
+{
+    struct epoll_event event ;
+
+    event.events   = EPOLLIN ;
+    event.data.ptr = session ;
+
+    if (session->WaitingWrite == true)
+
+        event.events |= EPOLLOUT ;
+
+    if (epoll_ctl (session->Worker->EpollId, operation, session->Client.Id, &event) != 0)
+    {
+        perror ("ERROR :: epoll_ctl") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/* Releases a session. Its copies of the model, if any, are destroyed */
+
+static void close_session (Session_t *session, Error_t result)
+{
+    Worker_t *worker = session->Worker ;
+
+    epoll_ctl (worker->EpollId, EPOLL_CTL_DEL, session->Client.Id, NULL) ;
+
+    if (session->Waiting == true)
+    {
+        Session_t **waiting = &worker->Waiting ;
+
+        while (*waiting != session)
+
+            waiting = &(*waiting)->NextWaiting ;
+
+        *waiting = session->NextWaiting ;
+    }
+
+    for ( ; session->Streaming < session->NOutputFiles ; session->Streaming++)
+
+        if (session->OutputFiles [session->Streaming].Fd >= 0)
+
+            close (session->OutputFiles [session->Streaming].Fd) ;
+
+    free (session->OutputFiles) ;
+
+    bulk_reference_destroy (&session->StateReference) ;
+
+    for ( ; session->NMapReferences != 0u ; session->NMapReferences--)
+
+        bulk_reference_destroy
+
+            (&session->MapReferences [session->NMapReferences - 1u].Reference) ;
+
+    free (session->MapReferences) ;
+
+    thermal_snapshot_destroy (&session->SpeculatedState) ;
+    thermal_snapshot_destroy (&session->SpeculationBase) ;
+
+    snapshot_pool_delete_session (&snapshot_pool, session->Id) ;
+
+    free (session->LastPowers) ;
+
+    socket_close          (&session->Client) ;
+    socket_buffer_destroy (&session->Requests) ;
+    socket_buffer_destroy (&session->Replies) ;
+
+    if (session->Verbose == false)
     {
-        MessageWord_t word = 0u ;
-        Quantity_t remaining = nbytes - index ;
-        Quantity_t chunk =
-            remaining < sizeof (MessageWord_t) ? remaining : sizeof (MessageWord_t) ;
+        fprintf (stdout, "Session %u: closed%s\n",
+                 session->Id, result == TDICE_SUCCESS ? "" : " with errors") ;
 
-        memcpy (&word, bytes + index, chunk) ;
+        fflush (stdout) ;
+    }
 
-        insert_message_word (message, &word) ;
+    if (session->TData == &session->SessionTData)
+    {
+        thermal_data_destroy (&session->SessionTData) ;
+        output_destroy       (&session->SessionOutput) ;
+        analysis_destroy     (&session->SessionAnalysis) ;
     }
+
+    if (session->Model != NULL)
+
+        model_registry_release (&model_registry, session->Model) ;
+
+    free (session) ;
+
+    pthread_mutex_lock   (&sessions_lock) ;
+    worker->NSessions-- ;
+    worker->Result = result ;
+    active_sessions-- ;
+    pthread_cond_signal  (&sessions_cond) ;
+    pthread_mutex_unlock (&sessions_lock) ;
 }
 
-static bool output_file_already_added
-(
-    String_t    file_name,
-    String_t   added_files [],
-    Quantity_t nfiles
-)
+/* Serves the requests received and sends the replies. The requests that
+ * follow a transfer of output files are served once the transfer is over */
+
+static Error_t serve_and_send (Session_t *session)
 {
-    Quantity_t index ;
+    Error_t error ;
+    bool    streaming ;
 
-    for (index = 0u ; index != nfiles ; index++)
+    do
     {
-        if (strcmp (file_name, added_files [index]) == 0)
+        error = serve_requests (session) ;
 
-            return true ;
-    }
+        streaming = streaming_output_files (session) ;
 
-    return false ;
+        if (error == TDICE_SUCCESS)
+
+            error = send_replies_timed (session) ;
+
+    } while (   error == TDICE_SUCCESS
+             && streaming == true
+             && streaming_output_files (session) == false) ;
+
+    return error ;
 }
 
-static Error_t append_file_to_message
-(
-    NetworkMessage_t *message,
-    String_t          file_name,
-    String_t          added_files [],
-    Quantity_t       *nfiles
-)
+/* Serves a client that moved to shared memory, until it exits. Requests and
+ * replies go through the segment, in order, without the event loop */
+
+static void *serve_shared_memory (void *arg)
 {
-    if (file_name == NULL || file_name [0] == '\0')
+    Session_t *session = (Session_t *) arg ;
 
-        return TDICE_SUCCESS ;
+    NetworkMessage_t request ;
 
-    if (output_file_already_added (file_name, added_files, *nfiles) == true)
+    Error_t error = TDICE_SUCCESS ;
 
-        return TDICE_SUCCESS ;
+    network_message_init (&request) ;
 
-    if (*nfiles == MAX_OUTPUT_FILES_TO_TRANSFER)
+    while (session->Closing == false && error == TDICE_SUCCESS)
+    {
+        error = receive_message_from_socket (&session->Client, &request) ;
 
-        return TDICE_FAILURE ;
+        if (error == TDICE_SUCCESS)
 
-    FILE *file = fopen (file_name, "rb") ;
+            error = serve_request (session, &request) ;
 
-    if (file == NULL)
-    {
-        fprintf (stderr, "warning: cannot open output file %s for transfer\n", file_name) ;
+        if (error == TDICE_SUCCESS)
 
-        return TDICE_SUCCESS ;
-    }
+            error = send_replies_timed (session) ;
 
-    if (fseek (file, 0L, SEEK_END) != 0)
-    {
-        fclose (file) ;
+        if (error == TDICE_SUCCESS)
 
-        return TDICE_FAILURE ;
+            speculate_step (session) ;
     }
 
-    long file_length_long = ftell (file) ;
+    network_message_destroy (&request) ;
+
+    close_session (session, error) ;
+
+    return NULL ;
+}
+
+/* Reads the requests available, serves them and sends as much of the replies
+ * as the socket accepts. Returns true if the session has been closed or it
+ * left the event loop to use shared memory */
 
-    if (file_length_long < 0)
+static bool handle_session_events (Session_t *session, uint32_t events)
+{
+    Error_t error  = TDICE_SUCCESS ;
+    bool    hangup = false ;
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
     {
-        fclose (file) ;
+        uint64_t start = stats_now ( ) ;
 
-        return TDICE_FAILURE ;
+        error = read_socket_buffer (&session->Client, &session->Requests, &hangup) ;
+
+        stats_histogram_add_since (&stats.Phases [TDICE_STATS_MESSAGE_IO], start) ;
     }
 
-    rewind (file) ;
+    if (error == TDICE_SUCCESS)
+
+        error = serve_and_send (session) ;
+
+    if (error != TDICE_SUCCESS || (hangup == true && session->Closing == false))
+    {
+        if (error == TDICE_SUCCESS)
+
+            fprintf (stderr, "error: session %u: client hung up\n", session->Id) ;
 
-    Quantity_t file_name_length = (Quantity_t) strlen (file_name) ;
-    Quantity_t file_length      = (Quantity_t) file_length_long ;
+        close_session (session, TDICE_FAILURE) ;
 
-    insert_message_word  (message, &file_name_length) ;
-    insert_message_word  (message, &file_length) ;
-    insert_message_bytes (message, (unsigned char *) file_name, file_name_length) ;
+        return true ;
+    }
 
-    if (file_length != 0u)
+    if (session->Client.SharedMemory != NULL)
     {
-        unsigned char *file_content = (unsigned char *) malloc (file_length) ;
+        pthread_t thread ;
+
+        epoll_ctl (session->Worker->EpollId, EPOLL_CTL_DEL, session->Client.Id, NULL) ;
 
-        if (file_content == NULL)
+        if (session->Verbose == false)
         {
-            fclose (file) ;
+            fprintf (stdout, "Session %u: using shared memory\n", session->Id) ;
 
-            return TDICE_FAILURE ;
+            fflush (stdout) ;
         }
 
-        size_t nread = fread (file_content, 1u, file_length, file) ;
+        // A session of a multi-session server gets its own thread, not to
+        // block the other sessions of the worker while waiting
+
+        if (session->Worker->Single == true)
 
-        fclose (file) ;
+            serve_shared_memory (session) ;
 
-        if (nread != file_length)
+        else if (pthread_create (&thread, NULL, serve_shared_memory, session) != 0)
         {
-            free (file_content) ;
+            fprintf (stderr, "Cannot create shared memory thread for session %u\n", session->Id) ;
 
-            return TDICE_FAILURE ;
+            close_session (session, TDICE_FAILURE) ;
         }
+        else
 
-        insert_message_bytes (message, file_content, file_length) ;
+            pthread_detach (thread) ;
 
-        free (file_content) ;
-    }
-    else
-    {
-        fclose (file) ;
+        return true ;
     }
 
-    added_files [*nfiles] = file_name ;
-    (*nfiles)++ ;
+    bool waiting_write =    socket_buffer_is_empty (&session->Replies) == false
+                         || streaming_output_files (session) == true ;
 
-    return TDICE_SUCCESS ;
-}
+    if (session->Closing == true && (waiting_write == false || hangup == true))
+    {
+        close_session (session, TDICE_SUCCESS) ;
 
-static Error_t append_output_files_from_list
-(
-    NetworkMessage_t      *message,
-    InspectionPointList_t *list,
-    String_t               added_files [],
-    Quantity_t            *nfiles
-)
-{
-    InspectionPointListNode_t *ipn ;
+        return true ;
+    }
 
-    for (ipn  = inspection_point_list_begin (list) ;
-         ipn != NULL ;
-         ipn  = inspection_point_list_next (ipn))
+    if (waiting_write != session->WaitingWrite)
     {
-        InspectionPoint_t *ipoint = inspection_point_list_data (ipn) ;
+        session->WaitingWrite = waiting_write ;
 
-        if (append_file_to_message
-            (message, ipoint->FileName, added_files, nfiles) != TDICE_SUCCESS)
+        if (watch_session (session, EPOLL_CTL_MOD) != TDICE_SUCCESS)
+        {
+            close_session (session, TDICE_FAILURE) ;
 
-            return TDICE_FAILURE ;
+            return true ;
+        }
     }
 
-    return TDICE_SUCCESS ;
+    // All the replies have been sent: the client is thinking
+
+    if (waiting_write == false)
+
+        speculate_step (session) ;
+
+    return false ;
 }
 
-static Error_t build_output_files_message
-(
-    Output_t         *output,
-    NetworkMessage_t *message
-)
-{
-    Quantity_t nfiles = 0u ;
-    String_t added_files [MAX_OUTPUT_FILES_TO_TRANSFER] ;
+/* Serves the requests of the sessions of a worker that were waiting for the
+ * model. Returns true if a session has been closed */
 
-    build_message_head  (message, TDICE_SEND_OUTPUT_FILES) ;
-    insert_message_word (message, &nfiles) ;
+static bool wake_waiting_sessions (Worker_t *worker)
+{
+    Session_t *session = worker->Waiting ;
 
-    if (append_output_files_from_list
-        (message, &output->InspectionPointListFinal, added_files, &nfiles) != TDICE_SUCCESS)
+    bool closed = false ;
 
-        return TDICE_FAILURE ;
+    worker->Waiting = NULL ;
 
-    if (append_output_files_from_list
-        (message, &output->InspectionPointListSlot, added_files, &nfiles) != TDICE_SUCCESS)
+    while (session != NULL)
+    {
+        Session_t *next = session->NextWaiting ;
 
-        return TDICE_FAILURE ;
+        session->Waiting     = false ;
+        session->NextWaiting = NULL ;
 
-    if (append_output_files_from_list
-        (message, &output->InspectionPointListStep, added_files, &nfiles) != TDICE_SUCCESS)
+        if (handle_session_events (session, 0u) == true)
 
-        return TDICE_FAILURE ;
+            closed = true ;
 
-    memcpy (message->Content, &nfiles, sizeof (MessageWord_t)) ;
+        session = next ;
+    }
 
-    return TDICE_SUCCESS ;
+    return closed ;
 }
 
-int main (int argc, char** argv)
+/* The event loop of a worker. A worker serving a single client returns as
+ * soon as that client has been served. The events without a session tell
+ * that the model is ready */
+
+static void *event_loop (void *arg)
 {
-    StackDescription_t stkd ;
-    Analysis_t         analysis ;
-    Output_t           output ;
-    ThermalData_t      tdata ;
+    Worker_t *worker = (Worker_t *) arg ;
 
-    Error_t error ;
+    struct epoll_event events [MAX_EPOLL_EVENTS] ;
 
-    Quantity_t server_port, slot_counter = 0u ;
+    while (1)
+    {
+        int index, nevents = epoll_wait (worker->EpollId, events, MAX_EPOLL_EVENTS, -1) ;
 
-    Socket_t server_socket, client_socket ;
+        if (nevents < 0)
+        {
+            if (errno == EINTR)
 
-    NetworkMessage_t request, reply ;
+                continue ;
 
-    bool headers = false ;
+            perror ("ERROR :: epoll_wait") ;
 
-    /* Checks if all arguments are there **************************************/
+            worker->Result = TDICE_FAILURE ;
 
-#define NARGC        3
-#define EXE_NAME     argv[0]
-#define STK_FILE     argv[1]
-#define SERVER_PORT  argv[2]
+            return NULL ;
+        }
 
-    if (argc != NARGC)
-    {
-        fprintf (stderr, "Usage: \"%s file.stk server_port\n", EXE_NAME) ;
+        bool model_ready = false ;
 
-        return EXIT_FAILURE ;
-    }
+        for (index = 0 ; index != nevents ; index++)
+        {
+            if (events [index].data.ptr == NULL)
+            {
+                model_ready = true ;
 
-    server_port = atoi (SERVER_PORT) ;
+                continue ;
+            }
 
-    /* Parses stack file (fills stack descrition and analysis) ****************/
+            bool closed = handle_session_events
 
-    fprintf (stdout, "Preparing stk data ... ") ; fflush (stdout) ;
+                ((Session_t *) events [index].data.ptr, events [index].events) ;
 
-    stack_description_init (&stkd) ;
-    analysis_init          (&analysis) ;
-    output_init            (&output) ;
+            if (closed == true && worker->Single == true)
 
-    error = parse_stack_description_file (STK_FILE, &stkd, &analysis, &output) ;
+                return NULL ;
+        }
 
-    if (error != TDICE_SUCCESS)    return EXIT_FAILURE ;
+        // The sessions waiting for the model are served last, since the
+        // ones closed by the events above leave the list
 
-    if (analysis.AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT)
-    {
-        fprintf (stderr, "only transient analysis!\n") ;
+        if (model_ready == false)
 
-        goto wrong_analysis_error ;
-    }
+            continue ;
 
-    fprintf (stdout, "done !\n") ;
+        if (wake_waiting_sessions (worker) == true && worker->Single == true)
 
-    /* Prepares thermal data **************************************************/
+            return NULL ;
 
-    fprintf (stdout, "Preparing thermal data ... ") ; fflush (stdout) ;
+        // A model ready can exceed the budget, and one failed is not needed
 
-    thermal_data_init (&tdata) ;
+        model_registry_evict (&model_registry) ;
+    }
+}
 
-    error = thermal_data_build
+/* Allocates a session for a client. It gets the model later on, with the
+ * first request that needs it */
 
-        (&tdata, &stkd.StackElements, stkd.Dimensions, &analysis, &stkd.Materials) ;
+static Session_t *open_session
+(
+    Quantity_t  id,
+    Socket_t   *client,
+    Worker_t   *worker
+)
+{
+    Session_t *session = (Session_t *) malloc (sizeof (Session_t)) ;
 
-    if (error != TDICE_SUCCESS)    goto ftd_error ;
+    if (session == NULL)
+    {
+        fprintf (stderr, "Cannot malloc session\n") ;
 
-    fprintf (stdout, "done !\n") ;
+        return NULL ;
+    }
 
-    /* Creates socket *********************************************************/
+    session->Id            = id ;
+    session->Client        = *client ;
+    session->Worker        = worker ;
+    session->Stkd          = NULL ;
+    session->TData         = NULL ;
+    session->Analysis      = NULL ;
+    session->Output        = NULL ;
+    session->Model         = NULL ;
+    session->Attached      = false ;
+    session->Waiting       = false ;
+    session->NextWaiting   = NULL ;
+    session->WaitingWrite  = false ;
+    session->Closing       = false ;
+    session->Headers       = false ;
+    session->Verbose       = worker->Single ;
+    session->SlotCounter   = 0u ;
+    session->Version       = 1u ;
+    session->OutputFiles   = NULL ;
+    session->NOutputFiles  = 0u ;
+    session->Streaming     = 0u ;
+    session->StreamOffsets = false ;
+
+    session->BulkResolution = TDICE_BULK_RESOLUTION ;
+    session->MapReferences  = NULL ;
+    session->NMapReferences = 0u ;
+
+    bulk_reference_init (&session->StateReference) ;
+
+    session->Speculate        = false ;
+    session->Speculated       = false ;
+    session->SpeculatedPowers = false ;
+    session->SpeculatedResult = TDICE_STEP_DONE ;
+    session->LastPowers       = NULL ;
+    session->NLastPowers      = 0u ;
+
+    thermal_snapshot_init (&session->SpeculatedState) ;
+    thermal_snapshot_init (&session->SpeculationBase) ;
+
+    thermal_data_init  (&session->SessionTData) ;
+    analysis_init      (&session->SessionAnalysis) ;
+    output_init        (&session->SessionOutput) ;
+    socket_buffer_init (&session->Requests) ;
+    socket_buffer_init (&session->Replies) ;
+
+    return session ;
+}
 
-    fprintf (stdout, "Creating socket ... ") ; fflush (stdout) ;
+/* Writes the statistics to their file periodically */
 
-    socket_init (&server_socket) ;
+static void *write_stats (void *arg)
+{
+    StatsGauges_t gauges ;
 
-    error = open_server_socket (&server_socket, server_port) ;
+    (void) arg ;
 
-    if (error != TDICE_SUCCESS)    goto socket_error ;
+    while (true)
+    {
+        get_stats_gauges (&gauges) ;
 
-    fprintf (stdout, "done !\n") ;
+        stats_write_file (&stats, stats_file, &gauges) ;
 
-    /* Waits for a client to connect ******************************************/
+        sleep (stats_period) ;
+    }
 
-    fprintf (stdout, "Waiting for client ... ") ; fflush (stdout) ;
+    return NULL ;
+}
 
-    socket_init (&client_socket) ;
+int main (int argc, char** argv)
+{
+    Error_t error ;
 
-    error = wait_for_client (&server_socket, &client_socket) ;
+    Quantity_t server_port, session_id, nworkers, index ;
 
-    if (error != TDICE_SUCCESS)    goto wait_error ;
+    size_t models_budget ;
 
-    fprintf (stdout, "done !\n") ;
+    Socket_t server_socket, client_socket ;
 
-    /* Runs the simlation *****************************************************/
+    Session_t *session ;
 
-    do
-    {
-        network_message_init (&request) ;
+    Worker_t *workers = NULL ;
 
-        receive_message_from_socket (&client_socket, &request) ;
+    Model_t *model ;
 
-        switch (*request.MType)
-        {
+    /* Checks if all arguments are there **************************************/
 
-        /**********************************************************************/
+#define EXE_NAME     argv[0]
+#define STK_FILE     argv[1]
+#define SERVER_PORT  argv[2]
+#define SESSIONS     argv[3]
+#define MEMORY_MIB   argv[4]
+#define STATS_FILE   argv[5]
+#define STATS_PERIOD argv[6]
 
-            case TDICE_EXIT_SIMULATION :
-            {
-                network_message_destroy (&request) ;
+    if (argc < 3 || argc > 7)
+    {
+        fprintf (stderr, "Usage: \"%s file.stk server_port [sessions [memory_MiB [stats_file [stats_seconds]]]]\n", EXE_NAME) ;
 
-                goto quit ;
-            }
+        return EXIT_FAILURE ;
+    }
 
-        /**********************************************************************/
+    server_port      = atoi (SERVER_PORT) ;
+    max_sessions     = argc >= 4 ? (Quantity_t) atoi (SESSIONS) : 1u ;
+    models_budget    = argc >= 5 ? (size_t) strtoull (MEMORY_MIB, NULL, 10) << 20 : 0u ;
+    stats_file       = argc >= 6 ? STATS_FILE : NULL ;
+    stats_period     = argc == 7 ? (unsigned int) atoi (STATS_PERIOD) : 10u ;
+    default_stk_file = STK_FILE ;
 
-            case TDICE_RESET_THERMAL_STATE :
-            {
-                reset_thermal_state (&tdata, &analysis) ;
+    stats_init          (&stats) ;
+    snapshot_pool_init  (&snapshot_pool) ;
+    model_registry_init (&model_registry) ;
 
-                break ;
-            }
+    if (max_sessions == 0u)
+    {
+        fprintf (stderr, "the number of sessions must be positive\n") ;
 
-        /**********************************************************************/
+        return EXIT_FAILURE ;
+    }
 
-            case TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS :
-            {
-                network_message_init (&reply) ;
+    // The stack files the clients select are looked for in the directory
+    // of the one of the server. The saved thermal states count in the
+    // budget of the models
 
-                build_message_head   (&reply, TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS) ;
+    if (model_registry_open (&model_registry, STK_FILE, models_budget,
+                             max_sessions > 1u, &snapshot_pool) != TDICE_SUCCESS)
 
-                Quantity_t nflpel = get_total_number_of_floorplan_elements (&stkd) ;
+        goto registry_error ;
 
-                insert_message_word (&reply, &nflpel) ;
+    // A client that goes away during the transfer of a file must not kill
+    // the server (sendfile cannot be told not to raise SIGPIPE)
 
-                send_message_to_socket (&client_socket, &reply) ;
+    signal (SIGPIPE, SIG_IGN) ;
 
-                network_message_destroy (&reply) ;
+    /* Starts writing the statistics, if asked *******************************/
 
-                break ;
-            }
+    if (stats_file != NULL)
+    {
+        pthread_t thread ;
 
-        /**********************************************************************/
+        if (stats_period == 0u)
+        {
+            fprintf (stderr, "the period of the statistics must be positive\n") ;
 
-            case TDICE_INSERT_POWERS :
-            {
-                Quantity_t nflpel, index ;
+            return EXIT_FAILURE ;
+        }
 
-                PowersQueue_t queue ;
+        if (pthread_create (&thread, NULL, write_stats, NULL) != 0)
+        {
+            fprintf (stderr, "error: cannot start writing the statistics\n") ;
 
-                powers_queue_init (&queue) ;
+            return EXIT_FAILURE ;
+        }
 
-                extract_message_word (&request, &nflpel, 0) ;
+        pthread_detach (thread) ;
+    }
 
-                powers_queue_build (&queue, nflpel) ;
+    /* Creates socket *********************************************************/
 
-                for (index = 1, nflpel++ ; index != nflpel ; index++)
-                {
-                    float power_value ;
+    fprintf (stdout, "Creating socket ... ") ; fflush (stdout) ;
 
-                    extract_message_word (&request, &power_value, index) ;
+    socket_init (&server_socket) ;
 
-                    put_into_powers_queue (&queue, power_value) ;
-                }
+    error = open_server_socket (&server_socket, server_port) ;
 
-                error = insert_power_values (&tdata.PowerGrid, &queue) ;
+    if (error != TDICE_SUCCESS)    goto socket_error ;
 
-                if (error != TDICE_SUCCESS)
-                {
-                    fprintf (stderr, "error: insert power values\n") ;
+    fprintf (stdout, "done !\n") ;
 
-                    powers_queue_destroy (&queue) ;
+    /* Starts the workers: one per session, up to the number of processors ****/
 
-                    goto sim_error ;
-                }
+    nworkers = (Quantity_t) sysconf (_SC_NPROCESSORS_ONLN) ;
 
-                powers_queue_destroy (&queue) ;
+    if (nworkers == 0u || nworkers > max_sessions)
 
-                network_message_init (&reply) ;
-                build_message_head   (&reply, TDICE_INSERT_POWERS) ;
-                insert_message_word (&reply, &error) ;
+        nworkers = max_sessions ;
 
-                send_message_to_socket (&client_socket, &reply) ;
+    workers = (Worker_t *) calloc (nworkers, sizeof (Worker_t)) ;
 
-                network_message_destroy (&reply) ;
+    if (workers == NULL)
+    {
+        fprintf (stderr, "Cannot malloc workers\n") ;
 
-                break ;
-            }
+        goto workers_error ;
+    }
 
-        /**********************************************************************/
+    for (index = 0u ; index != nworkers ; index++)
+    {
+        struct epoll_event event ;
 
-            case TDICE_SEND_OUTPUT :
-            {
-                OutputInstant_t  instant ;
-                OutputType_t     type ;
-                OutputQuantity_t quantity ;
+        workers [index].NSessions = 0u ;
+        workers [index].Single    = max_sessions == 1u ;
+        workers [index].Result    = TDICE_SUCCESS ;
+        workers [index].Waiting   = NULL ;
+        workers [index].EpollId   = epoll_create1 (0) ;
 
-                extract_message_word (&request, &instant,  0) ;
-                extract_message_word (&request, &type,     1) ;
-                extract_message_word (&request, &quantity, 2) ;
+        if (workers [index].EpollId < 0)
+        {
+            perror ("ERROR :: epoll_create") ;
 
-                network_message_init (&reply) ;
-                build_message_head   (&reply, TDICE_SEND_OUTPUT) ;
+            goto workers_error ;
+        }
 
-                float   time = get_simulated_time (&analysis) ;
-                Quantity_t n = get_number_of_inspection_points (&output, instant, type, quantity) ;
+        // Every worker gets (once) the event of the model ready
 
-                insert_message_word (&reply, &time) ;
-                insert_message_word (&reply, &n) ;
+        event.events   = EPOLLIN | EPOLLET ;
+        event.data.ptr = NULL ;
 
-                if (n > 0)
-                {
-                    error = fill_output_message
+        if (epoll_ctl (workers [index].EpollId, EPOLL_CTL_ADD, model_registry.Event, &event) != 0)
+        {
+            perror ("ERROR :: epoll_ctl") ;
 
-                        (&output, stkd.Dimensions,
-                         tdata.Temperatures, tdata.PowerGrid.Sources,
-                         instant, type, quantity, &reply) ;
+            goto workers_error ;
+        }
 
-                    if (error != TDICE_SUCCESS)
-                    {
-                        fprintf (stderr, "error: generate message content\n") ;
+        if (max_sessions == 1u)
 
-                        network_message_destroy (&reply) ;
+            continue ;
 
-                        goto sim_error ;
-                    }
-                }
+        if (pthread_create (&workers [index].Thread, NULL, event_loop, &workers [index]) != 0)
+        {
+            fprintf (stderr, "Cannot create worker thread %u\n", index) ;
 
-                send_message_to_socket (&client_socket, &reply) ;
+            goto workers_error ;
+        }
 
-                network_message_destroy (&reply) ;
+        pthread_detach (workers [index].Thread) ;
+    }
 
-                break ;
-            }
+    /* Builds the model of the stack file while the clients are accepted ****/
 
-        /**********************************************************************/
+    // Without users, it is kept until the budget needs its memory
 
-            case TDICE_PRINT_OUTPUT :
-            {
-                OutputInstant_t  instant ;
+    model = model_registry_acquire (&model_registry, STK_FILE) ;
 
-                extract_message_word (&request, &instant,  0) ;
+    if (model == NULL)    goto workers_error ;
 
-                if (headers == false)
-                {
-                    Error_t error = generate_output_headers
+    model_registry_release (&model_registry, model) ;
 
-                        (&output, stkd.Dimensions, (String_t)"% ") ;
+    /* Serves a single client *************************************************/
 
-                    if (error != TDICE_SUCCESS)
-                    {
-                        fprintf (stderr, "error in initializing output files \n ");
+    if (max_sessions == 1u)
+    {
+        fprintf (stdout, "Waiting for client ... ") ; fflush (stdout) ;
 
-                        goto sim_error ;
-                    }
+        socket_init (&client_socket) ;
 
-                    headers = true ;
-                }
+        error = wait_for_client (&server_socket, &client_socket) ;
 
-                generate_output
+        if (error != TDICE_SUCCESS)    goto wait_error ;
 
-                    (&output, stkd.Dimensions,
-                     tdata.Temperatures, tdata.PowerGrid.Sources,
-                     get_simulated_time (&analysis), analysis.CurrentTime, 
-                     analysis.SlotLength, instant) ;
+        if (socket_set_non_blocking (&client_socket) != TDICE_SUCCESS)
+        {
+            socket_close (&client_socket) ;
 
-                break ;
-            }
+            goto workers_error ;
+        }
 
-        /**********************************************************************/
+        session = open_session (0u, &client_socket, &workers [0]) ;
 
-            case TDICE_SEND_OUTPUT_FILES :
-            {
-                network_message_init (&reply) ;
+        if (session == NULL)
+        {
+            socket_close (&client_socket) ;
 
-                if (build_output_files_message (&output, &reply) != TDICE_SUCCESS)
-                {
-                    fprintf (stderr, "error: build output files message\n") ;
+            goto workers_error ;
+        }
 
-                    network_message_destroy (&reply) ;
+        fprintf (stdout, "done !\n") ;
 
-                    goto sim_error ;
-                }
+        active_sessions = sessions_peak = workers [0].NSessions = 1u ;
 
-                send_message_to_socket (&client_socket, &reply) ;
+        if (watch_session (session, EPOLL_CTL_ADD) != TDICE_SUCCESS)
+        {
+            close_session (session, TDICE_FAILURE) ;
 
-                network_message_destroy (&reply) ;
+            goto workers_error ;
+        }
 
-                break ;
-            }
+        event_loop (&workers [0]) ;
 
-        /**********************************************************************/
+        if (workers [0].Result != TDICE_SUCCESS)    goto workers_error ;
 
-            case TDICE_SIMULATE_SLOT :
-            {
-                network_message_init (&reply) ;
-                build_message_head   (&reply, TDICE_SIMULATE_SLOT) ;
+        goto quit ;
+    }
 
-                SimResult_t result = emulate_slot (&tdata, stkd.Dimensions, &analysis) ;
+    /* Serves many clients, assigning each one to the least loaded worker *****/
 
-                insert_message_word (&reply, &result) ;
+    fprintf (stdout, "Waiting for clients (at most %u sessions) ...\n", max_sessions) ;
 
-                send_message_to_socket (&client_socket, &reply) ;
+    fflush (stdout) ;
 
-                network_message_destroy (&reply) ;
+    for (session_id = 0u ; ; session_id++)
+    {
+        Worker_t *worker = &workers [0] ;
 
-                if (result == TDICE_END_OF_SIMULATION)
-                {
-                    network_message_destroy (&request) ;
+        pthread_mutex_lock (&sessions_lock) ;
 
-                    goto quit ;
-                }
-                else if (result != TDICE_SLOT_DONE)
-                {
-                    fprintf (stderr, "error %d: emulate slot\n", result) ;
+        while (active_sessions == max_sessions)
 
-                    goto sim_error ;
-                }
+            pthread_cond_wait (&sessions_cond, &sessions_lock) ;
 
-                fprintf (stdout, "%.3f ", get_simulated_time (&analysis)) ;
+        pthread_mutex_unlock (&sessions_lock) ;
 
-                fflush (stdout) ;
+        socket_init (&client_socket) ;
 
-                if (++slot_counter == 10)
-                {
-                    fprintf (stdout, "\n") ;
+        // wait_for_client closes the server socket on failure
 
-                    slot_counter = 0 ;
-                }
+        error = wait_for_client (&server_socket, &client_socket) ;
 
-                break ;
-            }
+        if (error != TDICE_SUCCESS)    goto accept_error ;
 
-        /**********************************************************************/
+        if (socket_set_non_blocking (&client_socket) != TDICE_SUCCESS)
+        {
+            socket_close (&client_socket) ;
 
-            case TDICE_SIMULATE_STEP :
-            {
-                network_message_init (&reply) ;
-                build_message_head   (&reply, TDICE_SIMULATE_STEP) ;
+            continue ;
+        }
 
-                SimResult_t result = emulate_step (&tdata, stkd.Dimensions, &analysis) ;
+        pthread_mutex_lock (&sessions_lock) ;
 
-                insert_message_word (&reply, &result) ;
+        for (index = 1u ; index != nworkers ; index++)
 
-                send_message_to_socket (&client_socket, &reply) ;
+            if (workers [index].NSessions < worker->NSessions)
 
-                network_message_destroy (&reply) ;
+                worker = &workers [index] ;
 
-                if (result == TDICE_END_OF_SIMULATION)
-                {
-                    network_message_destroy (&request) ;
+        pthread_mutex_unlock (&sessions_lock) ;
 
-                    goto quit ;
-                }
-                else if (result != TDICE_STEP_DONE && result != TDICE_SLOT_DONE)
-                {
-                    fprintf (stderr, "error %d: emulate step\n", result) ;
+        session = open_session (session_id, &client_socket, worker) ;
 
-                    goto sim_error ;
-                }
+        if (session == NULL)
+        {
+            fprintf (stderr, "Cannot open session %u\n", session_id) ;
 
-                fprintf (stdout, "%.3f ", get_simulated_time (&analysis)) ;
+            socket_close (&client_socket) ;
 
-                fflush (stdout) ;
+            continue ;
+        }
 
-                if (slot_completed (&analysis))
+        fprintf (stdout, "Session %u: client %s:%u connected\n",
+                 session_id, client_socket.HostName, client_socket.PortNumber) ;
 
-                    fprintf (stdout, "\n") ;
+        fflush (stdout) ;
 
-                break ;
-            }
+        pthread_mutex_lock   (&sessions_lock) ;
+        worker->NSessions++ ;
+        active_sessions++ ;
 
-        /**********************************************************************/
+        if (active_sessions > sessions_peak)
 
-            default :
+            sessions_peak = active_sessions ;
 
-                fprintf (stderr, "ERROR :: received unknown message type") ;
-        }
+        pthread_mutex_unlock (&sessions_lock) ;
 
-        network_message_destroy (&request) ;
+        if (watch_session (session, EPOLL_CTL_ADD) != TDICE_SUCCESS)
 
-    } while (1) ;
+            close_session (session, TDICE_FAILURE) ;
+    }
 
     /**************************************************************************/
 
 quit :
 
-    socket_close              (&client_socket) ;
-    socket_close              (&server_socket) ;
-    thermal_data_destroy      (&tdata) ;
-    stack_description_destroy (&stkd) ;
-    output_destroy            (&output) ;
+    close (workers [0].EpollId) ;
+    free  (workers) ;
+
+    snapshot_pool_destroy  (&snapshot_pool) ;
+    model_registry_destroy (&model_registry) ;
+
+    socket_close (&server_socket) ;
 
     return EXIT_SUCCESS ;
 
-sim_error :
-                            network_message_destroy   (&request) ;
-                            socket_close              (&client_socket) ;
+workers_error :
 wait_error :
                             socket_close              (&server_socket) ;
-socket_error :
-                            thermal_data_destroy      (&tdata) ;
-ftd_error :
-wrong_analysis_error :
-                            stack_description_destroy (&stkd) ;
-                            output_destroy            (&output) ;
+accept_error :
+
+                            // Waits for the running sessions before
+                            // destroying the model they share
+
+                            pthread_mutex_lock   (&sessions_lock) ;
+
+                            while (active_sessions != 0u)
 
+                                pthread_cond_wait (&sessions_cond, &sessions_lock) ;
+
+                            pthread_mutex_unlock (&sessions_lock) ;
+
+                            free (workers) ;
+
+                            snapshot_pool_destroy (&snapshot_pool) ;
+socket_error :
+registry_error :
+                            model_registry_destroy (&model_registry) ;
                             return EXIT_FAILURE ;
 }
@@ -44,6 +44,7 @@
     #include "floorplan_element.h"
     #include "ic_element.h"
     #include "powers_queue.h"
+    #include "leakage.h"
     #include "floorplan.h"
 
     //TODO: this definition seem to have disappeared, find a better fix
@@ -58,6 +59,7 @@
     ICElement_t        *p_icelement ;
     FloorplanElement_t *p_floorplan_element ;
     PowersQueue_t      *p_powers_queue ;
+    Leakage_t          *p_leakage ;
 }
 
 %code
@@ -84,13 +86,20 @@
 %type <p_powers_queue>      optional_power_values_list ;
 %type <p_powers_queue>      power_values_list ;
 %type <p_icelement>         ic_element ;
+%type <p_leakage>           optional_leakage ;
+%type <p_leakage>           leakage_points ;
 
 %destructor { string_destroy (&$$) ;   } <identifier>
 %destructor { powers_queue_free ($$) ; } <p_powers_queue>
+%destructor { leakage_free ($$) ;      } <p_leakage>
 
 %token DIMENSION  "keyword dimension"
 %token DISCRETIZATION  "keyword discretization"
+%token EXPONENTIAL     "keyword exponential"
+%token LEAKAGE         "keyword leakage"
+%token LINEAR          "keyword linear"
 %token MATERIAL        "keyword material"
+%token PIECEWISE       "keyword piecewise"
 %token POSITION   "keyword position"
 %token POWER      "keyword power"
 %token RECTANGLE  "keywork rectangle"
@@ -177,6 +186,7 @@ floorplan_element
   : IDENTIFIER ':'                        // $1
       ic_elements                         // $3
       optional_power_values_list          // $4
+      optional_leakage                    // $5
     {
         FloorplanElement_t *floorplan_element = $$ = floorplan_element_calloc ( ) ;
 
@@ -186,6 +196,8 @@ floorplan_element
 
             string_destroy (&$1) ;
 
+            leakage_free ($5) ;
+
             ic_element_list_destroy (&ic_element_list) ;
 
             YYABORT ;
@@ -195,6 +207,21 @@ floorplan_element
 
         floorplan_element->NICElements  = ic_element_list.Size ;
         floorplan_element->PowerValues  = $4 ;
+        floorplan_element->Leakage      = $5 ;
+
+        if ($5 != NULL)
+        {
+            if (dimensions->NonUniform == 1)
+            {
+                sprintf (error_message, "Leakage of %s not supported with non-uniform grids", $1) ;
+
+                floorplan_parser_error (floorplan, dimensions, scanner, error_message) ;
+
+                local_abort = true ;
+            }
+
+            floorplan->NLeakages++ ;
+        }
 
         ic_element_list_copy (&floorplan_element->ICElements, &ic_element_list) ;
         ic_element_list_destroy (&ic_element_list) ;
@@ -521,6 +548,86 @@ power_values_list
     }
   ;
 
+/******************************************************************************/
+/************************* Leakage power **************************************/
+/******************************************************************************/
+
+optional_leakage
+
+  : // The leakage power of the floorplan element is not mandatory
+
+    {
+        $$ = NULL ;
+    }
+
+  | LEAKAGE EXPONENTIAL DVALUE ',' DVALUE ',' DVALUE ';'  // $3 $5 $7
+    {
+        Leakage_t *leakage = $$ = leakage_calloc ( ) ;
+
+        if (leakage == NULL)
+        {
+            floorplan_parser_error (floorplan, dimensions, scanner, "Malloc leakage failed") ;
+
+            ic_element_list_destroy (&ic_element_list) ;
+
+            YYABORT ;
+        }
+
+        leakage->Model       = TDICE_LEAKAGE_EXPONENTIAL ;
+        leakage->Power       = $3 ;
+        leakage->Coefficient = $5 ;
+        leakage->Reference   = $7 ;
+    }
+
+  | LEAKAGE PIECEWISE LINEAR leakage_points ';'  // $4
+    {
+        $$ = $4 ;
+    }
+  ;
+
+leakage_points
+
+  : '(' DVALUE ',' DVALUE ')'  // $2 $4
+                               // Here at least one point is mandatory
+    {
+        Leakage_t *leakage = $$ = leakage_calloc ( ) ;
+
+        if (leakage == NULL)
+        {
+            floorplan_parser_error (floorplan, dimensions, scanner, "Malloc leakage failed") ;
+
+            ic_element_list_destroy (&ic_element_list) ;
+
+            YYABORT ;
+        }
+
+        leakage->Model = TDICE_LEAKAGE_PIECEWISE_LINEAR ;
+
+        if (leakage_add_point (leakage, $2, $4) == TDICE_FAILURE)
+        {
+            floorplan_parser_error (floorplan, dimensions, scanner, "Malloc leakage point failed") ;
+
+            local_abort = true ;
+        }
+    }
+
+  | leakage_points ',' '(' DVALUE ',' DVALUE ')'  // $1 the points so far ...
+                                                  // $4 $6 the point to add
+    {
+        if (leakage_add_point ($1, $4, $6) == TDICE_FAILURE)
+        {
+            sprintf (error_message,
+                "Leakage point (%.2f, %.4f) not sorted by increasing temperature", $4, $6) ;
+
+            floorplan_parser_error (floorplan, dimensions, scanner, error_message) ;
+
+            local_abort = true ;
+        }
+
+        $$ = $1 ;
+    }
+  ;
+
 %%
 
 /******************************************************************************/
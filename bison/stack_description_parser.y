@@ -139,6 +139,7 @@
 %token CHANNEL               "keyword channel"
 %token CHIP                  "keyword chip"
 %token COEFFICIENT           "keyword coefficient"
+%token COMMUNICATION         "keyword communication"
 %token CONDUCTIVITY          "keyword conductivity"
 %token COOLANT               "keyword coolant"
 %token DARCY                 "keyword darcy"
@@ -146,6 +147,7 @@
 %token DIE                   "keyword die"
 %token DIMENSIONS            "keyword dimensions"
 %token DISTRIBUTION          "keyword distribution"
+%token EXTRAPOLATE           "keyword extrapolate"
 %token DISCRETIZATION        "keyword discretization"
 %token FINAL                 "keyword final"
 %token FIRST                 "keyword first"
@@ -157,9 +159,12 @@
 %token INCOMING              "keyword incoming"
 %token INITIAL_              "keyword initial"
 %token INLINE                "keyword inline"
+%token INTERVAL              "keyword interval"
+%token ITERATIONS            "keyword iterations"
 %token LAST                  "keyword last"
 %token LAYER                 "keyword layer"
 %token LAYOUT                "keyword layout"
+%token LEAKAGE               "keyword leakage"
 %token LENGTH                "keyword length"
 %token MATERIAL              "keyword material"
 %token MAXIMUM               "keyword maximum"
@@ -167,7 +172,9 @@
 %token MINIMUM               "keyword minimum"
 %token NONUNIFORM            "keyword non-uniform"
 %token NUMOFCORES            "keyword numofcores"
+%token PARAREAL              "keyword parareal"
 %token OUTPUT                "keyword output"
+%token OVERLAP               "keyword overlap"
 %token PIN                   "keyword pin"
 %token PINFIN                "keyword pinfin"
 %token PITCH                 "keyword pitch"
@@ -186,12 +193,16 @@
 %token STATE                 "keyword state"
 %token STEADY                "keyword steady"
 %token STEP                  "keyword step"
+%token SUBMODEL              "keyword submodel"
+%token SUBSTRUCTURING        "keyword substructuring"
 %token TCELL                 "keyword T"
 %token TCOOLANT              "keyword Tcoolant"
 %token TEMPERATURE           "keyword temperature"
 %token TFLP                  "keyword Tflp"
 %token TFLPEL                "keyword Tflpel"
 %token THERMAL               "keyword thermal"
+%token TILES                 "keyword tiles"
+%token TOLERANCE             "keyword tolerance"
 %token TMAP                  "keyword Tmap"
 %token T3D                   "keyword T3d"
 %token TO                    "keyword to"
@@ -202,6 +213,7 @@
 %token VOLUMETRIC            "keywork volumetric"
 %token WALL                  "keyword wall"
 %token WIDTH                 "keyword width"
+%token WINDOWS               "keyword windows"
 %token TRUE_FLAG             "keyword true"
 %token FALSE_FLAG            "keyword false"
 
@@ -353,9 +365,9 @@ heatsink_opt
 
   | topsink bottomsink
 
-  | topsink_pluggable
+  | topsink_pluggable optional_communication_interval
 
-  | topsink_pluggable bottomsink
+  | topsink_pluggable optional_communication_interval bottomsink
 
   ;
 
@@ -494,6 +506,39 @@ topsink_pluggable
     }
   ;
 
+optional_communication_interval
+
+  : /* empty */
+
+  | COMMUNICATION INTERVAL DVALUE ';' // $3
+
+    {
+        if ($3 < 1)
+        {
+            STKERROR ("Communication interval must be a positive number of steps") ;
+
+            YYABORT ;
+        }
+
+        stkd->TopHeatSink->CommunicationSteps = (Quantity_t) $3 ;
+        stkd->TopHeatSink->Extrapolate        = false ;
+    }
+
+  | COMMUNICATION INTERVAL DVALUE ',' EXTRAPOLATE ';' // $3
+
+    {
+        if ($3 < 1)
+        {
+            STKERROR ("Communication interval must be a positive number of steps") ;
+
+            YYABORT ;
+        }
+
+        stkd->TopHeatSink->CommunicationSteps = (Quantity_t) $3 ;
+        stkd->TopHeatSink->Extrapolate        = true ;
+    }
+  ;
+
 /******************************************************************************/
 /******************************* MicroChannel *********************************/
 /******************************************************************************/
@@ -1735,6 +1780,10 @@ solver
         STEADY ';'
         INITIAL_ TEMPERATURE DVALUE ';' // $7
         optional_numofcores             // $9
+        optional_substructuring
+        optional_tiles
+        optional_submodel
+        optional_leakage
 
     {
         // StepTime is set to 1 to avoid division by zero when computing
@@ -1747,13 +1796,49 @@ solver
 
         analysis->InitialTemperature = (Temperature_t) $7 ;
         analysis->NumOfCores = (Quantity_t) $9;
+
+        // Without iterations, the leakage power would be evaluated
+        // only once, at the initial temperature
+
+        if (analysis->LeakageIterations == 0u)
+        {
+            analysis->LeakageIterations = 100u ;
+            analysis->LeakageTolerance  = (Temperature_t) 0.01 ;
+        }
+
+        if (analysis->TileRows != 0u && analysis->Substructuring == true)
+        {
+            STKERROR ("Tiles cannot be used together with substructuring") ;
+
+            YYABORT ;
+        }
+
+        if (stkd->TopHeatSink && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            if (stkd->Dimensions->NonUniform == 1)
+            {
+                STKERROR ("Steady state with a pluggable heat sink requires a uniform grid") ;
+
+                YYABORT ;
+            }
+
+            if (initialize_pluggable_heatsink (stkd->TopHeatSink, analysis) != TDICE_SUCCESS)
+
+                YYABORT ;
+        }
     }
 
   | SOLVER ':'
         TRANSIENT STEP DVALUE ',' SLOT DVALUE ';'  // $5 StepTime
                                                    // $8 SlotTime
         INITIAL_ TEMPERATURE DVALUE ';'            // $12 Initial temperature
-        optional_numofcores                        // $14 number of cores
+        optional_initial_state
+        optional_numofcores                        // $15 number of cores
+        optional_parareal
+        optional_substructuring
+        optional_tiles
+        optional_submodel
+        optional_leakage
     {
         if ($8 < $5)
         {
@@ -1780,7 +1865,14 @@ solver
         analysis->StepTime           = (Time_t) $5 ;
         analysis->SlotTime           = (Time_t) $8 ;
         analysis->InitialTemperature = (Temperature_t) $12 ;
-        analysis->NumOfCores         = (Quantity_t) $14;
+        analysis->NumOfCores         = (Quantity_t) $15;
+
+        // By default the leakage power is evaluated once per step,
+        // at the temperatures of the previous step
+
+        if (analysis->LeakageIterations == 0u)
+
+            analysis->LeakageIterations = 1u ;
 
         // Execute correct division Slot / Step avoiding floating point issues
         // i.e. both slot and step are mutiplied by 10 until the decimal part
@@ -1802,6 +1894,66 @@ solver
 
         analysis->SlotLength   = (Quantity_t) sl_int / (Quantity_t) st_int ;
 
+        if (analysis->PararealWindows != 0u
+            && stkd->TopHeatSink
+            && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            STKERROR ("Parareal cannot be used with a pluggable heat sink") ;
+
+            YYABORT ;
+        }
+
+        if (analysis->PararealWindows != 0u && analysis->Substructuring == true)
+        {
+            STKERROR ("Parareal cannot be used together with substructuring") ;
+
+            YYABORT ;
+        }
+
+        if (analysis->TileRows != 0u && analysis->Substructuring == true)
+        {
+            STKERROR ("Tiles cannot be used together with substructuring") ;
+
+            YYABORT ;
+        }
+
+        if (analysis->TileRows != 0u && analysis->PararealWindows != 0u)
+        {
+            STKERROR ("Tiles cannot be used together with parareal") ;
+
+            YYABORT ;
+        }
+
+        // The subdomains and the submodel start from their own
+        // uniform temperature
+
+        if (analysis->InitialState != TDICE_INITIAL_STATE_UNIFORM
+            && (analysis->TileRows != 0u || analysis->SubmodelLength != 0.0))
+        {
+            STKERROR ("Steady initial state cannot be used together with tiles or submodel") ;
+
+            YYABORT ;
+        }
+
+        if (analysis->InitialState != TDICE_INITIAL_STATE_UNIFORM
+            && stkd->Dimensions->NonUniform == 1
+            && stkd->TopHeatSink
+            && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            STKERROR ("Steady initial state with a pluggable heat sink requires a uniform grid") ;
+
+            YYABORT ;
+        }
+
+        // The submodel follows the coarse model one step at a time
+
+        if (analysis->SubmodelLength != 0.0 && analysis->PararealWindows != 0u)
+        {
+            STKERROR ("Submodel cannot be used together with parareal") ;
+
+            YYABORT ;
+        }
+
         // Cannot be done before as we need the step time and initial temperature
         if(stkd->TopHeatSink && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
         {
@@ -1811,6 +1963,23 @@ solver
     }
   ;
 
+optional_initial_state
+
+  : /* empty */
+
+  | INITIAL_ STATE STEADY ';'
+
+    {
+        analysis->InitialState = TDICE_INITIAL_STATE_STEADY ;
+    }
+
+  | INITIAL_ STATE STEADY AVERAGE ';'
+
+    {
+        analysis->InitialState = TDICE_INITIAL_STATE_STEADY_AVERAGE ;
+    }
+  ;
+
 optional_numofcores
   
   : /* empty */
@@ -1832,6 +2001,218 @@ optional_numofcores
 
   ;
 
+optional_parareal
+
+  : /* empty */
+
+  | PARAREAL WINDOWS DVALUE ',' TOLERANCE DVALUE ';' // $3 $6
+
+    {
+        if ($3 < 1)
+        {
+            STKERROR ("Number of parareal windows must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        if ($6 <= 0.0)
+        {
+            STKERROR ("Parareal tolerance must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        // Without a limit, iterating as many times as windows gives
+        // the same result of the sequential integration
+
+        analysis->PararealWindows    = (Quantity_t) $3 ;
+        analysis->PararealTolerance  = (Temperature_t) $6 ;
+        analysis->PararealIterations = (Quantity_t) $3 ;
+    }
+
+  | PARAREAL WINDOWS DVALUE ',' TOLERANCE DVALUE ',' ITERATIONS DVALUE ';' // $3 $6 $9
+
+    {
+        if ($3 < 1)
+        {
+            STKERROR ("Number of parareal windows must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        if ($6 <= 0.0)
+        {
+            STKERROR ("Parareal tolerance must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        if ($9 < 1)
+        {
+            STKERROR ("Number of parareal iterations must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        analysis->PararealWindows    = (Quantity_t) $3 ;
+        analysis->PararealTolerance  = (Temperature_t) $6 ;
+        analysis->PararealIterations = (Quantity_t) $9 ;
+    }
+  ;
+
+optional_substructuring
+
+  : /* empty */
+
+  | SUBSTRUCTURING ';'
+
+    {
+        if (stkd->Dimensions->NonUniform == 1)
+        {
+            STKERROR ("Substructuring requires a uniform grid") ;
+
+            YYABORT ;
+        }
+
+        analysis->Substructuring = true ;
+    }
+  ;
+
+optional_tiles
+
+  : /* empty */
+
+  | TILES DVALUE ',' DVALUE ',' OVERLAP DVALUE ';' // $2 $4 $7
+
+    {
+        if (stkd->Dimensions->NonUniform == 1)
+        {
+            STKERROR ("Tiles require a uniform grid") ;
+
+            YYABORT ;
+        }
+
+        if (stkd->TopHeatSink
+            && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            STKERROR ("Tiles cannot be used with a pluggable heat sink") ;
+
+            YYABORT ;
+        }
+
+        if ($2 < 1 || $4 < 1)
+        {
+            STKERROR ("Number of tiles must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        if (   $2 > get_number_of_rows (stkd->Dimensions)
+            || $4 > get_number_of_columns (stkd->Dimensions))
+        {
+            STKERROR ("More tiles than rows or columns of thermal cells") ;
+
+            YYABORT ;
+        }
+
+        // Without overlap the neighbours of the boundary cells of a tile
+        // would not belong to the subdomain
+
+        if ($7 < 1)
+        {
+            STKERROR ("Tiles overlap must be at least one cell") ;
+
+            YYABORT ;
+        }
+
+        analysis->TileRows    = (Quantity_t) $2 ;
+        analysis->TileColumns = (Quantity_t) $4 ;
+        analysis->TileOverlap = (Quantity_t) $7 ;
+    }
+  ;
+
+optional_submodel
+
+  : /* empty */
+
+  | SUBMODEL '(' DVALUE ',' DVALUE ')'        // $3 $5
+        LENGTH DVALUE ',' WIDTH DVALUE ','    // $8 $11
+        CELL LENGTH DVALUE ',' WIDTH DVALUE ';' // $15 $18
+
+    {
+        if (stkd->Dimensions->NonUniform == 1)
+        {
+            STKERROR ("Submodel requires a uniform grid") ;
+
+            YYABORT ;
+        }
+
+        if (stkd->Channel != NULL)
+        {
+            STKERROR ("Submodel cannot be used with channels") ;
+
+            YYABORT ;
+        }
+
+        if (stkd->TopHeatSink
+            && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            STKERROR ("Submodel cannot be used with a pluggable heat sink") ;
+
+            YYABORT ;
+        }
+
+        if ($3 < 0.0 || $5 < 0.0 || $8 <= 0.0 || $11 <= 0.0
+            || $3 + $8  - get_chip_length (stkd->Dimensions) > EPSILON
+            || $5 + $11 - get_chip_width  (stkd->Dimensions) > EPSILON)
+        {
+            STKERROR ("Submodel region is outside of the IC") ;
+
+            YYABORT ;
+        }
+
+        if ($15 <= 0.0 || $18 <= 0.0 || $15 > $8 || $18 > $11)
+        {
+            STKERROR ("Submodel cells must be smaller than the region") ;
+
+            YYABORT ;
+        }
+
+        analysis->SubmodelX          = (ChipDimension_t) $3 ;
+        analysis->SubmodelY          = (ChipDimension_t) $5 ;
+        analysis->SubmodelLength     = (ChipDimension_t) $8 ;
+        analysis->SubmodelWidth      = (ChipDimension_t) $11 ;
+        analysis->SubmodelCellLength = (CellDimension_t) $15 ;
+        analysis->SubmodelCellWidth  = (CellDimension_t) $18 ;
+    }
+  ;
+
+optional_leakage
+
+  : /* empty */
+
+  | LEAKAGE ITERATIONS DVALUE ',' TOLERANCE DVALUE ';' // $3 $6
+
+    {
+        if ($3 < 1)
+        {
+            STKERROR ("Number of leakage iterations must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        if ($6 <= 0.0)
+        {
+            STKERROR ("Leakage tolerance must be a positive value") ;
+
+            YYABORT ;
+        }
+
+        analysis->LeakageIterations = (Quantity_t) $3 ;
+        analysis->LeakageTolerance  = (Temperature_t) $6 ;
+    }
+  ;
+
 /******************************************************************************/
 /****************************** Desired Output ********************************/
 /******************************************************************************/
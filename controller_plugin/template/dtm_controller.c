@@ -0,0 +1,107 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+// This is just a template, write your thermal management policy here.
+// The example halves the power of all the floorplan elements as long as
+// one of the Tcell or Tflpel inspection points of the slot output instant
+// is above a threshold temperature, given as argument (in Kelvin)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned int nFlpel, nSlotPoints;
+static double threshold;
+
+int dtm_controller_init(unsigned int ncells, unsigned int nflpel,
+                        unsigned int nstepipoints, unsigned int nslotipoints,
+                        double steptime, double slottime,
+                        const char *args)
+{
+    /*
+     * - ncells is the number of thermal cells of the stack, nflpel the
+     *   number of floorplan elements and nstepipoints/nslotipoints the number
+     *   of Tcell and Tflpel inspection points of the step/slot output instant.
+     *
+     * - steptime and slottime are the step and slot times of the simulation.
+     *
+     * - args is the optional string given on the command line.
+     */
+    
+    (void) ncells;
+    (void) nstepipoints;
+    (void) steptime;
+    (void) slottime;
+    
+    nFlpel=nflpel;
+    nSlotPoints=nslotipoints;
+    threshold=args[0]!='\0' ? atof(args) : 358.15;
+    if(nSlotPoints==0)
+    {
+        fprintf(stderr,"the controller needs at least a slot inspection point\n");
+        return -1;
+    }
+    return 0;
+}
+
+int dtm_controller_slot(double time,
+                        const double *temperatures,
+                        const double *ipoints,
+                        double *powers, double *flowrate)
+{
+    /*
+     * Called at the end of every slot. Export dtm_controller_step (with the
+     * same arguments) instead, or as well, to be called after every step.
+     *
+     * temperatures and ipoints are read only. powers are the power values
+     * of the next slot, flowrate the coolant flow rate in ml/min: change
+     * them to take thermal management decisions.
+     */
+    
+    (void) time;
+    (void) temperatures;
+    (void) flowrate;
+    
+    double hottest=ipoints[0];
+    for(unsigned int i=1;i<nSlotPoints;i++)
+        if(ipoints[i]>hottest) hottest=ipoints[i];
+    
+    if(hottest>threshold)
+        for(unsigned int i=0;i<nFlpel;i++)
+            powers[i]*=0.5;
+    return 0;
+}
@@ -71,7 +71,7 @@ int heatsink_init(unsigned int nrows, unsigned int ncols,
 int heatsink_simulate_step(const double *spreadertemperatures,
                                  double *heatflow)
 {
-    ProfileFunction pf(profiler);
+    ProfileFunction pf(profiler,true);
     try {
         const CellMatrix t(const_cast<double*>(spreadertemperatures),nRows,nCols);
         CellMatrix q(heatflow,nRows,nCols);
@@ -83,6 +83,27 @@ int heatsink_simulate_step(const double *spreadertemperatures,
     }
 }
 
+int heatsink_steady_state(const double *spreadertemperatures,
+                                double *heatflow)
+{
+    ProfileFunction pf(profiler);
+    try {
+        const CellMatrix t(const_cast<double*>(spreadertemperatures),nRows,nCols);
+        CellMatrix q(heatflow,nRows,nCols);
+        wrapper->steadyState(t,q);
+        return 0;
+    } catch(exception& e) {
+        cerr<<"exception thrown: "<<e.what()<<endl;
+        return -1;
+    }
+}
+
+int heatsink_communication_interval(unsigned int steps)
+{
+    profiler.setCommunicationSteps(steps);
+    return 0;
+}
+
 //
 // Class Profiler
 //
@@ -92,6 +113,9 @@ Profiler::Profiler()
     last=high_resolution_clock::now();
     mainTime=nanoseconds::zero();
     pluginTime=nanoseconds::zero();
+    stepTime=nanoseconds::zero();
+    steps=0;
+    communicationSteps=1;
 }
 
 void Profiler::enterPlugin()
@@ -101,10 +125,15 @@ void Profiler::enterPlugin()
     last=now;
 }
 
-void Profiler::exitPlugin()
+void Profiler::exitPlugin(bool step)
 {
     auto now=high_resolution_clock::now();
     pluginTime+=duration_cast<nanoseconds>(now-last);
+    if(step)
+    {
+        stepTime+=duration_cast<nanoseconds>(now-last);
+        steps++;
+    }
     last=now;
 }
 
@@ -136,4 +165,13 @@ void Profiler::printStats()
     };
     print("3D-ICE: ",mt,mp);
     print("plugin: ",pt,pp);
+    if(communicationSteps>1 && steps>0)
+    {
+        // Estimate, as if the skipped steps had cost as much as the done ones
+        double st=static_cast<double>(stepTime.count())/1e9;
+        double saved=st*(communicationSteps-1);
+        cout<<"plugin steps: "<<steps<<" (one every "<<communicationSteps
+            <<" thermal steps)\n";
+        print("saved:  ",saved,100*saved/(mt+pt+saved));
+    }
 }
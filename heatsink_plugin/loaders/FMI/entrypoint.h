@@ -54,6 +54,13 @@ int heatsink_init(unsigned int nrows, unsigned int ncols,
                   const char *args);
 int heatsink_simulate_step(const double *spreadertemperatures,
                                  double *heatflow);
+// Used by steady state simulations, and to start transient ones from the
+// steady state
+int heatsink_steady_state(const double *spreadertemperatures,
+                                double *heatflow);
+// Optional, tells the plugin that heatsink_simulate_step is called
+// once every steps thermal steps
+int heatsink_communication_interval(unsigned int steps);
 }
 
 // Comment out to disable bound checking in CellMatrix
@@ -111,7 +118,9 @@ public:
     
     void enterPlugin();
     
-    void exitPlugin();
+    void exitPlugin(bool step=false);
+    
+    void setCommunicationSteps(unsigned int steps) { communicationSteps=steps; }
     
     void printStats();
     
@@ -121,15 +130,19 @@ private:
     std::chrono::high_resolution_clock::time_point last;
     std::chrono::nanoseconds mainTime;
     std::chrono::nanoseconds pluginTime;
+    std::chrono::nanoseconds stepTime; // Part of pluginTime spent in steps
+    unsigned int steps;
+    unsigned int communicationSteps;
 };
 
 class ProfileFunction
 {
 public:
-    ProfileFunction(Profiler& p) : p(p) { p.enterPlugin(); }
-    ~ProfileFunction()                  { p.exitPlugin();  }
+    ProfileFunction(Profiler& p, bool step=false) : p(p), step(step) { p.enterPlugin(); }
+    ~ProfileFunction()                                               { p.exitPlugin(step); }
 private:
     Profiler& p;
+    bool step;
 };
 
 #endif //ENTRYPOINT_H
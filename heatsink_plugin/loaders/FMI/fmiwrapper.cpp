@@ -39,6 +39,8 @@
 #include <stdexcept>
 #include <iostream>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 #include "fmiwrapper.h"
 
 using namespace std;
@@ -166,6 +168,27 @@ void FmiWrapper::simulateStep(const CellMatrix spreaderTemperatures,
     time+=timeStep;
 }
 
+void FmiWrapper::steadyState(const CellMatrix spreaderTemperatures,
+                                   CellMatrix heatFlow)
+{
+    // An FMU has no steady state solver, so the heatsink is simulated with
+    // the spreader temperatures held constant until its temperatures settle.
+    // It is left at its steady state, the one a transient simulation
+    // starting from the steady state needs
+    vector<double> previous(sinkTemperatureIndices.size());
+    for(unsigned int step=0;step<steadyMaxSteps;step++)
+    {
+        fmi.getVectorDouble(sinkTemperatureIndices.data(),previous.data(),previous.size());
+        simulateStep(spreaderTemperatures,heatFlow);
+        fmi.getVectorDouble(sinkTemperatureIndices.data(),&sinkTemperatures.at(0,0),sinkTemperatureIndices.size());
+        double change=0.0;
+        for(unsigned int i=0;i<previous.size();i++)
+            change=max(change,fabs((&sinkTemperatures.at(0,0))[i]-previous[i]));
+        if(change<steadyTolerance) return;
+    }
+    throw runtime_error("FMI: heatsink did not reach its steady state");
+}
+
 string FmiWrapper::getName(const string& args)
 {
     string pathModel=args.substr(0,args.find_first_of(" "));
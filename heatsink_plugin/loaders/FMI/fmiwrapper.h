@@ -63,6 +63,9 @@ public:
     void simulateStep(const CellMatrix spreaderTemperatures,
                             CellMatrix heatFlow);
 
+    void steadyState(const CellMatrix spreaderTemperatures,
+                           CellMatrix heatFlow);
+
 private:
     static std::string getName(const std::string& args);
     static std::string getPath(const std::string& args);
@@ -70,6 +73,10 @@ private:
     FmiInterface fmi;
     const double timeStep;
     double time = 0.0;
+    // The heatsink is left at its steady state between the calls of the
+    // steady state iteration, so only the first one needs many steps
+    static const unsigned int steadyMaxSteps = 10000;
+    static constexpr double steadyTolerance = 1e-9; // Kelvin
     FragmentGrid spreaderMapping;
     FragmentGrid sinkMapping;
     Matrix<double> sinkTemperatures;
@@ -81,6 +81,19 @@ int heatsink_simulate_step(const double *spreadertemperatures,
     }
 }
 
+int heatsink_steady_state(const double *spreadertemperatures,
+                                double *heatflow)
+{
+    ProfileFunction pf(profiler);
+    try {
+        wrapper->steadyState(spreadertemperatures,heatflow);
+        return 0;
+    } catch(exception& e) {
+        cerr<<"exception thrown: "<<e.what()<<endl;
+        return -1;
+    }
+}
+
 //
 // Class Profiler
 //
@@ -54,6 +54,8 @@ int heatsink_init(unsigned int nrows, unsigned int ncols,
                   const char *args);
 int heatsink_simulate_step(const double *spreadertemperatures,
                                  double *heatflow);
+int heatsink_steady_state(const double *spreadertemperatures,
+                                double *heatflow);
 }
 
 // Comment out to disable bound checking in CellMatrix
@@ -37,8 +37,6 @@
  ******************************************************************************/
 
 #include "pythonwrapper.h"
-// #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
-// #include <arrayobject.h>
 #include <stdexcept>
 #include <iostream>
 #include <cstring>
@@ -69,7 +67,23 @@ PythonWrapper::PythonWrapper(unsigned int nRows, unsigned int nCols,
     Py_Initialize();
     auto heatsink = check(PyImport_ImportModule(filenameNoExt.c_str()));
     auto init     = check(PyObject_GetAttrString(heatsink,"heatsinkInit"));
-    hSimulateStep = check(PyObject_GetAttrString(heatsink,"heatsinkSimulateStep"));
+    hSimulateStep = lookup(heatsink,"heatsinkSimulateStep");
+    if(hSimulateStep.object==nullptr)
+        throw runtime_error("heatsinkSimulateStep not found");
+    // heatsinkSteadyState is optional, fall back to heatsinkSimulateStep
+    hSteadyState = lookup(heatsink,"heatsinkSteadyState");
+    if(hSteadyState.object==nullptr)
+        hSteadyState = hSimulateStep;
+
+    // In place functions get numpy arrays if numpy is available,
+    // memoryviews of doubles otherwise
+    frombuffer = nullptr;
+    auto numpy = PyImport_ImportModule("numpy");
+    if(numpy)
+    {
+        frombuffer = check(PyObject_GetAttrString(numpy,"frombuffer"));
+        Py_DECREF(numpy);
+    } else PyErr_Clear();
 
     auto pyargs   = check(PyTuple_New(8));
     PyTuple_SetItem(pyargs,0,check(PyLong_FromLong(nRows)));
@@ -88,10 +102,31 @@ PythonWrapper::PythonWrapper(unsigned int nRows, unsigned int nCols,
 void PythonWrapper::simulateStep(const double *spreaderTemperatures,
                                        double *heatFlow)
 {
-//FIXME: using numpy arrays should be more performant, but all I got was segfaults
-// long int sizes[1];
-// sizes[0]=size;
-// auto pyargs=check(PyArray_SimpleNewFromData(1,sizes,NPY_DOUBLE,(void*)heatFlow));
+    call(hSimulateStep,spreaderTemperatures,heatFlow);
+}
+
+void PythonWrapper::steadyState(const double *spreaderTemperatures,
+                                      double *heatFlow)
+{
+    call(hSteadyState,spreaderTemperatures,heatFlow);
+}
+
+void PythonWrapper::call(const Function& function,
+                         const double *spreaderTemperatures,
+                               double *heatFlow)
+{
+    if(function.inPlace)
+    {
+        // No copies, the arrays are valid only during the call
+        auto pyargs = check(PyTuple_New(2));
+        PyTuple_SetItem(pyargs,0,wrap(spreaderTemperatures,false));
+        PyTuple_SetItem(pyargs,1,wrap(heatFlow,true));
+
+        // If function throws a python exception, check fails and a C++ exception is thrown
+        Py_DECREF(check(PyObject_CallObject(function.object,pyargs)));
+        Py_DECREF(pyargs);
+        return;
+    }
 
     //The list of spreader temperatures is made every time
     auto list=check(PyList_New(size));
@@ -102,13 +137,13 @@ void PythonWrapper::simulateStep(const double *spreaderTemperatures,
     PyTuple_SetItem(pyargs,0,list);
 
     // If function throws a python exception, check fails and a C++ exception is thrown
-    auto retVal=check(PyObject_CallObject(hSimulateStep,pyargs));
+    auto retVal=check(PyObject_CallObject(function.object,pyargs));
     Py_DECREF(pyargs);
 
     if(PyList_Check(retVal)==false)
-        throw runtime_error("heatsinkSimulateStep did not return heat flow list");
+        throw runtime_error("heatsink function did not return heat flow list");
     if(PyList_GET_SIZE(retVal)!=size)
-        throw runtime_error("heatsinkSimulateStep returned heat flow wrong size");
+        throw runtime_error("heatsink function returned heat flow wrong size");
     for(unsigned int i=0;i<size;i++)
         heatFlow[i]=PyFloat_AsDouble(PyList_GetItem(retVal,i));
     
@@ -127,3 +162,26 @@ PyObject *PythonWrapper::check(PyObject *object)
     PyErr_Print();
     throw runtime_error("python API returned error");
 }
+
+PythonWrapper::Function PythonWrapper::lookup(PyObject *module, const char *name)
+{
+    // The in place version takes precedence
+    string inPlaceName=string(name)+"InPlace";
+    if(PyObject_HasAttrString(module,inPlaceName.c_str()))
+        return { check(PyObject_GetAttrString(module,inPlaceName.c_str())), true };
+    if(PyObject_HasAttrString(module,name))
+        return { check(PyObject_GetAttrString(module,name)), false };
+    return { nullptr, false };
+}
+
+PyObject *PythonWrapper::wrap(const double *data, bool writable)
+{
+    auto bytes=check(PyMemoryView_FromMemory(const_cast<char*>(
+        reinterpret_cast<const char*>(data)),size*sizeof(double),
+        writable ? PyBUF_WRITE : PyBUF_READ));
+    PyObject *result;
+    if(frombuffer) result=PyObject_CallFunction(frombuffer,"O",bytes);
+    else result=PyObject_CallMethod(bytes,"cast","s","d");
+    Py_DECREF(bytes);
+    return check(result);
+}
@@ -54,14 +54,39 @@ public:
     void simulateStep(const double *spreaderTemperatures,
                             double *heatFlow);
 
+    void steadyState(const double *spreaderTemperatures,
+                           double *heatFlow);
+
     ~PythonWrapper();
 
 private:
+    /**
+     * A python heatsink function. In place functions receive the spreader
+     * temperatures and the heat flow as arrays over the memory of 3D-ICE
+     * and fill the heat flow, the others receive a list of spreader
+     * temperatures and return a list of heat flows
+     */
+    struct Function
+    {
+        PyObject *object;
+        bool inPlace;
+    };
+
     PyObject *check(PyObject *object);
 
+    Function lookup(PyObject *module, const char *name);
+
+    PyObject *wrap(const double *data, bool writable);
+
+    void call(const Function& function,
+              const double *spreaderTemperatures,
+                    double *heatFlow);
+
     unsigned int size;
     void *so;
-    PyObject *hSimulateStep;
+    PyObject *frombuffer; // numpy.frombuffer, nullptr without numpy
+    Function hSimulateStep;
+    Function hSteadyState;
 };
 
 #endif //PYTHONWRAPPER_H
@@ -44,23 +44,31 @@
 using namespace std;
 using namespace std::chrono;
 
-static unsigned int nRows, nCols;
+static unique_ptr<const CellMatrix> temperatures;
+static unique_ptr<CellMatrix> heatFlow;
 static unique_ptr<HeatSink> heatsink;
 static Profiler profiler;
 
-int heatsink_init(unsigned int nrows, unsigned int ncols,
-                  double cellwidth,   double celllength,
-                  double initialtemperature,
-                  double spreaderconductance,
-                  double timestep,
-                  const char *args)
+unsigned int heatsink_abi_version()
+{
+    return 2;
+}
+
+int heatsink_init_v2(unsigned int nrows, unsigned int ncols,
+                     double cellwidth,   double celllength,
+                     double initialtemperature,
+                     double spreaderconductance,
+                     const double *spreadertemperatures,
+                           double *heatflow,
+                     const char *args)
 {
     ProfileFunction pf(profiler);
-    nRows=nrows;
-    nCols=ncols;
     try {
+        temperatures=unique_ptr<const CellMatrix>(new CellMatrix(
+            const_cast<double*>(spreadertemperatures),nrows,ncols));
+        heatFlow=unique_ptr<CellMatrix>(new CellMatrix(heatflow,nrows,ncols));
         heatsink=unique_ptr<HeatSink>(new HeatSink(nrows,ncols,cellwidth,celllength,
-                                      initialtemperature,spreaderconductance,timestep,args));
+                                      initialtemperature,spreaderconductance,args));
         return 0;
     } catch(exception& e) {
         cerr<<"exception thrown: "<<e.what()<<endl;
@@ -68,14 +76,50 @@ int heatsink_init(unsigned int nrows, unsigned int ncols,
     }
 }
 
-int heatsink_simulate_step(const double *spreadertemperatures,
-                                 double *heatflow)
+int heatsink_simulate_v2(double time, double timestep)
 {
     ProfileFunction pf(profiler);
     try {
-        const CellMatrix t(const_cast<double*>(spreadertemperatures),nRows,nCols);
-        CellMatrix q(heatflow,nRows,nCols);
-        heatsink->simulateStep(t,q);
+        heatsink->simulateStep(time,timestep,*temperatures,*heatFlow);
+        return 0;
+    } catch(exception& e) {
+        cerr<<"exception thrown: "<<e.what()<<endl;
+        return -1;
+    }
+}
+
+int heatsink_steady_state_v2()
+{
+    ProfileFunction pf(profiler);
+    try {
+        heatsink->steadyState(*temperatures,*heatFlow);
+        return 0;
+    } catch(exception& e) {
+        cerr<<"exception thrown: "<<e.what()<<endl;
+        return -1;
+    }
+}
+
+size_t heatsink_state_size_v2()
+{
+    return heatsink->stateSize();
+}
+
+int heatsink_save_state_v2(void *state)
+{
+    try {
+        heatsink->saveState(state);
+        return 0;
+    } catch(exception& e) {
+        cerr<<"exception thrown: "<<e.what()<<endl;
+        return -1;
+    }
+}
+
+int heatsink_restore_state_v2(const void *state)
+{
+    try {
+        heatsink->restoreState(state);
         return 0;
     } catch(exception& e) {
         cerr<<"exception thrown: "<<e.what()<<endl;
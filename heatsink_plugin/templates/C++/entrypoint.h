@@ -41,19 +41,40 @@
 
 #include <chrono>
 #include <stdexcept>
+#include <cstddef>
 
 // This is the public interface that a heatsink plugin has to
 // implement. Functions need to have C linkage to be callable
 // from 3D-ICE
+//
+// This template implements version 2 of the interface, selected by
+// exporting heatsink_abi_version. Plugins that do not export it implement
+// version 1 (heatsink_init and heatsink_simulate_step, see the loaders),
+// where temperatures and heat flows are passed at each step
 extern "C" {
-int heatsink_init(unsigned int nrows, unsigned int ncols,
-                  double cellwidth,   double celllength,
-                  double initialtemperature,
-                  double spreaderconductance,
-                  double timestep,
-                  const char *args);
-int heatsink_simulate_step(const double *spreadertemperatures,
-                                 double *heatflow);
+unsigned int heatsink_abi_version();
+// The spreadertemperatures and heatflow buffers are registered once, and
+// remain valid until the end of the simulation. They are the ones 3D-ICE
+// solves on, so the heatflow buffer has to be written in full at each call
+int heatsink_init_v2(unsigned int nrows, unsigned int ncols,
+                     double cellwidth,   double celllength,
+                     double initialtemperature,
+                     double spreaderconductance,
+                     const double *spreadertemperatures,
+                           double *heatflow,
+                     const char *args);
+// Advances the heatsink from time to time+timestep, reading the
+// spreadertemperatures buffer and writing the heatflow one
+int heatsink_simulate_v2(double time, double timestep);
+// Optional, used by steady state simulations. If not exported, 3D-ICE
+// calls heatsink_simulate_v2 until the heatsink settles, which requires
+// the state save/restore entry points to undo those calls afterwards
+int heatsink_steady_state_v2();
+// Optional, either all or none, used to save and restore the state
+// of the heatsink, such as when forking a simulation
+size_t heatsink_state_size_v2();
+int heatsink_save_state_v2(void *state);
+int heatsink_restore_state_v2(const void *state);
 }
 
 // Comment out to disable bound checking in CellMatrix
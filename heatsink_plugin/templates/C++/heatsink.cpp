@@ -53,7 +53,6 @@ HeatSink::HeatSink(unsigned int nRows, unsigned int nCols,
                    double cellWidth,   double cellLength,
                    double initialTemperature,
                    double spreaderConductance,
-                   double timeStep,
                    const string& args)
 {
     /*
@@ -66,8 +65,6 @@ HeatSink::HeatSink(unsigned int nRows, unsigned int nCols,
      *   spreader cell to its top face. NOTE: in most simulation cases you have
      *   to add the conductance between the top face of the spreader and the
      *   center of the bottommost cell of the heat sink.
-     *
-     * - timeStep is the simuation time step.
      */
     
     cout.setf(ios::fixed);
@@ -80,7 +77,6 @@ HeatSink::HeatSink(unsigned int nRows, unsigned int nCols,
     P(cellLength);
     P(initialTemperature);
     P(spreaderConductance);
-    P(timeStep);
     P(args);
     #undef P
     
@@ -94,10 +90,15 @@ HeatSink::HeatSink(unsigned int nRows, unsigned int nCols,
     this->ambientTemperature=initialTemperature;
 }
 
-void HeatSink::simulateStep(const CellMatrix spreaderTemperatures,
+void HeatSink::simulateStep(double time, double timeStep,
+                            const CellMatrix spreaderTemperatures,
                                   CellMatrix heatFlow)
 {
     /*
+     * time is the simulation time at the beginning of the step, and timeStep
+     * its duration. Successive calls may have a different timeStep, as it
+     * is the time elapsed since the previous call.
+     *
      * spreaderTemperatures are the temperatures in Kelvin of the layer of cells
      * of the spreader computed by 3D-ICE.
      *
@@ -122,4 +123,34 @@ void HeatSink::simulateStep(const CellMatrix spreaderTemperatures,
                 conductance*(spreaderTemperatures.at(r,c)-ambientTemperature);
 }
 
+void HeatSink::steadyState(const CellMatrix spreaderTemperatures,
+                                 CellMatrix heatFlow)
+{
+    /*
+     * Same as simulateStep, but heatFlow has to be the heat flow once the
+     * heatsink has reached its steady state with the given spreader
+     * temperatures, that 3D-ICE iterates until convergence. The function
+     * should not alter the transient state of the heatsink.
+     */
+    
+    // The example heatsink has no thermal capacitance, so it is always
+    // at steady state
+    simulateStep(0.0,0.0,spreaderTemperatures,heatFlow);
+}
+
+size_t HeatSink::stateSize() const
+{
+    /*
+     * The state is the part of the heatsink that changes during a simulation,
+     * saved and restored by 3D-ICE as an opaque buffer of stateSize() bytes.
+     */
+    
+    // The example heatsink has no thermal capacitance, so no state
+    return 0;
+}
+
+void HeatSink::saveState(void *state) const {}
+
+void HeatSink::restoreState(const void *state) {}
+
 HeatSink::~HeatSink() {}
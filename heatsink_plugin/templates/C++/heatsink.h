@@ -54,12 +54,21 @@ public:
              double cellWidth,   double cellLength,
              double initialTemperature,
              double spreaderConductance,
-             double timeStep,
              const std::string& args);
 
-    void simulateStep(const CellMatrix spreaderTemperatures,
+    void simulateStep(double time, double timeStep,
+                      const CellMatrix spreaderTemperatures,
                             CellMatrix heatFlow);
 
+    void steadyState(const CellMatrix spreaderTemperatures,
+                           CellMatrix heatFlow);
+
+    size_t stateSize() const;
+
+    void saveState(void *state) const;
+
+    void restoreState(const void *state);
+
     ~HeatSink();
 
 private:
@@ -37,7 +37,15 @@
  ##############################################################################
 
 # This is just a template, write your heatsink code here
-# by implementing the heatsinkInit and heatsinkSimulateStep functions
+# by implementing the heatsinkInit and heatsinkSimulateStepInPlace functions.
+# The heatsinkSteadyStateInPlace function is optional, and used by steady
+# state simulations.
+#
+# The in place functions receive the spreader temperatures and the heat flow
+# as numpy arrays (memoryviews of doubles if numpy is not installed) sharing
+# the memory of 3D-ICE, so they must not be kept after the call. Functions
+# named without InPlace, taking a list of spreader temperatures and returning
+# a list of heat flows, are also accepted but slower
 
 ambientTemperature=0;
 conductance=0;
@@ -61,11 +69,16 @@ def heatsinkInit(nRows,nCols,cellWidth,cellLength,initialTemperature,spreaderCon
     conductance=parallel(spreaderConductance,ambientConductance)
     ambientTemperature=initialTemperature
 
-def heatsinkSimulateStep(spreaderTemperatures):
+def heatsinkSimulateStepInPlace(spreaderTemperatures,heatFlow):
     # See the C++ plugin comments for this
     global ambientTemperature
     global conductance
-    heatFlow=[]
-    for i in range(len(spreaderTemperatures)):
-        heatFlow.append(conductance*(spreaderTemperatures[i]-ambientTemperature))
-    return heatFlow
+    # Writes into the array of 3D-ICE without copies. With the memoryviews
+    # passed if numpy is not installed, loop on the elements instead:
+    # for i in range(len(spreaderTemperatures)):
+    #     heatFlow[i]=conductance*(spreaderTemperatures[i]-ambientTemperature)
+    heatFlow[:]=conductance*(spreaderTemperatures-ambientTemperature)
+
+def heatsinkSteadyStateInPlace(spreaderTemperatures,heatFlow):
+    # The example heatsink has no thermal capacitance
+    heatsinkSimulateStepInPlace(spreaderTemperatures,heatFlow)
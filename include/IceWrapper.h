@@ -47,6 +47,14 @@
 #include <systemc.h>
 #include <string>
 #include <fstream>
+#include <map>
+#include <vector>
+#include <deque>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 #include "network_socket.h"
 #include "network_message.h"
@@ -57,6 +65,11 @@
  * This class provides support to bind 3D-ICE with simulation tools based on
  * SystemC/TLM2.0 like <a href="http://www.uni-kl.de/3d-dram/tools/dramsys/">DRAMSys</a>,
  * <a href="http://www.es.ele.tue.nl/drampower/">DRAMPower</a>, and many others.
+ *
+ * The requests are exchanged with the server by a background thread, in the
+ * order they are made. The methods ending in Async return at once with a
+ * future, so that SystemC can go on simulating while the server works, and
+ * the other methods wait for the reply (and for the requests still pending).
  */
 class IceWrapper
 {
@@ -68,6 +81,7 @@ class IceWrapper
     NetworkMessage_t client_nflp,
                      client_powers,
                      client_simulate,
+                     client_tick,
                      client_tmap,
                      client_temperatures,
                      server_reply;
@@ -75,7 +89,32 @@ class IceWrapper
     // 3D Structure related:
     unsigned int numberOfFloorplanElements;
 
+    // Version of the protocol negotiated with the server:
+    unsigned int protocolVersion;
+
+    // Delta encoding of the thermal state and maps (0 if not enabled) and
+    // the last values received:
+    double bulkResolution;
+    BulkReference_t stateReference;
+    std::map<std::string, BulkReference_t> mapReferences;
+
+    // Background thread exchanging the requests with the server, and the
+    // requests it has still to send:
+    std::thread ioThread;
+    std::mutex ioLock;
+    std::condition_variable ioChanged;
+    std::deque<std::function<void()>> ioRequests;
+    unsigned int ioPending;
+    bool ioStop;
+
   public:
+    /*! Temperatures sent by the server with the simulated time they refer to */
+    struct Output
+    {
+        double time;
+        std::vector<float> values;
+    };
+
     /*! IceWrapper constructor
      *
      * Establishes a connection with the 3D-ICE server and gets information
@@ -84,9 +123,12 @@ class IceWrapper
      *
      * \param serverIp the IP address of the server
      * \param portNumber the port number of the server
+     * \param stackFile the stack to simulate, among the ones the server
+     *                  hosts (requires the protocol version 9). If empty,
+     *                  the one given to the server
      *
      */
-    IceWrapper(std::string serverIp, unsigned int portNumber);
+    IceWrapper(std::string serverIp, unsigned int portNumber, std::string stackFile = "");
 
     /*! IceWrapper destructor
      *
@@ -119,7 +161,71 @@ class IceWrapper
      */
     void getMap(OutputType_t type, std::string filename);
 
+    /*! Negotiates the version of the protocol with the server
+     *
+     * \return the version both client and server implement
+     */
+    unsigned int negotiateProtocol();
+
+    /*! Selects the stack the server simulates for this client
+     *
+     * \param stackFile the path of the stack file on the server
+     *
+     * \return \c true in case of success
+     * \return \c false if the server cannot read the file
+     */
+    bool selectModel(std::string stackFile);
+
+    /*! Body of the background thread: sends the requests posted, one at a
+     * time, until the wrapper is destroyed
+     */
+    void ioLoop();
+
+    /*! Posts a request to the background thread
+     *
+     * \param exchange the function sending the request and receiving the
+     *                 reply. It throws a std::runtime_error on failure.
+     *
+     * \return the future of the value returned by \p exchange
+     */
+    template <typename T> std::future<T> post(std::function<T()> exchange);
+
+    /*! Waits for a request posted to the background thread, reporting a
+     * fatal error if it failed
+     *
+     * \param reply the future returned by post
+     *
+     * \return the value of the reply
+     */
+    template <typename T> T wait(std::future<T> reply);
+
+    /*! Sends a request to the server and releases it, or receives a reply
+     * (to be released by the caller)
+     *
+     * \param message the request or the reply
+     *
+     * \throw std::runtime_error if the connection with the server fails
+     */
+    void sendMessage(NetworkMessage_t *message);
+    void receiveMessage(NetworkMessage_t *message);
+
+    /*! Exchanges with the server of the requests that can be posted to the
+     * background thread: the public methods with the same arguments post
+     * them, and these run there
+     */
+    void exchangePowerValues(std::vector<float> &powerValues);
+    void exchangeSimulate();
+    Output exchangeTemperature(OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
+    Output exchangeSimulate(std::vector<float> &powerValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
+    std::vector<double> exchangeThermalState();
+    std::vector<double> exchangeThermalMap(std::string stackElement, unsigned int &rows, unsigned int &columns);
+
   public:
+    /*! Waits until the server has replied to every request posted with the
+     * methods ending in Async
+     */
+    void synchronize();
+
     /*! Gets the number of floorplan elements
      *
      * \return the number of floorplan elements
@@ -137,6 +243,15 @@ class IceWrapper
      */
     void sendPowerValues(std::vector<float> *powerValues);
 
+    /*! Sends power information to the 3D-ICE server without waiting for
+     * the reply
+     *
+     * \param powerValues a vector containing the power values of all floorplan elements
+     *
+     * \return a future ready when the server has inserted the power values
+     */
+    std::future<void> sendPowerValuesAsync(std::vector<float> powerValues);
+
     /*! Requests the simulation of a time slot to the server.
      *
      * This function sends and receives messages using network sockets and it
@@ -144,6 +259,13 @@ class IceWrapper
      */
     void simulate();
 
+    /*! Requests the simulation of a time slot to the server without
+     * waiting for the result
+     *
+     * \return a future ready when the time slot has been simulated
+     */
+    std::future<void> simulateAsync();
+
     /*! Gets the temperature values regarding the last thermal simulation step
      *
      * \param TemperatureValues buffer to be filled with the temperature values
@@ -153,6 +275,44 @@ class IceWrapper
      */
     void getTemperature(std::vector<float> &TemperatureValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
 
+    /*! Requests the temperature values regarding the last thermal
+     * simulation step without waiting for them
+     *
+     * \param instant instant of time at which the inspection points generate the output
+     * \param type inspection point of interest
+     * \param quantity which of temperature records (e.g., average, maximum, minimum, gradient) shall be provided
+     *
+     * \return a future of the temperature values and of their time
+     */
+    std::future<Output> getTemperatureAsync(OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
+
+    /*! Sends the power values, simulates a time slot and gets the
+     * temperature values in a single exchange with the server
+     *
+     * It replaces a call to sendPowerValues, simulate and getTemperature,
+     * saving two round trips over the network.
+     *
+     * \param powerValues a vector containing the power values of all floorplan elements
+     * \param TemperatureValues buffer to be filled with the temperature values
+     * \param instant instant of time at which the inspection points generate the output
+     * \param type inspection point of interest
+     * \param quantity which of temperature records (e.g., average, maximum, minimum, gradient) shall be provided
+     */
+    void simulate(std::vector<float> *powerValues, std::vector<float> &TemperatureValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
+
+    /*! Sends the power values, simulates a time slot and gets the
+     * temperature values in a single exchange with the server, without
+     * waiting for it
+     *
+     * \param powerValues a vector containing the power values of all floorplan elements
+     * \param instant instant of time at which the inspection points generate the output
+     * \param type inspection point of interest
+     * \param quantity which of temperature records (e.g., average, maximum, minimum, gradient) shall be provided
+     *
+     * \return a future of the temperature values and of their time
+     */
+    std::future<Output> simulateAsync(std::vector<float> powerValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity);
+
     /*! Generates an output file containing values that correspond to a
      * thermal map of the stack element.
      *
@@ -166,6 +326,117 @@ class IceWrapper
      * \param filename name of the output file
      */
     void getPowerMap(std::string filename);
+
+    /*! Gets the temperature of every thermal cell of the stack, at full
+     * precision (requires the protocol version 2)
+     *
+     * \param TemperatureValues buffer to be filled with the temperature values
+     */
+    void getThermalState(std::vector<double> &TemperatureValues);
+
+    /*! Requests the temperature of every thermal cell of the stack without
+     * waiting for it (requires the protocol version 2)
+     *
+     * \return a future of the temperature values
+     */
+    std::future<std::vector<double>> getThermalStateAsync();
+
+    /*! Gets the thermal map of a stack element, at full precision
+     * (requires the protocol version 2)
+     *
+     * \param stackElement the name of a die or a layer of the stack
+     * \param TemperatureValues buffer to be filled with the map, row by row
+     * \param rows filled with the number of rows of the map
+     * \param columns filled with the number of columns of the map
+     */
+    void getThermalMap(std::string stackElement, std::vector<double> &TemperatureValues, unsigned int &rows, unsigned int &columns);
+
+    /*! Asks the server to send the thermal state and the thermal maps as
+     * changes since the last ones received, rounded to \p resolution
+     * (requires the protocol version 5). It saves most of the bandwidth for
+     * maps requested often, as they change slowly.
+     *
+     * \param resolution the resolution of the temperatures, in Kelvin
+     *
+     * \return \c true in case of success
+     * \return \c false if the server rejects the resolution
+     */
+    bool setBulkResolution(double resolution);
+
+    /*! Saves the thermal state of the simulation on the server (requires
+     * the protocol version 6)
+     *
+     * \return the handle of the saved state, valid for every client of
+     *         the server until deleted or until this client disconnects
+     * \return \c 0 if the state cannot be saved (too many states saved
+     *         or over the memory budget of the server)
+     */
+    unsigned int saveThermalState();
+
+    /*! Goes back to a thermal state saved with saveThermalState (requires
+     * the protocol version 6). The power values inserted since then are
+     * discarded, while the output files are not rolled back.
+     *
+     * \param handle the handle of the saved state
+     *
+     * \return \c true in case of success
+     * \return \c false if the handle is not valid
+     */
+    bool restoreThermalState(unsigned int handle);
+
+    /*! Deletes a thermal state saved with saveThermalState (requires the
+     * protocol version 6)
+     *
+     * \param handle the handle of the saved state
+     */
+    void deleteThermalState(unsigned int handle);
+
+    /*! Asks the server to simulate ahead the next time step while waiting
+     * for the next request (requires the protocol version 7). The results
+     * do not change, but a call to simulate a step that repeats the last
+     * power values returns without waiting for the solver.
+     *
+     * \param enable \c true to turn on the speculative steps
+     *
+     * \return \c true in case of success
+     * \return \c false if the simulation is not transient
+     */
+    bool setSpeculativeSteps(bool enable);
+
+    /*! Asks how far the server is in building the model (requires the
+     * protocol version 8). The other requests wait for the model to be
+     * ready, this one is answered at once.
+     *
+     * \param times filled with the seconds spent parsing the stack,
+     *              building and factorizing the model
+     *
+     * \return the phase the server is in
+     */
+    ModelPhase_t getModelStatus(float times[TDICE_MODEL_READY]);
+
+    /*! Gets the statistics of the server (requires the protocol version
+     * 10): the durations of the requests and of the phases of the
+     * simulation, and the memory used, in the text format of Prometheus.
+     * They are those of all the clients of the server.
+     *
+     * \param text filled with the statistics
+     */
+    void getStats(std::string &text);
+
+    /*! Gets a part of an output file written by the server (requires the
+     * protocol version 4). Called repeatedly with
+     * TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST it follows the file while the
+     * simulation goes on.
+     *
+     * \param fileName the name of the file, as in the stack description
+     * \param bytes buffer to be filled with the bytes of the file
+     * \param mode where the bytes to get start
+     * \param offset the offset of the first byte (TDICE_OUTPUT_FILES_FROM_OFFSET only)
+     * \param maxBytes the maximum number of bytes to get (0 means no limit)
+     *
+     * \return the offset of the first byte received
+     */
+    unsigned long long getOutputFile(std::string fileName, std::string &bytes, OutputFilesMode_t mode, unsigned long long offset = 0, unsigned int maxBytes = 0);
 };
 
 #endif /* ICEWRAPPER_H */
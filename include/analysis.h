@@ -87,9 +87,65 @@ extern "C"
 
         Temperature_t InitialTemperature ;
 
+        /*! Initial thermal state of a transient analysis: the uniform
+         *  initial temperature or the steady state solution for the
+         *  first (or the average) power values of the floorplan elements */
+
+        InitialState_t InitialState ;
+
         /*! Number of cores in parallel */
         Quantity_t NumOfCores ;
-        
+
+        /*! Number of slots integrated concurrently by the parareal driver.
+         *  The value \c 0 disables parareal (one step after the other) */
+
+        Quantity_t PararealWindows ;
+
+        /*! Maximum temperature change, between two parareal iterations,
+         *  below which the slot temperatures are considered converged */
+
+        Temperature_t PararealTolerance ;
+
+        /*! Maximum number of parareal iterations for a group of windows */
+
+        Quantity_t PararealIterations ;
+
+        /*! Solve the dies through their Schur complement, factorizing
+         *  identical dies only once */
+
+        bool Substructuring ;
+
+        /*! Number of tiles, along the rows and along the columns, in which
+         *  the grid is split by the domain decomposition driver. The value
+         *  \c 0 means that the grid is not decomposed */
+
+        Quantity_t TileRows, TileColumns ;
+
+        /*! Number of cells shared by adjacent tiles on each side */
+
+        Quantity_t TileOverlap ;
+
+        /*! Region of interest re-solved at a finer resolution by the
+         *  submodel: south-west corner (floorplan coordinates), length
+         *  and width. A length equal to \c 0 disables the submodel */
+
+        ChipDimension_t SubmodelX, SubmodelY, SubmodelLength, SubmodelWidth ;
+
+        /*! Length and width of the thermal cells of the submodel */
+
+        CellDimension_t SubmodelCellLength, SubmodelCellWidth ;
+
+        /*! Maximum number of solutions, within a step, used to converge
+         *  the temperature dependent leakage power of the floorplan elements */
+
+        Quantity_t LeakageIterations ;
+
+        /*! Maximum change of the temperature of the floorplan elements,
+         *  between two evaluations of their leakage, below which the
+         *  leakage power is considered converged */
+
+        Temperature_t LeakageTolerance ;
+
     } ;
 
     /*! Definition of the type Analysis_t */
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_CONTROLLER_H_
+#define _3DICE_CONTROLLER_H_
+
+/*! \file controller.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include "types.h"
+
+#include "analysis.h"
+#include "dimensions.h"
+#include "output.h"
+#include "stack_description.h"
+#include "thermal_data.h"
+
+/******************************************************************************/
+
+    /*! \struct Controller_t
+     *
+     *  \brief In-process dynamic thermal management (DTM) controller plugin
+     *
+     *  The controller is a shared object, loaded with \c dlopen , that is
+     *  called after every step and/or every slot of a transient simulation
+     *  in place of a client of the thermal server. It exports:
+     *
+     *  \code
+     *  int dtm_controller_init (unsigned int ncells, unsigned int nflpel,
+     *                           unsigned int nstepipoints,
+     *                           unsigned int nslotipoints,
+     *                           double steptime, double slottime,
+     *                           const char *args) ;
+     *
+     *  int dtm_controller_step (double time,
+     *                           const double *temperatures,
+     *                           const double *ipoints,
+     *                           double *powers, double *flowrate) ;
+     *
+     *  int dtm_controller_slot (double time,
+     *                           const double *temperatures,
+     *                           const double *ipoints,
+     *                           double *powers, double *flowrate) ;
+     *  \endcode
+     *
+     *  where at least one of \c dtm_controller_step and \c dtm_controller_slot
+     *  must be exported. \c temperatures are the \c ncells temperatures of
+     *  the thermal grid and \c ipoints the temperatures of the Tcell and
+     *  Tflpel inspection points of the step (or slot) output instant, in the
+     *  order they are declared in the stack file. \c powers contains the
+     *  \c nflpel power values of the next slot, taken from the floorplans in
+     *  the order used by \c TDICE_INSERT_POWERS , and \c flowrate the coolant
+     *  flow rate (ml/min, \c 0 without microchannels): the controller can
+     *  overwrite both. New power values are used from the next slot, a new
+     *  flow rate from the next step. The callbacks return \c 0 on success.
+     */
+
+    struct Controller_t
+    {
+        /*! The handle of the shared object */
+
+        void *Handle ;
+
+        /*! The step callback (\c NULL if not exported) */
+
+        int (*Step) (double time, const double *temperatures,
+                     const double *ipoints, double *powers, double *flowrate) ;
+
+        /*! The slot callback (\c NULL if not exported) */
+
+        int (*Slot) (double time, const double *temperatures,
+                     const double *ipoints, double *powers, double *flowrate) ;
+
+        /*! The number of floorplan elements in the stack */
+
+        Quantity_t NFloorplanElements ;
+
+        /*! The number of Tcell and Tflpel inspection points of the
+         *  step and of the slot output instants */
+
+        Quantity_t NStepPoints, NSlotPoints ;
+
+        /*! The power values given to the controller */
+
+        Power_t *Powers ;
+
+        /*! The temperatures of the inspection points of the step
+         *  and of the slot output instants */
+
+        Temperature_t *StepPoints, *SlotPoints ;
+    } ;
+
+    /*! Definition of the type Controller_t */
+
+    typedef struct Controller_t Controller_t ;
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a controller structure with default values
+     *
+     * \param controller the address of the structure to initalize
+     */
+
+    void controller_init (Controller_t *controller) ;
+
+
+
+    /*! Loads the controller plugin and initializes it
+     *
+     * \param controller the address of the Controller structure to build
+     * \param plugin     the path of the shared object
+     * \param args       the string given to the plugin as argument
+     * \param stkd       the address of the StackDescription structure
+     * \param analysis   the address of the Analysis structure
+     * \param output     the address of the Output structure
+     *
+     * \return \c TDICE_FAILURE if the plugin cannot be loaded, the memory
+     *                          allocation fails or the plugin reports an error
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t controller_build
+    (
+        Controller_t       *controller,
+        String_t            plugin,
+        String_t            args,
+        StackDescription_t *stkd,
+        Analysis_t         *analysis,
+        Output_t           *output
+    ) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a controller
+     *
+     * The function releases any dynamic memory used by the structure,
+     * unloads the plugin and resets its state calling \a controller_init .
+     *
+     * \param controller the address of the structure to destroy
+     */
+
+    void controller_destroy (Controller_t *controller) ;
+
+
+
+    /*! Calls the controller after a step or a slot and applies its decisions
+     *
+     * \param controller the address of the Controller structure
+     * \param tdata      the address of the ThermalData structure
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the address of the Analysis structure
+     * \param output     the address of the Output structure
+     * \param sim_result the value returned by \a emulate_step
+     *
+     * \return \c TDICE_FAILURE if the plugin reports an error or the new
+     *                          coolant flow rate cannot be set
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t controller_run
+    (
+        Controller_t  *controller,
+        ThermalData_t *tdata,
+        Dimensions_t  *dimensions,
+        Analysis_t    *analysis,
+        Output_t      *output,
+        SimResult_t    sim_result
+    ) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_CONTROLLER_H_ */
@@ -0,0 +1,312 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_DOMAIN_DECOMPOSITION_H_
+#define _3DICE_DOMAIN_DECOMPOSITION_H_
+
+/*! \file domain_decomposition.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stdbool.h>
+
+#include "types.h"
+
+#include "analysis.h"
+#include "dimensions.h"
+#include "halo_transport.h"
+#include "power_grid.h"
+#include "stack_element_list.h"
+#include "system_matrix.h"
+#include "thermal_grid.h"
+
+#include "slu_mt_ddefs.h"
+
+/******************************************************************************/
+
+    /*! \struct DomainNeighbour_t
+     *
+     *  \brief Cells exchanged with the process owning an adjacent tile
+     */
+
+    struct DomainNeighbour_t
+    {
+        /*! The rank of the process owning the tile */
+
+        Quantity_t Rank ;
+
+        /*! The number of cells sent to the neighbour */
+
+        CellIndex_t NSend ;
+
+        /*! The (local) index of the owned cells in the overlap of the neighbour */
+
+        CellIndex_t *SendCells ;
+
+        /*! The number of cells received from the neighbour */
+
+        CellIndex_t NReceive ;
+
+        /*! The (local) index of the halo cells owned by the neighbour */
+
+        CellIndex_t *ReceiveCells ;
+    } ;
+
+    /*! Definition of the type DomainNeighbour_t */
+
+    typedef struct DomainNeighbour_t DomainNeighbour_t ;
+
+/******************************************************************************/
+
+    /*! \struct DomainDecomposition_t
+     *
+     *  \brief Part of a (uniform) thermal grid simulated by one process
+     *
+     *  The grid is split in x/y tiles that include all the layers. Every
+     *  process owns one tile and assembles and factorizes only the system
+     *  matrix of its tile enlarged by \c Overlap cells (the subdomain).
+     *  The global system is solved with BiCGSTAB preconditioned by the
+     *  restricted additive Schwarz method: the subdomain factorizations
+     *  are applied independently and only the owned values are kept. The
+     *  halo temperatures are exchanged through a \c HaloTransport_t .
+     */
+
+    struct DomainDecomposition_t
+    {
+        /*! The channel connecting the processes (not owned) */
+
+        HaloTransport_t *Transport ;
+
+        /*! The number of tiles along the rows and along the columns */
+
+        Quantity_t NTileRows, NTileColumns ;
+
+        /*! The number of cells added to each side of the tile */
+
+        CellIndex_t Overlap ;
+
+        /*! The rows and columns owned by the process */
+
+        CellIndex_t FirstRow, LastRow, FirstColumn, LastColumn ;
+
+        /*! The rows and columns of the subdomain (tile and overlap) */
+
+        CellIndex_t WindowFirstRow, WindowLastRow, WindowFirstColumn, WindowLastColumn ;
+
+        /*! The number of cells of the subdomain */
+
+        CellIndex_t Size ;
+
+        /*! The global index of every cell of the subdomain */
+
+        CellIndex_t *Cells ;
+
+        /*! Whether a cell of the subdomain belongs to the tile */
+
+        bool *Owned ;
+
+        /*! The system matrix of the subdomain (halo temperatures set to zero) */
+
+        SystemMatrix_t SM_A ;
+
+        /*! Right hand side and solution of a subdomain solve */
+
+        double *Work ;
+
+        /*! SuperLU vector wrapping the Work array */
+
+        SuperMatrix SLUMatrix_Work ;
+
+        /*! The temperatures of the subdomain (halo updated after each solve) */
+
+        Temperature_t *Solution ;
+
+        /*! The right hand side of the subdomain */
+
+        double *Vector ;
+
+        /*! Vectors used by the Krylov solver */
+
+        double *Krylov ;
+
+        /*! The number of iterations of the last solve */
+
+        Quantity_t NIterations ;
+
+        /*! The number of adjacent tiles */
+
+        Quantity_t NNeighbours ;
+
+        /*! The cells exchanged with each adjacent tile (by increasing rank) */
+
+        DomainNeighbour_t *Neighbours ;
+
+        /*! Packing buffer for the messages */
+
+        double *Buffer ;
+
+        /*! The thermal grid (whole stack) */
+
+        ThermalGrid_t ThermalGrid ;
+
+        /*! The power grid (whole stack) */
+
+        PowerGrid_t PowerGrid ;
+
+        /*! The temperatures of the whole stack, gathered after each solve
+         *  by the process 0 only (NULL for the others) */
+
+        Temperature_t *Temperatures ;
+    } ;
+
+    /*! Definition of the type DomainDecomposition_t */
+
+    typedef struct DomainDecomposition_t DomainDecomposition_t ;
+
+/******************************************************************************/
+
+    /*! Inits the fields of the \a domain structure with default values
+     *
+     * \param domain the address of the structure to initalize
+     */
+
+    void domain_decomposition_init (DomainDecomposition_t *domain) ;
+
+
+
+    /*! Builds the subdomain of the calling process
+     *
+     * The number of tiles and the overlap are taken from \a analysis . The
+     * tile of the process is given by the rank of \a transport , that must
+     * connect as many processes as tiles.
+     *
+     * \param domain     the address of the DomainDecomposition to build
+     * \param transport  the transport connecting all the processes
+     * \param list       the list of stack elements (bottom first)
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the type of thermal analysis
+     *
+     * \return \c TDICE_FAILURE if the grid cannot be decomposed (non-uniform
+     *                          grid, pluggable heat sink, too many tiles),
+     *                          if the memory allocation fails or if the
+     *                          factorization fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t domain_decomposition_build
+    (
+        DomainDecomposition_t *domain,
+        HaloTransport_t       *transport,
+        StackElementList_t    *list,
+        Dimensions_t          *dimensions,
+        Analysis_t            *analysis
+    ) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a domain
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a domain_decomposition_init .
+     *
+     * \param domain the address of the structure to destroy
+     */
+
+    void domain_decomposition_destroy (DomainDecomposition_t *domain) ;
+
+
+
+    /*! Simulates a thermal step, as \a emulate_step
+     *
+     * All the processes must call the function together.
+     *
+     * \param domain     address of the DomainDecomposition structure
+     * \param dimensions address of the Dimensions structure
+     * \param analysis   address of the Analysis structure
+     *
+     * \return \c TDICE_WRONG_CONFIG if the parameters refer to a steady
+     *                               state simulation
+     * \return \c TDICE_END_OF_SIMULATION if the power traces are over
+     * \return \c TDICE_SOLVER_ERROR if the solver fails or a message
+     *                               cannot be exchanged
+     * \return \c TDICE_STEP_DONE or \c TDICE_SLOT_DONE otherwise
+     */
+
+    SimResult_t domain_decomposition_emulate_step
+    (
+        DomainDecomposition_t *domain,
+        Dimensions_t          *dimensions,
+        Analysis_t            *analysis
+    ) ;
+
+
+
+    /*! Executes a steady state simulation, as \a emulate_steady
+     *
+     * All the processes must call the function together.
+     *
+     * \param domain     address of the DomainDecomposition structure
+     * \param dimensions address of the Dimensions structure
+     * \param analysis   address of the Analysis structure
+     *
+     * \return \c TDICE_WRONG_CONFIG if the parameters refer to a transient
+     *                               simulation
+     * \return \c TDICE_SOLVER_ERROR if the solver fails or a message
+     *                               cannot be exchanged
+     * \return \c TDICE_END_OF_SIMULATION otherwise
+     */
+
+    SimResult_t domain_decomposition_emulate_steady
+    (
+        DomainDecomposition_t *domain,
+        Dimensions_t          *dimensions,
+        Analysis_t            *analysis
+    ) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_DOMAIN_DECOMPOSITION_H_ */
@@ -88,6 +88,16 @@ extern "C"
              to get the source vector */
 
         Power_t *Bpowers ;
+
+        /*! The number of floorplan elements having a leakage model */
+
+        Quantity_t NLeakages ;
+
+        /*! Leakage power of each floorplan element, evaluated at its
+         *  last temperature, to perform the mv-multiplication that adds
+         *  the leakage to the source vector. \c NULL if no leakage */
+
+        Power_t *Lpowers ;
     } ;
 
     /*! Definition of the type Floorplan_t */
@@ -202,6 +212,34 @@ extern "C"
 
 
 
+    /*! Restricts the floorplan to a rectangular region of the IC
+     *
+     * The ic elements are moved so that the point (\a origin_x, \a origin_y)
+     * becomes the south-west corner of the IC described by \a dimensions,
+     * the parts falling out of the IC are cut and the elements are aligned
+     * to its grid. The area of the floorplan elements is not changed, so
+     * that only the share of their power dissipated in the region is kept.
+     *
+     * \param floorplan  the floorplan structure (already filled)
+     * \param dimensions pointer to the structure storing the dimensions of
+     *                   the region
+     * \param origin_x   the X coordinate of the south-west corner of the region
+     * \param origin_y   the Y coordinate of the south-west corner of the region
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t crop_floorplan
+    (
+        Floorplan_t     *floorplan,
+        Dimensions_t    *dimensions,
+        ChipDimension_t  origin_x,
+        ChipDimension_t  origin_y
+    ) ;
+
+
+
     /*! Fills the source vector corresponding to a floorplan
      *
      *  \param floorplan    pointer to the floorplan placed on the source layer
@@ -219,6 +257,41 @@ extern "C"
 
 
 
+    /*! Evaluates the leakage power of the floorplan elements
+     *
+     *  The leakage power of every element having a leakage model is
+     *  computed at the average temperature of the element and stored
+     *  in \a Lpowers , to be added to a source vector with
+     *  \a fill_leakage_sources_floorplan .
+     *
+     *  \param floorplan    pointer to the floorplan placed on the source layer
+     *  \param dimensions   pointer to the structure storing the dimensions
+     *  \param temperatures pointer to the temperature of the South-West
+     *                      thermal cell of the layer where the floorplan
+     *                      is placed
+     *
+     *  \return the maximum change of the temperature of the elements since
+     *          the previous evaluation of their leakage power
+     */
+
+    Temperature_t update_leakage_floorplan
+
+        (Floorplan_t *floorplan, Dimensions_t *dimensions, Temperature_t *temperatures) ;
+
+
+
+    /*! Adds the leakage power of the floorplan elements to a source vector
+     *
+     *  \param floorplan pointer to the floorplan placed on the source layer
+     *  \param sources   pointer to the location of the source vector
+     *                   that corresponds to the South-West thermal cell
+     *                   of the layer where the floorplan is placed
+     */
+
+    void fill_leakage_sources_floorplan (Floorplan_t *floorplan, Source_t *sources) ;
+
+
+
     /*! Returns the total number of floorplan elements in the floorplan
      *
      * \param floorplan address of the Floorplan structure
@@ -270,6 +343,85 @@ extern "C"
 
 
 
+    /*! Duplicates, at the beginning of the power queue of each floorplan
+     *  element, its next power value or the average of its power values
+     *
+     *  The next call to \a fill_sources_floorplan consumes the inserted
+     *  values and leaves the power queues as they were.
+     *
+     *  \param floorplan pointer to the floorplan
+     *  \param average   \c true to insert the average power values
+     *
+     *  \return \c TDICE_FAILURE if the power queue of at least one floorplan
+     *                           element is empty
+     *  \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t repeat_power_values_floorplan (Floorplan_t *floorplan, bool average) ;
+
+
+
+    /*! Copies the next power value of each floorplan element, i.e. the one
+     *  that the next call to \a fill_sources_floorplan will consume
+     *
+     *  \param floorplan pointer to the floorplan
+     *  \param pvalues   the array where to store the power values (\c 0 for
+     *                   the elements with an empty power queue)
+     *
+     *  \return the number of floorplan elements
+     */
+
+    Quantity_t get_next_power_values_floorplan
+
+        (Floorplan_t *floorplan, Power_t *pvalues) ;
+
+
+
+    /*! Replaces the next power value of each floorplan element, if its
+     *  power queue is not empty
+     *
+     *  \param floorplan pointer to the floorplan
+     *  \param pvalues   the new power values, one per floorplan element
+     *
+     *  \return the number of floorplan elements
+     */
+
+    Quantity_t replace_next_power_values_floorplan
+
+        (Floorplan_t *floorplan, Power_t *pvalues) ;
+
+
+
+    /*! Copies the power queue of each floorplan element into \a pqueues
+     *
+     *  \param floorplan pointer to the floorplan
+     *  \param pqueues   the power queues where to copy the power values,
+     *                   one per floorplan element (already initialized)
+     *
+     *  \return the number of floorplan elements
+     */
+
+    Quantity_t save_power_values_floorplan
+
+        (Floorplan_t *floorplan, PowersQueue_t *pqueues) ;
+
+
+
+    /*! Replaces the power queue of each floorplan element with a copy of
+     *  the one saved in \a pqueues by \a save_power_values_floorplan
+     *
+     *  \param floorplan pointer to the floorplan
+     *  \param pqueues   the power queues to copy, one per floorplan element
+     *
+     *  \return the number of floorplan elements
+     */
+
+    Quantity_t restore_power_values_floorplan
+
+        (Floorplan_t *floorplan, PowersQueue_t *pqueues) ;
+
+
+
     /*! Returns the maximum temperature of each floorplan element
      *  in the given floorplan
      *
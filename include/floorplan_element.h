@@ -56,6 +56,7 @@ extern "C"
 #include "dimensions.h"
 #include "ic_element_list.h"
 #include "powers_queue.h"
+#include "leakage.h"
 
 /******************************************************************************/
 
@@ -90,6 +91,11 @@ extern "C"
          *  the floorplan element during the thermal simulation */
 
         PowersQueue_t *PowerValues ;
+
+        /*! The temperature dependent leakage power added to the power
+         *  values, \c NULL if the floorplan element has no leakage */
+
+        Leakage_t *Leakage ;
     } ;
 
     /*! Definition of the type FloorplanElement_t */
@@ -0,0 +1,187 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_HALO_TRANSPORT_H_
+#define _3DICE_HALO_TRANSPORT_H_
+
+/*! \file halo_transport.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stddef.h>
+
+#include "types.h"
+#include "string_t.h"
+
+/******************************************************************************/
+
+    /*! \struct HaloTransport_t
+     *
+     *  \brief Point to point channel between the processes that share a
+     *         decomposed thermal grid
+     *
+     *  Messages are blocking and delivered in order between each pair of
+     *  processes: they fail, instead of blocking forever, if the other
+     *  process exits. A new transport is added by providing the functions
+     *  of the table and the private data they use.
+     */
+
+    struct HaloTransport_t
+    {
+        /*! The index of this process (0 .. NProcesses - 1) */
+
+        Quantity_t Rank ;
+
+        /*! The number of processes connected by the transport */
+
+        Quantity_t NProcesses ;
+
+        /*! The private state of the implementation */
+
+        void *Data ;
+
+        /*! Sends \a bytes bytes to the process \a to
+         *
+         *  Returns only when the message can be reused by the caller
+         */
+
+        Error_t (*Send)
+
+            (struct HaloTransport_t *transport,
+             Quantity_t to, const void *message, size_t bytes) ;
+
+        /*! Receives \a bytes bytes from the process \a from */
+
+        Error_t (*Receive)
+
+            (struct HaloTransport_t *transport,
+             Quantity_t from, void *message, size_t bytes) ;
+
+        /*! Releases the private state of the implementation */
+
+        void (*Close) (struct HaloTransport_t *transport) ;
+    } ;
+
+    /*! Definition of the type HaloTransport_t */
+
+    typedef struct HaloTransport_t HaloTransport_t ;
+
+/******************************************************************************/
+
+    /*! Inits the fields of the \a transport structure with default values
+     *
+     * \param transport the address of the structure to initalize
+     */
+
+    void halo_transport_init (HaloTransport_t *transport) ;
+
+
+
+    /*! Connects \a nprocesses processes
+     *
+     * Every process must call the function with the same \a address and
+     * \a nprocesses and with a different \a rank . Two transports are
+     * available:
+     *
+     *   - "shm:name" a shared memory segment (processes on the same host)
+     *   - "tcp:address:port" a TCP connection between every pair of
+     *     processes. The process \a rank listens on \a port + \a rank
+     *     at the (dotted) \a address .
+     *
+     * \param transport  the address of the HaloTransport to connect
+     * \param address    the kind and the address of the transport
+     * \param rank       the index of the calling process
+     * \param nprocesses the number of processes to connect
+     *
+     * \return \c TDICE_FAILURE if the address is not valid or the
+     *                          connection fails. A message will be printed
+     *                          on standard error
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t halo_transport_connect
+    (
+        HaloTransport_t *transport,
+        String_t         address,
+        Quantity_t       rank,
+        Quantity_t       nprocesses
+    ) ;
+
+
+
+    /*! Sums \a size values over all the processes
+     *
+     * Partial sums are added in the order of the ranks by the process 0 so
+     * that every process gets exactly the same result.
+     *
+     * \param transport the address of the HaloTransport
+     * \param values    the local values, overwritten with the sums
+     * \param size      the number of values (at most 8)
+     *
+     * \return \c TDICE_FAILURE if a message cannot be exchanged
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t halo_transport_sum
+    (
+        HaloTransport_t *transport,
+        double          *values,
+        Quantity_t       size
+    ) ;
+
+
+
+    /*! Disconnects the process and releases the transport
+     *
+     * \param transport the address of the structure to destroy
+     */
+
+    void halo_transport_destroy (HaloTransport_t *transport) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_HALO_TRANSPORT_H_ */
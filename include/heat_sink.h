@@ -136,6 +136,39 @@ extern "C"
         /*! The pluggable heatsink callback */
         int (*PluggableHeatsink)(const double *spreadertemperatures,
                                        double *sinkheatflows);
+
+        /*! The pluggable heatsink steady state callback, optional: it
+            returns the heat flows of the heatsink at steady state for the
+            given spreader temperatures. NULL if the plugin does not
+            provide it, in which case the step callback is called until
+            the heatsink settles, on a saved state restored afterwards */
+        int (*PluggableHeatsinkSteady)(const double *spreadertemperatures,
+                                             double *sinkheatflows);
+
+        /*! The pluggable heatsink communication interval callback, optional:
+            it is told the number of thermal steps between two calls of
+            the step callback. NULL if the plugin does not provide it */
+        int (*PluggableHeatsinkInterval)(unsigned int steps);
+
+        /*! Number of thermal steps between two calls of the pluggable
+            heatsink callback (communication interval), only for
+            pluggable heatsink */
+
+        Quantity_t CommunicationSteps;
+
+        /*! Linearly extrapolate the heat flows between two calls of the
+            callback, instead of holding the last ones */
+
+        bool Extrapolate;
+
+        /*! Number of thermal steps simulated since the initialization */
+
+        Quantity_t CurrentStep;
+
+        /*! Heat flows returned by the last two calls of the callback, used
+            between two calls. NULL if the communication interval is 1 */
+
+        double *HeatFlows, *PreviousHeatFlows;
      };
 
     /*! Definition of the type HeatSink_t */
@@ -267,6 +300,78 @@ extern "C"
      */
     Error_t initialize_pluggable_heatsink(HeatSink_t *hsink, Analysis_t *analysis);
 
+    /*! Registers the spreader cells of the temperatures and sources of the
+     *  thermal data with the pluggable heatsink. Plugins implementing the
+     *  version 2 of the ABI read and write them in place, and are
+     *  initialized here. The callbacks must then be given these buffers
+     *
+     * \param hsink the heatsink
+     * \param spreadertemperatures the temperatures of the spreader cells
+     * \param heatflows the sources of the spreader cells
+     *
+     * \return \c TDICE_FAILURE if the plugin initialization fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+    Error_t register_pluggable_heatsink_buffers(HeatSink_t *hsink,
+                                                const double *spreadertemperatures,
+                                                      double *heatflows);
+
+    /*! Computes the heat flows from the spreader to the pluggable heatsink
+     *  for the current thermal step. The callback is called once every
+     *  communication interval, the heat flows it returned are held (or
+     *  extrapolated) in the steps in between
+     *
+     * \param hsink the heatsink
+     * \param spreadertemperatures the temperatures of the spreader cells
+     * \param heatflows the heat flows (output, positive from the spreader
+     *                  to the heatsink)
+     * \param time the simulated time at the beginning of the step
+     *
+     * \return \c TDICE_FAILURE if the callback reports an error
+     * \return \c TDICE_SUCCESS otherwise
+     */
+    Error_t pluggable_heatsink_heat_flows(HeatSink_t *hsink,
+                                          const double *spreadertemperatures,
+                                                double *heatflows,
+                                                Time_t  time);
+
+    /*! Returns the size of the state of the pluggable heatsink, which
+     *  includes the state of the plugin. Only plugins implementing the
+     *  version 2 of the ABI and its state save/restore entry points
+     *  support it
+     *
+     * \param hsink the heatsink
+     *
+     * \return the size in bytes of the state
+     * \return \c 0 if the heatsink does not support state save/restore
+     */
+    size_t get_pluggable_heatsink_state_size(HeatSink_t *hsink);
+
+    /*! Saves the state of the pluggable heatsink
+     *
+     * \param hsink the heatsink
+     * \param state the buffer where to save the state, whose size is
+     *              given by \a get_pluggable_heatsink_state_size
+     *
+     * \return \c TDICE_FAILURE if the heatsink does not support it or
+     *                          the plugin reports an error
+     * \return \c TDICE_SUCCESS otherwise
+     */
+    Error_t save_pluggable_heatsink_state(HeatSink_t *hsink, void *state);
+
+    /*! Restores the state of the pluggable heatsink previously saved
+     *  with \a save_pluggable_heatsink_state
+     *
+     * \param hsink the heatsink
+     * \param state the buffer with the saved state
+     *
+     * \return \c TDICE_FAILURE if the heatsink does not support it or
+     *                          the plugin reports an error
+     * \return \c TDICE_SUCCESS otherwise
+     */
+    Error_t restore_pluggable_heatsink_state(HeatSink_t *hsink,
+                                             const void *state);
+
     /*! \return the thermal capacity of a cell in the heat spreader */
     Capacity_t get_spreader_capacity(HeatSink_t *hsink);
     
@@ -317,6 +317,27 @@ extern "C"
 
 
 
+    /*! Returns the temperature measured by a Tcell or a Tflpel inspection
+     *  point, i.e. those reporting a single value
+     *
+     * \param ipoint the address of the InspectionPoint structure
+     * \param dimensions the address of the dimension structure
+     * \param temperatures pointer to the first element of the temparature array
+     *
+     * \return the temperature of the thermal cell or the quantity (max, min,
+     *         avg, gradient) of the temperatures of the floorplan element
+     * \return \c 0 if the inspection point is of another type
+     */
+
+    Temperature_t get_inspection_point_temperature
+    (
+        InspectionPoint_t *ipoint,
+        Dimensions_t      *dimensions,
+        Temperature_t     *temperatures
+    ) ;
+
+
+
     /*! Fills a message with the output implemented by the inspection point
      *
      * \param ipoint the address of the InspectionPoint structure
@@ -0,0 +1,238 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_LEAKAGE_H_
+#define _3DICE_LEAKAGE_H_
+
+/*! \file leakage.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stdio.h> // For the file type FILE
+
+#include "types.h"
+#include "string_t.h"
+
+/******************************************************************************/
+
+    /*! \struct Leakage_t
+     *  \brief  Temperature dependent leakage power of a floorplan element
+     *
+     *  The leakage power is evaluated from the average temperature of the
+     *  floorplan element and added to its dynamic power (the one given
+     *  through the power values) when the source vector is built.
+     */
+
+    struct Leakage_t
+    {
+        /*! The model used to compute the leakage power */
+
+        LeakageModel_t Model ;
+
+        /*! Exponential model: the leakage power at the
+         *  reference temperature, in \f$ W \f$ */
+
+        Power_t Power ;
+
+        /*! Exponential model: the exponent coefficient, in \f$ K^{-1} \f$ */
+
+        double Coefficient ;
+
+        /*! Exponential model: the reference temperature, in \f$ K \f$ */
+
+        Temperature_t Reference ;
+
+        /*! Piecewise linear model: the number of (temperature, power)
+         *  points, sorted by increasing temperature */
+
+        Quantity_t NPoints ;
+
+        /*! Piecewise linear model: the temperatures of the points */
+
+        Temperature_t *Temperatures ;
+
+        /*! Piecewise linear model: the powers of the points */
+
+        Power_t *Powers ;
+
+        /*! The temperature at which the leakage power has been evaluated
+         *  the last time */
+
+        Temperature_t Temperature ;
+    } ;
+
+    /*! Definition of the type Leakage_t */
+
+    typedef struct Leakage_t Leakage_t ;
+
+
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a leakage structure with default values
+     *
+     * \param leakage the address of the structure to initalize
+     */
+
+    void leakage_init (Leakage_t *leakage) ;
+
+
+
+    /*! Copies the structure \a src into \a dst , as an assignement
+     *
+     * The function destroys the content of \a dst and then makes the copy
+     *
+     * \param dst the address of the left term sructure (destination)
+     * \param src the address of the right term structure (source)
+     */
+
+    void leakage_copy (Leakage_t *dst, Leakage_t *src) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a leakage
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a leakage_init .
+     *
+     * \param leakage the address of the structure to destroy
+     */
+
+    void leakage_destroy (Leakage_t *leakage) ;
+
+
+
+    /*! Allocates memory for a structure of type Leakage_t
+     *
+     * The content of the new structure is set to default values
+     * calling \a leakage_init
+     *
+     * \return the pointer to the new structure
+     * \return \c NULL if the memory allocation fails
+     */
+
+    Leakage_t *leakage_calloc (void) ;
+
+
+
+    /*! Allocates memory for a new copy of the structure \a leakage
+     *
+     * \param leakage the address of the structure to clone
+     *
+     * \return a pointer to a new structure
+     * \return \c NULL if the memory allocation fails
+     * \return \c NULL if the parameter \a leakage is \c NULL
+     */
+
+    Leakage_t *leakage_clone (Leakage_t *leakage) ;
+
+
+
+    /*! Frees the memory space pointed by \a leakage
+     *
+     * The function destroys the structure \a leakage and then frees
+     * its memory. The pointer \a leakage must have been returned by
+     * a previous call to \a leakage_calloc or \a leakage_clone .
+     *
+     * If \a leakage is \c NULL, no operation is performed.
+     *
+     * \param leakage the pointer to free
+     */
+
+    void leakage_free (Leakage_t *leakage) ;
+
+
+
+    /*! Prints the leakage declaration as it looks in the floorplan file
+     *
+     * \param leakage the address of the structure to print
+     * \param stream  the output stream (must be already open)
+     * \param prefix  a string to be printed as prefix at the beginning
+     *                of each line
+     */
+
+    void leakage_print (Leakage_t *leakage, FILE *stream, String_t prefix) ;
+
+
+
+    /*! Appends a (temperature, power) point to a piecewise linear model
+     *
+     * \param leakage     the address of the leakage structure
+     * \param temperature the temperature of the point
+     * \param power       the leakage power at \a temperature
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails or if
+     *                          \a temperature is not greater than the
+     *                          temperature of the last point
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t leakage_add_point
+
+        (Leakage_t *leakage, Temperature_t temperature, Power_t power) ;
+
+
+
+    /*! Returns the leakage power at a given temperature
+     *
+     * The piecewise linear model extrapolates the first and the last
+     * segments outside the range of its points. Negative powers are
+     * clipped to zero.
+     *
+     * \param leakage     the address of the leakage structure
+     * \param temperature the temperature of the floorplan element
+     *
+     * \return the leakage power, in \f$ W \f$
+     */
+
+    Power_t get_leakage_power (Leakage_t *leakage, Temperature_t temperature) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_LEAKAGE_H_ */
@@ -0,0 +1,348 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_MODEL_REGISTRY_H_
+#define _3DICE_MODEL_REGISTRY_H_
+
+/*! \file model_registry.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stddef.h> // For the type size_t
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "types.h"
+#include "string_t.h"
+#include "stack_description.h"
+#include "thermal_data.h"
+#include "analysis.h"
+#include "output.h"
+#include "snapshot_pool.h"
+
+/******************************************************************************/
+
+    /*! \struct Model_t
+     *  \brief A model hosted by a server
+     *
+     * A model is built from a stack file by a thread of its own, while the
+     * server accepts the clients. It is identified by the path of the file
+     * and by the hash of its content, so that a file changed gives a new
+     * model. The time spent in each phase is kept for the status requests
+     */
+
+    struct Model_t
+    {
+        /*! The identifier of the model, from 1 */
+
+        Quantity_t Id ;
+
+        /*! The real path of the stack file */
+
+        String_t StkFile ;
+
+        /*! The hash of the content of the stack file */
+
+        uint64_t Hash ;
+
+        /*! The stack parsed */
+
+        StackDescription_t Stkd ;
+
+        /*! The hash of the files the stack refers to */
+
+        uint64_t InputsHash ;
+
+        /*! The thermal data, with the system matrix and its factors */
+
+        ThermalData_t TData ;
+
+        /*! The analysis of the stack */
+
+        Analysis_t Analysis ;
+
+        /*! The outputs of the stack */
+
+        Output_t Output ;
+
+        /*! The thread that builds the model */
+
+        pthread_t Thread ;
+
+        /*! The phase the model is in */
+
+        ModelPhase_t Phase ;
+
+        /*! The seconds spent in each phase over */
+
+        double Times [TDICE_MODEL_READY] ;
+
+        /*! The instant the current phase started */
+
+        struct timespec PhaseStart ;
+
+        /*! The memory of the model once ready, in bytes */
+
+        size_t Memory ;
+
+        /*! The number of sessions using the model */
+
+        Quantity_t Users ;
+
+        /*! The last time the sessions used the model (a logical clock) */
+
+        uint64_t LastUse ;
+
+        /*! The registry that hosts the model */
+
+        struct ModelRegistry_t *Registry ;
+
+        /*! The next model in the registry */
+
+        struct Model_t *Next ;
+    } ;
+
+    /*! Definition of the type Model_t */
+
+    typedef struct Model_t Model_t ;
+
+
+
+    /*! \struct ModelRegistry_t
+     *  \brief The models hosted by a server
+     *
+     * The models without users are kept until the memory of the models
+     * ready, and of the thermal states saved, exceeds the budget: then the
+     * ones used least recently are released first. The stack files must be
+     * in the directory of the stack file the registry is opened with (or
+     * below it), since a stack names the files the server reads and
+     * writes. The functions can be called by several threads
+     */
+
+    struct ModelRegistry_t
+    {
+        /*! The models hosted */
+
+        Model_t *Models ;
+
+        /*! The identifier of the last model built */
+
+        Quantity_t LastId ;
+
+        /*! The logical clock of the uses of the models */
+
+        uint64_t Clock ;
+
+        /*! The memory budget, in bytes (0 means no limit) */
+
+        size_t Budget ;
+
+        /*! The highest memory of the models ready, in bytes */
+
+        size_t MemoryPeak ;
+
+        /*! The directory of the stack files that can be selected */
+
+        String_t Directory ;
+
+        /*! \c true if several sessions share a model: a model is checked
+         *  to be shareable before it is ready */
+
+        bool Shared ;
+
+        /*! The event (an eventfd) written when a model is ready or failed */
+
+        int Event ;
+
+        /*! The thermal states saved, whose memory counts in the budget
+         *  (can be \c NULL ) */
+
+        SnapshotPool_t *Snapshots ;
+
+        /*! The lock on the models and on the fields above */
+
+        pthread_mutex_t Lock ;
+    } ;
+
+    /*! Definition of the type ModelRegistry_t */
+
+    typedef struct ModelRegistry_t ModelRegistry_t ;
+
+
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a registry structure with default values
+     *
+     * \param registry the address of the structure to initalize
+     */
+
+    void model_registry_init (ModelRegistry_t *registry) ;
+
+
+
+    /*! Opens a registry for the stack files in the directory of a stack file
+     *
+     * \param registry  the address of the registry
+     * \param stk_file  the stack file whose directory holds the models
+     * \param budget    the memory budget, in bytes (0 means no limit)
+     * \param shared    \c true if several sessions share a model
+     * \param snapshots the thermal states saved, whose memory counts in
+     *                  the budget (can be \c NULL )
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the stack file does not exist or the
+     *                          event cannot be created. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t model_registry_open
+    (
+        ModelRegistry_t *registry,
+        String_t         stk_file,
+        size_t           budget,
+        bool             shared,
+        SnapshotPool_t  *snapshots
+    ) ;
+
+
+
+    /*! Releases all the models, once their threads are over, and closes
+     *  the registry
+     *
+     * No session can use the models while, or after, they are destroyed
+     *
+     * \param registry the address of the structure to destroy
+     */
+
+    void model_registry_destroy (ModelRegistry_t *registry) ;
+
+
+
+    /*! Returns, with a user more, the model of a stack file
+     *
+     * The model is the one hosted, if the stack file and the files it
+     * refers to did not change since it has been built, or a new one,
+     * built in the background
+     *
+     * \param registry the address of the registry
+     * \param stk_file the stack file
+     *
+     * \return the address of the model
+     * \return \c NULL if the file cannot be read or it is not in the
+     *                 directory of the registry. A message will be printed
+     *                 on standard error
+     */
+
+    Model_t *model_registry_acquire (ModelRegistry_t *registry, String_t stk_file) ;
+
+
+
+    /*! Gives back a model acquired. Without users, it can be released
+     *
+     * \param registry the address of the registry
+     * \param model    the address of the model
+     */
+
+    void model_registry_release (ModelRegistry_t *registry, Model_t *model) ;
+
+
+
+    /*! Releases the models without users that failed and, least recently
+     *  used first, the ones ready until their memory fits the budget
+     *
+     * It waits for the threads of the models released
+     *
+     * \param registry the address of the registry
+     */
+
+    void model_registry_evict (ModelRegistry_t *registry) ;
+
+
+
+    /*! Returns the phase of a model and the seconds spent in each phase,
+     *  the one running included
+     *
+     * \param registry the address of the registry
+     * \param model    the address of the model
+     * \param times    where the seconds of the phases before
+     *                 \c TDICE_MODEL_READY are stored (can be \c NULL )
+     *
+     * \return the phase of the model
+     */
+
+    ModelPhase_t model_registry_status
+
+        (ModelRegistry_t *registry, Model_t *model, float *times) ;
+
+
+
+    /*! Returns the number of models hosted and their memory
+     *
+     * Every pointer can be \c NULL
+     *
+     * \param registry    the address of the registry
+     * \param nmodels     where the number of models is stored
+     * \param memory      where the memory of the models ready is stored
+     * \param memory_peak where the highest memory of the models ready is
+     *                    stored
+     */
+
+    void model_registry_usage
+    (
+        ModelRegistry_t *registry,
+        Quantity_t      *nmodels,
+        size_t          *memory,
+        size_t          *memory_peak
+    ) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_MODEL_REGISTRY_H_ */
@@ -57,6 +57,46 @@ extern "C"
 
 #   define MESSAGE_LENGTH 256
 
+    /*! \def TDICE_PROTOCOL_VERSION
+     *
+     *  The highest version of the client/server protocol implemented. The
+     *  version 1 is the protocol without the \c TDICE_NEGOTIATE_PROTOCOL
+     *  request and the bulk sections, the version 2 is the protocol without
+     *  the \c TDICE_OPEN_SHARED_MEMORY request, the version 3 is the
+     *  protocol without the partial transfers of the output files, the
+     *  version 4 is the protocol without the \c TDICE_BULK_DELTA sections,
+     *  the version 5 is the protocol without the saved thermal states, the
+     *  version 6 is the protocol without the speculative steps, the version
+     *  7 is the protocol without the \c TDICE_SEND_MODEL_STATUS request, the
+     *  version 8 is the protocol without the \c TDICE_SELECT_MODEL request,
+     *  the version 9 is the protocol without the \c TDICE_GET_STATS request
+     */
+
+#   define TDICE_PROTOCOL_VERSION 10u
+
+    /*! \def TDICE_NEGOTIATION_TIMEOUT
+     *
+     *  The time (in milliseconds) a client waits for the reply to the
+     *  \c TDICE_NEGOTIATE_PROTOCOL request before using the version 1
+     */
+
+#   define TDICE_NEGOTIATION_TIMEOUT 2000
+
+    /*! \def TDICE_BULK_RESOLUTION
+     *
+     *  The resolution (in Kelvin) of the \c TDICE_BULK_DELTA sections until
+     *  the client sets a different one
+     */
+
+#   define TDICE_BULK_RESOLUTION 1e-3
+
+    /*! \def TDICE_BULK_MIN_RESOLUTION
+     *
+     *  The finest resolution (in Kelvin) of the \c TDICE_BULK_DELTA sections
+     */
+
+#   define TDICE_BULK_MIN_RESOLUTION 1e-6
+
 /******************************************************************************/
 
     /*! \struct NetworkMessage_t
@@ -97,6 +137,37 @@ extern "C"
 
 
 
+    /*! \struct BulkReference_t
+     *
+     *  \brief The values of the last \c TDICE_BULK_DELTA section of a
+     *         sequence, sent or received
+     *
+     *  Sender and receiver keep one reference for each sequence of values
+     *  (the same thermal map requested again and again) and update it, in
+     *  the same way, at every section.
+     */
+
+    struct BulkReference_t
+    {
+        /*! The resolution of the values */
+
+        double Resolution ;
+
+        /*! The number of values */
+
+        Quantity_t NValues ;
+
+        /*! The values, as integer multiples of \a Resolution */
+
+        int64_t *Values ;
+    } ;
+
+    /*! Definition of the type BulkReference_t */
+
+    typedef struct BulkReference_t BulkReference_t ;
+
+
+
 /******************************************************************************/
 
 
@@ -183,6 +254,134 @@ extern "C"
 
         (NetworkMessage_t *message, void *word, Quantity_t index) ;
 
+
+
+    /*! Inserts a bulk section of values to the content of a message
+     *
+     * The section is made of its type, the number of values and the values,
+     * copied at once at the end of the message:
+     *
+     * | BulkType_t | nvalues | value 1 | ... | value nvalues |
+     *
+     * \param message the address of the message to build
+     * \param type    the precision of the values in the message
+     * \param values  the address of the first value to insert
+     * \param nvalues the number of values to insert
+     */
+
+    void insert_message_bulk
+    (
+        NetworkMessage_t *message,
+        BulkType_t        type,
+        double           *values,
+        Quantity_t        nvalues
+    ) ;
+
+
+
+    /*! Extracts the values of a bulk section from the content of a message
+     *
+     * \param message the address of the message to access
+     * \param index   (in/out) the index of the first word of the section.
+     *                It is moved to the first word after the section
+     * \param values  (out) the address of the array where to store the values
+     * \param nvalues the number of values that \a values can store
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the section is not valid, out of the
+     *                          message or with more than \a nvalues values
+     */
+
+    Error_t extract_message_bulk
+    (
+        NetworkMessage_t *message,
+        Quantity_t       *index,
+        double           *values,
+        Quantity_t        nvalues
+    ) ;
+
+
+
+    /*! Inits the fields of the \a reference structure with default values
+     *
+     * \param reference the address of the structure to initalize
+     */
+
+    void bulk_reference_init (BulkReference_t *reference) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a reference
+     *
+     * \param reference the address of the structure to destroy
+     */
+
+    void bulk_reference_destroy (BulkReference_t *reference) ;
+
+
+
+    /*! Inserts a delta encoded bulk section of values to the content of a
+     *  message
+     *
+     * The values are rounded to multiples of \a resolution and, unless the
+     * section is a key frame, replaced by their difference with the values
+     * in \a reference . The differences (mostly 0 for a slowly changing map)
+     * are stored as a sequence of pairs (number of zeros, next difference),
+     * each one as a variable length integer:
+     *
+     * | TDICE_BULK_DELTA | nvalues | key_frame | resolution | nbytes | bytes |
+     *
+     * A key frame (the differences with 0) is sent if \a reference has a
+     * different resolution or number of values. \a reference is then
+     * updated with the values sent.
+     *
+     * \param message    the address of the message to build
+     * \param reference  the address of the values of the last section
+     * \param resolution the resolution of the values
+     * \param values     the address of the first value to insert
+     * \param nvalues    the number of values to insert
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the memory allocation fails
+     */
+
+    Error_t insert_message_bulk_delta
+    (
+        NetworkMessage_t *message,
+        BulkReference_t  *reference,
+        double            resolution,
+        double           *values,
+        Quantity_t        nvalues
+    ) ;
+
+
+
+    /*! Extracts the values of a delta encoded bulk section from the content
+     *  of a message
+     *
+     * \param message   the address of the message to access
+     * \param index     (in/out) the index of the first word of the section.
+     *                  It is moved to the first word after the section
+     * \param reference the address of the values of the last section
+     *                  received, updated with the values extracted
+     * \param values    (out) the address of the array where to store the values
+     * \param nvalues   the number of values that \a values can store
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the section is not valid, out of the
+     *                          message, with more than \a nvalues values
+     *                          or if the memory allocation fails
+     */
+
+    Error_t extract_message_bulk_delta
+    (
+        NetworkMessage_t *message,
+        Quantity_t       *index,
+        BulkReference_t  *reference,
+        double           *values,
+        Quantity_t        nvalues
+    ) ;
+
 /******************************************************************************/
 
 #ifdef __cplusplus
@@ -0,0 +1,213 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_NETWORK_SHARED_MEMORY_H_
+#define _3DICE_NETWORK_SHARED_MEMORY_H_
+
+/*! \file network_shared_memory.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stddef.h> // For the type size_t
+
+#include "types.h"
+#include "string_t.h"
+
+/******************************************************************************/
+
+    /*! \struct SharedMemory_t
+     *
+     *  \brief Channel between a client and a server running on the same host
+     *
+     *  A shared memory segment holds two rings of bytes, one for each
+     *  direction. While both sides are busy, data moves without system
+     *  calls: a side waits on a futex only after spinning on an empty (or
+     *  full) ring for a bounded time, and the other side wakes it up only
+     *  if it is waiting.
+     */
+
+    struct SharedMemory_t
+    {
+        /*! The memory mapped segment */
+
+        void *Segment ;
+
+        /*! The size of the segment, in bytes */
+
+        size_t Length ;
+
+        /*! \c true on the side that created the segment (the client) */
+
+        bool Owner ;
+
+        /*! The socket connected to the other side, polled to detect if
+         *  it went away while waiting */
+
+        NetworkSocket_t Peer ;
+
+        /*! \c true if a side spins on a ring before waiting, \c false on
+         *  a host with a single processor */
+
+        bool Spin ;
+
+        /*! The name of the segment */
+
+        char Name [64] ;
+    } ;
+
+    /*! Definition of the type SharedMemory_t */
+
+    typedef struct SharedMemory_t SharedMemory_t ;
+
+/******************************************************************************/
+
+    /*! Inits the fields of the \a shm structure with default values
+     *
+     * \param shm the address of the structure to initalize
+     */
+
+    void shared_memory_init (SharedMemory_t *shm) ;
+
+
+
+    /*! Creates and maps a new shared memory segment
+     *
+     * The name of the segment is unique within the host and it is stored
+     * in \a Name , to be sent to the other side.
+     *
+     * \param shm  the address of the SharedMemory to create
+     * \param peer the socket connected to the other side
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the operation fails. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t shared_memory_create (SharedMemory_t *shm, NetworkSocket_t peer) ;
+
+
+
+    /*! Maps the shared memory segment created by the other side
+     *
+     * \param shm  the address of the SharedMemory to attach
+     * \param name the name of the segment
+     * \param peer the socket connected to the other side
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the segment does not exist or it has not
+     *                          been created by \a shared_memory_create . A
+     *                          message will be printed on standard error
+     */
+
+    Error_t shared_memory_attach
+
+        (SharedMemory_t *shm, String_t name, NetworkSocket_t peer) ;
+
+
+
+    /*! Removes the name of the segment
+     *
+     * The segment stays mapped but no other process can attach it anymore
+     *
+     * \param shm the address of the SharedMemory
+     */
+
+    void shared_memory_unlink (SharedMemory_t *shm) ;
+
+
+
+    /*! Writes \a bytes bytes to the other side
+     *
+     * The function returns when all the bytes are in the ring. Messages
+     * larger than the ring are written in chunks, as the other side reads.
+     *
+     * \param shm    the address of the SharedMemory
+     * \param memory the address of the bytes to write
+     * \param bytes  the number of bytes to write
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the other side closed the segment or went
+     *                          away. A message will be printed on standard
+     *                          error
+     */
+
+    Error_t shared_memory_write
+
+        (SharedMemory_t *shm, const void *memory, size_t bytes) ;
+
+
+
+    /*! Reads \a bytes bytes sent by the other side
+     *
+     * \param shm    the address of the SharedMemory
+     * \param memory the address where to store the bytes read
+     * \param bytes  the number of bytes to read
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the other side closed the segment or went
+     *                          away. A message will be printed on standard
+     *                          error
+     */
+
+    Error_t shared_memory_read
+
+        (SharedMemory_t *shm, void *memory, size_t bytes) ;
+
+
+
+    /*! Closes the channel and unmaps the segment
+     *
+     * The other side, if waiting, is woken up and its operations fail.
+     *
+     * \param shm the address of the structure to destroy
+     */
+
+    void shared_memory_destroy (SharedMemory_t *shm) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_NETWORK_SHARED_MEMORY_H_ */
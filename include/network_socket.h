@@ -48,12 +48,15 @@ extern "C"
 
 /******************************************************************************/
 
+#include <stddef.h> // For the type size_t
+#include <sys/types.h> // For the type off_t
 #include <netinet/in.h>
 
 #include "types.h"
 #include "string_t.h"
 
 #include "network_message.h"
+#include "network_shared_memory.h"
 
 /******************************************************************************/
 
@@ -80,6 +83,11 @@ extern "C"
         /*! The port number (host horder) */
 
         PortNumber_t PortNumber ;
+
+        /*! The shared memory used, instead of the socket, to exchange the
+         *  messages with a client on the same host ( \c NULL if none) */
+
+        SharedMemory_t *SharedMemory ;
     } ;
 
     /*! Definition of the type Socket_t */
@@ -88,6 +96,39 @@ extern "C"
 
 
 
+    /*! \struct SocketBuffer_t
+     *
+     *  \brief Bytes received from, or still to be sent to, a non-blocking
+     *         socket
+     *
+     *  The bytes not consumed yet are the ones between \a Begin and \a End
+     */
+
+    struct SocketBuffer_t
+    {
+        /*! The memory used to store the bytes */
+
+        unsigned char *Memory ;
+
+        /*! The number of bytes that can be stored in \a Memory */
+
+        size_t Size ;
+
+        /*! Offset of the first byte not consumed yet */
+
+        size_t Begin ;
+
+        /*! Offset of the first free byte */
+
+        size_t End ;
+    } ;
+
+    /*! Definition of the type SocketBuffer_t */
+
+    typedef struct SocketBuffer_t SocketBuffer_t ;
+
+
+
 /******************************************************************************/
 
 
@@ -142,8 +183,15 @@ extern "C"
      * The server side must be waiting for a connection. On error, the
      * socket is closed.
      *
+     * If \a host_name starts with "shm://" the server must run on the same
+     * host: once connected, the client asks the server to exchange all the
+     * following messages through a shared memory segment. The socket is
+     * used as usual if the server implements the version 2 of the protocol
+     * only or if the segment cannot be set up.
+     *
      * \param csocket        the address of the ClientSocket to initialize
-     * \param host_name   the ip address of the server (as dotted string)
+     * \param host_name   the ip address of the server (as dotted string),
+     *                    optionally prefixed by "shm://"
      * \param port_number the port number of the server
      *
      * \return \c TDICE_SUCCESS if the connection succeeded
@@ -160,6 +208,24 @@ extern "C"
 
 
 
+    /*! Negotiates the version of the protocol with the server
+     *
+     * The client sends the highest version it implements and waits for the
+     * reply at most \c TDICE_NEGOTIATION_TIMEOUT milliseconds. A server
+     * that does not reply implements only the version 1
+     *
+     * \param csocket the address of the ClientSocket connected to the server
+     * \param version where the version to use will be written
+     *
+     * \return \c TDICE_SUCCESS if the version has been negotiated
+     * \return \c TDICE_FAILURE if the socket does not work. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t negotiate_protocol (Socket_t *csocket, Quantity_t *version) ;
+
+
+
     /*! Waits unitl a client sends a connect to the server
      *
      * \param ssocket   the address of the ServerSocket that will wait
@@ -210,7 +276,217 @@ extern "C"
 
 
 
+    /*! Inits the fields of the \a buffer structure with default values
+     *
+     * \param buffer the address of the structure to initalize
+     */
+
+    void socket_buffer_init (SocketBuffer_t *buffer) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a buffer
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a socket_buffer_init .
+     *
+     * \param buffer the address of the structure to destroy
+     */
+
+    void socket_buffer_destroy (SocketBuffer_t *buffer) ;
+
+
+
+    /*! Tells if all the bytes of a buffer have been consumed
+     *
+     * \param buffer the address of the buffer
+     *
+     * \return \c TRUE if there are no bytes between \a Begin and \a End
+     */
+
+    bool socket_buffer_is_empty (SocketBuffer_t *buffer) ;
+
+
+
+    /*! Makes the read and write operations on a socket non-blocking
+     *
+     * \param socket the address of the socket
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the operation fails. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t socket_set_non_blocking (Socket_t *socket) ;
+
+
+
+    /*! Makes the read and write operations on a socket blocking again
+     *
+     * \param socket the address of the socket
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the operation fails. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t socket_set_blocking (Socket_t *socket) ;
+
+
+
+    /*! Reads all the bytes available on a non-blocking socket
+     *
+     * The bytes are appended to \a buffer , that grows if needed. The
+     * function returns when the read would block or the peer closed the
+     * connection.
+     *
+     * \param socket the address of the socket to read from
+     * \param buffer the address of the buffer where to append the bytes
+     * \param hangup set to \c true if the peer closed the connection
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the read or the memory allocation fails.
+     *                          A message will be printed on standard error
+     */
+
+    Error_t read_socket_buffer
+    (
+        Socket_t       *socket,
+        SocketBuffer_t *buffer,
+        bool           *hangup
+    ) ;
+
+
+
+    /*! Writes the bytes of a buffer on a non-blocking socket
+     *
+     * The function returns when the buffer is empty or the write would block.
+     * The bytes sent are consumed from \a buffer . If the socket uses a
+     * shared memory, the function returns when all the bytes are written.
+     *
+     * \param socket the address of the socket to write to
+     * \param buffer the address of the buffer to send
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the write fails. A message will be
+     *                          printed on standard error
+     */
+
+    Error_t write_socket_buffer
+    (
+        Socket_t       *socket,
+        SocketBuffer_t *buffer
+    ) ;
+
+
+
+    /*! Moves the first message stored in a buffer into \a message
+     *
+     * \param buffer   the address of the buffer to extract from
+     * \param message  the address of the message to fill
+     * \param complete set to \c true if a whole message was in the buffer
+     *                 and it has been extracted
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the buffer does not start with a valid
+     *                          message length
+     */
+
+    Error_t extract_message_from_buffer
+    (
+        SocketBuffer_t   *buffer,
+        NetworkMessage_t *message,
+        bool             *complete
+    ) ;
+
+
+
+    /*! Reads the type of the first message stored in a buffer, without
+     *  extracting it
+     *
+     * \param buffer the address of the buffer
+     * \param type   the address where the type will be written
+     *
+     * \return \c true if the buffer holds a whole message
+     * \return \c false otherwise. \a type is not written
+     */
+
+    bool peek_message_type_in_buffer
+    (
+        SocketBuffer_t *buffer,
+        MessageType_t  *type
+    ) ;
+
+
+
+    /*! Appends a message to a buffer, to be sent later on
+     *
+     * \param buffer  the address of the buffer
+     * \param message the address of the message to append
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the memory allocation fails
+     */
+
+    Error_t append_message_to_buffer
+    (
+        SocketBuffer_t   *buffer,
+        NetworkMessage_t *message
+    ) ;
+
+
+
+    /*! Appends bytes to a buffer, to be sent later on
+     *
+     * \param buffer the address of the buffer
+     * \param bytes  the address of the bytes to append
+     * \param nbytes the number of bytes to append
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the memory allocation fails
+     */
+
+    Error_t append_bytes_to_buffer
+    (
+        SocketBuffer_t *buffer,
+        const void     *bytes,
+        size_t          nbytes
+    ) ;
+
+
+
+    /*! Sends a part of a file on a non-blocking socket
+     *
+     * The bytes move from the file to the socket in bounded chunks, without
+     * being copied in user space. The function returns when all the bytes
+     * are sent or the write would block. \a offset and \a remaining are
+     * updated with the bytes sent. If the socket uses a shared memory, the
+     * function returns when all the bytes are written.
+     *
+     * \param socket    the address of the socket to write to
+     * \param file      the descriptor of the file to send
+     * \param offset    the offset of the first byte to send
+     * \param remaining the number of bytes to send
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the file or the socket cannot be used or
+     *                          the file is shorter than expected. A message
+     *                          will be printed on standard error
+     */
+
+    Error_t send_file_to_socket
+    (
+        Socket_t *socket,
+        int       file,
+        off_t    *offset,
+        size_t   *remaining
+    ) ;
+
+
+
     /*! Closes a socket
+     *
+     * The shared memory used by the socket, if any, is released.
      *
      * \param socket the address of the Socket to close
      *
@@ -247,6 +247,30 @@ extern "C"
         NetworkMessage_t *message
     ) ;
 
+
+
+    /*! Collects the temperatures measured by the Tcell and Tflpel inspection
+     *  points of an output instant, in the order they are declared
+     *
+     * \param output       pointer to the output structure
+     * \param dimensions the address of the dimension structure
+     * \param temperatures pointer to the first element of the temparature array
+     * \param output_instant the instant of the output (slot, step, final)
+     * \param values the array where to store the temperatures. If \c NULL ,
+     *               the inspection points are only counted
+     *
+     * \return the number of Tcell and Tflpel inspection points of the instant
+     */
+
+    Quantity_t get_inspection_point_temperatures
+    (
+        Output_t        *output,
+        Dimensions_t    *dimensions,
+        Temperature_t   *temperatures,
+        OutputInstant_t  output_instant,
+        Temperature_t   *values
+    ) ;
+
 /******************************************************************************/
 
 #ifdef __cplusplus
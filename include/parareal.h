@@ -0,0 +1,232 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_PARAREAL_H_
+#define _3DICE_PARAREAL_H_
+
+/*! \file parareal.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include "types.h"
+
+#include "analysis.h"
+#include "dimensions.h"
+#include "system_matrix.h"
+#include "thermal_data.h"
+
+#include "slu_mt_ddefs.h"
+
+/******************************************************************************/
+
+    /*! \struct Parareal_t
+     *
+     *  \brief Time-parallel (parareal) integration of a transient simulation
+     *
+     *  The power trace is split in windows of one slot each. A coarse
+     *  propagator, that covers a whole slot with a single implicit Euler
+     *  step, runs sequentially over the windows while the fine propagator
+     *  (\c SlotLength steps of \c StepTime each, as in \a emulate_step ) runs
+     *  on every window in parallel. The two are combined with the parareal
+     *  correction until the temperatures at the end of every slot change
+     *  less than \c PararealTolerance between two iterations.
+     *
+     *  The fine propagator reuses the L and U factors already stored in
+     *  the ThermalData while the coarse one has its own system matrix,
+     *  factorized once with the slot time as time step.
+     */
+
+    struct Parareal_t
+    {
+        /*! The system matrix of the coarse propagator (time step = slot) */
+
+        SystemMatrix_t SM_Coarse ;
+
+        /*! The number of windows (slots) integrated together */
+
+        Quantity_t NWindows ;
+
+        /*! The number of windows loaded in the last group (less than
+         *  \c NWindows at the end of the power trace) */
+
+        Quantity_t NSlots ;
+
+        /*! The index of the next window of the group to be returned
+         *  by \a emulate_parareal */
+
+        Quantity_t Cursor ;
+
+        /*! The number of cells of the thermal grid */
+
+        CellIndex_t Size ;
+
+        /*! The temperatures at the beginning of every window, plus the
+         *  temperatures at the end of the last one (\c NWindows + 1 vectors) */
+
+        Temperature_t *States ;
+
+        /*! The temperatures computed by the fine propagator at
+         *  the end of every window (\c NWindows vectors) */
+
+        Temperature_t *Fine ;
+
+        /*! The temperatures computed by the coarse propagator at the end of
+         *  every window during the previous iteration (\c NWindows vectors) */
+
+        Temperature_t *Coarse ;
+
+        /*! The source vectors of every window (\c NWindows vectors) */
+
+        Source_t *Sources ;
+
+        /*! Working vector for the coarse propagator */
+
+        double *Vector ;
+
+        /*! SuperLU vectors B (wrappers around the \c Fine vectors) */
+
+        SuperMatrix *SLUMatrix_Fine ;
+
+        /*! SuperLU vector B (wrapper around \c Vector ) */
+
+        SuperMatrix SLUMatrix_Vector ;
+
+        /*! The number of iterations run on the last group of windows */
+
+        Quantity_t NIterations ;
+    } ;
+
+    /*! Definition of the type Parareal_t */
+
+    typedef struct Parareal_t Parareal_t ;
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a parareal structure with default values
+     *
+     * \param parareal the address of the structure to initalize
+     */
+
+    void parareal_init (Parareal_t *parareal) ;
+
+
+
+    /*! Allocs memory and factorizes the coarse propagator
+     *
+     * The thermal data \a tdata must be already built since its thermal
+     * grid is used to fill the coarse system matrix.
+     *
+     * \param parareal   the address of the Parareal structure to build
+     * \param tdata      the address of the ThermalData structure
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the address of the Analysis structure
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails or the coarse
+     *                          system matrix cannot be split in A=LU.
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t parareal_build
+    (
+        Parareal_t    *parareal,
+        ThermalData_t *tdata,
+        Dimensions_t  *dimensions,
+        Analysis_t    *analysis
+    ) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a parareal
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a parareal_init .
+     *
+     * \param parareal the address of the structure to destroy
+     */
+
+    void parareal_destroy (Parareal_t *parareal) ;
+
+
+
+    /*! Simulates a time slot with the parareal driver
+     *
+     * Slots are integrated \c NWindows at a time: when all the slots
+     * computed by the previous group of windows have been returned, the
+     * function consumes the power values of the next \c NWindows slots (as
+     * \a emulate_step would do) and runs the parareal iterations on them.
+     * At the end, the temperatures and the sources in \a tdata refer to
+     * the slot just completed and the simulated time in \a analysis is
+     * moved forward by one slot, so that the same output functions used
+     * with \a emulate_slot can be used. Intermediate time steps are not
+     * available.
+     *
+     * \param parareal   the address of the Parareal structure
+     * \param tdata      the address of the ThermalData structure
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the address of the Analysis structure
+     *
+     * \return \c TDICE_WRONG_CONFIG if the parameters refers to a steady
+     *                               state simulation or if the current time
+     *                               is not at the end of a slot
+     * \return \c TDICE_SOLVER_ERROR if the SLU functions report an error
+     * \return \c TDICE_END_OF_SIMULATION if power values are over.
+     * \return \c TDICE_SLOT_DONE    the slot has been simulated correclty
+     */
+
+    SimResult_t emulate_parareal
+    (
+        Parareal_t    *parareal,
+        ThermalData_t *tdata,
+        Dimensions_t  *dimensions,
+        Analysis_t    *analysis
+    ) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_PARAREAL_H_ */
@@ -127,6 +127,11 @@ extern "C"
          */
 
         Capacity_t *CellsCapacities ;
+
+        /*! The number of floorplan elements, in the entire 3d-ic,
+         *  having a temperature dependent leakage power */
+
+        Quantity_t NLeakages ;
     } ;
 
     /*! Definition of the type PowerGrid_t */
@@ -206,6 +211,90 @@ extern "C"
 
 
 
+    /*! Fills the source vector as \a update_source_vector , with the next
+     *  power value (or the average power) of each floorplan element, but
+     *  without consuming the power values
+     *
+     * \param pgrid address of the PowerGrid structure storing the sources
+     * \param dimensions the dimensions of the IC
+     * \param average \c true to use the average power of the elements
+     *
+     *  \return \c TDICE_SUCCESS if the source vector has been filled
+     *  \return \c TDICE_FAILURE if it not possible to fill the source vector
+     *                           (at least one floorplan element with no power
+     *                            values in its queue)
+     */
+
+    Error_t fill_initial_source_vector
+
+        (PowerGrid_t *pgrid, Dimensions_t *dimensions, bool average) ;
+
+
+
+    /*! Copies the next power value of each floorplan element in the stack,
+     *  i.e. the one that the next call to \a update_source_vector will use
+     *
+     *  The floorplan elements are in the same order as the power values
+     *  given to \a insert_power_values
+     *
+     * \param pgrid   address of the PowerGrid structure
+     * \param pvalues the array where to store the power values (\c 0 for the
+     *                elements with no power values in their queue)
+     */
+
+    void get_next_power_values (PowerGrid_t *pgrid, Power_t *pvalues) ;
+
+
+
+    /*! Replaces the next power value of each floorplan element in the stack
+     *
+     *  The power queues are left with the same length: an element with no
+     *  power values in its queue is not changed (and the simulation will
+     *  end at the next slot, as it would have done)
+     *
+     * \param pgrid   address of the PowerGrid structure
+     * \param pvalues the new power values, ordered as \a get_next_power_values
+     */
+
+    void replace_next_power_values (PowerGrid_t *pgrid, Power_t *pvalues) ;
+
+
+
+    /*! Returns the number of floorplan elements in the stack, i.e. the
+     *  number of power queues
+     *
+     * \param pgrid address of the PowerGrid structure
+     *
+     * \return the number of floorplan elements
+     */
+
+    Quantity_t get_number_of_power_queues (PowerGrid_t *pgrid) ;
+
+
+
+    /*! Copies the power queue of each floorplan element in the stack
+     *
+     * \param pgrid   address of the PowerGrid structure
+     * \param pqueues the power queues where to copy the power values, as
+     *                many as \a get_number_of_power_queues (already
+     *                initialized), ordered as \a get_next_power_values
+     */
+
+    void save_power_values (PowerGrid_t *pgrid, PowersQueue_t *pqueues) ;
+
+
+
+    /*! Replaces the power queue of each floorplan element in the stack with
+     *  a copy of the one saved by \a save_power_values
+     *
+     * \param pgrid   address of the PowerGrid structure
+     * \param pqueues the power queues to copy
+     */
+
+    void restore_power_values (PowerGrid_t *pgrid, PowersQueue_t *pqueues) ;
+
+
+
     /*! Update channel sources
      *
      * \param pgrid address of the PowerGrid structure storing the sources
@@ -240,6 +329,35 @@ extern "C"
 
     Error_t insert_power_values (PowerGrid_t *pgrid, PowersQueue_t *pvalues) ;
 
+
+
+    /*! Evaluates the leakage power of the floorplan elements in the
+     *  entire stack at the temperatures \a temperatures
+     *
+     *  \param pgrid        address of the PowerGrid structure
+     *  \param dimensions   the dimensions of the IC
+     *  \param temperatures pointer to the temperature of the first thermal
+     *                      cell of the 3d-ic
+     *
+     *  \return the maximum change of the temperature of the floorplan
+     *          elements since the previous evaluation of their leakage
+     */
+
+    Temperature_t update_leakage_powers
+
+        (PowerGrid_t *pgrid, Dimensions_t *dimensions, Temperature_t *temperatures) ;
+
+
+
+    /*! Adds the leakage power of the floorplan elements, as evaluated by
+     *  the last call to \a update_leakage_powers , to a source vector
+     *
+     *  \param pgrid   address of the PowerGrid structure
+     *  \param sources pointer to the first element of the source vector
+     */
+
+    void add_leakage_sources (PowerGrid_t *pgrid, Source_t *sources) ;
+
 /******************************************************************************/
 
 #ifdef __cplusplus
@@ -245,6 +245,30 @@ extern "C"
 
     Power_t get_from_powers_queue (PowersQueue_t *pqueue) ;
 
+
+
+    /*! Inserts a power value at the beginning of the queue, so that it
+     *  will be the next value returned by \a get_from_powers_queue
+     *
+     * \param pqueue the powers queue
+     * \param power  the power value to insert
+     */
+
+    void put_front_into_powers_queue (PowersQueue_t *pqueue, Power_t power) ;
+
+
+
+    /*! Returns the average of the power values in the queue, without
+     *  removing them
+     *
+     * \param pqueue the powers queue
+     *
+     * \return the average power value
+     * \return \c 0.0 if the queue is empty
+     */
+
+    Power_t get_average_powers_queue (PowersQueue_t *pqueue) ;
+
 /******************************************************************************/
 
 #ifdef __cplusplus
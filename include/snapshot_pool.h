@@ -0,0 +1,294 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_SNAPSHOT_POOL_H_
+#define _3DICE_SNAPSHOT_POOL_H_
+
+/*! \file snapshot_pool.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stddef.h> // For the type size_t
+#include <pthread.h>
+
+#include "types.h"
+#include "thermal_data.h"
+#include "analysis.h"
+
+/******************************************************************************/
+
+    /*! The largest number of snapshots deleted kept to be reused */
+
+#define TDICE_SNAPSHOT_POOL_SIZE 8u
+
+    /*! The largest number of thermal states a session can save */
+
+#define TDICE_SESSION_SNAPSHOTS 64u
+
+
+
+    /*! \struct Snapshot_t
+     *  \brief A thermal state saved by a session
+     */
+
+    struct Snapshot_t
+    {
+        /*! The handle the clients use to restore or delete the state */
+
+        Quantity_t Handle ;
+
+        /*! The model of the session that saved the state */
+
+        Quantity_t ModelId ;
+
+        /*! The session that saved the state */
+
+        Quantity_t SessionId ;
+
+        /*! The memory of the state, in bytes */
+
+        size_t Memory ;
+
+        /*! The temperatures, the analysis clock and the power values */
+
+        ThermalSnapshot_t State ;
+
+        /*! The next snapshot in the list */
+
+        struct Snapshot_t *Next ;
+    } ;
+
+    /*! Definition of the type Snapshot_t */
+
+    typedef struct Snapshot_t Snapshot_t ;
+
+
+
+    /*! \struct SnapshotPool_t
+     *  \brief The thermal states saved by the sessions of a server
+     *
+     * The states are shared by all the sessions until the session that
+     * saved them ends. The snapshots deleted are kept in a pool, so that
+     * saving a state reuses their memory instead of allocating it again.
+     * The functions can be called by several threads
+     */
+
+    struct SnapshotPool_t
+    {
+        /*! The states saved */
+
+        Snapshot_t *Saved ;
+
+        /*! The snapshots deleted, to be reused */
+
+        Snapshot_t *Free ;
+
+        /*! The number of snapshots in \a Free */
+
+        Quantity_t NFree ;
+
+        /*! The handle of the last state saved */
+
+        Quantity_t LastHandle ;
+
+        /*! The memory of the states saved, in bytes */
+
+        size_t Memory ;
+
+        /*! The lock on the fields above */
+
+        pthread_mutex_t Lock ;
+    } ;
+
+    /*! Definition of the type SnapshotPool_t */
+
+    typedef struct SnapshotPool_t SnapshotPool_t ;
+
+
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a pool structure with default values
+     *
+     * \param pool the address of the structure to initalize
+     */
+
+    void snapshot_pool_init (SnapshotPool_t *pool) ;
+
+
+
+    /*! Frees the states saved and the snapshots kept to be reused
+     *
+     * No thread can use the pool while, or after, it is destroyed
+     *
+     * \param pool the address of the structure to destroy
+     */
+
+    void snapshot_pool_destroy (SnapshotPool_t *pool) ;
+
+
+
+    /*! Returns the memory of the states saved
+     *
+     * \param pool the address of the pool
+     *
+     * \return the memory, in bytes
+     */
+
+    size_t snapshot_pool_memory (SnapshotPool_t *pool) ;
+
+
+
+    /*! Takes a snapshot, reused from the pool or allocated, where a session
+     *  saves a state
+     *
+     * The snapshot must be given to \a snapshot_pool_add or given back with
+     * \a snapshot_pool_give_back
+     *
+     * \param pool       the address of the pool
+     * \param session_id the session that saves the state
+     *
+     * \return the address of the snapshot
+     * \return \c NULL if the session saved \c TDICE_SESSION_SNAPSHOTS
+     *                 states already or if the memory is not enough. A
+     *                 message will be printed on standard error
+     */
+
+    Snapshot_t *snapshot_pool_take (SnapshotPool_t *pool, Quantity_t session_id) ;
+
+
+
+    /*! Gives back a snapshot taken, but not added
+     *
+     * \param pool     the address of the pool
+     * \param snapshot the address of the snapshot
+     */
+
+    void snapshot_pool_give_back (SnapshotPool_t *pool, Snapshot_t *snapshot) ;
+
+
+
+    /*! Adds to the states saved a snapshot taken and filled by a session
+     *
+     * If the memory of the states saved, together with \a other_memory ,
+     * would exceed \a budget , the snapshot is given back instead
+     *
+     * \param pool         the address of the pool
+     * \param snapshot     the address of the snapshot
+     * \param model_id     the model of the session
+     * \param session_id   the session that saved the state
+     * \param budget       the memory budget, in bytes (0 means no limit)
+     * \param other_memory the memory that counts in the budget too
+     *
+     * \return the handle of the state saved
+     * \return 0 if the state exceeds the budget. A message will be printed
+     *           on standard error
+     */
+
+    Quantity_t snapshot_pool_add
+    (
+        SnapshotPool_t *pool,
+        Snapshot_t     *snapshot,
+        Quantity_t      model_id,
+        Quantity_t      session_id,
+        size_t          budget,
+        size_t          other_memory
+    ) ;
+
+
+
+    /*! Restores a state saved into the thermal data and the analysis of a
+     *  session
+     *
+     * \param pool     the address of the pool
+     * \param handle   the handle of the state
+     * \param model_id the model of the session
+     * \param tdata    the thermal data of the session
+     * \param analysis the analysis of the session
+     *
+     * \return \c TDICE_SUCCESS if the state has been restored
+     * \return \c TDICE_FAILURE if there is no state with that handle or it
+     *                          belongs to another model
+     */
+
+    Error_t snapshot_pool_restore
+    (
+        SnapshotPool_t *pool,
+        Quantity_t      handle,
+        Quantity_t      model_id,
+        ThermalData_t  *tdata,
+        Analysis_t     *analysis
+    ) ;
+
+
+
+    /*! Deletes a state saved, whatever the session that saved it
+     *
+     * \param pool   the address of the pool
+     * \param handle the handle of the state
+     *
+     * \return \c TDICE_SUCCESS if the state has been deleted
+     * \return \c TDICE_FAILURE if there is no state with that handle
+     */
+
+    Error_t snapshot_pool_delete (SnapshotPool_t *pool, Quantity_t handle) ;
+
+
+
+    /*! Deletes the states saved by a session that ends
+     *
+     * \param pool       the address of the pool
+     * \param session_id the session
+     */
+
+    void snapshot_pool_delete_session (SnapshotPool_t *pool, Quantity_t session_id) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_SNAPSHOT_POOL_H_ */
@@ -0,0 +1,306 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_STATS_H_
+#define _3DICE_STATS_H_
+
+/*! \file stats.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include <stdio.h>  // For the file type FILE
+#include <stddef.h> // For the type size_t
+#include <stdint.h>
+
+#include "types.h"
+#include "string_t.h"
+
+/******************************************************************************/
+
+    /*! The number of buckets of a histogram. The bucket \c i counts the
+     *  durations shorter than 2^i microseconds (and not shorter than the
+     *  ones of the bucket before), the last one all the longer ones */
+
+#define TDICE_STATS_NBUCKETS 32u
+
+
+
+    /*! \struct StatsHistogram_t
+     *  \brief The distribution of the durations of an operation
+     *
+     * The fields are updated atomically, so that several threads can
+     * record in the same histogram without locks
+     */
+
+    struct StatsHistogram_t
+    {
+        /*! The number of durations recorded */
+
+        uint64_t Count ;
+
+        /*! The sum of the durations, in nanoseconds */
+
+        uint64_t Sum ;
+
+        /*! The longest duration, in nanoseconds */
+
+        uint64_t Max ;
+
+        /*! The number of durations in each bucket */
+
+        uint64_t Buckets [TDICE_STATS_NBUCKETS] ;
+    } ;
+
+    /*! Definition of the type StatsHistogram_t */
+
+    typedef struct StatsHistogram_t StatsHistogram_t ;
+
+
+
+
+    /*! The number of types of requests a server records: the ones up to
+     *  \c TDICE_GET_STATS */
+
+#define TDICE_STATS_NREQUESTS (TDICE_GET_STATS + 1)
+
+
+
+    /*! \struct Stats_t
+     *  \brief The statistics of a server
+     *
+     * The durations of the requests served, by type, and of the phases of
+     * the simulation. All the sessions record them without locks
+     */
+
+    struct Stats_t
+    {
+        /*! The durations of the requests, by type */
+
+        StatsHistogram_t Requests [TDICE_STATS_NREQUESTS] ;
+
+        /*! The number of requests that failed, by type */
+
+        uint64_t Failures [TDICE_STATS_NREQUESTS] ;
+
+        /*! The durations of the phases of the simulation
+         *  ( \c TDICE_STATS_NPHASES ) */
+
+        StatsHistogram_t Phases [TDICE_STATS_NPHASES] ;
+
+        /*! The instant the statistics started, from \a stats_now */
+
+        uint64_t Start ;
+    } ;
+
+    /*! Definition of the type Stats_t */
+
+    typedef struct Stats_t Stats_t ;
+
+
+
+    /*! \struct StatsGauges_t
+     *  \brief The state of a server when its statistics are printed
+     */
+
+    struct StatsGauges_t
+    {
+        /*! The sessions being served */
+
+        Quantity_t Sessions ;
+
+        /*! The most sessions served at the same time */
+
+        Quantity_t SessionsPeak ;
+
+        /*! The models hosted */
+
+        Quantity_t Models ;
+
+        /*! The memory of the models ready, in bytes */
+
+        size_t ModelsMemory ;
+
+        /*! The highest memory of the models ready, in bytes */
+
+        size_t ModelsMemoryPeak ;
+
+        /*! The memory of the thermal states saved, in bytes */
+
+        size_t SavedStatesMemory ;
+    } ;
+
+    /*! Definition of the type StatsGauges_t */
+
+    typedef struct StatsGauges_t StatsGauges_t ;
+
+
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a histogram structure with default values
+     *
+     * \param histogram the address of the structure to initalize
+     */
+
+    void stats_histogram_init (StatsHistogram_t *histogram) ;
+
+
+
+    /*! Returns the current instant of a monotonic clock
+     *
+     * \return the instant, in nanoseconds
+     */
+
+    uint64_t stats_now (void) ;
+
+
+
+    /*! Records a duration in a histogram
+     *
+     * \param histogram the address of the histogram
+     * \param nanoseconds the duration
+     */
+
+    void stats_histogram_add (StatsHistogram_t *histogram, uint64_t nanoseconds) ;
+
+
+
+    /*! Records the duration of an operation started at \a start
+     *
+     * \param histogram the address of the histogram (nothing is recorded
+     *                  if \c NULL )
+     * \param start the instant the operation started, from \a stats_now
+     */
+
+    void stats_histogram_add_since (StatsHistogram_t *histogram, uint64_t start) ;
+
+
+
+    /*! Prints a histogram in the text format of Prometheus
+     *
+     * The buckets are cumulative and their bounds in seconds, as in
+     *
+     * name_bucket{labels,le="0.000001"} 3
+     * ...
+     * name_sum{labels} 0.0042
+     * name_count{labels} 12
+     *
+     * \param histogram the address of the histogram
+     * \param stream the output stream
+     * \param name the name of the metric
+     * \param labels the labels of the metric (can be empty)
+     */
+
+    void stats_histogram_print
+
+        (StatsHistogram_t *histogram, FILE *stream, String_t name, String_t labels) ;
+
+
+
+    /*! Inits the statistics of a server, that start at the current instant
+     *
+     * \param stats the address of the structure to initalize
+     */
+
+    void stats_init (Stats_t *stats) ;
+
+
+
+    /*! Records the duration of a request started at \a start
+     *
+     * Nothing is recorded for the types of request out of range
+     *
+     * \param stats the address of the statistics
+     * \param type  the type of the request
+     * \param start the instant the request started, from \a stats_now
+     * \param error the result of the request
+     */
+
+    void stats_add_request
+
+        (Stats_t *stats, MessageType_t type, uint64_t start, Error_t error) ;
+
+
+
+    /*! Prints the statistics of a server in the text format of Prometheus
+     *
+     * Together with the gauges given, the resident memory of the process
+     * and the time since the statistics started are printed
+     *
+     * \param stats  the address of the statistics
+     * \param stream the output stream
+     * \param gauges the address of the state of the server
+     */
+
+    void stats_print (Stats_t *stats, FILE *stream, StatsGauges_t *gauges) ;
+
+
+
+    /*! Writes the statistics of a server to a file
+     *
+     * The statistics are written to a temporary file (the name of the file
+     * followed by .tmp) then renamed, so that a reader never sees them
+     * half written
+     *
+     * \param stats     the address of the statistics
+     * \param file_name the name of the file
+     * \param gauges    the address of the state of the server
+     *
+     * \return \c TDICE_SUCCESS if the operation succeeded
+     * \return \c TDICE_FAILURE if the file cannot be written. A message
+     *                          will be printed on standard error
+     */
+
+    Error_t stats_write_file
+
+        (Stats_t *stats, String_t file_name, StatsGauges_t *gauges) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_STATS_H_ */
@@ -0,0 +1,244 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_SUBMODEL_H_
+#define _3DICE_SUBMODEL_H_
+
+/*! \file submodel.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include "types.h"
+
+#include "analysis.h"
+#include "dimensions.h"
+#include "output.h"
+#include "power_grid.h"
+#include "stack_description.h"
+#include "system_matrix.h"
+#include "thermal_grid.h"
+
+#include "slu_mt_ddefs.h"
+
+/******************************************************************************/
+
+    /*! \struct Submodel_t
+     *
+     *  \brief Fine model of a region of interest of the IC
+     *
+     *  The region is described by the same stack of the (coarse) global
+     *  model, with its own grid of thermal cells. All the layers are kept.
+     *  The lateral faces of the region that do not lie on the border of
+     *  the IC are kept at the temperature of the coarse model, interpolated
+     *  at the center of each face after every coarse solve.
+     */
+
+    struct Submodel_t
+    {
+        /*! The position of the south-west corner of the region in the
+         *  coarse model (floorplan coordinates) */
+
+        ChipDimension_t OriginX, OriginY ;
+
+        /*! The number of cells of the submodel */
+
+        CellIndex_t Size ;
+
+        /*! The temperature of every cell of the submodel */
+
+        Temperature_t *Temperatures ;
+
+        /*! SuperLU vector B (wrapper around the Temperatures array) */
+
+        SuperMatrix SLUMatrix_B ;
+
+        /*! The thermal grid of the region */
+
+        ThermalGrid_t ThermalGrid ;
+
+        /*! The power grid of the region */
+
+        PowerGrid_t PowerGrid ;
+
+        /*! The system matrix of the region, boundary conductances included */
+
+        SystemMatrix_t SM_A ;
+
+        /*! The number of cell faces on the boundary of the region */
+
+        CellIndex_t NBoundaries ;
+
+        /*! The cell of the submodel every boundary face belongs to */
+
+        CellIndex_t *BoundaryCells ;
+
+        /*! The conductance between the center of the cell and its face */
+
+        Conductance_t *BoundaryConductances ;
+
+        /*! The four cells of the coarse model surrounding the center of
+         *  every boundary face ... */
+
+        CellIndex_t *CoarseCells ;
+
+        /*! ... and their weights in the (bilinear) interpolation */
+
+        double *CoarseWeights ;
+    } ;
+
+    /*! Definition of the type Submodel_t */
+
+    typedef struct Submodel_t Submodel_t ;
+
+/******************************************************************************/
+
+    /*! Inits the fields of the \a submodel structure with default values
+     *
+     * \param submodel the address of the structure to initalize
+     */
+
+    void submodel_init (Submodel_t *submodel) ;
+
+
+
+    /*! Builds the fine model of the region of interest
+     *
+     * \a stkd , \a analysis and \a output must come from a second parsing of
+     * the stack file of the coarse model. The dimensions of \a stkd are
+     * overridden with the region and the cells given in \a analysis , the
+     * floorplans are cropped to the region and the inspection points of
+     * \a output are moved on the new grid: cells out of the region are
+     * dropped and the names of the output files get the prefix
+     * "submodel_".
+     *
+     * \param submodel   the address of the Submodel to build
+     * \param stkd       the stack description of the submodel
+     * \param analysis   the analysis of the submodel
+     * \param output     the output of the submodel
+     * \param dimensions the dimensions of the coarse model
+     *
+     * \return \c TDICE_FAILURE if a layer has a material layout, if the
+     *                          memory allocation fails or if the
+     *                          factorization fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t submodel_build
+    (
+        Submodel_t         *submodel,
+        StackDescription_t *stkd,
+        Analysis_t         *analysis,
+        Output_t           *output,
+        Dimensions_t       *dimensions
+    ) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a submodel
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a submodel_init .
+     *
+     * \param submodel the address of the structure to destroy
+     */
+
+    void submodel_destroy (Submodel_t *submodel) ;
+
+
+
+    /*! Simulates a thermal step of the submodel, as \a emulate_step
+     *
+     * The function must be called after every step of the coarse model,
+     * with the temperatures it has just computed.
+     *
+     * \param submodel     address of the Submodel structure
+     * \param dimensions   address of the Dimensions of the submodel
+     * \param analysis     address of the Analysis of the submodel
+     * \param temperatures the temperatures of the coarse model
+     *
+     * \return \c TDICE_WRONG_CONFIG if the parameters refer to a steady
+     *                               state simulation
+     * \return \c TDICE_END_OF_SIMULATION if the power traces are over
+     * \return \c TDICE_SOLVER_ERROR if the solver fails
+     * \return \c TDICE_STEP_DONE or \c TDICE_SLOT_DONE otherwise
+     */
+
+    SimResult_t submodel_emulate_step
+    (
+        Submodel_t    *submodel,
+        Dimensions_t  *dimensions,
+        Analysis_t    *analysis,
+        Temperature_t *temperatures
+    ) ;
+
+
+
+    /*! Executes a steady state simulation of the submodel, as
+     *  \a emulate_steady
+     *
+     * \param submodel     address of the Submodel structure
+     * \param dimensions   address of the Dimensions of the submodel
+     * \param analysis     address of the Analysis of the submodel
+     * \param temperatures the temperatures of the coarse model
+     *
+     * \return \c TDICE_WRONG_CONFIG if the parameters refer to a transient
+     *                               simulation
+     * \return \c TDICE_SOLVER_ERROR if the solver fails
+     * \return \c TDICE_END_OF_SIMULATION otherwise
+     */
+
+    SimResult_t submodel_emulate_steady
+    (
+        Submodel_t    *submodel,
+        Dimensions_t  *dimensions,
+        Analysis_t    *analysis,
+        Temperature_t *temperatures
+    ) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_SUBMODEL_H_ */
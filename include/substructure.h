@@ -0,0 +1,341 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#ifndef _3DICE_SUBSTRUCTURE_H_
+#define _3DICE_SUBSTRUCTURE_H_
+
+/*! \file substructure.h */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************/
+
+#include "types.h"
+
+#include "dimensions.h"
+#include "system_matrix.h"
+#include "stack_element_list.h"
+
+#include "slu_mt_ddefs.h"
+
+/******************************************************************************/
+
+    /*! \struct SubstructureCoupling_t
+     *
+     *  \brief Coefficients of the system matrix that couple the interior of
+     *         a die with the interface, stored as (row, column, value)
+     */
+
+    struct SubstructureCoupling_t
+    {
+        /*! The number of coefficients */
+
+        Quantity_t NNz ;
+
+        /*! The (local) row index of each coefficient */
+
+        CellIndex_t *Rows ;
+
+        /*! The (local) column index of each coefficient */
+
+        CellIndex_t *Columns ;
+
+        /*! The value of each coefficient */
+
+        SystemMatrixCoeff_t *Values ;
+    } ;
+
+    /*! Definition of the type SubstructureCoupling_t */
+
+    typedef struct SubstructureCoupling_t SubstructureCoupling_t ;
+
+/******************************************************************************/
+
+    /*! \struct SubstructureBlock_t
+     *
+     *  \brief The interior of a die, shared by all the identical instances
+     *         of the die in the stack
+     *
+     *  The block is factorized once. The right hand sides of all its
+     *  instances are stored side by side in \c Vectors and solved together.
+     */
+
+    struct SubstructureBlock_t
+    {
+        /*! The system matrix of the interior of the die */
+
+        SystemMatrix_t SM_A ;
+
+        /*! The number of instances sharing the block */
+
+        Quantity_t NInstances ;
+
+        /*! One vector (of \c SM_A.Size values) for each instance */
+
+        double *Vectors ;
+
+        /*! SuperLU matrix B (wrapper around \c Vectors ) */
+
+        SuperMatrix SLUMatrix_B ;
+    } ;
+
+    /*! Definition of the type SubstructureBlock_t */
+
+    typedef struct SubstructureBlock_t SubstructureBlock_t ;
+
+/******************************************************************************/
+
+    /*! \struct SubstructureInstance_t
+     *
+     *  \brief A die stack element whose interior is eliminated from the
+     *         system through its Schur complement
+     */
+
+    struct SubstructureInstance_t
+    {
+        /*! The index of the first thermal cell of the interior */
+
+        CellIndex_t FirstCell ;
+
+        /*! The number of thermal cells in the interior */
+
+        CellIndex_t NCells ;
+
+        /*! The index of the block shared with the identical instances */
+
+        Quantity_t Block ;
+
+        /*! The index of the vector of the instance within the block */
+
+        Quantity_t Column ;
+
+        /*! Coefficients coupling the interior (rows)
+         *  to the interface (columns) */
+
+        SubstructureCoupling_t CouplingIn ;
+
+        /*! Coefficients coupling the interface (rows)
+         *  to the interior (columns) */
+
+        SubstructureCoupling_t CouplingOut ;
+
+        /*! The temperatures of the interior computed
+         *  with the interface at zero */
+
+        Temperature_t *Interior ;
+    } ;
+
+    /*! Definition of the type SubstructureInstance_t */
+
+    typedef struct SubstructureInstance_t SubstructureInstance_t ;
+
+/******************************************************************************/
+
+    /*! \struct Substructure_t
+     *
+     *  \brief Schur-complement solver of the linear system \c A x = b
+     *
+     *  The thermal cells are split in the interiors of the die stack
+     *  elements and in the interface (all the other cells). Dies that
+     *  share the same die definition, the same floorplan geometry and the
+     *  same coefficients in the system matrix use the same factorization.
+     *  The interface system, with the Schur complements of the dies applied
+     *  through their factorizations, is solved with BiCGSTAB preconditioned
+     *  by the factorization of the interface alone.
+     *
+     *  Factorization time and memory grow with the number of distinct dies
+     *  and not with the number of their instances.
+     */
+
+    struct Substructure_t
+    {
+        /*! The number of cells in the whole system (\c 0 if not built) */
+
+        CellIndex_t Size ;
+
+        /*! The number of distinct dies */
+
+        Quantity_t NBlocks ;
+
+        /*! The distinct dies */
+
+        SubstructureBlock_t *Blocks ;
+
+        /*! The number of die stack elements */
+
+        Quantity_t NInstances ;
+
+        /*! The die stack elements */
+
+        SubstructureInstance_t *Instances ;
+
+        /*! The number of cells in the interface */
+
+        CellIndex_t NInterface ;
+
+        /*! The index in the whole system of every interface cell */
+
+        CellIndex_t *InterfaceCells ;
+
+        /*! The system matrix of the interface alone (preconditioner) */
+
+        SystemMatrix_t SM_Interface ;
+
+        /*! Working vector for the preconditioner */
+
+        double *Work ;
+
+        /*! SuperLU vector B (wrapper around \c Work ) */
+
+        SuperMatrix SLUMatrix_Work ;
+
+        /*! The temperatures of the interface, kept as initial guess for
+         *  the next solve */
+
+        Temperature_t *Solution ;
+
+        /*! Working vectors for BiCGSTAB and for the reduced right hand side */
+
+        double *Krylov ;
+
+        /*! The number of BiCGSTAB iterations of the last solve */
+
+        Quantity_t NIterations ;
+
+        /*! The stack used to split the system (needed to update it) */
+
+        StackElementList_t *StackElements ;
+
+        /*! The dimensions of the IC (needed to update the splitting) */
+
+        Dimensions_t *Dimensions ;
+
+        /*! The number of threads given to the factorizations */
+
+        CellIndex_t NThreads ;
+    } ;
+
+    /*! Definition of the type Substructure_t */
+
+    typedef struct Substructure_t Substructure_t ;
+
+/******************************************************************************/
+
+
+
+    /*! Inits the fields of the \a sub structure with default values
+     *
+     * \param sub the address of the structure to initalize
+     */
+
+    void substructure_init (Substructure_t *sub) ;
+
+
+
+    /*! Splits and factorizes an already filled system matrix
+     *
+     * \param sub        the address of the Substructure to build
+     * \param sysmatrix  the system matrix (filled but not factorized)
+     * \param list       the list of stack element (bottom first)
+     * \param dimensions the dimensions of the IC
+     * \param threads    the number of threads for the factorizations
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails, if two dies
+     *                  touch each other or if a factorization fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t substructure_build
+    (
+        Substructure_t     *sub,
+        SystemMatrix_t     *sysmatrix,
+        StackElementList_t *list,
+        Dimensions_t       *dimensions,
+        CellIndex_t         threads
+    ) ;
+
+
+
+    /*! Splits and factorizes again a system matrix whose coefficients
+     *  changed (i.e. after a new coolant flow rate)
+     *
+     * \param sub        the address of the Substructure to update
+     * \param sysmatrix  the system matrix (filled but not factorized)
+     *
+     * \return \c TDICE_FAILURE if the factorization fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t substructure_update (Substructure_t *sub, SystemMatrix_t *sysmatrix) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a sub
+     *
+     * The function releases any dynamic memory used by the structure and
+     * resets its state calling \a substructure_init .
+     *
+     * \param sub the address of the structure to destroy
+     */
+
+    void substructure_destroy (Substructure_t *sub) ;
+
+
+
+    /*! Solve the linear system b = A/b
+     *
+     * \param sub the address of the Substructure
+     * \param b   the right hand side, overwritten with the solution
+     *
+     * \return \c TDICE_SUCCESS if the solution b has been found
+     * \return \c TDICE_FAILURE if some error occured or if the interface
+     *                          iterations do not converge
+     */
+
+    Error_t substructure_solve (Substructure_t *sub, double *b) ;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _3DICE_SUBSTRUCTURE_H_ */
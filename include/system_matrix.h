@@ -206,6 +206,18 @@ extern "C"
 
 
 
+    /*! Estimates the memory used by the system matrix and its factors
+     *
+     * \param sysmatrix the address of the system matrix
+     *
+     * \return the number of bytes used by the coefficients, the indices and
+     *         the nonzeroes of the factors (if the matrix is factored)
+     */
+
+    size_t system_matrix_memory (SystemMatrix_t *sysmatrix) ;
+
+
+
     /*! Destroys the content of the fields of the structure \a sysmatrix
      *
      * The function releases any dynamic memory used by the structure and
@@ -241,6 +253,41 @@ extern "C"
 
 
 
+    /*! Fills the columns of a rectangular window of the (uniform) grid
+     *
+     *  Only the columns of the cells within rows \a from_row .. \a to_row
+     *  and columns \a from_column .. \a to_column (all the layers) are
+     *  added, in the order used to number the cells. Row indices are
+     *  left as global cell indices: the caller must renumber them and
+     *  drop the ones falling outside the window. The matrix must have
+     *  room for (at most) 7 coefficients per cell of the window.
+     *
+     *  \param sysmatrix    pointer to the system matrix to fill
+     *  \param thermal_grid pointer to the thermal grid structure
+     *  \param analysis     pointer to the structure containing info
+     *                      about the type of thermal analysis
+     *  \param dimensions   pointer to the structure containing the
+     *                      dimensions of the IC
+     *  \param from_row     index of the first row of the window
+     *  \param to_row       index of the last row of the window
+     *  \param from_column  index of the first column of the window
+     *  \param to_column    index of the last column of the window
+     */
+
+    void fill_system_matrix_window
+    (
+        SystemMatrix_t *sysmatrix,
+        ThermalGrid_t  *thermal_grid,
+        Analysis_t     *analysis,
+        Dimensions_t   *dimensions,
+        CellIndex_t     from_row,
+        CellIndex_t     to_row,
+        CellIndex_t     from_column,
+        CellIndex_t     to_column
+    ) ;
+
+
+
     /*! Perform the A=LU decomposition on the system matrix
      *
      * \param sysmatrix pointer to the (system) matrix \a A to factorize
@@ -266,6 +313,25 @@ extern "C"
 
 
 
+    /*! Solve the linear system b = A/b without touching the state of A
+     *
+     * Same as \a solve_sparse_linear_system but the SuperLU statistics and
+     * the error code are kept on the stack of the caller, so that several
+     * threads can solve different right hand sides against the same L and U
+     * factors at the same time.
+     *
+     * \param sysmatrix pointer to the (system) matrix \a A (already factorized)
+     * \param b    pointer to the input vector \a b
+     *
+     * \return \c TDICE_SUCCESS if the solution b has been found
+     * \return \c TDICE_FAILURE if some error occured
+     */
+
+    Error_t solve_sparse_linear_system_concurrent
+        (SystemMatrix_t *sysmatrix, SuperMatrix *b) ;
+
+
+
     /*! Generates a text file storing the sparse matrix
      *
      * The file will contain one row of the form row-column-value" for each
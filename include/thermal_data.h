@@ -54,12 +54,14 @@ extern "C"
 #include "analysis.h"
 #include "stack_element_list.h"
 #include "system_matrix.h"
+#include "substructure.h"
 #include "thermal_grid.h"
 #include "power_grid.h"
 #include "dimensions.h"
 #include "connection_list.h"
 #include "material_list.h"
 #include "layer_list.h"
+#include "stats.h"
 
 #include "slu_mt_ddefs.h"
 
@@ -101,6 +103,35 @@ extern "C"
         /*! SuperLU vector B (wrapper around the Temperatures array) */
 
         SuperMatrix SLUMatrix_B ;
+
+        /*! Schur-complement solver used in place of the factorization of
+         *  \c SM_A when the analysis asks for substructuring */
+
+        Substructure_t Substructure ;
+
+        /*! Copy of the right hand side of the system, without the leakage
+         *  power, used to solve again the system while the leakage power
+         *  of the floorplan elements converges. \c NULL if not needed */
+
+        double *LeakageVector ;
+
+        /*! Steady state temperatures the transient starts from, restored
+         *  by \a reset_thermal_state . \c NULL if the transient starts
+         *  from the uniform initial temperature */
+
+        Temperature_t *InitialTemperatures ;
+
+        /*! \c true if the structure is a session of another ThermalData
+         *  (see \a thermal_data_share ): the thermal grid, the system matrix
+         *  and its factors belong to the other structure, only the
+         *  temperatures, the sources and the floorplans are private */
+
+        bool Shared ;
+
+        /*! The histograms ( \c TDICE_STATS_NPHASES ) where the steps
+         *  record the duration of their phases. \c NULL if not measured */
+
+        StatsHistogram_t *Phases ;
     } ;
 
 
@@ -110,6 +141,60 @@ extern "C"
 
 
 
+    /*! \struct ThermalSnapshot_t
+     *
+     * \brief A copy of the state of a transient simulation, to go back to it
+     *
+     * The state is what changes while the simulation goes on: the
+     * temperatures, the source vector, the clock of the analysis, the power
+     * values still to simulate and the state of a pluggable heatsink. The
+     * system matrix and its factors are not part of it, so restoring a
+     * snapshot needs no new factorization. A snapshot can be restored in any
+     * session of the ThermalData it was saved from.
+     */
+
+    struct ThermalSnapshot_t
+    {
+        /*! The number of cells in the 3D grid */
+
+        CellIndex_t Size ;
+
+        /*! The temperature of each thermal cell */
+
+        Temperature_t *Temperatures ;
+
+        /*! The source vector (constant within a time slot) */
+
+        Source_t *Sources ;
+
+        /*! The number of time steps simulated */
+
+        Quantity_t CurrentTime ;
+
+        /*! The number of floorplan elements in the stack */
+
+        Quantity_t NPowerQueues ;
+
+        /*! The power values queued to each floorplan element */
+
+        PowersQueue_t *PowerQueues ;
+
+        /*! The size in bytes of the state of the pluggable heatsink */
+
+        size_t HeatSinkStateSize ;
+
+        /*! The state of the pluggable heatsink, \c NULL if none */
+
+        void *HeatSinkState ;
+    } ;
+
+
+    /*! Definition of the type ThermalSnapshot_t */
+
+    typedef struct ThermalSnapshot_t ThermalSnapshot_t ;
+
+
+
 /******************************************************************************/
 
 
@@ -206,6 +291,51 @@ extern "C"
         MaterialList_t     *materials
     ) ;
 
+    /*! Allocs and fills the grids and the system matrix, the first part of
+     *  \c thermal_data_build
+     *
+     * \param tdata      the address of the ThermalData to fill
+     * \param list       the list of stack element (bottom first)
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the address of the Analysis structure
+     * \param materials  defined material list in stk file
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t thermal_data_assemble
+    (
+        ThermalData_t      *tdata,
+        StackElementList_t *list,
+        Dimensions_t       *dimensions,
+        Analysis_t         *analysis,
+        MaterialList_t     *materials
+    ) ;
+
+    /*! Computes the initial state, if not uniform, and splits the system
+     *  matrix in A=LU (or in the substructures), the second part of
+     *  \c thermal_data_build
+     *
+     * \param tdata      the address of the ThermalData filled by
+     *                   \c thermal_data_assemble
+     * \param list       the list of stack element (bottom first)
+     * \param dimensions the dimensions of the IC
+     * \param analysis   the address of the Analysis structure
+     *
+     * \return \c TDICE_FAILURE if the system matrix cannot be factorized.
+     *                          \a tdata is destroyed
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t thermal_data_factorize
+    (
+        ThermalData_t      *tdata,
+        StackElementList_t *list,
+        Dimensions_t       *dimensions,
+        Analysis_t         *analysis
+    ) ;
+
     /*! Set the number of cores for non-uniform and superlu_mt
      *
      * \param analysis   the address of the Analysis structure
@@ -218,10 +348,51 @@ extern "C"
         Quantity_t         num
     ) ;
 
+    /*! Builds a session of an already built ThermalData
+     *
+     * The session shares, read only, the thermal grid, the system matrix and
+     * its L and U factors of \a shared , while it has its own temperatures,
+     * sources and floorplans (and so its own power queues). Different
+     * sessions of the same ThermalData can then be simulated concurrently,
+     * each one with its own Analysis structure. \a shared must not be
+     * destroyed before its sessions.
+     *
+     * \param tdata    the address of the ThermalData to fill
+     * \param shared   the address of the ThermalData to share
+     * \param analysis the address of the Analysis structure of the session
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails or \a shared
+     *                          uses substructuring or a pluggable heatsink
+     *                          (whose state cannot be shared)
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t thermal_data_share
+    (
+        ThermalData_t *tdata,
+        ThermalData_t *shared,
+        Analysis_t    *analysis
+    ) ;
+
+    /*! Estimates the memory used by the thermal data
+     *
+     * The vectors and the system matrix with its factors are counted, while
+     * the grids and the substructures are not.
+     *
+     * \param tdata the address of the thermal data
+     *
+     * \return the number of bytes
+     */
+
+    size_t thermal_data_memory (ThermalData_t *tdata) ;
+
+
+
     /*! Destroys the content of the fields of the structure \a tdata
      *
      * The function releases any dynamic memory used by the structure and
-     * resets its state calling \a thermal_data_init .
+     * resets its state calling \a thermal_data_init . For a session, only
+     * the private memory is released.
      *
      * \param tdata the address of the structure to destroy
      */
@@ -230,7 +401,8 @@ extern "C"
 
 
 
-    /*! Reset the thermal state to the initial temperature
+    /*! Reset the thermal state to the initial temperature (or to the
+     *  initial steady state, if the analysis asks for it)
      *
      * \param tdata     the address of the ThermalData structure to reset
      * \param analysis the address of the Analysis structure related to \a tdata
@@ -240,6 +412,76 @@ extern "C"
 
 
 
+    /*! Inits the fields of the \a snapshot structure with default values
+     *
+     * \param snapshot the address of the structure to initalize
+     */
+
+    void thermal_snapshot_init (ThermalSnapshot_t *snapshot) ;
+
+
+
+    /*! Destroys the content of the fields of the structure \a snapshot
+     *
+     * \param snapshot the address of the structure to destroy
+     */
+
+    void thermal_snapshot_destroy (ThermalSnapshot_t *snapshot) ;
+
+
+
+    /*! Estimates the memory used by a snapshot
+     *
+     * \param snapshot the address of the snapshot
+     *
+     * \return the number of bytes
+     */
+
+    size_t thermal_snapshot_memory (ThermalSnapshot_t *snapshot) ;
+
+
+
+    /*! Saves the state of a transient simulation in a snapshot
+     *
+     * The memory of \a snapshot is reused if it has already been used to
+     * save the state of the same ThermalData (or of one of its sessions), so
+     * that the snapshot costs only the copy of the state.
+     *
+     * \param tdata    the address of the ThermalData structure to save
+     * \param analysis the address of the Analysis structure related to \a tdata
+     * \param snapshot the address of the snapshot to fill
+     *
+     * \return \c TDICE_FAILURE if the memory allocation fails or if the
+     *                          pluggable heatsink cannot save its state
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t save_thermal_state
+
+        (ThermalData_t *tdata, Analysis_t *analysis, ThermalSnapshot_t *snapshot) ;
+
+
+
+    /*! Restores the state of a transient simulation saved in a snapshot
+     *
+     * The snapshot is not changed and can be restored again.
+     *
+     * \param tdata    the address of the ThermalData structure to restore
+     * \param analysis the address of the Analysis structure related to \a tdata
+     * \param snapshot the address of the snapshot to restore
+     *
+     * \return \c TDICE_FAILURE if \a snapshot was not saved from the same
+     *                          ThermalData (or one of its sessions) or if the
+     *                          pluggable heatsink cannot restore its state
+     * \return \c TDICE_SUCCESS otherwise
+     */
+
+    Error_t restore_thermal_state
+
+        (ThermalData_t *tdata, Analysis_t *analysis, ThermalSnapshot_t *snapshot) ;
+
+
+
     /*! Simulates a time step
      *
      * \param tdata           the address of the ThermalData to fill
@@ -237,6 +237,25 @@ extern "C"
 
     typedef enum HeatSinkModel_t HeatSinkModel_t ;
 
+/******************************************************************************/
+
+    /*! \enum LeakageModel_t
+     *
+     *   Enumeration to collect the supported models of the leakage power
+     *   of a floorplan element as a function of its temperature
+     */
+
+    enum LeakageModel_t
+    {
+        TDICE_LEAKAGE_NONE = 0,          //!< Undefined type
+        TDICE_LEAKAGE_EXPONENTIAL,       //!< P0 exp (beta (T - T0))
+        TDICE_LEAKAGE_PIECEWISE_LINEAR   //!< Interpolation of (T, P) points
+    } ;
+
+    /*! The definition of the type LeakageModel_t */
+
+    typedef enum LeakageModel_t LeakageModel_t ;
+
 /******************************************************************************/
 
     /*! \enum StackLayerType_t
@@ -469,6 +488,27 @@ extern "C"
 
     typedef enum AnalysisType_t AnalysisType_t ;
 
+/******************************************************************************/
+
+    /*! \enum InitialState_t
+     *
+     *  Enumeration to collect the possible initial thermal states
+     *  of a transient analysis
+     */
+
+    enum InitialState_t
+    {
+        TDICE_INITIAL_STATE_UNIFORM = 0,     //!< Uniform initial temperature
+        TDICE_INITIAL_STATE_STEADY,          //!< Steady state for the first power values
+        TDICE_INITIAL_STATE_STEADY_AVERAGE   //!< Steady state for the average power values
+    } ;
+
+
+
+    /*! the definition of the type InitialState_t */
+
+    typedef enum InitialState_t InitialState_t ;
+
 
 
     /*! \enum OutputQuantity_t
@@ -722,9 +762,281 @@ extern "C"
          *
          * | length | TDICE_SEND_OUTPUT_FILES | nfiles |
          * | filename_length | file_length | filename bytes | file bytes | ...
+         *
+         * Since version 4, the client can ask for a part of the files, to
+         * resume a transfer or to follow the files while they grow. The
+         * request tells from where to start ( \c OutputFilesMode_t and the
+         * offset, as an unsigned 64 bit value over two words), the maximum
+         * number of bytes to send per file (0 means no limit) and the name
+         * of the file to send (all the files if name_length is 0) :
+         *
+         * | length | TDICE_SEND_OUTPUT_FILES | OutputFilesMode_t | max_bytes |
+         * | offset | name_length | name bytes |
+         *
+         * The reply carries, for each file, the offset of its first byte:
+         *
+         * | length | TDICE_SEND_OUTPUT_FILES | nfiles |
+         * | filename_length | file_length | offset | filename bytes | file bytes | ...
+         *
+         * In both cases a reply carries at most 1 GiB of file bytes: the
+         * rest can be requested with \c TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST
          */
 
         TDICE_SEND_OUTPUT_FILES,
+
+
+
+        /*! \brief Insert powers, simulate and request outputs in one exchange
+         *
+         * The client sends the power values (as in \c TDICE_INSERT_POWERS ,
+         * \c n can be 0 to keep the queued ones), the unit of simulation
+         * ( \c TDICE_SIMULATE_SLOT or \c TDICE_SIMULATE_STEP ), how many
+         * units to simulate and the outputs it wants (as in
+         * \c TDICE_SEND_OUTPUT ):
+         *
+         * | length | TDICE_SIMULATE_AND_SEND_OUTPUT | n | power0 | ... | power n-1 |
+         * | unit | count | nout | OutputInstant_t | OutputType_t | OutputQuantity_t | ... |
+         *
+         * The server simulates until \c count units are done or a simulation
+         * does not succeed and sends back its state, the time and, if the
+         * simulations succeeded, the outputs, each one as in the reply to
+         * \c TDICE_SEND_OUTPUT (nout is \c 0 otherwise):
+         *
+         * | length | TDICE_SIMULATE_AND_SEND_OUTPUT | SimResult_t | time | nout |
+         * | nip | ip 1 | ... | ip nip | ... |
+         */
+
+        TDICE_SIMULATE_AND_SEND_OUTPUT,
+
+
+
+        /*! \brief Negotiates the version of the protocol
+         *
+         * The client sends, as its first request, the highest version it
+         * implements ( \c TDICE_PROTOCOL_VERSION ) :
+         *
+         * | 3 | TDICE_NEGOTIATE_PROTOCOL | version |
+         *
+         * The server replies with the version both sides will use, the lowest
+         * of the two. A server implementing only version 1 does not know the
+         * request and does not reply: the client uses the version 1 if no
+         * reply comes within \c TDICE_NEGOTIATION_TIMEOUT milliseconds :
+         *
+         * | 3 | TDICE_NEGOTIATE_PROTOCOL | version |
+         */
+
+        TDICE_NEGOTIATE_PROTOCOL,
+
+
+
+        /*! \brief Request the temperature of every thermal cell (version 2)
+         *
+         * The client sends the precision of the values to receive:
+         *
+         * | 3 | TDICE_SEND_THERMAL_STATE | BulkType_t |
+         *
+         * The server replies with the time and the temperatures, in the order
+         * of the cells in the stack, as a bulk section:
+         *
+         * | length | TDICE_SEND_THERMAL_STATE | time | BulkType_t | n | T 1 | ... | T n |
+         */
+
+        TDICE_SEND_THERMAL_STATE,
+
+
+
+        /*! \brief Request the thermal map of a stack element (version 2)
+         *
+         * The client sends the precision of the values and the name of the
+         * stack element (a die or a layer) :
+         *
+         * | length | TDICE_SEND_THERMAL_MAP | BulkType_t | name_length | name bytes |
+         *
+         * The server replies with the time, the size of the map and its
+         * temperatures as a bulk section. An unknown stack element has a
+         * map of size 0 x 0 :
+         *
+         * | length | TDICE_SEND_THERMAL_MAP | time | nrows | ncolumns |
+         * | BulkType_t | n | T 1 | ... | T n |
+         */
+
+        TDICE_SEND_THERMAL_MAP,
+
+
+
+        /*! \brief Moves the connection to a shared memory segment (version 3)
+         *
+         * The client, running on the same host as the server, sends the name
+         * of a segment created with \c shared_memory_create :
+         *
+         * | length | TDICE_OPEN_SHARED_MEMORY | name_length | name bytes |
+         *
+         * The server attaches the segment and replies, still on the socket:
+         *
+         * | 3 | TDICE_OPEN_SHARED_MEMORY | Error_t |
+         *
+         * If the reply is \c TDICE_SUCCESS , both sides exchange all the
+         * following messages, unchanged, through the segment
+         */
+
+        TDICE_OPEN_SHARED_MEMORY,
+
+
+
+        /*! \brief Sets the resolution of the delta encoded bulk sections
+         *         (version 5)
+         *
+         * The client sends the resolution, in Kelvin, of the temperatures
+         * it will receive in the \c TDICE_BULK_DELTA sections (1 mK if
+         * never set) :
+         *
+         * | 3 | TDICE_SET_BULK_RESOLUTION | resolution |
+         *
+         * The server replies if the resolution is valid (at least 1 uK) :
+         *
+         * | 3 | TDICE_SET_BULK_RESOLUTION | Error_t |
+         *
+         * Since a change of resolution, every map (and the thermal state)
+         * is sent again in full the first time it is requested
+         */
+
+        TDICE_SET_BULK_RESOLUTION,
+
+
+
+        /*! \brief Saves the thermal state of the session (version 6)
+         *
+         * The server keeps a copy of the temperatures, of the clock of the
+         * analysis and of the power values not simulated yet, and replies
+         * with the handle of the copy:
+         *
+         * | 2 | TDICE_SAVE_THERMAL_STATE |
+         *
+         * | 4 | TDICE_SAVE_THERMAL_STATE | Error_t | handle |
+         *
+         * The handles are valid in every session of the server until
+         * deleted or until the end of the session that saved them. A
+         * session saves at most 64 states, and none beyond the memory
+         * budget of the server: then the server replies \c TDICE_FAILURE
+         */
+
+        TDICE_SAVE_THERMAL_STATE,
+
+
+
+        /*! \brief Restores a thermal state saved with
+         *         \c TDICE_SAVE_THERMAL_STATE (version 6)
+         *
+         * The saved state replaces the one of the session, and it can be
+         * restored again (to try other power values from the same point).
+         * A handle saved by another session forks that session:
+         *
+         * | 3 | TDICE_RESTORE_THERMAL_STATE | handle |
+         *
+         * | 3 | TDICE_RESTORE_THERMAL_STATE | Error_t |
+         *
+         * The output files are not rolled back
+         */
+
+        TDICE_RESTORE_THERMAL_STATE,
+
+
+
+        /*! \brief Deletes a thermal state saved with
+         *         \c TDICE_SAVE_THERMAL_STATE (version 6)
+         *
+         * | 3 | TDICE_DELETE_THERMAL_STATE | handle |
+         *
+         * | 3 | TDICE_DELETE_THERMAL_STATE | Error_t |
+         */
+
+        TDICE_DELETE_THERMAL_STATE,
+
+
+
+        /*! \brief Turns on or off the speculative steps (version 7)
+         *
+         * While the session waits for the next request, the server
+         * simulates ahead the next time step, with the power values it
+         * already has or, at the end of a slot with no power values left,
+         * with the last ones received. The step is kept if the next
+         * request is \c TDICE_SIMULATE_STEP (after, at most,
+         * \c TDICE_INSERT_POWERS requests with the same power values) and
+         * undone before any other request, so the results do not change:
+         *
+         * | 3 | TDICE_SPECULATE_STEPS | 0 (off) or 1 (on) |
+         *
+         * | 3 | TDICE_SPECULATE_STEPS | Error_t |
+         *
+         * It fails if the analysis is not transient
+         */
+
+        TDICE_SPECULATE_STEPS,
+
+
+
+        /*! \brief Asks how far the server is in building the model
+         *         (version 8)
+         *
+         * The server accepts the clients while it parses the stack and
+         * builds the model. Until the model is ready, only this request,
+         * \c TDICE_NEGOTIATE_PROTOCOL, \c TDICE_SELECT_MODEL,
+         * \c TDICE_GET_STATS and \c TDICE_EXIT_SIMULATION are served: the
+         * others wait for the model, in order.
+         *
+         * | 2 | TDICE_SEND_MODEL_STATUS |
+         *
+         * | 6 | TDICE_SEND_MODEL_STATUS | ModelPhase_t | parse | build | factorization |
+         *
+         * The last three words are the seconds (as float) spent in each
+         * phase, the one running included
+         */
+
+        TDICE_SEND_MODEL_STATUS,
+
+
+
+        /*! \brief Selects the stack the session simulates (version 9)
+         *
+         * The server hosts a model for each stack file used by its
+         * sessions, built in the background the first time the file is
+         * selected (and again if the file, or one of the floorplan, layout
+         * and plugin files it refers to, changes). The sessions that do
+         * not select a stack use the one given to the server. The path of
+         * the stack file is relative to the working directory of the
+         * server, and the file must be in the directory of the stack file
+         * of the server (or below it) :
+         *
+         * | length | TDICE_SELECT_MODEL | path_length | path bytes |
+         *
+         * | 3 | TDICE_SELECT_MODEL | Error_t |
+         *
+         * It fails if the file cannot be read or is not in that directory,
+         * or if the session already used its model. The build fails if the
+         * stack uses a pluggable heat sink while another model hosted uses
+         * one. The build can be followed with \c TDICE_SEND_MODEL_STATUS
+         */
+
+        TDICE_SELECT_MODEL,
+
+
+
+        /*! \brief Requests the statistics of the server (version 10)
+         *
+         * The server replies with the counters of the requests served,
+         * the distribution of their durations and of the phases of the
+         * simulation ( \c StatsPhase_t ), and its memory usage, as the
+         * text format of Prometheus (the same text it can write
+         * periodically to a file) :
+         *
+         * | 2 | TDICE_GET_STATS |
+         *
+         * | length | TDICE_GET_STATS | text_length | text bytes |
+         *
+         * The statistics are those of the whole server, not of the session
+         */
+
+        TDICE_GET_STATS,
     } ;
 
 
@@ -741,6 +1053,92 @@ extern "C"
 
 
 
+    /*! \enum BulkType_t
+     *
+     * The precision of the values stored in a bulk section of a message
+     */
+
+    enum BulkType_t
+    {
+        TDICE_BULK_FLOAT = 0,  //!< One word per value
+        TDICE_BULK_DOUBLE,     //!< Two words per value
+        TDICE_BULK_DELTA       //!< Quantized changes, run-length and varint encoded
+    } ;
+
+
+
+    /*! Definition of the type BulkType_t */
+
+    typedef enum BulkType_t BulkType_t ;
+
+
+
+    /*! \enum OutputFilesMode_t
+     *
+     * Where the transfer of an output file starts
+     */
+
+    enum OutputFilesMode_t
+    {
+        TDICE_OUTPUT_FILES_WHOLE = 0,          //!< From the beginning
+        TDICE_OUTPUT_FILES_FROM_OFFSET,        //!< From the offset requested
+        TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST  //!< From the first byte not sent yet
+    } ;
+
+
+
+    /*! Definition of the type OutputFilesMode_t */
+
+    typedef enum OutputFilesMode_t OutputFilesMode_t ;
+
+
+
+
+    /*! \enum ModelPhase_t
+     *
+     * The phase the server is in while building the model
+     */
+
+    enum ModelPhase_t
+    {
+        TDICE_MODEL_PARSING = 0,   //!< Parsing the stack description
+        TDICE_MODEL_BUILDING,      //!< Filling the grids and the system matrix
+        TDICE_MODEL_FACTORIZING,   //!< Factorizing the system matrix
+        TDICE_MODEL_READY,         //!< The requests can be served
+        TDICE_MODEL_FAILED         //!< The model cannot be built
+    } ;
+
+
+
+    /*! Definition of the type ModelPhase_t */
+
+    typedef enum ModelPhase_t ModelPhase_t ;
+
+
+
+    /*! \enum StatsPhase_t
+     *
+     * The phases of the simulation whose durations the server measures
+     */
+
+    enum StatsPhase_t
+    {
+        TDICE_STATS_FILL_VECTOR = 0,  //!< Filling the sources and the system vector
+        TDICE_STATS_SOLVE,            //!< Solving the system (leakage iterations included)
+        TDICE_STATS_PLUGIN,           //!< Running the pluggable heat sink
+        TDICE_STATS_OUTPUT,           //!< Generating the outputs
+        TDICE_STATS_MESSAGE_IO,       //!< Receiving the requests and sending the replies
+        TDICE_STATS_NPHASES           //!< The number of phases
+    } ;
+
+
+
+    /*! Definition of the type StatsPhase_t */
+
+    typedef enum StatsPhase_t StatsPhase_t ;
+
+
+
     /******************************************************************************/
 
     /*! \enum StackElementType_t
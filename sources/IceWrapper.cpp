@@ -37,14 +37,18 @@
  ******************************************************************************/
 
 #include <stdlib.h>
+#include <memory>
+#include <stdexcept>
 #include "IceWrapper.h"
 
-IceWrapper::IceWrapper(std::string serverIp, unsigned int portNumber)
+IceWrapper::IceWrapper(std::string serverIp, unsigned int portNumber, std::string stackFile)
 {
     SC_REPORT_INFO("3D-ICE","Starting thermal simulation");
     // Configure Connection
     serverIP = serverIp;
     serverPort = portNumber;
+    ioPending = 0;
+    ioStop = false;
 
     if(openConnection() == false)
     {
@@ -52,12 +56,39 @@ IceWrapper::IceWrapper(std::string serverIp, unsigned int portNumber)
         exit(EXIT_FAILURE);
     }
 
+    protocolVersion = negotiateProtocol();
+
+    // The stack must be selected before the first request that needs it
+    if (!stackFile.empty() && selectModel(stackFile) == false)
+    {
+        SC_REPORT_FATAL("3D-ICE","Cannot select the stack of the thermal simulation");
+        exit(EXIT_FAILURE);
+    }
+
     // Get information about system architecture:
     numberOfFloorplanElements = getNumberOfFloorplanElements();
+
+    bulkResolution = 0.0;
+    bulk_reference_init (&stateReference) ;
+
+    // From now on the requests go through the background thread
+    ioThread = std::thread(&IceWrapper::ioLoop, this);
 }
 
 IceWrapper::~IceWrapper()
 {
+    // The requests still pending are sent before stopping
+    {
+        std::lock_guard<std::mutex> lock(ioLock);
+        ioStop = true;
+    }
+    ioChanged.notify_all();
+    ioThread.join();
+
+    bulk_reference_destroy (&stateReference) ;
+    for (auto &reference : mapReferences)
+        bulk_reference_destroy (&reference.second) ;
+
     if(closeConnection() == false)
     {
         SC_REPORT_FATAL("3D-ICE","Cannot close connection to thermal simulation");
@@ -90,14 +121,97 @@ bool IceWrapper::closeConnection()
     return (socket_close(&client_socket) == TDICE_SUCCESS);
 }
 
+void IceWrapper::ioLoop()
+{
+    std::unique_lock<std::mutex> lock(ioLock);
+
+    while (true)
+    {
+        ioChanged.wait(lock, [this] { return ioStop || !ioRequests.empty(); });
+
+        if (ioRequests.empty())
+            return;
+
+        std::function<void()> request = std::move(ioRequests.front());
+        ioRequests.pop_front();
+
+        // The exchange with the server runs without the lock, so that
+        // other requests can be posted meanwhile
+        lock.unlock();
+        request();
+        lock.lock();
+
+        ioPending--;
+        ioChanged.notify_all();
+    }
+}
+
+template <typename T> std::future<T> IceWrapper::post(std::function<T()> exchange)
+{
+    auto request = std::make_shared<std::packaged_task<T()>>(exchange);
+    std::future<T> reply = request->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(ioLock);
+        ioRequests.push_back([request] { (*request)(); });
+        ioPending++;
+    }
+    ioChanged.notify_all();
+
+    return reply;
+}
+
+template <typename T> T IceWrapper::wait(std::future<T> reply)
+{
+    try
+    {
+        return reply.get();
+    }
+    catch (std::runtime_error &error)
+    {
+        SC_REPORT_FATAL("3D-ICE", error.what());
+        throw;
+    }
+}
+
+void IceWrapper::sendMessage(NetworkMessage_t *message)
+{
+    Error_t error = send_message_to_socket (&client_socket, message) ;
+    network_message_destroy (message) ;
+
+    if (error != TDICE_SUCCESS)
+    {
+        throw std::runtime_error("Cannot send the request to the thermal simulation");
+    }
+}
+
+void IceWrapper::receiveMessage(NetworkMessage_t *message)
+{
+    network_message_init (message) ;
+
+    if (receive_message_from_socket (&client_socket, message) != TDICE_SUCCESS)
+    {
+        network_message_destroy (message) ;
+        throw std::runtime_error("Cannot receive the reply of the thermal simulation");
+    }
+}
+
+void IceWrapper::synchronize()
+{
+    std::unique_lock<std::mutex> lock(ioLock);
+    ioChanged.wait(lock, [this] { return ioPending == 0; });
+}
+
 unsigned int IceWrapper::getNumberOfFloorplanElements()
 {
     unsigned int value;
 
+    synchronize();
+
     network_message_init(&client_nflp) ;
     build_message_head(&client_nflp, TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS);
-    send_message_to_socket(&client_socket, &client_nflp);
-    receive_message_from_socket(&client_socket, &client_nflp);
+    sendMessage(&client_nflp);
+    receiveMessage(&client_nflp);
     extract_message_word(&client_nflp, &value, 0);
     network_message_destroy(&client_nflp);
 
@@ -106,12 +220,68 @@ unsigned int IceWrapper::getNumberOfFloorplanElements()
     return value;
 }
 
+unsigned int IceWrapper::negotiateProtocol()
+{
+    Quantity_t version;
+
+    // A server implementing only the version 1 does not reply
+    if (negotiate_protocol(&client_socket, &version) != TDICE_SUCCESS)
+    {
+        throw std::runtime_error("Cannot negotiate the protocol with the thermal simulation");
+    }
+
+    // Debug
+    cout << "Protocol version: " << version << endl;
+    return version;
+}
+
+bool IceWrapper::selectModel(std::string stackFile)
+{
+    if (protocolVersion < 9)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not host many stacks");
+    }
+
+    NetworkMessage_t client_select;
+    unsigned int path_length = stackFile.size();
+    Error_t result = TDICE_FAILURE;
+
+    network_message_init (&client_select) ;
+    build_message_head   (&client_select, TDICE_SELECT_MODEL) ;
+    insert_message_word  (&client_select, &path_length) ;
+
+    for (unsigned int i = 0 ; i < path_length ; i += sizeof (MessageWord_t))
+    {
+        MessageWord_t word = 0;
+        stackFile.copy((char *) &word, sizeof (MessageWord_t), i);
+        insert_message_word (&client_select, &word) ;
+    }
+
+    sendMessage (&client_select) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &result, 0) ;
+    network_message_destroy (&server_reply) ;
+
+    return result == TDICE_SUCCESS;
+}
+
 void IceWrapper::sendPowerValues(std::vector<float> * powerValues)
 {
-    if(powerValues->size() != numberOfFloorplanElements)
+    wait(sendPowerValuesAsync(*powerValues));
+}
+
+std::future<void> IceWrapper::sendPowerValuesAsync(std::vector<float> powerValues)
+{
+    if(powerValues.size() != numberOfFloorplanElements)
     {
         SC_REPORT_FATAL("3D-ICE","Wrong number of power numbers");
     }
+    return post<void>([this, powerValues] () mutable { exchangePowerValues(powerValues); });
+}
+
+void IceWrapper::exchangePowerValues(std::vector<float> &powerValues)
+{
     network_message_init (&client_powers) ;
     build_message_head   (&client_powers, TDICE_INSERT_POWERS) ;
     insert_message_word  (&client_powers, &numberOfFloorplanElements) ;
@@ -119,51 +289,75 @@ void IceWrapper::sendPowerValues(std::vector<float> * powerValues)
     float power;
     for (unsigned int i = 0 ; i != numberOfFloorplanElements ; i++)
     {
-        power = powerValues->at(i);
+        power = powerValues.at(i);
         insert_message_word (&client_powers, &power) ;
     }
 
-    send_message_to_socket (&client_socket, &client_powers);
-    network_message_destroy (&client_powers);
+    sendMessage (&client_powers) ;
 
-    // Get result from Thermal Simulator (BLOCKING)
-    network_message_init (&server_reply);
-    receive_message_from_socket (&client_socket, &server_reply);
+    // Get result from Thermal Simulator (BLOCKING the background thread)
+    receiveMessage (&server_reply) ;
     Error_t error;
     extract_message_word (&server_reply, &error, 0);
+    network_message_destroy (&server_reply);
 
     if (error != TDICE_SUCCESS)
     {
-        network_message_destroy (&server_reply);
-        closeConnection();
-        SC_REPORT_FATAL("3D-ICE","Cannot send power values");
+        throw std::runtime_error("Cannot send power values");
     }
-    network_message_destroy (&server_reply);
 }
 
 void IceWrapper::simulate()
+{
+    wait(simulateAsync());
+}
+
+std::future<void> IceWrapper::simulateAsync()
+{
+    return post<void>([this] { exchangeSimulate(); });
+}
+
+void IceWrapper::exchangeSimulate()
 {
     network_message_init (&client_simulate) ;
     build_message_head   (&client_simulate, TDICE_SIMULATE_SLOT) ;
-    send_message_to_socket (&client_socket, &client_simulate) ;
-    network_message_destroy (&client_simulate) ;
+    sendMessage (&client_simulate) ;
 
-    // Wait for Simulation Result (BLOCKING)
-    network_message_init (&server_reply) ;
-    receive_message_from_socket (&client_socket, &server_reply) ;
+    // Wait for Simulation Result (BLOCKING the background thread)
+    receiveMessage (&server_reply) ;
     SimResult_t sim_result ;
     extract_message_word (&server_reply, &sim_result, 0) ;
+    network_message_destroy (&server_reply) ;
 
     if (sim_result != TDICE_SLOT_DONE)
     {
-        network_message_destroy (&server_reply) ;
-        closeConnection();
-        SC_REPORT_FATAL("3D-ICE","Cannot send power values");
+        throw std::runtime_error("Cannot simulate the time slot");
     }
-    network_message_destroy (&server_reply) ;
 }
 
 void IceWrapper::getTemperature(std::vector<float> &TemperatureValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
+{
+    Output output = wait(getTemperatureAsync(instant, type, quantity));
+    double time = output.time;
+
+    // Check if the SystemC time is almost aligned (+-1ns) with 3D-ICE time 
+    if(   sc_time(time, SC_SEC) >= (sc_time_stamp()+sc_time(1, SC_NS))
+            && sc_time(time, SC_SEC) <= (sc_time_stamp()-sc_time(1, SC_NS)))
+    {
+        fprintf (stdout, "%5.9e sec : \t", time) ;
+        std::cout << " @" << sc_time_stamp() << ":" << sc_time(time, SC_SEC) << endl;
+        SC_REPORT_FATAL("3D-ICE","The time of 3D-ICE is not in sync with the current SystemC time");
+    }
+
+    TemperatureValues.insert(TemperatureValues.end(), output.values.begin(), output.values.end());
+}
+
+std::future<IceWrapper::Output> IceWrapper::getTemperatureAsync(OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
+{
+    return post<Output>([this, instant, type, quantity] { return exchangeTemperature(instant, type, quantity); });
+}
+
+IceWrapper::Output IceWrapper::exchangeTemperature(OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
 {
     network_message_init(&client_temperatures) ;
     build_message_head(&client_temperatures, TDICE_SEND_OUTPUT) ;
@@ -171,43 +365,113 @@ void IceWrapper::getTemperature(std::vector<float> &TemperatureValues, OutputIns
     insert_message_word(&client_temperatures, &type) ;
     insert_message_word(&client_temperatures, &quantity) ;
 
-    send_message_to_socket (&client_socket, &client_temperatures) ;
-
-    network_message_destroy (&client_temperatures) ;
+    sendMessage (&client_temperatures) ;
 
     // Receive Temperatures:
 
-    network_message_init (&server_reply) ;
+    receiveMessage (&server_reply) ;
 
-    receive_message_from_socket (&client_socket, &server_reply) ;
+    Output output;
+    unsigned int nresults;
 
-    double time = 0;
+    output.time = 0;
+    extract_message_word (&server_reply, &output.time, 0) ;
+    extract_message_word (&server_reply, &nresults,    1) ;
+
+    nresults += 2;
+    for(unsigned int i = 2; i != nresults ; i++)
+    {
+        float temperature = 0;
+        extract_message_word (&server_reply, &temperature, i) ;
+        output.values.push_back(temperature);
+    }
+    network_message_destroy (&server_reply) ;
+
+    return output;
+}
+
+void IceWrapper::simulate(std::vector<float> *powerValues, std::vector<float> &TemperatureValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
+{
+    Output output = wait(simulateAsync(*powerValues, instant, type, quantity));
+
+    TemperatureValues.insert(TemperatureValues.end(), output.values.begin(), output.values.end());
+}
+
+std::future<IceWrapper::Output> IceWrapper::simulateAsync(std::vector<float> powerValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
+{
+    if(powerValues.size() != numberOfFloorplanElements)
+    {
+        SC_REPORT_FATAL("3D-ICE","Wrong number of power numbers");
+    }
+    return post<Output>([this, powerValues, instant, type, quantity] () mutable
+                        { return exchangeSimulate(powerValues, instant, type, quantity); });
+}
+
+IceWrapper::Output IceWrapper::exchangeSimulate(std::vector<float> &powerValues, OutputInstant_t instant, OutputType_t type, OutputQuantity_t quantity)
+{
+    network_message_init (&client_tick) ;
+    build_message_head   (&client_tick, TDICE_SIMULATE_AND_SEND_OUTPUT) ;
+    insert_message_word  (&client_tick, &numberOfFloorplanElements) ;
+
+    float power;
+    for (unsigned int i = 0 ; i != numberOfFloorplanElements ; i++)
+    {
+        power = powerValues.at(i);
+        insert_message_word (&client_tick, &power) ;
+    }
+
+    // One slot and one output
+    MessageType_t unit = TDICE_SIMULATE_SLOT ;
+    unsigned int count = 1, noutputs = 1 ;
+
+    insert_message_word (&client_tick, &unit) ;
+    insert_message_word (&client_tick, &count) ;
+    insert_message_word (&client_tick, &noutputs) ;
+    insert_message_word (&client_tick, &instant) ;
+    insert_message_word (&client_tick, &type) ;
+    insert_message_word (&client_tick, &quantity) ;
+
+    sendMessage (&client_tick) ;
+
+    // Wait for Simulation Result and Temperatures (BLOCKING the background thread)
+    receiveMessage (&server_reply) ;
+
+    SimResult_t sim_result ;
+    float time = 0;
     unsigned int nresults;
 
-    extract_message_word (&server_reply, &time,     0) ;
-    extract_message_word (&server_reply, &nresults, 1) ;
+    extract_message_word (&server_reply, &sim_result, 0) ;
+    extract_message_word (&server_reply, &time,       1) ;
+    extract_message_word (&server_reply, &noutputs,   2) ;
 
-    // Check if the SystemC time is almost aligned (+-1ns) with 3D-ICE time 
-    if(   sc_time(time, SC_SEC) >= (sc_time_stamp()+sc_time(1, SC_NS))
-            && sc_time(time, SC_SEC) <= (sc_time_stamp()-sc_time(1, SC_NS)))
+    if (sim_result != TDICE_SLOT_DONE || noutputs != 1)
     {
-        fprintf (stdout, "%5.9e sec : \t", time) ;
-        std::cout << " @" << sc_time_stamp() << ":" << sc_time(time, SC_SEC) << endl;
-        SC_REPORT_FATAL("3D-ICE","The time of 3D-ICE is not in sync with the current SystemC time");
+        network_message_destroy (&server_reply) ;
+        throw std::runtime_error("Cannot simulate the time slot");
     }
 
-    nresults += 2;
-    for(unsigned int i = 2; i != nresults ; i++)
+    Output output;
+    output.time = time;
+
+    extract_message_word (&server_reply, &nresults, 3) ;
+
+    nresults += 4;
+    for(unsigned int i = 4; i != nresults ; i++)
     {
         float temperature = 0;
         extract_message_word (&server_reply, &temperature, i) ;
-        TemperatureValues.push_back(temperature);
+        output.values.push_back(temperature);
     }
+    network_message_destroy (&server_reply) ;
+
+    return output;
 }
 
 void IceWrapper::getMap(OutputType_t type, std::string filename)
 {
-    // Send request to 3D-ICE:
+    // Send request to 3D-ICE, after the ones still pending:
+
+    synchronize();
 
     OutputInstant_t instant = TDICE_OUTPUT_INSTANT_SLOT ;
     OutputQuantity_t quantity = TDICE_OUTPUT_QUANTITY_NONE ;
@@ -218,9 +482,7 @@ void IceWrapper::getMap(OutputType_t type, std::string filename)
     insert_message_word  (&client_tmap, &type) ;
     insert_message_word  (&client_tmap, &quantity) ;
 
-    send_message_to_socket (&client_socket, &client_tmap) ;
-
-    network_message_destroy (&client_tmap) ;
+    sendMessage (&client_tmap) ;
 
     // Open file
     ofstream myfile;
@@ -234,9 +496,7 @@ void IceWrapper::getMap(OutputType_t type, std::string filename)
     unsigned int ncolumns;
     double time = 0;
 
-    network_message_init (&server_reply) ;
-
-    receive_message_from_socket (&client_socket, &server_reply) ;
+    receiveMessage (&server_reply) ;
 
     extract_message_word (&server_reply, &time,     0) ;
     extract_message_word (&server_reply, &nresults, 1) ;
@@ -263,6 +523,342 @@ void IceWrapper::getMap(OutputType_t type, std::string filename)
     myfile.close();
 }
 
+void IceWrapper::getThermalState(std::vector<double> &TemperatureValues)
+{
+    TemperatureValues = wait(getThermalStateAsync());
+}
+
+std::future<std::vector<double>> IceWrapper::getThermalStateAsync()
+{
+    if (protocolVersion < 2)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send the thermal state");
+    }
+    return post<std::vector<double>>([this] { return exchangeThermalState(); });
+}
+
+std::vector<double> IceWrapper::exchangeThermalState()
+{
+    std::vector<double> TemperatureValues;
+    NetworkMessage_t client_state;
+    BulkType_t bulk_type = bulkResolution != 0.0 ? TDICE_BULK_DELTA : TDICE_BULK_DOUBLE;
+
+    network_message_init (&client_state) ;
+    build_message_head   (&client_state, TDICE_SEND_THERMAL_STATE) ;
+    insert_message_word  (&client_state, &bulk_type) ;
+    sendMessage (&client_state) ;
+
+    receiveMessage (&server_reply) ;
+
+    // The number of values follows the time and the type of the section
+    unsigned int index = 1, nvalues = 0;
+    extract_message_word (&server_reply, &nvalues, 2) ;
+
+    TemperatureValues.resize(nvalues);
+    Error_t error = bulk_type == TDICE_BULK_DELTA
+        ? extract_message_bulk_delta (&server_reply, &index, &stateReference, TemperatureValues.data(), nvalues)
+        : extract_message_bulk       (&server_reply, &index, TemperatureValues.data(), nvalues) ;
+    network_message_destroy (&server_reply) ;
+
+    if (error != TDICE_SUCCESS)
+    {
+        throw std::runtime_error("Wrong thermal state message");
+    }
+    return TemperatureValues;
+}
+
+void IceWrapper::getThermalMap(std::string stackElement, std::vector<double> &TemperatureValues, unsigned int &rows, unsigned int &columns)
+{
+    if (protocolVersion < 2)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send the thermal maps");
+    }
+    TemperatureValues = wait(post<std::vector<double>>([this, stackElement, &rows, &columns]
+                                                       { return exchangeThermalMap(stackElement, rows, columns); }));
+}
+
+std::vector<double> IceWrapper::exchangeThermalMap(std::string stackElement, unsigned int &rows, unsigned int &columns)
+{
+    std::vector<double> TemperatureValues;
+    NetworkMessage_t client_map;
+    BulkType_t bulk_type = bulkResolution != 0.0 ? TDICE_BULK_DELTA : TDICE_BULK_DOUBLE;
+    unsigned int name_length = stackElement.size();
+
+    network_message_init (&client_map) ;
+    build_message_head   (&client_map, TDICE_SEND_THERMAL_MAP) ;
+    insert_message_word  (&client_map, &bulk_type) ;
+    insert_message_word  (&client_map, &name_length) ;
+
+    for (unsigned int i = 0 ; i < name_length ; i += sizeof (MessageWord_t))
+    {
+        MessageWord_t word = 0;
+        stackElement.copy((char *) &word, sizeof (MessageWord_t), i);
+        insert_message_word (&client_map, &word) ;
+    }
+
+    sendMessage (&client_map) ;
+
+    receiveMessage (&server_reply) ;
+
+    unsigned int index = 3;
+    extract_message_word (&server_reply, &rows,    1) ;
+    extract_message_word (&server_reply, &columns, 2) ;
+
+    TemperatureValues.resize(rows * columns);
+    Error_t error = TDICE_FAILURE;
+    if (bulk_type == TDICE_BULK_DELTA)
+    {
+        // Inserts an empty reference the first time the map is requested
+        BulkReference_t &reference = mapReferences[stackElement];
+        if (reference.Values == NULL)
+            bulk_reference_init (&reference) ;
+        error = extract_message_bulk_delta (&server_reply, &index, &reference, TemperatureValues.data(), rows * columns) ;
+    }
+    else
+        error = extract_message_bulk (&server_reply, &index, TemperatureValues.data(), rows * columns) ;
+    network_message_destroy (&server_reply) ;
+
+    if (error != TDICE_SUCCESS)
+    {
+        throw std::runtime_error("Wrong thermal map message");
+    }
+    return TemperatureValues;
+}
+
+bool IceWrapper::setBulkResolution(double resolution)
+{
+    if (protocolVersion < 5)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send delta encoded maps");
+    }
+
+    NetworkMessage_t client_resolution;
+    float value = resolution;
+    Error_t result = TDICE_FAILURE;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_resolution) ;
+    build_message_head   (&client_resolution, TDICE_SET_BULK_RESOLUTION) ;
+    insert_message_word  (&client_resolution, &value) ;
+    sendMessage (&client_resolution) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &result, 0) ;
+    network_message_destroy (&server_reply) ;
+
+    if (result != TDICE_SUCCESS)
+        return false;
+
+    bulkResolution = resolution;
+    return true;
+}
+
+unsigned int IceWrapper::saveThermalState()
+{
+    if (protocolVersion < 6)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not save thermal states");
+    }
+
+    NetworkMessage_t client_save;
+    Error_t result = TDICE_FAILURE;
+    unsigned int handle = 0;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_save) ;
+    build_message_head   (&client_save, TDICE_SAVE_THERMAL_STATE) ;
+    sendMessage (&client_save) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &result, 0) ;
+    extract_message_word (&server_reply, &handle, 1) ;
+    network_message_destroy (&server_reply) ;
+
+    return result == TDICE_SUCCESS ? handle : 0;
+}
+
+bool IceWrapper::restoreThermalState(unsigned int handle)
+{
+    if (protocolVersion < 6)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not save thermal states");
+    }
+
+    NetworkMessage_t client_restore;
+    Error_t result = TDICE_FAILURE;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_restore) ;
+    build_message_head   (&client_restore, TDICE_RESTORE_THERMAL_STATE) ;
+    insert_message_word  (&client_restore, &handle) ;
+    sendMessage (&client_restore) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &result, 0) ;
+    network_message_destroy (&server_reply) ;
+
+    return result == TDICE_SUCCESS;
+}
+
+void IceWrapper::deleteThermalState(unsigned int handle)
+{
+    if (protocolVersion < 6)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not save thermal states");
+    }
+
+    NetworkMessage_t client_delete;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_delete) ;
+    build_message_head   (&client_delete, TDICE_DELETE_THERMAL_STATE) ;
+    insert_message_word  (&client_delete, &handle) ;
+    sendMessage (&client_delete) ;
+
+    receiveMessage (&server_reply) ;
+    network_message_destroy (&server_reply) ;
+}
+
+bool IceWrapper::setSpeculativeSteps(bool enable)
+{
+    if (protocolVersion < 7)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not speculate the steps");
+    }
+
+    NetworkMessage_t client_speculate;
+    unsigned int speculate = enable ? 1 : 0;
+    Error_t result = TDICE_FAILURE;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_speculate) ;
+    build_message_head   (&client_speculate, TDICE_SPECULATE_STEPS) ;
+    insert_message_word  (&client_speculate, &speculate) ;
+    sendMessage (&client_speculate) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &result, 0) ;
+    network_message_destroy (&server_reply) ;
+
+    return result == TDICE_SUCCESS;
+}
+
+ModelPhase_t IceWrapper::getModelStatus(float times[TDICE_MODEL_READY])
+{
+    if (protocolVersion < 8)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send the model status");
+    }
+
+    NetworkMessage_t client_status;
+    ModelPhase_t phase;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_status) ;
+    build_message_head   (&client_status, TDICE_SEND_MODEL_STATUS) ;
+    sendMessage (&client_status) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &phase, 0) ;
+
+    for (unsigned int i = 0; i < TDICE_MODEL_READY; i++)
+        extract_message_word (&server_reply, &times[i], i + 1) ;
+
+    network_message_destroy (&server_reply) ;
+
+    return phase;
+}
+
+void IceWrapper::getStats(std::string &text)
+{
+    if (protocolVersion < 10)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send its statistics");
+    }
+
+    NetworkMessage_t client_stats;
+    unsigned int text_length;
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_stats) ;
+    build_message_head   (&client_stats, TDICE_GET_STATS) ;
+    sendMessage (&client_stats) ;
+
+    receiveMessage (&server_reply) ;
+    extract_message_word (&server_reply, &text_length, 0) ;
+
+    text.assign((const char *) (server_reply.Content + 1), text_length);
+
+    network_message_destroy (&server_reply) ;
+}
+
+unsigned long long IceWrapper::getOutputFile(std::string fileName, std::string &bytes, OutputFilesMode_t mode, unsigned long long offset, unsigned int maxBytes)
+{
+    if (protocolVersion < 4)
+    {
+        SC_REPORT_FATAL("3D-ICE","The server does not send parts of the output files");
+    }
+
+    NetworkMessage_t client_files;
+    uint64_t first_byte = offset;
+    unsigned int name_length = fileName.size();
+
+    // The requests posted before must be answered first
+    synchronize();
+
+    network_message_init (&client_files) ;
+    build_message_head   (&client_files, TDICE_SEND_OUTPUT_FILES) ;
+    insert_message_word  (&client_files, &mode) ;
+    insert_message_word  (&client_files, &maxBytes) ;
+    insert_message_word  (&client_files, (MessageWord_t *) &first_byte) ;
+    insert_message_word  (&client_files, (MessageWord_t *) &first_byte + 1) ;
+    insert_message_word  (&client_files, &name_length) ;
+
+    for (unsigned int i = 0 ; i < name_length ; i += sizeof (MessageWord_t))
+    {
+        MessageWord_t word = 0;
+        fileName.copy((char *) &word, sizeof (MessageWord_t), i);
+        insert_message_word (&client_files, &word) ;
+    }
+
+    sendMessage (&client_files) ;
+
+    receiveMessage (&server_reply) ;
+
+    // | nfiles | filename_length | file_length | offset | filename bytes | file bytes |
+    unsigned int nfiles = 0, file_length = 0;
+    extract_message_word (&server_reply, &nfiles, 0) ;
+
+    bytes.clear();
+    if (nfiles != 0)
+    {
+        extract_message_word (&server_reply, &name_length, 1) ;
+        extract_message_word (&server_reply, &file_length, 2) ;
+        extract_message_word (&server_reply, (MessageWord_t *) &first_byte,     3) ;
+        extract_message_word (&server_reply, (MessageWord_t *) &first_byte + 1, 4) ;
+
+        unsigned int index = 5 + (name_length + sizeof (MessageWord_t) - 1) / sizeof (MessageWord_t);
+        bytes.assign((const char *) (server_reply.Content + index), file_length);
+    }
+    network_message_destroy (&server_reply) ;
+
+    return first_byte;
+}
+
 void IceWrapper::getTemperatureMap(std::string filename)
 {
     getMap(TDICE_OUTPUT_TYPE_TMAP, filename);
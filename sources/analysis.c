@@ -50,7 +50,23 @@ void analysis_init (Analysis_t *analysis)
     analysis->SlotLength         = (Quantity_t) 0u ;
     analysis->CurrentTime        = (Quantity_t) 0u ;
     analysis->InitialTemperature = (Temperature_t) 0.0 ;
+    analysis->InitialState       = (InitialState_t) TDICE_INITIAL_STATE_UNIFORM ;
     analysis->NumOfCores = (Quantity_t) 0u ;
+    analysis->PararealWindows    = (Quantity_t) 0u ;
+    analysis->PararealTolerance  = (Temperature_t) 0.0 ;
+    analysis->PararealIterations = (Quantity_t) 0u ;
+    analysis->Substructuring     = false ;
+    analysis->TileRows           = (Quantity_t) 0u ;
+    analysis->TileColumns        = (Quantity_t) 0u ;
+    analysis->TileOverlap        = (Quantity_t) 0u ;
+    analysis->SubmodelX          = (ChipDimension_t) 0.0 ;
+    analysis->SubmodelY          = (ChipDimension_t) 0.0 ;
+    analysis->SubmodelLength     = (ChipDimension_t) 0.0 ;
+    analysis->SubmodelWidth      = (ChipDimension_t) 0.0 ;
+    analysis->SubmodelCellLength = (CellDimension_t) 0.0 ;
+    analysis->SubmodelCellWidth  = (CellDimension_t) 0.0 ;
+    analysis->LeakageIterations  = (Quantity_t) 0u ;
+    analysis->LeakageTolerance   = (Temperature_t) 0.0 ;
 }
 
 /******************************************************************************/
@@ -65,7 +81,23 @@ void analysis_copy (Analysis_t *dst, Analysis_t *src)
     dst->SlotLength         = src->SlotLength ;
     dst->CurrentTime        = src->CurrentTime ;
     dst->InitialTemperature = src->InitialTemperature ;
+    dst->InitialState       = src->InitialState ;
     dst->NumOfCores         = src->NumOfCores ;
+    dst->PararealWindows    = src->PararealWindows ;
+    dst->PararealTolerance  = src->PararealTolerance ;
+    dst->PararealIterations = src->PararealIterations ;
+    dst->Substructuring     = src->Substructuring ;
+    dst->TileRows           = src->TileRows ;
+    dst->TileColumns        = src->TileColumns ;
+    dst->TileOverlap        = src->TileOverlap ;
+    dst->SubmodelX          = src->SubmodelX ;
+    dst->SubmodelY          = src->SubmodelY ;
+    dst->SubmodelLength     = src->SubmodelLength ;
+    dst->SubmodelWidth      = src->SubmodelWidth ;
+    dst->SubmodelCellLength = src->SubmodelCellLength ;
+    dst->SubmodelCellWidth  = src->SubmodelCellWidth ;
+    dst->LeakageIterations  = src->LeakageIterations ;
+    dst->LeakageTolerance   = src->LeakageTolerance ;
 }
 
 /******************************************************************************/
@@ -137,10 +169,45 @@ void analysis_print (Analysis_t *analysis, FILE *stream, String_t prefix)
 
     fprintf (stream, "%s  initial temperature  %.2f ;\n",
         prefix, analysis->InitialTemperature) ;
+
+    if (analysis->InitialState == TDICE_INITIAL_STATE_STEADY)
+
+        fprintf (stream, "%s  initial state steady ;\n", prefix) ;
+
+    else if (analysis->InitialState == TDICE_INITIAL_STATE_STEADY_AVERAGE)
+
+        fprintf (stream, "%s  initial state steady average ;\n", prefix) ;
     
     fprintf (stream, "  number of cores %d ;\n",
             analysis->NumOfCores) ;
 
+    if (analysis->PararealWindows != 0u)
+
+        fprintf (stream, "  parareal windows %d, tolerance %.4f, iterations %d ;\n",
+            analysis->PararealWindows, analysis->PararealTolerance,
+            analysis->PararealIterations) ;
+
+    if (analysis->Substructuring == true)
+
+        fprintf (stream, "  substructuring ;\n") ;
+
+    if (analysis->TileRows != 0u)
+
+        fprintf (stream, "  tiles %d, %d, overlap %d ;\n",
+            analysis->TileRows, analysis->TileColumns, analysis->TileOverlap) ;
+
+    if (analysis->SubmodelLength != 0.0)
+
+        fprintf (stream, "  submodel (%.1f, %.1f) length %.1f, width %.1f, cell length %.1f, width %.1f ;\n",
+            analysis->SubmodelX, analysis->SubmodelY,
+            analysis->SubmodelLength, analysis->SubmodelWidth,
+            analysis->SubmodelCellLength, analysis->SubmodelCellWidth) ;
+
+    if (analysis->LeakageIterations > 1u)
+
+        fprintf (stream, "  leakage iterations %d, tolerance %.4f ;\n",
+            analysis->LeakageIterations, analysis->LeakageTolerance) ;
+
     fprintf (stream, "%s\n", prefix) ;
 }
 
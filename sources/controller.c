@@ -0,0 +1,279 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/free
+#include <string.h> // For the string functions strlen/strncat
+#include <unistd.h> // For the function getcwd
+#include <dlfcn.h>
+
+#include "controller.h"
+#include "macros.h"
+
+/******************************************************************************/
+
+void controller_init (Controller_t *controller)
+{
+    controller->Handle             = NULL ;
+    controller->Step               = NULL ;
+    controller->Slot               = NULL ;
+    controller->NFloorplanElements = (Quantity_t) 0u ;
+    controller->NStepPoints        = (Quantity_t) 0u ;
+    controller->NSlotPoints        = (Quantity_t) 0u ;
+    controller->Powers             = NULL ;
+    controller->StepPoints         = NULL ;
+    controller->SlotPoints         = NULL ;
+}
+
+/******************************************************************************/
+
+Error_t controller_build
+(
+    Controller_t       *controller,
+    String_t            plugin,
+    String_t            args,
+    StackDescription_t *stkd,
+    Analysis_t         *analysis,
+    Output_t           *output
+)
+{
+    char path [2048] ;
+
+    memset (path, 0, sizeof (path)) ;
+
+    // As for the heatsink plugin, a relative path starts from the
+    // current directory and not from the library search path
+
+    if (plugin [0] != '/')
+    {
+        if (getcwd (path, sizeof (path) - 1) == NULL)
+        {
+            fprintf (stderr, "ERROR: getcwd() failed\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        strncat (path, "/", sizeof (path) - strlen (path) - 1) ;
+    }
+
+    strncat (path, plugin, sizeof (path) - strlen (path) - 1) ;
+
+    controller->Handle = dlopen (path, RTLD_NOW | RTLD_LOCAL) ;
+
+    if (controller->Handle == NULL)
+    {
+        fprintf (stderr, "ERROR: could not load controller plugin %s\n", dlerror ()) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    int (*init) (unsigned int, unsigned int, unsigned int, unsigned int,
+                 double, double, const char *) =
+
+        (int (*) (unsigned int, unsigned int, unsigned int, unsigned int,
+                  double, double, const char *))
+
+        dlsym (controller->Handle, "dtm_controller_init") ;
+
+    controller->Step =
+
+        (int (*) (double, const double *, const double *, double *, double *))
+
+        dlsym (controller->Handle, "dtm_controller_step") ;
+
+    controller->Slot =
+
+        (int (*) (double, const double *, const double *, double *, double *))
+
+        dlsym (controller->Handle, "dtm_controller_slot") ;
+
+    if (init == NULL || (controller->Step == NULL && controller->Slot == NULL))
+    {
+        fprintf (stderr, "ERROR: controller plugin must export dtm_controller_init"
+                         " and dtm_controller_step or dtm_controller_slot\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    controller->NFloorplanElements = get_total_number_of_floorplan_elements (stkd) ;
+
+    controller->NStepPoints = get_inspection_point_temperatures
+
+        (output, stkd->Dimensions, NULL, TDICE_OUTPUT_INSTANT_STEP, NULL) ;
+
+    controller->NSlotPoints = get_inspection_point_temperatures
+
+        (output, stkd->Dimensions, NULL, TDICE_OUTPUT_INSTANT_SLOT, NULL) ;
+
+    // One more element so that the arrays are allocated even if empty
+
+    controller->Powers = (Power_t *) malloc
+
+        (sizeof (Power_t) * (controller->NFloorplanElements + 1)) ;
+
+    controller->StepPoints = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * (controller->NStepPoints + 1)) ;
+
+    controller->SlotPoints = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * (controller->NSlotPoints + 1)) ;
+
+    if (   controller->Powers     == NULL
+        || controller->StepPoints == NULL
+        || controller->SlotPoints == NULL)
+    {
+        fprintf (stderr, "Cannot malloc controller buffers\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (init (get_number_of_cells (stkd->Dimensions),
+              controller->NFloorplanElements,
+              controller->NStepPoints, controller->NSlotPoints,
+              analysis->StepTime, analysis->SlotTime, args) != 0)
+    {
+        fprintf (stderr, "ERROR: controller plugin initialization failed\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+void controller_destroy (Controller_t *controller)
+{
+    free (controller->Powers) ;
+    free (controller->StepPoints) ;
+    free (controller->SlotPoints) ;
+
+    if (controller->Handle != NULL)
+
+        dlclose (controller->Handle) ;
+
+    controller_init (controller) ;
+}
+
+/******************************************************************************/
+
+static Error_t call_controller
+(
+    Controller_t  *controller,
+    int          (*callback) (double, const double *, const double *, double *, double *),
+    Temperature_t *points,
+    OutputInstant_t instant,
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis,
+    Output_t      *output
+)
+{
+    Channel_t *channel = tdata->ThermalGrid.Channel ;
+
+    CoolantFR_t flow_rate = channel != NULL
+
+        ? FLOW_RATE_FROM_UM3SEC_TO_MLMIN (channel->Coolant.FlowRate)
+        : (CoolantFR_t) 0.0 ;
+
+    CoolantFR_t new_flow_rate = flow_rate ;
+
+    get_next_power_values (&tdata->PowerGrid, controller->Powers) ;
+
+    get_inspection_point_temperatures
+
+        (output, dimensions, tdata->Temperatures, instant, points) ;
+
+    if (callback (get_simulated_time (analysis), tdata->Temperatures,
+                  points, controller->Powers, &new_flow_rate) != 0)
+    {
+        fprintf (stderr, "ERROR: controller plugin reported an error\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    replace_next_power_values (&tdata->PowerGrid, controller->Powers) ;
+
+    if (new_flow_rate == flow_rate)
+
+        return TDICE_SUCCESS ;
+
+    if (channel == NULL)
+    {
+        fprintf (stderr, "ERROR: controller set the flow rate of a stack without channels\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return update_coolant_flow_rate (tdata, dimensions, analysis, new_flow_rate) ;
+}
+
+/******************************************************************************/
+
+Error_t controller_run
+(
+    Controller_t  *controller,
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis,
+    Output_t      *output,
+    SimResult_t    sim_result
+)
+{
+    if (sim_result != TDICE_STEP_DONE && sim_result != TDICE_SLOT_DONE)
+
+        return TDICE_SUCCESS ;
+
+    if (controller->Step != NULL
+        && call_controller (controller, controller->Step,
+                            controller->StepPoints, TDICE_OUTPUT_INSTANT_STEP,
+                            tdata, dimensions, analysis, output) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    if (sim_result == TDICE_SLOT_DONE && controller->Slot != NULL
+        && call_controller (controller, controller->Slot,
+                            controller->SlotPoints, TDICE_OUTPUT_INSTANT_SLOT,
+                            tdata, dimensions, analysis, output) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
@@ -0,0 +1,993 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/calloc/free
+#include <string.h> // For the memory functions memcpy/memset
+#include <math.h>   // For the math function sqrt
+
+#include "domain_decomposition.h"
+
+/******************************************************************************/
+
+// Relative residual and maximum number of iterations of the global solver
+
+#define DOMAIN_TOLERANCE      1e-10
+#define DOMAIN_MAX_ITERATIONS 1000u
+
+// Largest number of coefficients in a column of the system matrix
+
+#define MAX_COLUMN_ENTRIES    7u
+
+/******************************************************************************/
+
+void domain_decomposition_init (DomainDecomposition_t *domain)
+{
+    domain->Transport         = NULL ;
+    domain->NTileRows         = (Quantity_t) 0u ;
+    domain->NTileColumns      = (Quantity_t) 0u ;
+    domain->Overlap           = (CellIndex_t) 0u ;
+    domain->FirstRow          = (CellIndex_t) 0u ;
+    domain->LastRow           = (CellIndex_t) 0u ;
+    domain->FirstColumn       = (CellIndex_t) 0u ;
+    domain->LastColumn        = (CellIndex_t) 0u ;
+    domain->WindowFirstRow    = (CellIndex_t) 0u ;
+    domain->WindowLastRow     = (CellIndex_t) 0u ;
+    domain->WindowFirstColumn = (CellIndex_t) 0u ;
+    domain->WindowLastColumn  = (CellIndex_t) 0u ;
+    domain->Size              = (CellIndex_t) 0u ;
+    domain->Cells             = NULL ;
+    domain->Owned             = NULL ;
+    domain->Work              = NULL ;
+    domain->Solution          = NULL ;
+    domain->Vector            = NULL ;
+    domain->Krylov            = NULL ;
+    domain->NIterations       = (Quantity_t) 0u ;
+    domain->NNeighbours       = (Quantity_t) 0u ;
+    domain->Neighbours        = NULL ;
+    domain->Buffer            = NULL ;
+    domain->Temperatures      = NULL ;
+
+    domain->SLUMatrix_Work.Store = NULL ;
+
+    system_matrix_init (&domain->SM_A) ;
+    thermal_grid_init  (&domain->ThermalGrid) ;
+    power_grid_init    (&domain->PowerGrid) ;
+}
+
+/******************************************************************************/
+
+// Rows (or columns) [first, last] of the tile at position index when n
+// cells are split in ntiles tiles
+
+static void tile_range
+
+    (CellIndex_t n, Quantity_t ntiles, Quantity_t index, CellIndex_t *first, CellIndex_t *last)
+{
+    *first = (CellIndex_t) (((uint64_t) n * index) / ntiles) ;
+    *last  = (CellIndex_t) (((uint64_t) n * (index + 1u)) / ntiles) - 1u ;
+}
+
+/******************************************************************************/
+
+// Rows and columns (owned and of the subdomain) of the tile of a process
+
+static void tile_window
+(
+    DomainDecomposition_t *domain,
+    Dimensions_t          *dimensions,
+    Quantity_t             rank,
+    CellIndex_t           *window
+)
+{
+    CellIndex_t overlap = domain->Overlap ;
+
+    tile_range (get_number_of_rows (dimensions), domain->NTileRows,
+                rank / domain->NTileColumns, window, window + 1) ;
+
+    tile_range (get_number_of_columns (dimensions), domain->NTileColumns,
+                rank % domain->NTileColumns, window + 2, window + 3) ;
+
+    window [4] = window [0] > overlap ? window [0] - overlap : 0u ;
+    window [5] = window [1] + overlap < last_row (dimensions)
+               ? window [1] + overlap : last_row (dimensions) ;
+
+    window [6] = window [2] > overlap ? window [2] - overlap : 0u ;
+    window [7] = window [3] + overlap < last_column (dimensions)
+               ? window [3] + overlap : last_column (dimensions) ;
+}
+
+/******************************************************************************/
+
+static CellIndex_t window_rows (DomainDecomposition_t *domain)
+{
+    return domain->WindowLastRow - domain->WindowFirstRow + 1u ;
+}
+
+static CellIndex_t window_columns (DomainDecomposition_t *domain)
+{
+    return domain->WindowLastColumn - domain->WindowFirstColumn + 1u ;
+}
+
+/******************************************************************************/
+
+// Local index of the cell (layer, row, column) of the subdomain
+
+static CellIndex_t local_cell
+(
+    DomainDecomposition_t *domain,
+    CellIndex_t            layer,
+    CellIndex_t            row,
+    CellIndex_t            column
+)
+{
+    return   layer * window_rows (domain) * window_columns (domain)
+           + (row - domain->WindowFirstRow) * window_columns (domain)
+           + (column - domain->WindowFirstColumn) ;
+}
+
+/******************************************************************************/
+
+// Local indices of the cells of the subdomain in the rectangle given (all
+// the layers). Returns the number of cells (0 if the rectangle is empty).
+
+static CellIndex_t intersect_cells
+(
+    DomainDecomposition_t *domain,
+    Dimensions_t          *dimensions,
+    CellIndex_t            first_row_index,
+    CellIndex_t            last_row_index,
+    CellIndex_t            first_column_index,
+    CellIndex_t            last_column_index,
+    CellIndex_t           *cells
+)
+{
+    CellIndex_t layer, row, column, ncells = 0u ;
+
+    if (first_row_index > last_row_index || first_column_index > last_column_index)
+
+        return 0u ;
+
+    for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
+
+        for (row = first_row_index ; row <= last_row_index ; row++)
+
+            for (column = first_column_index ; column <= last_column_index ; column++)
+            {
+                if (cells != NULL)
+
+                    cells [ncells] = local_cell (domain, layer, row, column) ;
+
+                ncells++ ;
+            }
+
+    return ncells ;
+}
+
+/******************************************************************************/
+
+// Finds the cells exchanged with every other tile. Both sides visit the
+// same cells in the same order, so only values are sent.
+
+static Error_t build_neighbours (DomainDecomposition_t *domain, Dimensions_t *dimensions)
+{
+    HaloTransport_t *transport = domain->Transport ;
+    Quantity_t       rank ;
+    CellIndex_t      largest = 0u ;
+
+    domain->Neighbours = (DomainNeighbour_t *) calloc
+
+        (transport->NProcesses, sizeof (DomainNeighbour_t)) ;
+
+    if (domain->Neighbours == NULL)
+
+        return TDICE_FAILURE ;
+
+    for (rank = 0u ; rank != transport->NProcesses ; rank++)
+    {
+        CellIndex_t other [8] ;
+
+        tile_window (domain, dimensions, rank, other) ;
+
+        // The process 0 gathers the tiles of all the others
+
+        CellIndex_t tile_cells = get_number_of_layers (dimensions)
+                                 * (other [1] - other [0] + 1u)
+                                 * (other [3] - other [2] + 1u) ;
+
+        largest = MAX (largest, tile_cells) ;
+
+        if (rank == transport->Rank)
+
+            continue ;
+
+        DomainNeighbour_t *neighbour = &domain->Neighbours [domain->NNeighbours] ;
+
+        /* Owned cells in the subdomain of the other tile */
+
+        CellIndex_t send [4] =
+        {
+            MAX (domain->FirstRow,    other [4]), MIN (domain->LastRow,    other [5]),
+            MAX (domain->FirstColumn, other [6]), MIN (domain->LastColumn, other [7])
+        } ;
+
+        /* Cells of the subdomain owned by the other tile */
+
+        CellIndex_t receive [4] =
+        {
+            MAX (domain->WindowFirstRow,    other [0]), MIN (domain->WindowLastRow,    other [1]),
+            MAX (domain->WindowFirstColumn, other [2]), MIN (domain->WindowLastColumn, other [3])
+        } ;
+
+        neighbour->NSend    = intersect_cells (domain, dimensions, send [0], send [1], send [2], send [3], NULL) ;
+        neighbour->NReceive = intersect_cells (domain, dimensions, receive [0], receive [1], receive [2], receive [3], NULL) ;
+
+        if (neighbour->NSend == 0u && neighbour->NReceive == 0u)
+
+            continue ;
+
+        neighbour->Rank         = rank ;
+        neighbour->SendCells    = (CellIndex_t *) malloc (sizeof (CellIndex_t) * MAX (neighbour->NSend, 1u)) ;
+        neighbour->ReceiveCells = (CellIndex_t *) malloc (sizeof (CellIndex_t) * MAX (neighbour->NReceive, 1u)) ;
+
+        domain->NNeighbours++ ;
+
+        if (neighbour->SendCells == NULL || neighbour->ReceiveCells == NULL)
+
+            return TDICE_FAILURE ;
+
+        intersect_cells (domain, dimensions, send [0], send [1], send [2], send [3], neighbour->SendCells) ;
+        intersect_cells (domain, dimensions, receive [0], receive [1], receive [2], receive [3], neighbour->ReceiveCells) ;
+
+        largest = MAX (largest, MAX (neighbour->NSend, neighbour->NReceive)) ;
+    }
+
+    domain->Buffer = (double *) malloc (sizeof (double) * largest) ;
+
+    if (domain->Buffer == NULL)
+
+        return TDICE_FAILURE ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Assembles the columns of the subdomain and keeps the coefficients whose
+// row belongs to the subdomain as well (halo temperatures set to zero)
+
+static Error_t build_system_matrix
+(
+    DomainDecomposition_t *domain,
+    Dimensions_t          *dimensions,
+    Analysis_t            *analysis
+)
+{
+    SystemMatrix_t window ;
+    CellIndex_t    column, nnz = 0u ;
+    LUIndex_t      lnz ;
+    Error_t        result = TDICE_FAILURE ;
+
+    system_matrix_init (&window) ;
+
+    window.Size = domain->Size ;
+    window.NNz  = domain->Size * MAX_COLUMN_ENTRIES ;
+
+    window.ColumnPointers = (LUIndex_t *) malloc (sizeof (LUIndex_t) * (window.Size + 1)) ;
+    window.RowIndices     = (LUIndex_t *) malloc (sizeof (LUIndex_t) * window.NNz) ;
+    window.Values         = (SystemMatrixCoeff_t *) malloc (sizeof (SystemMatrixCoeff_t) * window.NNz) ;
+
+    if (window.ColumnPointers == NULL || window.RowIndices == NULL || window.Values == NULL)
+    {
+        fprintf (stderr, "Cannot malloc subdomain system matrix\n") ;
+
+        goto free_window ;
+    }
+
+    fill_system_matrix_window
+
+        (&window, &domain->ThermalGrid, analysis, dimensions,
+         domain->WindowFirstRow, domain->WindowLastRow,
+         domain->WindowFirstColumn, domain->WindowLastColumn) ;
+
+    // Global row indices are translated into local ones (UINT32_MAX if
+    // the cell is out of the subdomain)
+
+    CellIndex_t area    = get_layer_area (dimensions) ;
+    CellIndex_t columns = get_number_of_columns (dimensions) ;
+
+    for (lnz = 0 ; lnz != window.ColumnPointers [window.Size] ; lnz++)
+    {
+        CellIndex_t cell   = (CellIndex_t) window.RowIndices [lnz] ;
+        CellIndex_t layer  = cell / area ;
+        CellIndex_t row    = (cell % area) / columns ;
+        CellIndex_t col    = (cell % area) % columns ;
+
+        if (   row < domain->WindowFirstRow    || row > domain->WindowLastRow
+            || col < domain->WindowFirstColumn || col > domain->WindowLastColumn)
+
+            window.RowIndices [lnz] = (LUIndex_t) UINT32_MAX ;
+
+        else
+        {
+            window.RowIndices [lnz] = local_cell (domain, layer, row, col) ;
+
+            nnz++ ;
+        }
+    }
+
+    if (system_matrix_build (&domain->SM_A, domain->Size, nnz, analysis->NumOfCores) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc subdomain system matrix\n") ;
+
+        system_matrix_init (&domain->SM_A) ;
+
+        goto free_window ;
+    }
+
+    nnz = 0u ;
+
+    domain->SM_A.ColumnPointers [0] = 0 ;
+
+    for (column = 0u ; column != domain->Size ; column++)
+    {
+        for (lnz  = window.ColumnPointers [column] ;
+             lnz != window.ColumnPointers [column + 1] ;
+             lnz++)
+
+            if (window.RowIndices [lnz] != (LUIndex_t) UINT32_MAX)
+            {
+                domain->SM_A.RowIndices [nnz] = window.RowIndices [lnz] ;
+                domain->SM_A.Values     [nnz] = window.Values     [lnz] ;
+
+                nnz++ ;
+            }
+
+        domain->SM_A.ColumnPointers [column + 1] = nnz ;
+    }
+
+    result = do_factorization (&domain->SM_A) ;
+
+free_window :
+
+    free (window.ColumnPointers) ;
+    free (window.RowIndices) ;
+    free (window.Values) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+Error_t domain_decomposition_build
+(
+    DomainDecomposition_t *domain,
+    HaloTransport_t       *transport,
+    StackElementList_t    *list,
+    Dimensions_t          *dimensions,
+    Analysis_t            *analysis
+)
+{
+    CellIndex_t window [8] ;
+    CellIndex_t layer, row, column, cell ;
+
+    if (dimensions->NonUniform == 1)
+    {
+        fprintf (stderr, "Domain decomposition requires a uniform grid\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (analysis->TileRows * analysis->TileColumns != transport->NProcesses)
+    {
+        fprintf (stderr, "Domain decomposition: %d x %d tiles for %d processes\n",
+            analysis->TileRows, analysis->TileColumns, transport->NProcesses) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    domain->Transport    = transport ;
+    domain->NTileRows    = analysis->TileRows ;
+    domain->NTileColumns = analysis->TileColumns ;
+    domain->Overlap      = analysis->TileOverlap ;
+
+    tile_window (domain, dimensions, transport->Rank, window) ;
+
+    domain->FirstRow          = window [0] ;
+    domain->LastRow           = window [1] ;
+    domain->FirstColumn       = window [2] ;
+    domain->LastColumn        = window [3] ;
+    domain->WindowFirstRow    = window [4] ;
+    domain->WindowLastRow     = window [5] ;
+    domain->WindowFirstColumn = window [6] ;
+    domain->WindowLastColumn  = window [7] ;
+
+    domain->Size = get_number_of_layers (dimensions)
+                   * window_rows (domain) * window_columns (domain) ;
+
+    /* The thermal and power grids describe the whole stack */
+
+    if (   thermal_grid_build (&domain->ThermalGrid, dimensions) == TDICE_FAILURE
+        || power_grid_build   (&domain->PowerGrid,   dimensions) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc thermal or power grid\n") ;
+
+        goto failure ;
+    }
+
+    if (thermal_grid_fill (&domain->ThermalGrid, list) == TDICE_FAILURE)
+
+        goto failure ;
+
+    power_grid_fill (&domain->PowerGrid, &domain->ThermalGrid, list, dimensions) ;
+
+    if (domain->PowerGrid.NLeakages != 0u)
+    {
+        fprintf (stderr, "Tiles cannot be used with leakage power\n") ;
+
+        goto failure ;
+    }
+
+    /* Subdomain vectors */
+
+    domain->Cells    = (CellIndex_t *) malloc (sizeof (CellIndex_t) * domain->Size) ;
+    domain->Owned    = (bool *) malloc (sizeof (bool) * domain->Size) ;
+    domain->Work     = (double *) malloc (sizeof (double) * domain->Size) ;
+    domain->Solution = (Temperature_t *) malloc (sizeof (Temperature_t) * domain->Size) ;
+    domain->Vector   = (double *) malloc (sizeof (double) * domain->Size) ;
+    domain->Krylov   = (double *) malloc (sizeof (double) * domain->Size * 8) ;
+
+    if (   domain->Cells == NULL || domain->Owned == NULL || domain->Work == NULL
+        || domain->Solution == NULL || domain->Vector == NULL || domain->Krylov == NULL)
+    {
+        fprintf (stderr, "Cannot malloc subdomain vectors\n") ;
+
+        goto failure ;
+    }
+
+    for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
+
+        for (row = domain->WindowFirstRow ; row <= domain->WindowLastRow ; row++)
+
+            for (column = domain->WindowFirstColumn ; column <= domain->WindowLastColumn ; column++)
+            {
+                cell = local_cell (domain, layer, row, column) ;
+
+                domain->Cells [cell] = get_cell_offset_in_stack (dimensions, layer, row, column) ;
+
+                domain->Owned [cell] =    row    >= domain->FirstRow    && row    <= domain->LastRow
+                                       && column >= domain->FirstColumn && column <= domain->LastColumn ;
+
+                domain->Solution [cell] = analysis->InitialTemperature ;
+            }
+
+    dCreate_Dense_Matrix  /* Vector Work */
+
+        (&domain->SLUMatrix_Work, domain->Size, 1,
+         domain->Work, domain->Size,
+         SLU_DN, SLU_D, SLU_GE) ;
+
+    if (transport->Rank == 0u)
+    {
+        CellIndex_t ncells = get_number_of_cells (dimensions) ;
+
+        domain->Temperatures = (Temperature_t *) malloc (sizeof (Temperature_t) * ncells) ;
+
+        if (domain->Temperatures == NULL)
+        {
+            fprintf (stderr, "Cannot malloc temperature array\n") ;
+
+            goto failure ;
+        }
+
+        for (cell = 0u ; cell != ncells ; cell++)
+
+            domain->Temperatures [cell] = analysis->InitialTemperature ;
+    }
+
+    if (build_neighbours (domain, dimensions) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc subdomain neighbours\n") ;
+
+        goto failure ;
+    }
+
+    if (build_system_matrix (domain, dimensions, analysis) == TDICE_FAILURE)
+
+        goto failure ;
+
+    return TDICE_SUCCESS ;
+
+failure :
+
+    domain_decomposition_destroy (domain) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+void domain_decomposition_destroy (DomainDecomposition_t *domain)
+{
+    Quantity_t index ;
+
+    if (domain->Neighbours != NULL)
+
+        for (index = 0u ; index != domain->NNeighbours ; index++)
+        {
+            free (domain->Neighbours [index].SendCells) ;
+            free (domain->Neighbours [index].ReceiveCells) ;
+        }
+
+    if (domain->SLUMatrix_Work.Store != NULL)
+
+        Destroy_SuperMatrix_Store (&domain->SLUMatrix_Work) ;
+
+    if (domain->SM_A.Size != 0)
+
+        system_matrix_destroy (&domain->SM_A) ;
+
+    thermal_grid_destroy (&domain->ThermalGrid) ;
+    power_grid_destroy   (&domain->PowerGrid) ;
+
+    free (domain->Cells) ;
+    free (domain->Owned) ;
+    free (domain->Work) ;
+    free (domain->Solution) ;
+    free (domain->Vector) ;
+    free (domain->Krylov) ;
+    free (domain->Neighbours) ;
+    free (domain->Buffer) ;
+    free (domain->Temperatures) ;
+
+    domain_decomposition_init (domain) ;
+}
+
+/******************************************************************************/
+
+// Copies into the halo of vector the values owned by the adjacent tiles.
+// Pairs are served by increasing rank, the lower rank sending first, so
+// that blocking transports cannot deadlock.
+
+static Error_t exchange_halo (DomainDecomposition_t *domain, double *vector)
+{
+    HaloTransport_t *transport = domain->Transport ;
+    Quantity_t       index ;
+    CellIndex_t      cell ;
+
+    for (index = 0u ; index != domain->NNeighbours ; index++)
+    {
+        DomainNeighbour_t *neighbour = &domain->Neighbours [index] ;
+
+        if (transport->Rank < neighbour->Rank && neighbour->NSend != 0u)
+        {
+            for (cell = 0u ; cell != neighbour->NSend ; cell++)
+
+                domain->Buffer [cell] = vector [neighbour->SendCells [cell]] ;
+
+            if (transport->Send (transport, neighbour->Rank, domain->Buffer,
+                                 sizeof (double) * neighbour->NSend) == TDICE_FAILURE)
+
+                return TDICE_FAILURE ;
+        }
+
+        if (neighbour->NReceive != 0u)
+        {
+            if (transport->Receive (transport, neighbour->Rank, domain->Buffer,
+                                    sizeof (double) * neighbour->NReceive) == TDICE_FAILURE)
+
+                return TDICE_FAILURE ;
+
+            for (cell = 0u ; cell != neighbour->NReceive ; cell++)
+
+                vector [neighbour->ReceiveCells [cell]] = domain->Buffer [cell] ;
+        }
+
+        if (transport->Rank > neighbour->Rank && neighbour->NSend != 0u)
+        {
+            for (cell = 0u ; cell != neighbour->NSend ; cell++)
+
+                domain->Buffer [cell] = vector [neighbour->SendCells [cell]] ;
+
+            if (transport->Send (transport, neighbour->Rank, domain->Buffer,
+                                 sizeof (double) * neighbour->NSend) == TDICE_FAILURE)
+
+                return TDICE_FAILURE ;
+        }
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// out = A in (owned cells only, the halo of in must be up to date)
+
+static void apply_system_matrix (DomainDecomposition_t *domain, double *in, double *out)
+{
+    SystemMatrix_t *sysmatrix = &domain->SM_A ;
+    CellIndex_t     column ;
+    LUIndex_t       lnz ;
+
+    memset (out, 0, sizeof (double) * domain->Size) ;
+
+    for (column = 0u ; column != domain->Size ; column++)
+
+        for (lnz  = sysmatrix->ColumnPointers [column] ;
+             lnz != sysmatrix->ColumnPointers [column + 1] ;
+             lnz++)
+
+            out [sysmatrix->RowIndices [lnz]] += sysmatrix->Values [lnz] * in [column] ;
+}
+
+/******************************************************************************/
+
+// out = inv(A_sub) in, keeping only the owned cells (restricted additive
+// Schwarz). The halo of in is updated first.
+
+static Error_t apply_preconditioner (DomainDecomposition_t *domain, double *in, double *out)
+{
+    CellIndex_t cell ;
+
+    if (exchange_halo (domain, in) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    memcpy (domain->Work, in, sizeof (double) * domain->Size) ;
+
+    if (solve_sparse_linear_system (&domain->SM_A, &domain->SLUMatrix_Work) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    for (cell = 0u ; cell != domain->Size ; cell++)
+
+        out [cell] = domain->Owned [cell] == true ? domain->Work [cell] : 0.0 ;
+
+    return exchange_halo (domain, out) ;
+}
+
+/******************************************************************************/
+
+// Scalar product over the owned cells of the tile (partial sum)
+
+static double dot_product (DomainDecomposition_t *domain, double *x, double *y)
+{
+    CellIndex_t cell ;
+    double      result = 0.0 ;
+
+    for (cell = 0u ; cell != domain->Size ; cell++)
+
+        if (domain->Owned [cell] == true)
+
+            result += x [cell] * y [cell] ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Solves A x = b with BiCGSTAB (right preconditioned), b being stored in
+// Vector and x in Solution. The solution of the previous call is used as
+// initial guess. The halo of the solution is up to date on return.
+
+static Error_t solve_system (DomainDecomposition_t *domain)
+{
+    CellIndex_t n = domain->Size ;
+    CellIndex_t index ;
+    Quantity_t  iteration ;
+
+    double *b    = domain->Vector ;
+    double *x    = domain->Solution ;
+    double *r    = domain->Krylov ;
+    double *r0   = domain->Krylov + n ;
+    double *p    = domain->Krylov + n * 2 ;
+    double *v    = domain->Krylov + n * 3 ;
+    double *s    = domain->Krylov + n * 4 ;
+    double *t    = domain->Krylov + n * 5 ;
+    double *phat = domain->Krylov + n * 6 ;
+    double *shat = domain->Krylov + n * 7 ;
+
+    double rho = 1.0, alpha = 1.0, omega = 1.0 ;
+    double products [2] ;
+
+    domain->NIterations = 0u ;
+
+    products [0] = dot_product (domain, b, b) ;
+
+    if (   exchange_halo      (domain, x) == TDICE_FAILURE
+        || halo_transport_sum (domain->Transport, products, 1u) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    double norm_b = sqrt (products [0]) ;
+
+    if (norm_b == 0.0)
+    {
+        memset (x, 0, sizeof (double) * n) ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    apply_system_matrix (domain, x, t) ;
+
+    for (index = 0u ; index != n ; index++)
+    {
+        r  [index] = b [index] - t [index] ;
+        r0 [index] = r [index] ;
+        p  [index] = 0.0 ;
+        v  [index] = 0.0 ;
+    }
+
+    for (iteration = 0u ; iteration != DOMAIN_MAX_ITERATIONS ; iteration++)
+    {
+        products [0] = dot_product (domain, r,  r) ;
+        products [1] = dot_product (domain, r0, r) ;
+
+        if (halo_transport_sum (domain->Transport, products, 2u) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        if (sqrt (products [0]) / norm_b < DOMAIN_TOLERANCE)
+
+            break ;
+
+        double rho_new = products [1] ;
+
+        if (rho_new == 0.0)
+
+            break ;
+
+        double beta = (rho_new / rho) * (alpha / omega) ;
+
+        for (index = 0u ; index != n ; index++)
+
+            p [index] = r [index] + beta * (p [index] - omega * v [index]) ;
+
+        if (apply_preconditioner (domain, p, phat) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        apply_system_matrix (domain, phat, v) ;
+
+        products [0] = dot_product (domain, r0, v) ;
+
+        if (halo_transport_sum (domain->Transport, products, 1u) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        alpha = rho_new / products [0] ;
+
+        for (index = 0u ; index != n ; index++)
+
+            s [index] = r [index] - alpha * v [index] ;
+
+        if (apply_preconditioner (domain, s, shat) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        apply_system_matrix (domain, shat, t) ;
+
+        products [0] = dot_product (domain, t, s) ;
+        products [1] = dot_product (domain, t, t) ;
+
+        if (halo_transport_sum (domain->Transport, products, 2u) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        omega = products [1] != 0.0 ? products [0] / products [1] : 0.0 ;
+
+        for (index = 0u ; index != n ; index++)
+        {
+            x [index] += alpha * phat [index] + omega * shat [index] ;
+            r [index]  = s [index] - omega * t [index] ;
+        }
+
+        rho = rho_new ;
+
+        domain->NIterations++ ;
+
+        if (omega == 0.0)
+
+            break ;
+    }
+
+    // The last iteration may have stopped before checking the residual
+
+    products [0] = dot_product (domain, r, r) ;
+
+    if (halo_transport_sum (domain->Transport, products, 1u) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    if (sqrt (products [0]) / norm_b >= DOMAIN_TOLERANCE)
+    {
+        fprintf (stderr,
+            "Domain decomposition: did not converge in %d iterations\n",
+            domain->NIterations) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return exchange_halo (domain, x) ;
+}
+
+/******************************************************************************/
+
+// Copies the owned temperatures of every tile into the Temperatures array
+// of the process 0
+
+static Error_t gather_temperatures (DomainDecomposition_t *domain, Dimensions_t *dimensions)
+{
+    HaloTransport_t *transport = domain->Transport ;
+    CellIndex_t      layer, row, column, cell ;
+    Quantity_t       rank ;
+
+    if (transport->Rank != 0u)
+    {
+        CellIndex_t ncells = 0u ;
+
+        for (cell = 0u ; cell != domain->Size ; cell++)
+
+            if (domain->Owned [cell] == true)
+
+                domain->Buffer [ncells++] = domain->Solution [cell] ;
+
+        return transport->Send (transport, 0u, domain->Buffer, sizeof (double) * ncells) ;
+    }
+
+    for (cell = 0u ; cell != domain->Size ; cell++)
+
+        if (domain->Owned [cell] == true)
+
+            domain->Temperatures [domain->Cells [cell]] = domain->Solution [cell] ;
+
+    for (rank = 1u ; rank != transport->NProcesses ; rank++)
+    {
+        CellIndex_t tile [8] ;
+
+        tile_window (domain, dimensions, rank, tile) ;
+
+        CellIndex_t ncells = get_number_of_layers (dimensions)
+                             * (tile [1] - tile [0] + 1u)
+                             * (tile [3] - tile [2] + 1u) ;
+
+        if (transport->Receive (transport, rank, domain->Buffer,
+                                sizeof (double) * ncells) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        cell = 0u ;
+
+        for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
+
+            for (row = tile [0] ; row <= tile [1] ; row++)
+
+                for (column = tile [2] ; column <= tile [3] ; column++)
+
+                    domain->Temperatures [get_cell_offset_in_stack (dimensions, layer, row, column)]
+
+                        = domain->Buffer [cell++] ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+SimResult_t domain_decomposition_emulate_step
+(
+    DomainDecomposition_t *domain,
+    Dimensions_t          *dimensions,
+    Analysis_t            *analysis
+)
+{
+    CellIndex_t cell ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT)
+
+        return TDICE_WRONG_CONFIG ;
+
+    if (slot_completed (analysis) == true)
+    {
+        Error_t result = update_source_vector (&domain->PowerGrid, dimensions) ;
+
+        if (result == TDICE_FAILURE)
+
+            return TDICE_END_OF_SIMULATION ;
+    }
+
+    for (cell = 0u ; cell != domain->Size ; cell++)
+
+        domain->Vector [cell] =   domain->PowerGrid.Sources [domain->Cells [cell]]
+                                + (domain->PowerGrid.CellsCapacities [domain->Cells [cell]] / analysis->StepTime)
+                                * domain->Solution [cell] ;
+
+    if (   solve_system        (domain)             != TDICE_SUCCESS
+        || gather_temperatures (domain, dimensions) != TDICE_SUCCESS)
+
+        return TDICE_SOLVER_ERROR ;
+
+    increase_by_step_time (analysis) ;
+
+    if (slot_completed (analysis) == false)
+
+        return TDICE_STEP_DONE ;
+
+    else
+
+        return TDICE_SLOT_DONE ;
+}
+
+/******************************************************************************/
+
+SimResult_t domain_decomposition_emulate_steady
+(
+    DomainDecomposition_t *domain,
+    Dimensions_t          *dimensions,
+    Analysis_t            *analysis
+)
+{
+    CellIndex_t cell ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_STEADY)
+
+        return TDICE_WRONG_CONFIG ;
+
+    Error_t result = update_source_vector (&domain->PowerGrid, dimensions) ;
+
+    if (result == TDICE_FAILURE)
+    {
+        fprintf (stderr,
+
+            "Warning: no power trace given for steady state simulation\n") ;
+
+        return TDICE_END_OF_SIMULATION ;
+    }
+
+    for (cell = 0u ; cell != domain->Size ; cell++)
+
+        domain->Vector [cell] = domain->PowerGrid.Sources [domain->Cells [cell]] ;
+
+    if (   solve_system        (domain)             != TDICE_SUCCESS
+        || gather_temperatures (domain, dimensions) != TDICE_SUCCESS)
+
+        return TDICE_SOLVER_ERROR ;
+
+    return TDICE_END_OF_SIMULATION ;
+}
+
+/******************************************************************************/
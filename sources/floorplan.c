@@ -38,9 +38,11 @@
 
 #include <stdlib.h> // For the memory functions malloc/free
 #include <string.h> // For the memory function memcpy
+#include <math.h>   // For the math function fabs
 
 #include "floorplan.h"
 #include "floorplan_file_parser.h"
+#include "macros.h"
 
 /******************************************************************************/
 
@@ -50,6 +52,8 @@ void floorplan_init (Floorplan_t *floorplan)
 
     floorplan->NElements    = (Quantity_t) 0u ;
     floorplan->Bpowers      = NULL ;
+    floorplan->NLeakages    = (Quantity_t) 0u ;
+    floorplan->Lpowers      = NULL ;
 
     floorplan_element_list_init (&floorplan->ElementsList) ;
     floorplan_matrix_init       (&floorplan->SurfaceCoefficients) ;
@@ -64,6 +68,7 @@ void floorplan_copy (Floorplan_t *dst, Floorplan_t *src)
     string_copy (&dst->FileName, &src->FileName) ;
 
     dst->NElements = src->NElements ;
+    dst->NLeakages = src->NLeakages ;
 
     floorplan_element_list_copy (&dst->ElementsList, &src->ElementsList) ;
 
@@ -86,6 +91,21 @@ void floorplan_copy (Floorplan_t *dst, Floorplan_t *src)
     }
 
     memcpy (dst->Bpowers, src->Bpowers, sizeof (Power_t) * src->NElements) ;
+
+    if (src->Lpowers == NULL)
+
+        return ;
+
+    dst->Lpowers = (Power_t *) malloc (sizeof (Power_t) * src->NElements) ;
+
+    if (dst->Lpowers == NULL)
+    {
+        fprintf (stderr, "ERROR: malloc Lpowers in floorplan copy\n") ;
+
+        return ;
+    }
+
+    memcpy (dst->Lpowers, src->Lpowers, sizeof (Power_t) * src->NElements) ;
 }
 
 /******************************************************************************/
@@ -98,6 +118,10 @@ void floorplan_destroy (Floorplan_t *floorplan)
 
         free (floorplan->Bpowers) ;
 
+    if (floorplan->Lpowers != NULL)
+
+        free (floorplan->Lpowers) ;
+
     floorplan_element_list_destroy (&floorplan->ElementsList) ;
     floorplan_matrix_destroy       (&floorplan->SurfaceCoefficients) ;
 
@@ -167,6 +191,58 @@ void floorplan_print (Floorplan_t *floorplan, FILE *stream, String_t prefix)
 
 /******************************************************************************/
 
+// Builds the matrix distributing the power of every floorplan element
+// over the thermal cells it covers
+
+static Error_t fill_surface_coefficients
+(
+    Floorplan_t  *floorplan,
+    Dimensions_t *dimensions
+)
+{
+    Error_t result ;
+
+    CellIndex_t nnz = 0u ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln))
+    {
+        FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
+
+        ICElementListNode_t *iceln ;
+
+        for (iceln  = ic_element_list_begin(&flpel->ICElements) ;
+             iceln != NULL ;
+             iceln  = ic_element_list_next (iceln))
+        {
+            ICElement_t *icel = ic_element_list_data(iceln) ;
+
+            nnz +=    (icel->NE_Row    - icel->SW_Row    + 1)
+                    * (icel->NE_Column - icel->SW_Column + 1) ;
+        }
+    }
+
+    result = floorplan_matrix_build
+
+        (&floorplan->SurfaceCoefficients, get_layer_area (dimensions),
+         floorplan->NElements, nnz) ;
+
+    if (result == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    floorplan_matrix_fill
+
+        (&floorplan->SurfaceCoefficients, &floorplan->ElementsList, dimensions) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
 Error_t fill_floorplan
 (
     Floorplan_t  *floorplan,
@@ -193,8 +269,33 @@ Error_t fill_floorplan
         return TDICE_FAILURE ;
     }
 
-    CellIndex_t nnz = 0u ;
+    if (floorplan->NLeakages != 0u)
+    {
+        floorplan->Lpowers =
+
+            (Power_t *) calloc (floorplan->NElements, sizeof (Power_t)) ;
+
+        if (floorplan->Lpowers == NULL)
+        {
+            fprintf (stderr, "Malloc Lpowers failed\n") ;
 
+            return TDICE_FAILURE ;
+        }
+    }
+
+    return fill_surface_coefficients (floorplan, dimensions) ;
+}
+
+/******************************************************************************/
+
+Error_t crop_floorplan
+(
+    Floorplan_t     *floorplan,
+    Dimensions_t    *dimensions,
+    ChipDimension_t  origin_x,
+    ChipDimension_t  origin_y
+)
+{
     FloorplanElementListNode_t *flpeln ;
 
     for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
@@ -203,33 +304,61 @@ Error_t fill_floorplan
     {
         FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
 
+        ICElementList_t      cropped ;
         ICElementListNode_t *iceln ;
 
-        for (iceln  = ic_element_list_begin(&flpel->ICElements) ;
+        ic_element_list_init (&cropped) ;
+
+        flpel->NICElements = 0u ;
+
+        for (iceln  = ic_element_list_begin (&flpel->ICElements) ;
              iceln != NULL ;
              iceln  = ic_element_list_next (iceln))
         {
-            ICElement_t *icel = ic_element_list_data(iceln) ;
+            ICElement_t *icel = ic_element_list_data (iceln) ;
 
-            nnz +=    (icel->NE_Row    - icel->SW_Row    + 1)
-                    * (icel->NE_Column - icel->SW_Column + 1) ;
-        }
-    }
+            ChipDimension_t west  = MAX (icel->SW_X - origin_x, 0.0) ;
+            ChipDimension_t south = MAX (icel->SW_Y - origin_y, 0.0) ;
 
-    result = floorplan_matrix_build
+            ChipDimension_t east  = MIN (icel->SW_X + icel->Length - origin_x,
+                                         get_chip_length (dimensions)) ;
 
-        (&floorplan->SurfaceCoefficients, get_layer_area (dimensions),
-         floorplan->NElements, nnz) ;
+            ChipDimension_t north = MIN (icel->SW_Y + icel->Width  - origin_y,
+                                         get_chip_width (dimensions)) ;
 
-    if (result == TDICE_FAILURE)
+            if (east - west <= EPSILON || north - south <= EPSILON)
 
-        return TDICE_FAILURE ;
+                continue ;
 
-    floorplan_matrix_fill
+            ICElement_t icelement ;
 
-        (&floorplan->SurfaceCoefficients, &floorplan->ElementsList, dimensions) ;
+            ic_element_init (&icelement) ;
+            ic_element_copy (&icelement, icel) ;
 
-    return TDICE_SUCCESS ;
+            icelement.SW_X   = west ;
+            icelement.SW_Y   = south ;
+            icelement.Length = east - west ;
+            icelement.Width  = north - south ;
+
+            align_to_grid (&icelement, dimensions) ;
+
+            ic_element_list_insert_end (&cropped, &icelement) ;
+
+            ic_element_destroy (&icelement) ;
+
+            flpel->NICElements++ ;
+        }
+
+        // The area is not changed: the power of the element is split
+        // over its whole surface, also the part that has been cut away
+
+        ic_element_list_copy    (&flpel->ICElements, &cropped) ;
+        ic_element_list_destroy (&cropped) ;
+    }
+
+    floorplan_matrix_destroy (&floorplan->SurfaceCoefficients) ;
+
+    return fill_surface_coefficients (floorplan, dimensions) ;
 }
 
 /******************************************************************************/
@@ -294,6 +423,61 @@ Error_t fill_sources_floorplan (Floorplan_t *floorplan, Source_t *sources)
 
 /******************************************************************************/
 
+Temperature_t update_leakage_floorplan
+(
+    Floorplan_t   *floorplan,
+    Dimensions_t  *dimensions,
+    Temperature_t *temperatures
+)
+{
+    Quantity_t    index = 0u ;
+    Temperature_t max_change = 0.0 ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    if (floorplan->Lpowers == NULL)
+
+        return max_change ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln), index++)
+    {
+        FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
+
+        if (flpel->Leakage == NULL)
+
+            continue ;
+
+        Temperature_t temperature = get_avg_temperature_floorplan_element
+
+            (flpel, dimensions, temperatures) ;
+
+        max_change = MAX (max_change, fabs (temperature - flpel->Leakage->Temperature)) ;
+
+        flpel->Leakage->Temperature = temperature ;
+
+        floorplan->Lpowers [ index ] = get_leakage_power (flpel->Leakage, temperature) ;
+    }
+
+    return max_change ;
+}
+
+/******************************************************************************/
+
+void fill_leakage_sources_floorplan (Floorplan_t *floorplan, Source_t *sources)
+{
+    if (floorplan->Lpowers == NULL)
+
+        return ;
+
+    floorplan_matrix_multiply
+
+        (&floorplan->SurfaceCoefficients, sources, floorplan->Lpowers) ;
+}
+
+/******************************************************************************/
+
 Error_t insert_power_values_floorplan
 (
     Floorplan_t   *floorplan,
@@ -322,6 +506,124 @@ Error_t insert_power_values_floorplan
 
 /******************************************************************************/
 
+Error_t repeat_power_values_floorplan (Floorplan_t *floorplan, bool average)
+{
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln))
+    {
+        FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
+
+        if (is_empty_powers_queue (flpel->PowerValues) == true)
+
+            return TDICE_FAILURE ;
+
+        Power_t power = average == true
+
+            ? get_average_powers_queue (flpel->PowerValues)
+            : flpel->PowerValues->Memory [flpel->PowerValues->Start] ;
+
+        put_front_into_powers_queue (flpel->PowerValues, power) ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Quantity_t get_next_power_values_floorplan
+
+    (Floorplan_t *floorplan, Power_t *pvalues)
+{
+    Quantity_t index = 0u ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln), index++)
+    {
+        FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
+
+        pvalues [index] = is_empty_powers_queue (flpel->PowerValues) == true
+
+            ? (Power_t) 0.0
+            : flpel->PowerValues->Memory [flpel->PowerValues->Start] ;
+    }
+
+    return index ;
+}
+
+/******************************************************************************/
+
+Quantity_t replace_next_power_values_floorplan
+
+    (Floorplan_t *floorplan, Power_t *pvalues)
+{
+    Quantity_t index = 0u ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln), index++)
+    {
+        FloorplanElement_t *flpel = floorplan_element_list_data (flpeln) ;
+
+        if (is_empty_powers_queue (flpel->PowerValues) == false)
+
+            flpel->PowerValues->Memory [flpel->PowerValues->Start] = pvalues [index] ;
+    }
+
+    return index ;
+}
+
+/******************************************************************************/
+
+Quantity_t save_power_values_floorplan
+
+    (Floorplan_t *floorplan, PowersQueue_t *pqueues)
+{
+    Quantity_t index = 0u ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln), index++)
+
+        powers_queue_copy
+
+            (&pqueues [index], floorplan_element_list_data (flpeln)->PowerValues) ;
+
+    return index ;
+}
+
+/******************************************************************************/
+
+Quantity_t restore_power_values_floorplan
+
+    (Floorplan_t *floorplan, PowersQueue_t *pqueues)
+{
+    Quantity_t index = 0u ;
+
+    FloorplanElementListNode_t *flpeln ;
+
+    for (flpeln  = floorplan_element_list_begin (&floorplan->ElementsList) ;
+         flpeln != NULL ;
+         flpeln  = floorplan_element_list_next (flpeln), index++)
+
+        powers_queue_copy
+
+            (floorplan_element_list_data (flpeln)->PowerValues, &pqueues [index]) ;
+
+    return index ;
+}
+
+/******************************************************************************/
+
 Temperature_t *get_all_max_temperatures_floorplan
 (
     Floorplan_t   *floorplan,
@@ -53,6 +53,7 @@ void floorplan_element_init (FloorplanElement_t *flpel)
 
     flpel->Area           = (ChipDimension_t) 0.0 ;
     flpel->PowerValues    = NULL ;
+    flpel->Leakage        = NULL ;
 }
 
 /******************************************************************************/
@@ -73,6 +74,7 @@ void floorplan_element_copy
     ic_element_list_copy (&dst->ICElements, &src->ICElements) ;
 
     dst->PowerValues = powers_queue_clone (src->PowerValues) ;
+    dst->Leakage     = leakage_clone      (src->Leakage) ;
 }
 
 /******************************************************************************/
@@ -84,6 +86,7 @@ void floorplan_element_destroy (FloorplanElement_t *flpel)
     ic_element_list_destroy (&flpel->ICElements) ;
 
     powers_queue_free (flpel->PowerValues) ;
+    leakage_free      (flpel->Leakage) ;
 
     floorplan_element_init (flpel) ;
 }
@@ -167,7 +170,13 @@ void floorplan_element_print
 
     powers_queue_print (flpel->PowerValues, stream, (String_t)"") ;
 
-    fprintf (stream, " ;\n%s\n", prefix) ;
+    fprintf (stream, " ;\n") ;
+
+    if (flpel->Leakage != NULL)
+
+        leakage_print (flpel->Leakage, stream, prefix) ;
+
+    fprintf (stream, "%s\n", prefix) ;
 }
 
 /******************************************************************************/
@@ -286,6 +295,10 @@ Temperature_t get_avg_temperature_floorplan_element
         avg += get_avg_temperature_ic_element (icel, dimensions, temperatures) ;
     }
 
+    if (flpel->NICElements == 0u)
+
+        return avg ;
+
     return avg / (Temperature_t) flpel->NICElements ;
 }
 
@@ -0,0 +1,908 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>  // For the function fprintf
+#include <stdlib.h> // For the memory functions malloc/free
+#include <string.h> // For the memory function memcpy
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <linux/futex.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "halo_transport.h"
+
+/******************************************************************************/
+
+// Processes are started independently: the time given to the others to
+// show up before giving up (in units of CONNECT_DELAY microseconds)
+
+#define CONNECT_DELAY    10000u
+#define CONNECT_ATTEMPTS 3000u
+
+// Largest number of bytes moved at once through a shared memory mailbox
+
+#define MAILBOX_BYTES    (256u * 1024u)
+
+// The number of times a process checks a mailbox before waiting on its
+// futex, and the period of the checks that the other process is alive
+
+#define SPIN_ITERATIONS  1000u
+#define WAIT_SECONDS     1
+
+#define SEGMENT_MAGIC    0x3d1ceu
+
+/******************************************************************************/
+/*************************** Shared memory transport **************************/
+/******************************************************************************/
+
+// One mailbox for every (sender, receiver) pair. The sender waits until
+// the previous chunk has been collected before posting a new one. The one
+// waiting (sender or receiver) raises its flag and sleeps on Signal, that
+// the other one increments before waking it up.
+
+typedef struct
+{
+    uint64_t Posted ;
+    uint64_t Collected ;
+    uint64_t Bytes ;
+    uint32_t Signal ;
+    uint32_t SenderWaiting ;
+    uint32_t ReceiverWaiting ;
+    uint32_t Padding [5] ;
+
+    unsigned char Message [MAILBOX_BYTES] ;
+
+} Mailbox_t ;
+
+// The segment starts with its header, followed by the process id of every
+// rank and by the mailboxes. The process 0 writes a generation, different
+// for each run, that the others check to tell the segment of this run from
+// the one left by a previous run.
+
+typedef struct
+{
+    uint32_t Magic ;
+    uint32_t NProcesses ;
+    uint32_t Attached ;
+    uint32_t Generation ;
+    uint32_t Padding [12] ;
+
+} Segment_t ;
+
+typedef struct
+{
+    Segment_t *Segment ;
+    size_t     Length ;
+    char       Name [64] ;
+
+} ShmData_t ;
+
+/******************************************************************************/
+
+// The bytes of the process ids, rounded up to keep the mailboxes aligned
+
+static size_t pids_bytes (Quantity_t nprocesses)
+{
+    return (sizeof (uint32_t) * nprocesses + sizeof (Segment_t) - 1u)
+           / sizeof (Segment_t) * sizeof (Segment_t) ;
+}
+
+static uint32_t *pids (ShmData_t *shm)
+{
+    return (uint32_t *) (shm->Segment + 1) ;
+}
+
+static Mailbox_t *mailbox (ShmData_t *shm, Quantity_t from, Quantity_t to)
+{
+    Mailbox_t *first = (Mailbox_t *)
+
+        ((unsigned char *) pids (shm) + pids_bytes (shm->Segment->NProcesses)) ;
+
+    return first + from * shm->Segment->NProcesses + to ;
+}
+
+/******************************************************************************/
+
+// A process (on the same host) is alive until it has exited
+
+static bool process_alive (uint32_t pid)
+{
+    return pid != 0u && (kill ((pid_t) pid, 0) == 0 || errno != ESRCH) ;
+}
+
+/******************************************************************************/
+
+// The sender waits for the mailbox to be empty, the receiver to be full
+
+static bool mailbox_ready (Mailbox_t *box, bool receiver)
+{
+    bool empty =    __atomic_load_n (&box->Posted,    __ATOMIC_SEQ_CST)
+                 == __atomic_load_n (&box->Collected, __ATOMIC_SEQ_CST) ;
+
+    return receiver == true ? empty == false : empty == true ;
+}
+
+/******************************************************************************/
+
+// Waits until the mailbox is ready, failing if the other process exits
+
+static Error_t wait_mailbox
+
+    (ShmData_t *shm, Mailbox_t *box, Quantity_t other, bool receiver)
+{
+    uint32_t  *waiting = receiver == true ? &box->ReceiverWaiting : &box->SenderWaiting ;
+    Quantity_t spin ;
+
+    for (spin = 0u ; spin != SPIN_ITERATIONS ; spin++)
+
+        if (mailbox_ready (box, receiver) == true)
+
+            return TDICE_SUCCESS ;
+
+    while (1)
+    {
+        struct timespec timeout = { WAIT_SECONDS, 0 } ;
+
+        __atomic_store_n (waiting, 1u, __ATOMIC_SEQ_CST) ;
+
+        uint32_t signal = __atomic_load_n (&box->Signal, __ATOMIC_SEQ_CST) ;
+
+        // Checked after raising the flag: the other process either sees
+        // the flag or has already made the mailbox ready
+
+        if (mailbox_ready (box, receiver) == false)
+
+            syscall (SYS_futex, &box->Signal, FUTEX_WAIT, signal, &timeout, NULL, 0) ;
+
+        __atomic_store_n (waiting, 0u, __ATOMIC_SEQ_CST) ;
+
+        if (mailbox_ready (box, receiver) == true)
+
+            return TDICE_SUCCESS ;
+
+        if (process_alive (pids (shm) [other]) == false)
+        {
+            fprintf (stderr, "Halo transport: process %d exited\n", other) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+}
+
+/******************************************************************************/
+
+// Wakes up the other process, only if it is waiting on the mailbox
+
+static void wake_mailbox (Mailbox_t *box, uint32_t *waiting)
+{
+    if (__atomic_load_n (waiting, __ATOMIC_SEQ_CST) == 0u)
+
+        return ;
+
+    __atomic_add_fetch (&box->Signal, 1u, __ATOMIC_SEQ_CST) ;
+
+    syscall (SYS_futex, &box->Signal, FUTEX_WAKE, INT_MAX, NULL, NULL, 0) ;
+}
+
+/******************************************************************************/
+
+static Error_t shm_send
+
+    (HaloTransport_t *transport, Quantity_t to, const void *message, size_t bytes)
+{
+    Mailbox_t           *box   = mailbox (transport->Data, transport->Rank, to) ;
+    const unsigned char *begin = (const unsigned char *) message ;
+
+    do
+    {
+        size_t chunk = bytes < MAILBOX_BYTES ? bytes : MAILBOX_BYTES ;
+
+        if (wait_mailbox (transport->Data, box, to, false) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        uint64_t collected = __atomic_load_n (&box->Collected, __ATOMIC_ACQUIRE) ;
+
+        memcpy (box->Message, begin, chunk) ;
+
+        box->Bytes = chunk ;
+
+        __atomic_store_n (&box->Posted, collected + 1u, __ATOMIC_SEQ_CST) ;
+
+        wake_mailbox (box, &box->ReceiverWaiting) ;
+
+        begin += chunk ;
+        bytes -= chunk ;
+
+    } while (bytes > 0) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static Error_t shm_receive
+
+    (HaloTransport_t *transport, Quantity_t from, void *message, size_t bytes)
+{
+    Mailbox_t     *box   = mailbox (transport->Data, from, transport->Rank) ;
+    unsigned char *begin = (unsigned char *) message ;
+
+    do
+    {
+        if (wait_mailbox (transport->Data, box, from, true) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        uint64_t collected = __atomic_load_n (&box->Collected, __ATOMIC_ACQUIRE) ;
+
+        if (box->Bytes > bytes)
+        {
+            fprintf (stderr, "Halo transport: unexpected message from %d\n", from) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        memcpy (begin, box->Message, box->Bytes) ;
+
+        begin += box->Bytes ;
+        bytes -= box->Bytes ;
+
+        __atomic_store_n (&box->Collected, collected + 1u, __ATOMIC_SEQ_CST) ;
+
+        wake_mailbox (box, &box->SenderWaiting) ;
+
+    } while (bytes > 0) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void shm_close (HaloTransport_t *transport)
+{
+    ShmData_t *shm = transport->Data ;
+
+    munmap (shm->Segment, shm->Length) ;
+
+    free (shm) ;
+}
+
+/******************************************************************************/
+
+// Maps the segment of the process 0 and checks it belongs to this run: it
+// has been initialized, its creator is alive and it is still the one with
+// that name (and not the one of a previous run, removed since then).
+// Returns false if the segment is not ready yet
+
+static bool shm_map_current (HaloTransport_t *transport, ShmData_t *shm)
+{
+    struct stat status ;
+    Segment_t   header ;
+
+    int fd = shm_open (shm->Name, O_RDWR, S_IRUSR | S_IWUSR) ;
+
+    if (fd < 0)
+
+        return false ;
+
+    if (fstat (fd, &status) != 0 || (size_t) status.st_size != shm->Length)
+    {
+        close (fd) ;
+
+        return false ;
+    }
+
+    shm->Segment = (Segment_t *) mmap
+
+        (NULL, shm->Length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+
+    close (fd) ;
+
+    if (shm->Segment == MAP_FAILED)
+    {
+        shm->Segment = NULL ;
+
+        return false ;
+    }
+
+    uint32_t generation = __atomic_load_n (&shm->Segment->Generation, __ATOMIC_ACQUIRE) ;
+
+    // The generation is read again from the segment that has the name now
+
+    fd = shm_open (shm->Name, O_RDONLY, S_IRUSR | S_IWUSR) ;
+
+    bool current =    fd >= 0
+                   && pread (fd, &header, sizeof (header), 0) == (ssize_t) sizeof (header)
+                   && __atomic_load_n (&shm->Segment->Magic, __ATOMIC_ACQUIRE) == SEGMENT_MAGIC
+                   && generation != 0u
+                   && header.Generation == generation
+                   && shm->Segment->NProcesses == transport->NProcesses
+                   && process_alive (pids (shm) [0]) == true ;
+
+    if (fd >= 0)
+
+        close (fd) ;
+
+    if (current == false)
+    {
+        munmap (shm->Segment, shm->Length) ;
+
+        shm->Segment = NULL ;
+    }
+
+    return current ;
+}
+
+/******************************************************************************/
+
+static Error_t shm_connect (HaloTransport_t *transport, const char *name)
+{
+    ShmData_t *shm = (ShmData_t *) malloc (sizeof (ShmData_t)) ;
+    Quantity_t attempt ;
+
+    if (shm == NULL)
+    {
+        fprintf (stderr, "Cannot malloc shared memory transport\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    snprintf (shm->Name, sizeof (shm->Name), "/3d-ice-%s", name) ;
+
+    shm->Segment = NULL ;
+    shm->Length  =   sizeof (Segment_t)
+                   + pids_bytes (transport->NProcesses)
+                   + sizeof (Mailbox_t) * transport->NProcesses * transport->NProcesses ;
+
+    // The first process creates the segment (removing the one left by a
+    // run that did not terminate), the others wait for it
+
+    if (transport->Rank == 0u)
+    {
+        struct timespec now ;
+
+        shm_unlink (shm->Name) ;
+
+        int fd = shm_open (shm->Name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR) ;
+
+        if (fd >= 0 && ftruncate (fd, (off_t) shm->Length) == 0)
+
+            shm->Segment = (Segment_t *) mmap
+
+                (NULL, shm->Length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+
+        if (fd >= 0)
+
+            close (fd) ;
+
+        if (shm->Segment == NULL || shm->Segment == MAP_FAILED)
+        {
+            perror ("ERROR :: shared memory segment") ;
+
+            shm_unlink (shm->Name) ;
+            free (shm) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        clock_gettime (CLOCK_REALTIME, &now) ;
+
+        shm->Segment->NProcesses = transport->NProcesses ;
+        shm->Segment->Generation = ((uint32_t) now.tv_nsec ^ (uint32_t) now.tv_sec ^ (uint32_t) getpid ( )) | 1u ;
+
+        pids (shm) [0] = (uint32_t) getpid ( ) ;
+
+        __atomic_store_n (&shm->Segment->Magic, SEGMENT_MAGIC, __ATOMIC_RELEASE) ;
+    }
+    else
+    {
+        for (attempt = 0u ; attempt != CONNECT_ATTEMPTS ; attempt++)
+        {
+            if (shm_map_current (transport, shm) == true)
+
+                break ;
+
+            usleep (CONNECT_DELAY) ;
+        }
+
+        if (shm->Segment == NULL)
+        {
+            fprintf (stderr, "Halo transport: no segment %s for %d processes\n",
+                shm->Name, transport->NProcesses) ;
+
+            free (shm) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        pids (shm) [transport->Rank] = (uint32_t) getpid ( ) ;
+    }
+
+    transport->Data    = shm ;
+    transport->Send    = shm_send ;
+    transport->Receive = shm_receive ;
+    transport->Close   = shm_close ;
+
+    // Every process waits for the others, so that their ids are known.
+    // Once everybody is attached the name is not needed anymore
+
+    __atomic_add_fetch (&shm->Segment->Attached, 1u, __ATOMIC_ACQ_REL) ;
+
+    for (attempt = 0u ; attempt != CONNECT_ATTEMPTS ; attempt++)
+    {
+        if (__atomic_load_n (&shm->Segment->Attached, __ATOMIC_ACQUIRE) == transport->NProcesses)
+
+            break ;
+
+        usleep (CONNECT_DELAY) ;
+    }
+
+    if (transport->Rank == 0u)
+
+        shm_unlink (shm->Name) ;
+
+    if (attempt == CONNECT_ATTEMPTS)
+    {
+        fprintf (stderr, "Halo transport: not all the processes attached to %s\n", shm->Name) ;
+
+        shm_close (transport) ;
+
+        transport->Data = NULL ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+/********************************* TCP transport ******************************/
+/******************************************************************************/
+
+// One connected socket for every other process
+
+typedef struct
+{
+    int *Sockets ;
+
+} TcpData_t ;
+
+/******************************************************************************/
+
+static Error_t tcp_send
+
+    (HaloTransport_t *transport, Quantity_t to, const void *message, size_t bytes)
+{
+    TcpData_t           *tcp   = transport->Data ;
+    const unsigned char *begin = (const unsigned char *) message ;
+
+    while (bytes > 0)
+    {
+        ssize_t bwritten = write (tcp->Sockets [to], begin, bytes) ;
+
+        if (bwritten < 0)
+        {
+            if (errno == EINTR)
+
+                continue ;
+
+            perror ("ERROR :: halo write failure") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        bytes -= (size_t) bwritten ;
+        begin += bwritten ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static Error_t tcp_receive
+
+    (HaloTransport_t *transport, Quantity_t from, void *message, size_t bytes)
+{
+    TcpData_t     *tcp   = transport->Data ;
+    unsigned char *begin = (unsigned char *) message ;
+
+    while (bytes > 0)
+    {
+        ssize_t bread = read (tcp->Sockets [from], begin, bytes) ;
+
+        if (bread < 0)
+        {
+            if (errno == EINTR)
+
+                continue ;
+
+            perror ("ERROR :: halo read failure") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (bread == 0)
+        {
+            fprintf (stderr, "Halo transport: process %d disconnected\n", from) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        bytes -= (size_t) bread ;
+        begin += bread ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void tcp_close (HaloTransport_t *transport)
+{
+    TcpData_t *tcp = transport->Data ;
+    Quantity_t index ;
+
+    for (index = 0u ; index != transport->NProcesses ; index++)
+
+        if (tcp->Sockets [index] >= 0)
+
+            close (tcp->Sockets [index]) ;
+
+    free (tcp->Sockets) ;
+    free (tcp) ;
+}
+
+/******************************************************************************/
+
+static Error_t tcp_connect (HaloTransport_t *transport, const char *address)
+{
+    char               host [32] ;
+    const char        *colon = strrchr (address, ':') ;
+    char              *end ;
+    struct sockaddr_in server ;
+    Quantity_t         index, attempt ;
+    int                listener = -1, one = 1 ;
+
+    if (colon == NULL || (size_t) (colon - address) >= sizeof (host))
+    {
+        fprintf (stderr, "Halo transport: expected tcp:address:port\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    memcpy (host, address, (size_t) (colon - address)) ;
+
+    host [colon - address] = '\0' ;
+
+    long port = strtol (colon + 1, &end, 10) ;
+
+    if (*end != '\0' || port <= 0 || port + transport->NProcesses > 65535)
+    {
+        fprintf (stderr, "Halo transport: wrong port number %s\n", colon + 1) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    memset (&server, 0, sizeof (server)) ;
+
+    server.sin_family = AF_INET ;
+
+    if (inet_pton (AF_INET, host, &server.sin_addr) <= 0)
+    {
+        fprintf (stderr, "Halo transport: wrong address %s\n", host) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    TcpData_t *tcp = (TcpData_t *) malloc (sizeof (TcpData_t)) ;
+
+    if (tcp == NULL)
+    {
+        fprintf (stderr, "Cannot malloc tcp transport\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    tcp->Sockets = (int *) malloc (sizeof (int) * transport->NProcesses) ;
+
+    if (tcp->Sockets == NULL)
+    {
+        fprintf (stderr, "Cannot malloc tcp transport\n") ;
+
+        free (tcp) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    for (index = 0u ; index != transport->NProcesses ; index++)
+
+        tcp->Sockets [index] = -1 ;
+
+    transport->Data    = tcp ;
+    transport->Send    = tcp_send ;
+    transport->Receive = tcp_receive ;
+    transport->Close   = tcp_close ;
+
+    // Every process listens for the ones with a higher rank ...
+
+    if (transport->Rank + 1u < transport->NProcesses)
+    {
+        struct sockaddr_in local = server ;
+
+        local.sin_port = htons ((uint16_t) (port + transport->Rank)) ;
+
+        listener = socket (AF_INET, SOCK_STREAM, 0) ;
+
+        if (   listener < 0
+            || setsockopt (listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one)) < 0
+            || bind (listener, (struct sockaddr *) &local, sizeof (local)) < 0
+            || listen (listener, (int) transport->NProcesses) < 0)
+        {
+            perror ("ERROR :: halo listen") ;
+
+            goto failure ;
+        }
+    }
+
+    // ... and connects to the ones with a lower rank
+
+    for (index = 0u ; index != transport->Rank ; index++)
+    {
+        uint32_t rank = transport->Rank ;
+
+        server.sin_port = htons ((uint16_t) (port + index)) ;
+
+        for (attempt = 0u ; attempt != CONNECT_ATTEMPTS ; attempt++)
+        {
+            tcp->Sockets [index] = socket (AF_INET, SOCK_STREAM, 0) ;
+
+            if (tcp->Sockets [index] < 0)
+            {
+                perror ("ERROR :: halo socket creation") ;
+
+                goto failure ;
+            }
+
+            if (connect (tcp->Sockets [index], (struct sockaddr *) &server, sizeof (server)) == 0)
+
+                break ;
+
+            close (tcp->Sockets [index]) ;
+
+            tcp->Sockets [index] = -1 ;
+
+            usleep (CONNECT_DELAY) ;
+        }
+
+        if (tcp->Sockets [index] < 0)
+        {
+            fprintf (stderr, "Halo transport: process %d not reachable\n", index) ;
+
+            goto failure ;
+        }
+
+        if (tcp_send (transport, index, &rank, sizeof (rank)) == TDICE_FAILURE)
+
+            goto failure ;
+    }
+
+    for (index = transport->Rank + 1u ; index != transport->NProcesses ; index++)
+    {
+        uint32_t      rank ;
+        struct pollfd descriptor = { listener, POLLIN, 0 } ;
+
+        // The processes with a higher rank get as long to show up as the
+        // ones that connect give to the listener
+
+        if (poll (&descriptor, 1, (int) (CONNECT_ATTEMPTS * (CONNECT_DELAY / 1000u))) == 0)
+        {
+            fprintf (stderr, "Halo transport: process %d not connected\n", index) ;
+
+            goto failure ;
+        }
+
+        int client = accept (listener, NULL, NULL) ;
+
+        if (client < 0)
+        {
+            perror ("ERROR :: halo accept") ;
+
+            goto failure ;
+        }
+
+        ssize_t bread = recv (client, &rank, sizeof (rank), MSG_WAITALL) ;
+
+        if (   bread != (ssize_t) sizeof (rank)
+            || rank <= transport->Rank || rank >= transport->NProcesses
+            || tcp->Sockets [rank] >= 0)
+        {
+            fprintf (stderr, "Halo transport: unexpected connection\n") ;
+
+            close (client) ;
+
+            goto failure ;
+        }
+
+        tcp->Sockets [rank] = client ;
+    }
+
+    if (listener >= 0)
+
+        close (listener) ;
+
+    // Halo messages are small and latency bound
+
+    for (index = 0u ; index != transport->NProcesses ; index++)
+
+        if (tcp->Sockets [index] >= 0)
+
+            setsockopt (tcp->Sockets [index], IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one)) ;
+
+    return TDICE_SUCCESS ;
+
+failure :
+
+    if (listener >= 0)
+
+        close (listener) ;
+
+    tcp_close (transport) ;
+
+    transport->Data = NULL ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
+
+void halo_transport_init (HaloTransport_t *transport)
+{
+    transport->Rank       = (Quantity_t) 0u ;
+    transport->NProcesses = (Quantity_t) 0u ;
+    transport->Data       = NULL ;
+    transport->Send       = NULL ;
+    transport->Receive    = NULL ;
+    transport->Close      = NULL ;
+}
+
+/******************************************************************************/
+
+Error_t halo_transport_connect
+(
+    HaloTransport_t *transport,
+    String_t         address,
+    Quantity_t       rank,
+    Quantity_t       nprocesses
+)
+{
+    if (rank >= nprocesses)
+    {
+        fprintf (stderr, "Halo transport: rank %d out of %d processes\n", rank, nprocesses) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    transport->Rank       = rank ;
+    transport->NProcesses = nprocesses ;
+
+    if (strncmp (address, "shm:", 4) == 0 && address [4] != '\0')
+
+        return shm_connect (transport, address + 4) ;
+
+    if (strncmp (address, "tcp:", 4) == 0)
+
+        return tcp_connect (transport, address + 4) ;
+
+    fprintf (stderr, "Halo transport: unknown address %s\n", address) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+Error_t halo_transport_sum
+(
+    HaloTransport_t *transport,
+    double          *values,
+    Quantity_t       size
+)
+{
+    double     partial [8] ;
+    Quantity_t index, process ;
+
+    if (size > 8u)
+
+        return TDICE_FAILURE ;
+
+    if (transport->Rank != 0u)
+    {
+        if (transport->Send (transport, 0u, values, sizeof (double) * size) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        return transport->Receive (transport, 0u, values, sizeof (double) * size) ;
+    }
+
+    for (process = 1u ; process != transport->NProcesses ; process++)
+    {
+        if (transport->Receive (transport, process, partial, sizeof (double) * size) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        for (index = 0u ; index != size ; index++)
+
+            values [index] += partial [index] ;
+    }
+
+    for (process = 1u ; process != transport->NProcesses ; process++)
+
+        if (transport->Send (transport, process, values, sizeof (double) * size) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+void halo_transport_destroy (HaloTransport_t *transport)
+{
+    if (transport->Data != NULL && transport->Close != NULL)
+
+        transport->Close (transport) ;
+
+    halo_transport_init (transport) ;
+}
+
+/******************************************************************************/
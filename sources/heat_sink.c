@@ -46,6 +46,12 @@
 #include "heat_sink.h"
 #include "macros.h"
 
+// The plugin keeps its state in the process, so only one heatsink (and its
+// copies) can use it at a time: the one that loaded it, until destroyed
+static HeatSink_t *pluginOwner = NULL;
+
+static void forget_heatsink_plugin_v2(void);
+
 /******************************************************************************/
 
 void heat_sink_init (HeatSink_t *hsink)
@@ -70,6 +76,14 @@ void heat_sink_init (HeatSink_t *hsink)
     hsink->NumColumnsBorder   = 0;
     
     hsink->PluggableHeatsink        = NULL;
+    hsink->PluggableHeatsinkSteady  = NULL;
+    hsink->PluggableHeatsinkInterval = NULL;
+    
+    hsink->CommunicationSteps = 1;
+    hsink->Extrapolate        = false;
+    hsink->CurrentStep        = 0;
+    hsink->HeatFlows          = NULL;
+    hsink->PreviousHeatFlows  = NULL;
 }
 
 /******************************************************************************/
@@ -110,16 +124,38 @@ void heat_sink_copy (HeatSink_t *dst, HeatSink_t *src)
     dst->NumColumnsBorder   = src->NumColumnsBorder;
     
     dst->PluggableHeatsink  = src->PluggableHeatsink;
+    dst->PluggableHeatsinkSteady = src->PluggableHeatsinkSteady;
+    dst->PluggableHeatsinkInterval = src->PluggableHeatsinkInterval;
+    
+    dst->CommunicationSteps = src->CommunicationSteps;
+    dst->Extrapolate        = src->Extrapolate;
+    dst->CurrentStep        = src->CurrentStep;
+    
+    if(src->HeatFlows != NULL)
+    {
+        size_t size = sizeof(double) * src->NRows * src->NColumns;
+        dst->HeatFlows         = array_alloc_copy(src->HeatFlows,         size);
+        dst->PreviousHeatFlows = array_alloc_copy(src->PreviousHeatFlows, size);
+    }
 }
 
 /******************************************************************************/
 
 void heat_sink_destroy (HeatSink_t *hsink)
 {    
+    if(hsink == pluginOwner)
+    {
+        pluginOwner = NULL;
+        forget_heatsink_plugin_v2();
+    }
+    
     material_destroy (&hsink->SpreaderMaterial);
     string_destroy (&hsink->Plugin);
     string_destroy (&hsink->Args);
     
+    free (hsink->HeatFlows);
+    free (hsink->PreviousHeatFlows);
+    
     heat_sink_init (hsink) ;
 }
 
@@ -243,6 +279,12 @@ void heat_sink_print (HeatSink_t *hsink, FILE *stream, String_t prefix)
             "%s   plugin args             %s ;\n",
             prefix, hsink->Args) ;
         
+        if(hsink->CommunicationSteps > 1)
+            fprintf (stream,
+                "%s   communication interval  %d%s ;\n",
+                prefix, hsink->CommunicationSteps,
+                hsink->Extrapolate ? ", extrapolate" : "") ;
+        
         fprintf (stream,
             "%s   cell     length          %.0f ;\n",
             prefix, hsink->CellLength) ;
@@ -271,12 +313,134 @@ void heat_sink_print (HeatSink_t *hsink, FILE *stream, String_t prefix)
 
 // Need a static variable because atexit doesn't allow parameters
 static void *so = NULL;
+static bool atexitRegistered = false;
+
+// Version 2 of the plugin ABI. The plugin registers the spreader temperature
+// and heat flow buffers once, and is told the simulation time and time step
+// at each call. The buffers are the spreader cells of the temperatures and
+// sources of the thermal data, so the plugin is initialized when the thermal
+// data registers them, not when the stack file is parsed. The callbacks of
+// the heatsink structure keep the version 1 signatures and must be given the
+// registered buffers
+static unsigned int abiVersion = 1;
+
+static struct
+{
+    int (*init)(unsigned int nrows, unsigned int ncols,
+                double cellwidth,   double celllength,
+                double initialtemperature,
+                double spreaderconductance,
+                const double *spreadertemperatures,
+                      double *heatflow,
+                const char *args);
+    int (*simulate)(double time, double timestep);
+    int (*steady)(void);
+    size_t (*stateSize)(void);
+    int (*saveState)(void *state);
+    int (*restoreState)(const void *state);
+    const double *temperatures;
+    double *heatflows;
+    unsigned int nrows, ncols;
+    double cellwidth, celllength, initialtemperature, spreaderconductance;
+    const char *args;
+    double time, timestep;
+} v2;
+
+// The entry points of a version 2 plugin point into its shared object, so
+// they are forgotten when it is unloaded or its owner destroyed
+static void forget_heatsink_plugin_v2(void)
+{
+    memset(&v2, 0, sizeof(v2));
+    abiVersion = 1;
+}
 
 static void close_shared_object()
 {
     if(so) dlclose(so);
 }
 
+static int heatsink_init_v2_adapter(unsigned int nrows, unsigned int ncols,
+                                    double cellwidth,   double celllength,
+                                    double initialtemperature,
+                                    double spreaderconductance,
+                                    double timestep,
+                                    const char *args)
+{
+    // The plugin init is deferred to register_pluggable_heatsink_buffers
+    v2.temperatures        = NULL;
+    v2.heatflows           = NULL;
+    v2.nrows               = nrows;
+    v2.ncols               = ncols;
+    v2.cellwidth           = cellwidth;
+    v2.celllength          = celllength;
+    v2.initialtemperature  = initialtemperature;
+    v2.spreaderconductance = spreaderconductance;
+    v2.args                = args;
+    v2.time                = 0.0;
+    v2.timestep            = timestep;
+    return 0;
+}
+
+static bool registered_buffers(const double *spreadertemperatures,
+                               const double *heatflow)
+{
+    if(spreadertemperatures == v2.temperatures && heatflow == v2.heatflows)
+        return true;
+    fprintf (stderr, "ERROR: heatsink plugin called with unregistered buffers\n") ;
+    return false;
+}
+
+static int heatsink_simulate_v2_adapter(const double *spreadertemperatures,
+                                              double *heatflow)
+{
+    if(registered_buffers(spreadertemperatures, heatflow) == false)
+        return -1;
+    return v2.simulate(v2.time, v2.timestep);
+}
+
+static int heatsink_steady_v2_adapter(const double *spreadertemperatures,
+                                            double *heatflow)
+{
+    if(registered_buffers(spreadertemperatures, heatflow) == false)
+        return -1;
+    return v2.steady();
+}
+
+static Error_t load_heatsink_plugin_v2(HeatSink_t *hsink)
+{
+    v2.init = 
+    (int (*)(unsigned int, unsigned int, double, double, double, double,
+             const double*, double*, const char*))
+           dlsym(so, "heatsink_init_v2");
+    v2.simulate = (int (*)(double, double)) dlsym(so, "heatsink_simulate_v2");
+    if(v2.init == NULL || v2.simulate == NULL)
+    {
+        fprintf (stderr, "ERROR: heatsink plugin reported %s\n", dlerror()) ;
+        return TDICE_FAILURE;
+    }
+    
+    // The steady state and the state save/restore entry points are optional
+    v2.steady       = (int (*)(void))        dlsym(so, "heatsink_steady_state_v2");
+    v2.stateSize    = (size_t (*)(void))     dlsym(so, "heatsink_state_size_v2");
+    v2.saveState    = (int (*)(void*))       dlsym(so, "heatsink_save_state_v2");
+    v2.restoreState = (int (*)(const void*)) dlsym(so, "heatsink_restore_state_v2");
+    if(v2.stateSize == NULL || v2.saveState == NULL || v2.restoreState == NULL)
+    {
+        v2.stateSize    = NULL;
+        v2.saveState    = NULL;
+        v2.restoreState = NULL;
+    }
+    
+    hsink->PluggableHeatsinkInit   = heatsink_init_v2_adapter;
+    hsink->PluggableHeatsink       = heatsink_simulate_v2_adapter;
+    hsink->PluggableHeatsinkSteady = v2.steady != NULL
+                                   ? heatsink_steady_v2_adapter : NULL;
+    // The time step given at each call supersedes the communication interval
+    hsink->PluggableHeatsinkInterval = NULL;
+    
+    return TDICE_SUCCESS;
+}
+
 Error_t initialize_heat_spreader(HeatSink_t *hsink, Dimensions_t *chip)
 {
     if(hsink->SinkModel != TDICE_HEATSINK_TOP_PLUGGABLE)
@@ -331,13 +495,37 @@ Error_t initialize_heat_spreader(HeatSink_t *hsink, Dimensions_t *chip)
     }
         
     strncat(path,hsink->Plugin,sizeof(path)-1);
+    if(pluginOwner != NULL && pluginOwner != hsink)
+    {
+        fprintf (stderr, "ERROR: heatsink plugin already used by another stack\n") ;
+        return TDICE_FAILURE;
+    }
+    if(so != NULL)
+        dlclose(so);
+    forget_heatsink_plugin_v2();
     so = dlopen(path, RTLD_LAZY | RTLD_GLOBAL);
     if(so == NULL)
     {
         fprintf (stderr, "ERROR: could not load heatsink plugin %s\n", path) ;
         return TDICE_FAILURE;
     }
-    atexit(close_shared_object);
+    pluginOwner = hsink;
+    if(atexitRegistered == false)
+        atexit(close_shared_object);
+    atexitRegistered = true;
+    
+    // Plugins not exporting their ABI version implement version 1
+    unsigned int (*version)(void) =
+    (unsigned int (*)(void)) dlsym(so, "heatsink_abi_version");
+    abiVersion = version != NULL ? version() : 1;
+    if(abiVersion == 2)
+        return load_heatsink_plugin_v2(hsink);
+    if(abiVersion != 1)
+    {
+        fprintf (stderr, "ERROR: unsupported heatsink plugin ABI version %u\n",
+                 abiVersion) ;
+        return TDICE_FAILURE;
+    }
     
     hsink->PluggableHeatsinkInit = 
     (int (*)(unsigned int, unsigned int, double, double, double, double, double, const char*))
@@ -357,23 +545,194 @@ Error_t initialize_heat_spreader(HeatSink_t *hsink, Dimensions_t *chip)
         return TDICE_FAILURE;
     }
     
+    // The steady state entry point is optional
+    hsink->PluggableHeatsinkSteady =
+    (int (*)(const double*, double*))
+           dlsym(so, "heatsink_steady_state");
+    
+    // The communication interval entry point is optional
+    hsink->PluggableHeatsinkInterval =
+    (int (*)(unsigned int))
+           dlsym(so, "heatsink_communication_interval");
+    
     return TDICE_SUCCESS;
 }
 
 Error_t initialize_pluggable_heatsink(HeatSink_t *hsink, Analysis_t *analysis)
 {
     double spreaderConductance = get_spreader_conductance_top_bottom(hsink);
+    // The plugin advances by a whole communication interval at each call
     if(hsink->PluggableHeatsinkInit(
         hsink->NRows,     hsink->NColumns,
         hsink->CellWidth, hsink->CellLength,
         analysis->InitialTemperature,
         spreaderConductance,
-        analysis->StepTime,
+        analysis->StepTime * hsink->CommunicationSteps,
         hsink->Args) != 0)
         return TDICE_FAILURE;
+    
+    if(hsink->PluggableHeatsinkInterval != NULL &&
+       hsink->PluggableHeatsinkInterval(hsink->CommunicationSteps) != 0)
+        return TDICE_FAILURE;
+    
+    return TDICE_SUCCESS;
+}
+
+Error_t register_pluggable_heatsink_buffers(HeatSink_t *hsink,
+                                            const double *spreadertemperatures,
+                                                  double *heatflows)
+{
+    // Version 1 plugins are given the buffers at each call
+    if(hsink->SinkModel != TDICE_HEATSINK_TOP_PLUGGABLE || abiVersion != 2)
+        return TDICE_SUCCESS;
+    
+    v2.temperatures = spreadertemperatures;
+    v2.heatflows    = heatflows;
+    if(v2.init(v2.nrows, v2.ncols, v2.cellwidth, v2.celllength,
+               v2.initialtemperature, v2.spreaderconductance,
+               v2.temperatures, v2.heatflows, v2.args) != 0)
+        return TDICE_FAILURE;
+    
+    return TDICE_SUCCESS;
+}
+
+Error_t pluggable_heatsink_heat_flows(HeatSink_t *hsink,
+                                      const double *spreadertemperatures,
+                                            double *heatflows,
+                                            Time_t  time)
+{
+    v2.time = time;
+    if(hsink->CommunicationSteps <= 1)
+        return hsink->PluggableHeatsink(spreadertemperatures, heatflows) == 0
+             ? TDICE_SUCCESS : TDICE_FAILURE;
+    
+    size_t size = hsink->NRows * hsink->NColumns;
+    Quantity_t step = hsink->CurrentStep % hsink->CommunicationSteps;
+    
+    // Allocated at the first step, the heatsink of the thermal grid
+    // being a copy made before the pluggable heatsink initialization
+    if(hsink->HeatFlows == NULL)
+    {
+        hsink->HeatFlows         = (double *) calloc(size, sizeof(double));
+        hsink->PreviousHeatFlows = (double *) calloc(size, sizeof(double));
+        if(hsink->HeatFlows == NULL || hsink->PreviousHeatFlows == NULL)
+        {
+            fprintf (stderr, "ERROR: cannot malloc heatsink heat flows\n") ;
+            return TDICE_FAILURE;
+        }
+    }
+    hsink->CurrentStep++;
+    
+    if(step == 0)
+    {
+        double *tmp              = hsink->PreviousHeatFlows;
+        hsink->PreviousHeatFlows = hsink->HeatFlows;
+        hsink->HeatFlows         = tmp;
+        
+        if(hsink->PluggableHeatsink(spreadertemperatures, heatflows) != 0)
+            return TDICE_FAILURE;
+        
+        memcpy(hsink->HeatFlows, heatflows, sizeof(double) * size);
+        return TDICE_SUCCESS;
+    }
+    
+    // Extrapolation needs two calls of the callback
+    if(hsink->Extrapolate == false || hsink->CurrentStep < hsink->CommunicationSteps)
+    {
+        memcpy(heatflows, hsink->HeatFlows, sizeof(double) * size);
+        return TDICE_SUCCESS;
+    }
+    
+    double ratio = (double) step / hsink->CommunicationSteps;
+    size_t i;
+    for(i = 0; i < size; i++)
+        heatflows[i] = hsink->HeatFlows[i]
+                     + ratio * (hsink->HeatFlows[i] - hsink->PreviousHeatFlows[i]);
+    
     return TDICE_SUCCESS;
 }
 
+// The state is the communication interval position and held heat flows,
+// followed by the state of the plugin itself. The simulation time is the
+// one of the analysis, given at each call
+static size_t heat_flows_state_size(HeatSink_t *hsink)
+{
+    if(hsink->CommunicationSteps <= 1)
+        return 0;
+    return 2 * sizeof(double) * hsink->NRows * hsink->NColumns;
+}
+
+size_t get_pluggable_heatsink_state_size(HeatSink_t *hsink)
+{
+    if(hsink->SinkModel != TDICE_HEATSINK_TOP_PLUGGABLE || abiVersion != 2
+       || v2.stateSize == NULL)
+        return 0;
+    
+    return sizeof(Quantity_t)
+         + heat_flows_state_size(hsink) + v2.stateSize();
+}
+
+Error_t save_pluggable_heatsink_state(HeatSink_t *hsink, void *state)
+{
+    if(abiVersion != 2 || get_pluggable_heatsink_state_size(hsink) == 0)
+    {
+        fprintf (stderr, "ERROR: heatsink plugin does not support state save\n") ;
+        return TDICE_FAILURE;
+    }
+    
+    char *ptr = (char *) state;
+    memcpy(ptr, &hsink->CurrentStep, sizeof(Quantity_t));
+    ptr += sizeof(Quantity_t);
+    
+    size_t size = heat_flows_state_size(hsink);
+    if(size > 0)
+    {
+        // Not yet allocated if no step has been simulated
+        if(hsink->HeatFlows != NULL)
+        {
+            memcpy(ptr,            hsink->HeatFlows,         size / 2);
+            memcpy(ptr + size / 2, hsink->PreviousHeatFlows, size / 2);
+        }
+        else memset(ptr, 0, size);
+        ptr += size;
+    }
+    
+    return v2.saveState(ptr) == 0 ? TDICE_SUCCESS : TDICE_FAILURE;
+}
+
+Error_t restore_pluggable_heatsink_state(HeatSink_t *hsink, const void *state)
+{
+    if(abiVersion != 2 || get_pluggable_heatsink_state_size(hsink) == 0)
+    {
+        fprintf (stderr, "ERROR: heatsink plugin does not support state restore\n") ;
+        return TDICE_FAILURE;
+    }
+    
+    const char *ptr = (const char *) state;
+    memcpy(&hsink->CurrentStep, ptr, sizeof(Quantity_t));
+    ptr += sizeof(Quantity_t);
+    
+    size_t size = heat_flows_state_size(hsink);
+    if(size > 0)
+    {
+        if(hsink->HeatFlows == NULL)
+        {
+            hsink->HeatFlows         = (double *) malloc(size / 2);
+            hsink->PreviousHeatFlows = (double *) malloc(size / 2);
+            if(hsink->HeatFlows == NULL || hsink->PreviousHeatFlows == NULL)
+            {
+                fprintf (stderr, "ERROR: cannot malloc heatsink heat flows\n") ;
+                return TDICE_FAILURE;
+            }
+        }
+        memcpy(hsink->HeatFlows,         ptr,            size / 2);
+        memcpy(hsink->PreviousHeatFlows, ptr + size / 2, size / 2);
+        ptr += size;
+    }
+    
+    return v2.restoreState(ptr) == 0 ? TDICE_SUCCESS : TDICE_FAILURE;
+}
+
 Capacity_t get_spreader_capacity(HeatSink_t *hsink)
 {
     assert(hsink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE);
@@ -1114,6 +1114,81 @@ error:
 
 /******************************************************************************/
 
+Temperature_t get_inspection_point_temperature
+(
+    InspectionPoint_t *ipoint,
+    Dimensions_t      *dimensions,
+    Temperature_t     *temperatures
+)
+{
+    if (ipoint->OType == TDICE_OUTPUT_TYPE_TCELL)
+    {
+        Quantity_t index ;
+
+        if (dimensions->NonUniform == 1)
+
+            index = get_non_uniform_inspection_cell_index (ipoint, dimensions) ;
+
+        else
+
+            index = get_cell_offset_in_stack
+
+                (dimensions,
+                 get_source_layer_offset(ipoint->StackElement),
+                 ipoint->RowIndex, ipoint->ColumnIndex) ;
+
+        return *(temperatures + index) ;
+    }
+
+    if (ipoint->OType != TDICE_OUTPUT_TYPE_TFLPEL)
+
+        return (Temperature_t) 0.0 ;
+
+    if (dimensions->NonUniform != 1)
+
+        temperatures += get_cell_offset_in_stack
+
+            (dimensions,
+             get_source_layer_offset(ipoint->StackElement),
+             first_row (dimensions), first_column (dimensions)) ;
+
+    switch (ipoint->Quantity)
+    {
+        case TDICE_OUTPUT_QUANTITY_MAXIMUM :
+
+            return get_max_temperature_floorplan_element
+
+                (ipoint->FloorplanElement, dimensions, temperatures) ;
+
+        case TDICE_OUTPUT_QUANTITY_MINIMUM :
+
+            return get_min_temperature_floorplan_element
+
+                (ipoint->FloorplanElement, dimensions, temperatures) ;
+
+        case TDICE_OUTPUT_QUANTITY_AVERAGE :
+
+            return get_avg_temperature_floorplan_element
+
+                (ipoint->FloorplanElement, dimensions, temperatures) ;
+
+        case TDICE_OUTPUT_QUANTITY_GRADIENT :
+
+            return get_gradient_temperature_floorplan_element
+
+                (ipoint->FloorplanElement, dimensions, temperatures) ;
+
+        default :
+
+            fprintf (stderr,
+                "Inspection Point: Error reading output quantity for Tflpel\n") ;
+
+            return (Temperature_t) 0.0 ;
+    }
+}
+
+/******************************************************************************/
+
 void fill_message_inspection_point
 (
     InspectionPoint_t *ipoint,
@@ -1127,22 +1202,11 @@ void fill_message_inspection_point
     switch (ipoint->OType)
     {
         case TDICE_OUTPUT_TYPE_TCELL :
+        case TDICE_OUTPUT_TYPE_TFLPEL :
         {
-            Quantity_t index ;
+            float temperature = get_inspection_point_temperature
 
-            if (dimensions->NonUniform == 1)
-
-                index = get_non_uniform_inspection_cell_index (ipoint, dimensions) ;
-
-            else
-
-                index = get_cell_offset_in_stack
-
-                    (dimensions,
-                     get_source_layer_offset(ipoint->StackElement),
-                     ipoint->RowIndex, ipoint->ColumnIndex) ;
-
-            float temperature = *(temperatures + index) ;
+                (ipoint, dimensions, temperatures) ;
 
             insert_message_word (message, &temperature) ;
 
@@ -1229,55 +1293,6 @@ void fill_message_inspection_point
 
             break ;
         }
-        case TDICE_OUTPUT_TYPE_TFLPEL :
-        {
-            if (dimensions->NonUniform != 1)
-
-                temperatures += get_cell_offset_in_stack
-
-                    (dimensions,
-                     get_source_layer_offset(ipoint->StackElement),
-                     first_row (dimensions), first_column (dimensions)) ;
-
-
-            float temperature ;
-
-            if (output_quantity == TDICE_OUTPUT_QUANTITY_MAXIMUM)
-
-                temperature = get_max_temperature_floorplan_element
-
-                    (ipoint->FloorplanElement, dimensions, temperatures) ;
-
-            else if (output_quantity == TDICE_OUTPUT_QUANTITY_MINIMUM)
-
-                temperature = get_min_temperature_floorplan_element
-
-                    (ipoint->FloorplanElement, dimensions, temperatures) ;
-
-            else if (output_quantity == TDICE_OUTPUT_QUANTITY_AVERAGE)
-
-                temperature = get_avg_temperature_floorplan_element
-
-                    (ipoint->FloorplanElement, dimensions, temperatures) ;
-
-            else if (output_quantity == TDICE_OUTPUT_QUANTITY_GRADIENT)
-
-                temperature = get_gradient_temperature_floorplan_element
-
-                    (ipoint->FloorplanElement, dimensions, temperatures) ;
-
-            else
-            {
-                fprintf (stderr,
-                    "Inspection Point: Error reading output quantity for Tflpel\n") ;
-
-                break ;
-            }
-
-            insert_message_word (message, &temperature) ;
-
-            break ;
-        }
         case TDICE_OUTPUT_TYPE_TMAP :
         {
             if (dimensions->NonUniform == 1)
@@ -0,0 +1,294 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/free
+#include <string.h> // For the memory function memcpy
+#include <math.h>   // For the math function exp
+
+#include "leakage.h"
+
+/******************************************************************************/
+
+void leakage_init (Leakage_t *leakage)
+{
+    leakage->Model        = (LeakageModel_t) TDICE_LEAKAGE_NONE ;
+    leakage->Power        = (Power_t) 0.0 ;
+    leakage->Coefficient  = 0.0 ;
+    leakage->Reference    = (Temperature_t) 0.0 ;
+    leakage->NPoints      = (Quantity_t) 0u ;
+    leakage->Temperatures = NULL ;
+    leakage->Powers       = NULL ;
+    leakage->Temperature  = (Temperature_t) 0.0 ;
+}
+
+/******************************************************************************/
+
+void leakage_copy (Leakage_t *dst, Leakage_t *src)
+{
+    leakage_destroy (dst) ;
+
+    dst->Model       = src->Model ;
+    dst->Power       = src->Power ;
+    dst->Coefficient = src->Coefficient ;
+    dst->Reference   = src->Reference ;
+    dst->Temperature = src->Temperature ;
+
+    if (src->NPoints == 0u)
+
+        return ;
+
+    dst->Temperatures = (Temperature_t *) malloc (sizeof (Temperature_t) * src->NPoints) ;
+    dst->Powers       = (Power_t *)       malloc (sizeof (Power_t)       * src->NPoints) ;
+
+    if (dst->Temperatures == NULL || dst->Powers == NULL)
+    {
+        fprintf (stderr, "ERROR: malloc leakage points in leakage copy\n") ;
+
+        free (dst->Temperatures) ;
+        free (dst->Powers) ;
+
+        dst->Temperatures = NULL ;
+        dst->Powers       = NULL ;
+
+        return ;
+    }
+
+    memcpy (dst->Temperatures, src->Temperatures, sizeof (Temperature_t) * src->NPoints) ;
+    memcpy (dst->Powers,       src->Powers,       sizeof (Power_t)       * src->NPoints) ;
+
+    dst->NPoints = src->NPoints ;
+}
+
+/******************************************************************************/
+
+void leakage_destroy (Leakage_t *leakage)
+{
+    free (leakage->Temperatures) ;
+    free (leakage->Powers) ;
+
+    leakage_init (leakage) ;
+}
+
+/******************************************************************************/
+
+Leakage_t *leakage_calloc (void)
+{
+    Leakage_t *leakage = (Leakage_t *) malloc (sizeof (Leakage_t)) ;
+
+    if (leakage != NULL)
+
+        leakage_init (leakage) ;
+
+    return leakage ;
+}
+
+/******************************************************************************/
+
+Leakage_t *leakage_clone (Leakage_t *leakage)
+{
+    if (leakage == NULL)
+
+        return NULL ;
+
+    Leakage_t *newl = leakage_calloc ( ) ;
+
+    if (newl != NULL)
+
+        leakage_copy (newl, leakage) ;
+
+    return newl ;
+}
+
+/******************************************************************************/
+
+void leakage_free (Leakage_t *leakage)
+{
+    if (leakage == NULL)
+
+        return ;
+
+    leakage_destroy (leakage) ;
+
+    free (leakage) ;
+}
+
+/******************************************************************************/
+
+void leakage_print (Leakage_t *leakage, FILE *stream, String_t prefix)
+{
+    Quantity_t index ;
+
+    switch (leakage->Model)
+    {
+        case TDICE_LEAKAGE_EXPONENTIAL :
+
+            fprintf (stream, "%s   leakage exponential %.4f, %.6f, %.2f ;\n",
+                prefix, leakage->Power, leakage->Coefficient, leakage->Reference) ;
+
+            break ;
+
+        case TDICE_LEAKAGE_PIECEWISE_LINEAR :
+
+            fprintf (stream, "%s   leakage piecewise linear ", prefix) ;
+
+            for (index = 0u ; index != leakage->NPoints ; index++)
+
+                fprintf (stream, "%s(%.2f, %.4f)", index == 0u ? "" : ", ",
+                    leakage->Temperatures [index], leakage->Powers [index]) ;
+
+            fprintf (stream, " ;\n") ;
+
+            break ;
+
+        case TDICE_LEAKAGE_NONE :
+
+            break ;
+
+        default :
+
+            fprintf (stderr, "Undefined leakage model %d\n", leakage->Model) ;
+
+            break ;
+    }
+}
+
+/******************************************************************************/
+
+Error_t leakage_add_point
+(
+    Leakage_t     *leakage,
+    Temperature_t  temperature,
+    Power_t        power
+)
+{
+    if (   leakage->NPoints != 0u
+        && temperature <= leakage->Temperatures [leakage->NPoints - 1])
+
+        return TDICE_FAILURE ;
+
+    Temperature_t *temperatures = (Temperature_t *) realloc
+
+        (leakage->Temperatures, sizeof (Temperature_t) * (leakage->NPoints + 1)) ;
+
+    if (temperatures == NULL)
+
+        return TDICE_FAILURE ;
+
+    leakage->Temperatures = temperatures ;
+
+    Power_t *powers = (Power_t *) realloc
+
+        (leakage->Powers, sizeof (Power_t) * (leakage->NPoints + 1)) ;
+
+    if (powers == NULL)
+
+        return TDICE_FAILURE ;
+
+    leakage->Powers = powers ;
+
+    leakage->Temperatures [leakage->NPoints] = temperature ;
+    leakage->Powers       [leakage->NPoints] = power ;
+
+    leakage->NPoints++ ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Power_t get_leakage_power (Leakage_t *leakage, Temperature_t temperature)
+{
+    Power_t power = (Power_t) 0.0 ;
+
+    switch (leakage->Model)
+    {
+        case TDICE_LEAKAGE_EXPONENTIAL :
+
+            power = leakage->Power
+
+                    * exp (leakage->Coefficient * (temperature - leakage->Reference)) ;
+
+            break ;
+
+        case TDICE_LEAKAGE_PIECEWISE_LINEAR :
+        {
+            Quantity_t index = 1u ;
+
+            if (leakage->NPoints == 1u)
+            {
+                power = leakage->Powers [0] ;
+
+                break ;
+            }
+
+            // Segment [index - 1, index] containing the temperature
+            // (the first or the last one when extrapolating)
+
+            while (   index != leakage->NPoints - 1
+                   && temperature > leakage->Temperatures [index])
+
+                index++ ;
+
+            power = leakage->Powers [index - 1]
+
+                    +   (leakage->Powers [index] - leakage->Powers [index - 1])
+                      * (temperature - leakage->Temperatures [index - 1])
+                      / (leakage->Temperatures [index] - leakage->Temperatures [index - 1]) ;
+
+            break ;
+        }
+
+        case TDICE_LEAKAGE_NONE :
+
+            break ;
+
+        default :
+
+            fprintf (stderr, "Undefined leakage model %d\n", leakage->Model) ;
+
+            break ;
+    }
+
+    if (power < 0.0)
+
+        power = (Power_t) 0.0 ;
+
+    return power ;
+}
+
+/******************************************************************************/
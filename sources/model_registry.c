@@ -0,0 +1,686 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>  // For the file type FILE
+#include <stdlib.h> // For the memory functions calloc/free and realpath
+#include <string.h> // For the string functions
+#include <unistd.h> // For the functions write and close
+#include <sys/eventfd.h>
+
+#include "model_registry.h"
+#include "stack_file_parser.h"
+
+/******************************************************************************/
+
+// The parsers of the stack and floorplan files keep their state in static
+// variables: the models are built concurrently, but parsed one at a time
+
+static pthread_mutex_t parser_lock = PTHREAD_MUTEX_INITIALIZER ;
+
+// SuperLU keeps the memory of the factorization being computed in static
+// variables too: the models are factorized one at a time
+
+static pthread_mutex_t factorization_lock = PTHREAD_MUTEX_INITIALIZER ;
+
+// The seed of the hashes (FNV-1a) of the files of a model
+
+#define HASH_SEED 14695981039346656037ull
+
+/******************************************************************************/
+
+void model_registry_init (ModelRegistry_t *registry)
+{
+    registry->Models     = NULL ;
+    registry->LastId     = 0u ;
+    registry->Clock      = 0u ;
+    registry->Budget     = 0u ;
+    registry->MemoryPeak = 0u ;
+    registry->Directory  = NULL ;
+    registry->Shared     = false ;
+    registry->Event      = -1 ;
+    registry->Snapshots  = NULL ;
+
+    pthread_mutex_init (&registry->Lock, NULL) ;
+}
+
+/******************************************************************************/
+
+Error_t model_registry_open
+(
+    ModelRegistry_t *registry,
+    String_t         stk_file,
+    size_t           budget,
+    bool             shared,
+    SnapshotPool_t  *snapshots
+)
+{
+    registry->Budget    = budget ;
+    registry->Shared    = shared ;
+    registry->Snapshots = snapshots ;
+    registry->Directory = realpath (stk_file, NULL) ;
+
+    if (registry->Directory == NULL)
+    {
+        fprintf (stderr, "Unable to open stack file %s\n", stk_file) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (strrchr (registry->Directory, '/') == registry->Directory)
+
+        registry->Directory [1] = '\0' ;
+
+    else
+
+        *strrchr (registry->Directory, '/') = '\0' ;
+
+    registry->Event = eventfd (0, EFD_NONBLOCK) ;
+
+    if (registry->Event < 0)
+    {
+        perror ("ERROR :: eventfd") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// The memory of the models ready. The lock must be held
+
+static size_t ready_models_memory (ModelRegistry_t *registry)
+{
+    Model_t *model ;
+    size_t   memory = 0u ;
+
+    for (model = registry->Models ; model != NULL ; model = model->Next)
+
+        if (model->Phase == TDICE_MODEL_READY)
+
+            memory += model->Memory ;
+
+    return memory ;
+}
+
+/******************************************************************************/
+
+// The seconds elapsed between two instants
+
+static double seconds_between (struct timespec *begin, struct timespec *end)
+{
+    return (end->tv_sec - begin->tv_sec) + (end->tv_nsec - begin->tv_nsec) / 1e9 ;
+}
+
+/******************************************************************************/
+
+// Releases the memory of a model. Its thread, if any, must be over
+
+static void free_model (Model_t *model)
+{
+    thermal_data_destroy      (&model->TData) ;
+    output_destroy            (&model->Output) ;
+    analysis_destroy          (&model->Analysis) ;
+
+    // The stack gives back the heat sink plugin, if it uses it, that the
+    // parser of another model may be loading
+
+    pthread_mutex_lock        (&parser_lock) ;
+    stack_description_destroy (&model->Stkd) ;
+    pthread_mutex_unlock      (&parser_lock) ;
+
+    free (model->StkFile) ;
+    free (model) ;
+}
+
+/******************************************************************************/
+
+void model_registry_destroy (ModelRegistry_t *registry)
+{
+    while (registry->Models != NULL)
+    {
+        Model_t *model = registry->Models ;
+
+        registry->Models = model->Next ;
+
+        pthread_join (model->Thread, NULL) ;
+
+        free_model (model) ;
+    }
+
+    free (registry->Directory) ;
+
+    registry->Directory = NULL ;
+
+    if (registry->Event >= 0)
+
+        close (registry->Event) ;
+
+    registry->Event = -1 ;
+
+    pthread_mutex_destroy (&registry->Lock) ;
+}
+
+/******************************************************************************/
+
+void model_registry_evict (ModelRegistry_t *registry)
+{
+    Model_t *evicted = NULL ;
+    size_t   saved   = 0u ;
+
+    if (registry->Snapshots != NULL)
+
+        saved = snapshot_pool_memory (registry->Snapshots) ;
+
+    pthread_mutex_lock (&registry->Lock) ;
+
+    while (1)
+    {
+        Model_t **model, **victim = NULL ;
+        size_t    memory = saved ;
+
+        for (model = &registry->Models ; *model != NULL ; model = &(*model)->Next)
+        {
+            if ((*model)->Phase == TDICE_MODEL_READY)
+
+                memory += (*model)->Memory ;
+
+            if ((*model)->Users != 0u || (*model)->Phase < TDICE_MODEL_READY)
+
+                continue ;
+
+            if (   victim == NULL
+                || (*model)->Phase == TDICE_MODEL_FAILED
+                || (   (*victim)->Phase == TDICE_MODEL_READY
+                    && (*model)->LastUse < (*victim)->LastUse))
+
+                victim = model ;
+        }
+
+        if (   victim == NULL
+            || (   (*victim)->Phase == TDICE_MODEL_READY
+                && (registry->Budget == 0u || memory <= registry->Budget)))
+
+            break ;
+
+        Model_t *released = *victim ;
+
+        *victim = released->Next ;
+
+        released->Next = evicted ;
+        evicted        = released ;
+    }
+
+    pthread_mutex_unlock (&registry->Lock) ;
+
+    while (evicted != NULL)
+    {
+        Model_t *next = evicted->Next ;
+
+        fprintf (stdout, "Model %u: released (%s)\n", evicted->Id, evicted->StkFile) ;
+
+        fflush (stdout) ;
+
+        pthread_join (evicted->Thread, NULL) ;
+
+        free_model (evicted) ;
+
+        evicted = next ;
+    }
+}
+
+/******************************************************************************/
+
+// Moves a model to its next phase, recording the time spent in the one
+// that is over. The event is written once the model is ready or failed
+
+static void enter_model_phase (Model_t *model, ModelPhase_t phase)
+{
+    ModelRegistry_t *registry = model->Registry ;
+    struct timespec  now ;
+
+    clock_gettime (CLOCK_MONOTONIC, &now) ;
+
+    pthread_mutex_lock (&registry->Lock) ;
+
+    model->Times [model->Phase] = seconds_between (&model->PhaseStart, &now) ;
+
+    model->Phase      = phase ;
+    model->PhaseStart = now ;
+
+    if (phase == TDICE_MODEL_READY)
+    {
+        size_t memory = ready_models_memory (registry) ;
+
+        if (memory > registry->MemoryPeak)
+
+            registry->MemoryPeak = memory ;
+    }
+
+    pthread_mutex_unlock (&registry->Lock) ;
+
+    if (phase == TDICE_MODEL_READY || phase == TDICE_MODEL_FAILED)
+    {
+        uint64_t one = 1u ;
+
+        if (write (registry->Event, &one, sizeof (one)) != sizeof (one))
+
+            perror ("ERROR :: write model event") ;
+    }
+}
+
+/******************************************************************************/
+
+ModelPhase_t model_registry_status
+
+    (ModelRegistry_t *registry, Model_t *model, float *times)
+{
+    struct timespec now ;
+    ModelPhase_t    phase ;
+    Quantity_t      index ;
+
+    clock_gettime (CLOCK_MONOTONIC, &now) ;
+
+    pthread_mutex_lock (&registry->Lock) ;
+
+    phase = model->Phase ;
+
+    if (times != NULL)
+    {
+        for (index = 0u ; index != TDICE_MODEL_READY ; index++)
+
+            times [index] = model->Times [index] ;
+
+        if (phase < TDICE_MODEL_READY)
+
+            times [phase] = seconds_between (&model->PhaseStart, &now) ;
+    }
+
+    pthread_mutex_unlock (&registry->Lock) ;
+
+    return phase ;
+}
+
+/******************************************************************************/
+
+void model_registry_usage
+(
+    ModelRegistry_t *registry,
+    Quantity_t      *nmodels,
+    size_t          *memory,
+    size_t          *memory_peak
+)
+{
+    Model_t *model ;
+
+    pthread_mutex_lock (&registry->Lock) ;
+
+    if (nmodels != NULL)
+    {
+        *nmodels = 0u ;
+
+        for (model = registry->Models ; model != NULL ; model = model->Next)
+
+            (*nmodels)++ ;
+    }
+
+    if (memory != NULL)
+
+        *memory = ready_models_memory (registry) ;
+
+    if (memory_peak != NULL)
+
+        *memory_peak = registry->MemoryPeak ;
+
+    pthread_mutex_unlock (&registry->Lock) ;
+}
+
+/******************************************************************************/
+
+// Adds the content of a file to a hash (FNV-1a)
+
+static Error_t hash_file (String_t file_name, uint64_t *hash)
+{
+    unsigned char buffer [4096] ;
+    size_t        nbytes, index ;
+
+    FILE *file = fopen (file_name, "r") ;
+
+    if (file == NULL)
+    {
+        fprintf (stderr, "Unable to open file %s\n", file_name) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    while ((nbytes = fread (buffer, 1u, sizeof (buffer), file)) != 0u)
+
+        for (index = 0u ; index != nbytes ; index++)
+
+            *hash = (*hash ^ buffer [index]) * 1099511628211ull ;
+
+    fclose (file) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Computes the hash of the files a parsed stack refers to: the floorplans
+// and the layouts of its dies and the heat sink plugin, if any. A model
+// whose files changed is not reused
+
+static Error_t hash_model_inputs (StackDescription_t *stkd, uint64_t *hash)
+{
+    StackElementListNode_t *stkeln ;
+    LayerListNode_t        *lnd ;
+
+    Error_t error = TDICE_SUCCESS ;
+
+    *hash = HASH_SEED ;
+
+    for (stkeln  = stack_element_list_begin (&stkd->StackElements) ;
+         stkeln != NULL && error == TDICE_SUCCESS ;
+         stkeln  = stack_element_list_next (stkeln))
+    {
+        StackElement_t *stkel = stack_element_list_data (stkeln) ;
+
+        if (   stkel->SEType == TDICE_STACK_ELEMENT_LAYER
+            && stkel->Pointer.Layer->LayoutFileName != NULL)
+
+            error = hash_file (stkel->Pointer.Layer->LayoutFileName, hash) ;
+
+        if (stkel->SEType != TDICE_STACK_ELEMENT_DIE)
+
+            continue ;
+
+        error = hash_file (stkel->Pointer.Die->Floorplan.FileName, hash) ;
+
+        for (lnd  = layer_list_begin (&stkel->Pointer.Die->Layers) ;
+             lnd != NULL && error == TDICE_SUCCESS ;
+             lnd  = layer_list_next (lnd))
+
+            if (layer_list_data (lnd)->LayoutFileName != NULL)
+
+                error = hash_file (layer_list_data (lnd)->LayoutFileName, hash) ;
+    }
+
+    if (   error == TDICE_SUCCESS
+        && stkd->TopHeatSink != NULL
+        && stkd->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+
+        error = hash_file (stkd->TopHeatSink->Plugin, hash) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+// Tells if the files a model ready refers to are still the ones it was
+// built from. The lock must be held
+
+static bool model_inputs_unchanged (Model_t *model)
+{
+    uint64_t hash ;
+
+    if (model->Phase != TDICE_MODEL_READY)
+
+        return true ;
+
+    return    hash_model_inputs (&model->Stkd, &hash) == TDICE_SUCCESS
+           && hash == model->InputsHash ;
+}
+
+/******************************************************************************/
+
+// Tells if a stack file (its real path) can be selected: it must be in the
+// directory of the registry, or below it
+
+static bool stack_file_allowed (ModelRegistry_t *registry, String_t path)
+{
+    size_t length = strlen (registry->Directory) ;
+
+    return    strncmp (path, registry->Directory, length) == 0
+           && (   path [length] == '/'
+               || registry->Directory [length - 1u] == '/') ;
+}
+
+/******************************************************************************/
+
+// Parses the stack and builds a model while the server accepts the clients
+
+static void *build_model (void *arg)
+{
+    Model_t *model = (Model_t *) arg ;
+
+    pthread_mutex_lock (&parser_lock) ;
+
+    Error_t error = parse_stack_description_file
+
+        (model->StkFile, &model->Stkd, &model->Analysis, &model->Output) ;
+
+    pthread_mutex_unlock (&parser_lock) ;
+
+    if (error == TDICE_SUCCESS)
+
+        error = hash_model_inputs (&model->Stkd, &model->InputsHash) ;
+
+    if (error == TDICE_SUCCESS && model->Analysis.AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT)
+    {
+        fprintf (stderr, "only transient analysis!\n") ;
+
+        error = TDICE_FAILURE ;
+    }
+
+    if (error == TDICE_SUCCESS)
+    {
+        enter_model_phase (model, TDICE_MODEL_BUILDING) ;
+
+        error = thermal_data_assemble
+
+            (&model->TData, &model->Stkd.StackElements, model->Stkd.Dimensions,
+             &model->Analysis, &model->Stkd.Materials) ;
+    }
+
+    if (error == TDICE_SUCCESS)
+    {
+        enter_model_phase (model, TDICE_MODEL_FACTORIZING) ;
+
+        pthread_mutex_lock (&factorization_lock) ;
+
+        error = thermal_data_factorize
+
+            (&model->TData, &model->Stkd.StackElements, model->Stkd.Dimensions,
+             &model->Analysis) ;
+
+        pthread_mutex_unlock (&factorization_lock) ;
+    }
+
+    // Checks that the model can be shared before any session uses it
+
+    if (error == TDICE_SUCCESS && model->Registry->Shared == true)
+    {
+        ThermalData_t tdata ;
+
+        thermal_data_init (&tdata) ;
+
+        error = thermal_data_share (&tdata, &model->TData, &model->Analysis) ;
+
+        thermal_data_destroy (&tdata) ;
+    }
+
+    if (error == TDICE_SUCCESS)
+    {
+        model->Memory = thermal_data_memory (&model->TData) ;
+
+        fprintf (stdout, "Model %u: ready (%s, %zu MiB)\n",
+                 model->Id, model->StkFile, model->Memory >> 20) ;
+    }
+    else
+
+        fprintf (stderr, "Model %u: cannot be built (%s): the requests that need it will fail\n",
+                 model->Id, model->StkFile) ;
+
+    fflush (stdout) ;
+
+    // The event wakes up the server, that releases the models over the
+    // budget
+
+    enter_model_phase (model, error == TDICE_SUCCESS ? TDICE_MODEL_READY : TDICE_MODEL_FAILED) ;
+
+    return NULL ;
+}
+
+/******************************************************************************/
+
+Model_t *model_registry_acquire (ModelRegistry_t *registry, String_t stk_file)
+{
+    Model_t  *model ;
+    uint64_t  hash ;
+
+    char *path = realpath (stk_file, NULL) ;
+
+    if (path == NULL)
+    {
+        fprintf (stderr, "Unable to open stack file %s\n", stk_file) ;
+
+        return NULL ;
+    }
+
+    if (stack_file_allowed (registry, path) == false)
+    {
+        fprintf (stderr, "error: stack file %s is not in %s\n", path, registry->Directory) ;
+
+        free (path) ;
+
+        return NULL ;
+    }
+
+    hash = HASH_SEED ;
+
+    if (hash_file (path, &hash) != TDICE_SUCCESS)
+    {
+        free (path) ;
+
+        return NULL ;
+    }
+
+    pthread_mutex_lock (&registry->Lock) ;
+
+    for (model = registry->Models ; model != NULL ; model = model->Next)
+
+        if (   model->Hash == hash
+            && model->Phase != TDICE_MODEL_FAILED
+            && strcmp (model->StkFile, path) == 0
+            && model_inputs_unchanged (model) == true)
+
+            break ;
+
+    if (model != NULL)
+
+        free (path) ;
+
+    else
+    {
+        model = (Model_t *) calloc (1u, sizeof (Model_t)) ;
+
+        if (model == NULL)
+        {
+            fprintf (stderr, "Cannot malloc model\n") ;
+
+            pthread_mutex_unlock (&registry->Lock) ;
+
+            free (path) ;
+
+            return NULL ;
+        }
+
+        model->Id       = ++registry->LastId ;
+        model->StkFile  = path ;
+        model->Hash     = hash ;
+        model->Phase    = TDICE_MODEL_PARSING ;
+        model->Registry = registry ;
+
+        stack_description_init (&model->Stkd) ;
+        thermal_data_init      (&model->TData) ;
+        analysis_init          (&model->Analysis) ;
+        output_init            (&model->Output) ;
+
+        clock_gettime (CLOCK_MONOTONIC, &model->PhaseStart) ;
+
+        if (pthread_create (&model->Thread, NULL, build_model, model) != 0)
+        {
+            fprintf (stderr, "Cannot create the thread of model %u\n", model->Id) ;
+
+            pthread_mutex_unlock (&registry->Lock) ;
+
+            free_model (model) ;
+
+            return NULL ;
+        }
+
+        model->Next      = registry->Models ;
+        registry->Models = model ;
+
+        fprintf (stdout, "Model %u: building %s\n", model->Id, model->StkFile) ;
+
+        fflush (stdout) ;
+    }
+
+    model->Users++ ;
+    model->LastUse = ++registry->Clock ;
+
+    pthread_mutex_unlock (&registry->Lock) ;
+
+    return model ;
+}
+
+/******************************************************************************/
+
+void model_registry_release (ModelRegistry_t *registry, Model_t *model)
+{
+    pthread_mutex_lock   (&registry->Lock) ;
+    model->Users-- ;
+    model->LastUse = ++registry->Clock ;
+    pthread_mutex_unlock (&registry->Lock) ;
+
+    model_registry_evict (registry) ;
+}
+
+/******************************************************************************/
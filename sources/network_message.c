@@ -38,6 +38,8 @@
 
 #include <stdlib.h> // For the memory function calloc
 #include <string.h> // For the memory function memcpy
+#include <math.h>   // For the function floor
+#include <stdbool.h>
 
 #include "network_message.h"
 
@@ -136,3 +138,366 @@ Error_t extract_message_word
 
 /******************************************************************************/
 
+void insert_message_bulk
+(
+    NetworkMessage_t *message,
+    BulkType_t        type,
+    double           *values,
+    Quantity_t        nvalues
+)
+{
+    Quantity_t nwords = type == TDICE_BULK_DOUBLE ? 2u * nvalues : nvalues ;
+
+    insert_message_word (message, &type) ;
+    insert_message_word (message, &nvalues) ;
+
+    // Reserves the memory once, for all the values
+
+    if (*message->Length + nwords > message->MaxLength)
+    {
+        Quantity_t new_size = 2u * message->MaxLength ;
+
+        if (new_size < *message->Length + nwords)
+
+            new_size = *message->Length + nwords ;
+
+        increase_message_memory (message, new_size) ;
+    }
+
+    MessageWord_t *toinsert = message->Memory + *message->Length ;
+
+    if (type == TDICE_BULK_DOUBLE)
+
+        memcpy (toinsert, values, nvalues * sizeof (double)) ;
+
+    else
+    {
+        Quantity_t index ;
+
+        for (index = 0u ; index != nvalues ; index++)
+        {
+            float value = (float) values [index] ;
+
+            memcpy (toinsert + index, &value, sizeof (MessageWord_t)) ;
+        }
+    }
+
+    *message->Length += nwords ;
+}
+
+/******************************************************************************/
+
+Error_t extract_message_bulk
+(
+    NetworkMessage_t *message,
+    Quantity_t       *index,
+    double           *values,
+    Quantity_t        nvalues
+)
+{
+    BulkType_t type ;
+    Quantity_t count, nwords ;
+
+    if (   extract_message_word (message, &type,  *index)      != TDICE_SUCCESS
+        || extract_message_word (message, &count, *index + 1u) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (count > nvalues || (type != TDICE_BULK_FLOAT && type != TDICE_BULK_DOUBLE))
+
+        return TDICE_FAILURE ;
+
+    nwords = type == TDICE_BULK_DOUBLE ? 2u * count : count ;
+
+    if (*index + 2u + nwords > *message->Length - 2u)
+
+        return TDICE_FAILURE ;
+
+    MessageWord_t *toextract = message->Content + *index + 2u ;
+
+    if (type == TDICE_BULK_DOUBLE)
+
+        memcpy (values, toextract, count * sizeof (double)) ;
+
+    else
+    {
+        Quantity_t value_index ;
+
+        for (value_index = 0u ; value_index != count ; value_index++)
+        {
+            float value ;
+
+            memcpy (&value, toextract + value_index, sizeof (MessageWord_t)) ;
+
+            values [value_index] = (double) value ;
+        }
+    }
+
+    *index += 2u + nwords ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+
+void bulk_reference_init (BulkReference_t *reference)
+{
+    reference->Resolution = 0.0 ;
+    reference->NValues    = 0u ;
+    reference->Values     = NULL ;
+}
+
+/******************************************************************************/
+
+void bulk_reference_destroy (BulkReference_t *reference)
+{
+    free (reference->Values) ;
+
+    bulk_reference_init (reference) ;
+}
+
+/******************************************************************************/
+
+// Starts a new sequence of values: all the values of the reference are 0
+
+static Error_t reset_bulk_reference
+
+    (BulkReference_t *reference, double resolution, Quantity_t nvalues)
+{
+    int64_t *tmp = (int64_t *) calloc (nvalues + 1u, sizeof (int64_t)) ;
+
+    if (tmp == NULL)
+
+        return TDICE_FAILURE ;
+
+    free (reference->Values) ;
+
+    reference->Resolution = resolution ;
+    reference->NValues    = nvalues ;
+    reference->Values     = tmp ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Variable length integers: 7 bits per byte, the highest bit set if more
+// bytes follow. Signed differences are zigzag mapped first (0, -1, 1, ...)
+
+#define VARINT_MAX_BYTES 10u
+
+static size_t put_varint (unsigned char *bytes, uint64_t value)
+{
+    size_t nbytes = 0u ;
+
+    while (value >= 0x80u)
+    {
+        bytes [nbytes++] = (unsigned char) (value | 0x80u) ;
+
+        value >>= 7 ;
+    }
+
+    bytes [nbytes++] = (unsigned char) value ;
+
+    return nbytes ;
+}
+
+static bool get_varint
+
+    (unsigned char *bytes, size_t nbytes, size_t *position, uint64_t *value)
+{
+    unsigned shift = 0u ;
+
+    *value = 0u ;
+
+    while (*position < nbytes && shift < 64u)
+    {
+        unsigned char byte = bytes [(*position)++] ;
+
+        *value |= (uint64_t) (byte & 0x7Fu) << shift ;
+
+        if ((byte & 0x80u) == 0u)
+
+            return true ;
+
+        shift += 7u ;
+    }
+
+    return false ;
+}
+
+/******************************************************************************/
+
+Error_t insert_message_bulk_delta
+(
+    NetworkMessage_t *message,
+    BulkReference_t  *reference,
+    double            resolution,
+    double           *values,
+    Quantity_t        nvalues
+)
+{
+    // The resolution travels as a float: both sides use the rounded value
+
+    float         resolution_word = (float) resolution ;
+    MessageWord_t key_frame       = 0u ;
+    MessageWord_t nbytes_word ;
+    BulkType_t    type            = TDICE_BULK_DELTA ;
+
+    resolution = (double) resolution_word ;
+
+    if (reference->Resolution != resolution || reference->NValues != nvalues)
+    {
+        if (reset_bulk_reference (reference, resolution, nvalues) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        key_frame = 1u ;
+    }
+
+    insert_message_word (message, &type) ;
+    insert_message_word (message, &nvalues) ;
+    insert_message_word (message, &key_frame) ;
+    insert_message_word (message, &resolution_word) ;
+
+    // Reserves the memory once, for the worst case: a run of zeros and a
+    // difference for every value
+
+    Quantity_t max_words =
+
+        1u + (Quantity_t) ((2u * VARINT_MAX_BYTES * (nvalues + 1u)) / sizeof (MessageWord_t)) ;
+
+    if (*message->Length + max_words > message->MaxLength)
+    {
+        Quantity_t new_size = 2u * message->MaxLength ;
+
+        if (new_size < *message->Length + max_words)
+
+            new_size = *message->Length + max_words ;
+
+        increase_message_memory (message, new_size) ;
+    }
+
+    unsigned char *bytes  = (unsigned char *) (message->Memory + *message->Length + 1u) ;
+    size_t         nbytes = 0u ;
+    uint64_t       zeros  = 0u ;
+    Quantity_t     index ;
+
+    for (index = 0u ; index != nvalues ; index++)
+    {
+        int64_t value = (int64_t) floor (values [index] / resolution + 0.5) ;
+        int64_t delta = value - reference->Values [index] ;
+
+        reference->Values [index] = value ;
+
+        if (delta == 0)
+        {
+            zeros++ ;
+
+            continue ;
+        }
+
+        nbytes += put_varint (bytes + nbytes, zeros) ;
+        nbytes += put_varint (bytes + nbytes, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63)) ;
+
+        zeros = 0u ;
+    }
+
+    if (zeros != 0u)
+
+        nbytes += put_varint (bytes + nbytes, zeros) ;
+
+    // Clears the padding of the last word
+
+    memset (bytes + nbytes, 0, (sizeof (MessageWord_t) - nbytes % sizeof (MessageWord_t)) % sizeof (MessageWord_t)) ;
+
+    nbytes_word = (MessageWord_t) nbytes ;
+
+    insert_message_word (message, &nbytes_word) ;
+
+    *message->Length += (MessageWord_t) ((nbytes + sizeof (MessageWord_t) - 1u) / sizeof (MessageWord_t)) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t extract_message_bulk_delta
+(
+    NetworkMessage_t *message,
+    Quantity_t       *index,
+    BulkReference_t  *reference,
+    double           *values,
+    Quantity_t        nvalues
+)
+{
+    BulkType_t    type ;
+    Quantity_t    count, value_index = 0u ;
+    MessageWord_t key_frame, nbytes ;
+    float         resolution ;
+
+    if (   extract_message_word (message, &type,       *index)      != TDICE_SUCCESS
+        || extract_message_word (message, &count,      *index + 1u) != TDICE_SUCCESS
+        || extract_message_word (message, &key_frame,  *index + 2u) != TDICE_SUCCESS
+        || extract_message_word (message, &resolution, *index + 3u) != TDICE_SUCCESS
+        || extract_message_word (message, &nbytes,     *index + 4u) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (type != TDICE_BULK_DELTA || count > nvalues)
+
+        return TDICE_FAILURE ;
+
+    Quantity_t nwords = (nbytes + sizeof (MessageWord_t) - 1u) / sizeof (MessageWord_t) ;
+
+    if (*index + 5u + nwords > *message->Length - 2u)
+
+        return TDICE_FAILURE ;
+
+    // Without a key frame, the differences refer to the last section received
+
+    if (key_frame != 0u)
+    {
+        if (reset_bulk_reference (reference, (double) resolution, count) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+    }
+    else if (reference->NValues != count || reference->Resolution != (double) resolution)
+
+        return TDICE_FAILURE ;
+
+    unsigned char *bytes    = (unsigned char *) (message->Content + *index + 5u) ;
+    size_t         position = 0u ;
+
+    while (value_index != count)
+    {
+        uint64_t zeros, delta ;
+
+        if (get_varint (bytes, nbytes, &position, &zeros) == false || zeros > count - value_index)
+
+            return TDICE_FAILURE ;
+
+        value_index += (Quantity_t) zeros ;
+
+        if (value_index == count)
+
+            break ;
+
+        if (get_varint (bytes, nbytes, &position, &delta) == false)
+
+            return TDICE_FAILURE ;
+
+        reference->Values [value_index++] += (int64_t) (delta >> 1) ^ - (int64_t) (delta & 1u) ;
+    }
+
+    for (value_index = 0u ; value_index != count ; value_index++)
+
+        values [value_index] = (double) reference->Values [value_index] * (double) resolution ;
+
+    *index += 5u + nwords ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
@@ -0,0 +1,504 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>  // For the function fprintf
+#include <string.h> // For the memory function memcpy
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "network_shared_memory.h"
+
+/******************************************************************************/
+
+// The number of bytes of a ring (one for each direction)
+
+#define RING_BYTES       (1024u * 1024u)
+
+// The time a side spins on a ring before waiting on the futex, reading the
+// clock once every SPIN_CHECKS checks of the ring. A side does not spin on
+// a host with one processor, where the other side cannot run meanwhile
+
+#define SPIN_NANOSECONDS 100000u
+
+#define SPIN_CHECKS      64u
+
+// A waiting side checks, once per second, if the other one went away
+
+#define WAIT_SECONDS     1
+
+#define SEGMENT_MAGIC    0x3d1ce5u
+
+#define SEGMENT_PREFIX   "/3d-ice-"
+
+/******************************************************************************/
+
+// Head and Tail count the bytes written and read since the creation of the
+// ring. The side waiting for bytes (or for room) raises its flag and sleeps
+// on Signal, that the other side increments before waking it up.
+
+typedef struct
+{
+    uint64_t Head ;
+    uint64_t Padding1 [7] ;
+
+    uint64_t Tail ;
+    uint64_t Padding2 [7] ;
+
+    uint32_t Signal ;
+    uint32_t ReaderWaiting ;
+    uint32_t WriterWaiting ;
+    uint32_t Padding3 [13] ;
+
+    unsigned char Data [RING_BYTES] ;
+
+} Ring_t ;
+
+// Rings [0] carries the requests of the client, Rings [1] the replies
+
+typedef struct
+{
+    uint32_t Magic ;
+    uint32_t Closed ;
+    uint32_t Padding [14] ;
+
+    Ring_t   Rings [2] ;
+
+} Segment_t ;
+
+static uint32_t segment_counter = 0u ;
+
+/******************************************************************************/
+
+static Ring_t *write_ring (SharedMemory_t *shm)
+{
+    return &((Segment_t *) shm->Segment)->Rings [shm->Owner == true ? 0 : 1] ;
+}
+
+static Ring_t *read_ring (SharedMemory_t *shm)
+{
+    return &((Segment_t *) shm->Segment)->Rings [shm->Owner == true ? 1 : 0] ;
+}
+
+/******************************************************************************/
+
+static bool ring_ready (Ring_t *ring, bool reader)
+{
+    uint64_t used =   __atomic_load_n (&ring->Head, __ATOMIC_SEQ_CST)
+                    - __atomic_load_n (&ring->Tail, __ATOMIC_SEQ_CST) ;
+
+    return reader == true ? used != 0u : used != RING_BYTES ;
+}
+
+/******************************************************************************/
+
+static uint64_t monotonic_ns (void)
+{
+    struct timespec now ;
+
+    clock_gettime (CLOCK_MONOTONIC, &now) ;
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec ;
+}
+
+/******************************************************************************/
+
+// The other side went away if its end of the socket has been closed
+
+static bool peer_hung_up (SharedMemory_t *shm)
+{
+    struct pollfd descriptor ;
+    char          byte ;
+
+    descriptor.fd      = shm->Peer ;
+    descriptor.events  = POLLIN ;
+    descriptor.revents = 0 ;
+
+    if (poll (&descriptor, 1, 0) <= 0)
+
+        return false ;
+
+    if (descriptor.revents & (POLLHUP | POLLERR))
+
+        return true ;
+
+    return recv (shm->Peer, &byte, 1, MSG_PEEK | MSG_DONTWAIT) == 0 ;
+}
+
+/******************************************************************************/
+
+// Waits until the ring has bytes to read (reader) or room to write
+
+static Error_t wait_ring (SharedMemory_t *shm, Ring_t *ring, bool reader)
+{
+    Segment_t *segment = (Segment_t *) shm->Segment ;
+    uint32_t  *waiting = reader == true ? &ring->ReaderWaiting : &ring->WriterWaiting ;
+    Quantity_t spin ;
+
+    if (shm->Spin == true)
+    {
+        uint64_t deadline = monotonic_ns ( ) + SPIN_NANOSECONDS ;
+
+        for (spin = 1u ; ; spin++)
+        {
+            if (ring_ready (ring, reader) == true)
+
+                return TDICE_SUCCESS ;
+
+            if (spin % SPIN_CHECKS == 0u && monotonic_ns ( ) >= deadline)
+
+                break ;
+        }
+    }
+
+    while (1)
+    {
+        struct timespec timeout = { WAIT_SECONDS, 0 } ;
+
+        __atomic_store_n (waiting, 1u, __ATOMIC_SEQ_CST) ;
+
+        uint32_t signal = __atomic_load_n (&ring->Signal, __ATOMIC_SEQ_CST) ;
+
+        // Checked after raising the flag: the other side either sees the
+        // flag or has already made the ring ready
+
+        if (ring_ready (ring, reader) == false
+            && __atomic_load_n (&segment->Closed, __ATOMIC_SEQ_CST) == 0u)
+
+            syscall (SYS_futex, &ring->Signal, FUTEX_WAIT, signal, &timeout, NULL, 0) ;
+
+        __atomic_store_n (waiting, 0u, __ATOMIC_SEQ_CST) ;
+
+        if (ring_ready (ring, reader) == true)
+
+            return TDICE_SUCCESS ;
+
+        if (__atomic_load_n (&segment->Closed, __ATOMIC_SEQ_CST) != 0u)
+        {
+            fprintf (stderr, "ERROR :: shared memory closed by the other side\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (peer_hung_up (shm) == true)
+        {
+            fprintf (stderr, "ERROR :: shared memory peer hung up\n") ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+}
+
+/******************************************************************************/
+
+// Wakes up the other side, only if it is waiting on the ring
+
+static void wake_ring (Ring_t *ring, uint32_t *waiting)
+{
+    if (__atomic_load_n (waiting, __ATOMIC_SEQ_CST) == 0u)
+
+        return ;
+
+    __atomic_add_fetch (&ring->Signal, 1u, __ATOMIC_SEQ_CST) ;
+
+    syscall (SYS_futex, &ring->Signal, FUTEX_WAKE, INT_MAX, NULL, NULL, 0) ;
+}
+
+/******************************************************************************/
+
+void shared_memory_init (SharedMemory_t *shm)
+{
+    shm->Segment = NULL ;
+    shm->Length  = sizeof (Segment_t) ;
+    shm->Owner   = false ;
+    shm->Peer    = -1 ;
+    shm->Spin    = sysconf (_SC_NPROCESSORS_ONLN) > 1 ;
+
+    memset ((void *) &(shm->Name), '\0', sizeof (shm->Name)) ;
+}
+
+/******************************************************************************/
+
+Error_t shared_memory_create (SharedMemory_t *shm, NetworkSocket_t peer)
+{
+    uint32_t counter = __atomic_fetch_add (&segment_counter, 1u, __ATOMIC_RELAXED) ;
+
+    snprintf (shm->Name, sizeof (shm->Name), SEGMENT_PREFIX "%d-%u",
+              (int) getpid (), counter) ;
+
+    int fd = shm_open (shm->Name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR) ;
+
+    if (fd < 0)
+    {
+        perror ("ERROR :: shared memory segment") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    // The new segment is filled with zeros: the rings are empty
+
+    if (ftruncate (fd, (off_t) shm->Length) != 0)
+    {
+        perror ("ERROR :: shared memory segment size") ;
+
+        close (fd) ;
+        shm_unlink (shm->Name) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    shm->Segment = mmap (NULL, shm->Length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+
+    close (fd) ;
+
+    if (shm->Segment == MAP_FAILED)
+    {
+        perror ("ERROR :: shared memory mapping") ;
+
+        shm_unlink (shm->Name) ;
+
+        shm->Segment = NULL ;
+
+        return TDICE_FAILURE ;
+    }
+
+    shm->Owner = true ;
+    shm->Peer  = peer ;
+
+    __atomic_store_n (&((Segment_t *) shm->Segment)->Magic, SEGMENT_MAGIC, __ATOMIC_RELEASE) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t shared_memory_attach
+
+    (SharedMemory_t *shm, String_t name, NetworkSocket_t peer)
+{
+    struct stat status ;
+
+    // Only the segments made by shared_memory_create can be attached
+
+    if (strncmp (name, SEGMENT_PREFIX, strlen (SEGMENT_PREFIX)) != 0
+        || strlen (name) >= sizeof (shm->Name))
+    {
+        fprintf (stderr, "ERROR :: wrong shared memory segment name %s\n", name) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    strcpy (shm->Name, name) ;
+
+    int fd = shm_open (shm->Name, O_RDWR, S_IRUSR | S_IWUSR) ;
+
+    if (fd < 0)
+    {
+        perror ("ERROR :: shared memory segment") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (fstat (fd, &status) != 0 || (size_t) status.st_size != shm->Length)
+    {
+        fprintf (stderr, "ERROR :: wrong shared memory segment size\n") ;
+
+        close (fd) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    shm->Segment = mmap (NULL, shm->Length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+
+    close (fd) ;
+
+    if (shm->Segment == MAP_FAILED)
+    {
+        perror ("ERROR :: shared memory mapping") ;
+
+        shm->Segment = NULL ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (__atomic_load_n (&((Segment_t *) shm->Segment)->Magic, __ATOMIC_ACQUIRE) != SEGMENT_MAGIC)
+    {
+        fprintf (stderr, "ERROR :: wrong shared memory segment %s\n", name) ;
+
+        munmap (shm->Segment, shm->Length) ;
+
+        shm->Segment = NULL ;
+
+        return TDICE_FAILURE ;
+    }
+
+    shm->Owner = false ;
+    shm->Peer  = peer ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+void shared_memory_unlink (SharedMemory_t *shm)
+{
+    shm_unlink (shm->Name) ;
+}
+
+/******************************************************************************/
+
+Error_t shared_memory_write
+
+    (SharedMemory_t *shm, const void *memory, size_t bytes)
+{
+    Ring_t              *ring  = write_ring (shm) ;
+    const unsigned char *begin = (const unsigned char *) memory ;
+
+    while (bytes > 0)
+    {
+        if (wait_ring (shm, ring, false) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        uint64_t head   = __atomic_load_n (&ring->Head, __ATOMIC_RELAXED) ;
+        uint64_t tail   = __atomic_load_n (&ring->Tail, __ATOMIC_ACQUIRE) ;
+        size_t   offset = (size_t) (head % RING_BYTES) ;
+
+        // Copies as much as fits, up to the end of the ring
+
+        size_t chunk = RING_BYTES - (size_t) (head - tail) ;
+
+        if (chunk > RING_BYTES - offset)
+
+            chunk = RING_BYTES - offset ;
+
+        if (chunk > bytes)
+
+            chunk = bytes ;
+
+        memcpy (ring->Data + offset, begin, chunk) ;
+
+        __atomic_store_n (&ring->Head, head + chunk, __ATOMIC_SEQ_CST) ;
+
+        wake_ring (ring, &ring->ReaderWaiting) ;
+
+        begin += chunk ;
+        bytes -= chunk ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t shared_memory_read
+
+    (SharedMemory_t *shm, void *memory, size_t bytes)
+{
+    Ring_t        *ring  = read_ring (shm) ;
+    unsigned char *begin = (unsigned char *) memory ;
+
+    while (bytes > 0)
+    {
+        if (wait_ring (shm, ring, true) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        uint64_t tail   = __atomic_load_n (&ring->Tail, __ATOMIC_RELAXED) ;
+        uint64_t head   = __atomic_load_n (&ring->Head, __ATOMIC_ACQUIRE) ;
+        size_t   offset = (size_t) (tail % RING_BYTES) ;
+
+        // Copies as much as available, up to the end of the ring
+
+        size_t chunk = (size_t) (head - tail) ;
+
+        if (chunk > RING_BYTES - offset)
+
+            chunk = RING_BYTES - offset ;
+
+        if (chunk > bytes)
+
+            chunk = bytes ;
+
+        memcpy (begin, ring->Data + offset, chunk) ;
+
+        __atomic_store_n (&ring->Tail, tail + chunk, __ATOMIC_SEQ_CST) ;
+
+        wake_ring (ring, &ring->WriterWaiting) ;
+
+        begin += chunk ;
+        bytes -= chunk ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+void shared_memory_destroy (SharedMemory_t *shm)
+{
+    if (shm->Segment != NULL)
+    {
+        Segment_t *segment = (Segment_t *) shm->Segment ;
+
+        __atomic_store_n (&segment->Closed, 1u, __ATOMIC_SEQ_CST) ;
+
+        // The other side may be waiting on any of the two rings
+
+        wake_ring (&segment->Rings [0], &segment->Rings [0].ReaderWaiting) ;
+        wake_ring (&segment->Rings [0], &segment->Rings [0].WriterWaiting) ;
+        wake_ring (&segment->Rings [1], &segment->Rings [1].ReaderWaiting) ;
+        wake_ring (&segment->Rings [1], &segment->Rings [1].WriterWaiting) ;
+
+        munmap (shm->Segment, shm->Length) ;
+    }
+
+    shared_memory_init (shm) ;
+}
+
+/******************************************************************************/
@@ -37,12 +37,16 @@
  ******************************************************************************/
 
 #include <stdio.h>  // For the function perror
+#include <stdlib.h> // For the memory functions malloc/free
 #include <errno.h>  // For the function perror
 #include <string.h> // For the memory function memset
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>  // For the function fcntl
+#include <poll.h>   // For the function poll
 
 #include <arpa/inet.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 
 #include "network_socket.h"
@@ -58,6 +62,8 @@ void socket_init (Socket_t *socket)
     memset ((void *) &(socket->HostName), '\0', sizeof (socket->HostName)) ;
 
     socket->PortNumber = 0u ;
+
+    socket->SharedMemory = NULL ;
 }
 
 /******************************************************************************/
@@ -97,6 +103,15 @@ Error_t open_server_socket
     ssocket->Address.sin_port        = htons (port_number) ;
     ssocket->Address.sin_addr.s_addr = htonl (INADDR_ANY) ;
 
+    // A server started again on the same port must not wait for the
+    // connections of the previous one to leave TIME_WAIT
+
+    int reuse = 1 ;
+
+    if (setsockopt (ssocket->Id, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse)) < 0)
+
+        perror ("warning: server socket reuse") ;
+
     if (bind (ssocket->Id, (struct sockaddr *) &ssocket->Address,
               sizeof (struct sockaddr_in)) < 0)
     {
@@ -107,7 +122,7 @@ Error_t open_server_socket
         return TDICE_FAILURE ;
     }
 
-    if (listen (ssocket->Id, 1) < 0)
+    if (listen (ssocket->Id, SOMAXCONN) < 0)
     {
         perror ("ERROR :: server listen") ;
 
@@ -121,6 +136,173 @@ Error_t open_server_socket
 
 /******************************************************************************/
 
+// The prefix of the host name of a server to reach through shared memory
+
+#define SHARED_MEMORY_PREFIX "shm://"
+
+Error_t negotiate_protocol (Socket_t *csocket, Quantity_t *version)
+{
+    NetworkMessage_t message ;
+    struct pollfd    reply ;
+    int              ready ;
+
+    *version = TDICE_PROTOCOL_VERSION ;
+
+    network_message_init (&message) ;
+    build_message_head   (&message, TDICE_NEGOTIATE_PROTOCOL) ;
+    insert_message_word  (&message, version) ;
+
+    if (send_message_to_socket (csocket, &message) != TDICE_SUCCESS)
+    {
+        network_message_destroy (&message) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    // A server using shared memory implements the version 3 at least, so
+    // it replies. Otherwise the reply may never come
+
+    if (csocket->SharedMemory == NULL)
+    {
+        reply.fd     = csocket->Id ;
+        reply.events = POLLIN ;
+
+        do
+
+            ready = poll (&reply, 1, TDICE_NEGOTIATION_TIMEOUT) ;
+
+        while (ready < 0 && errno == EINTR) ;
+
+        if (ready < 0)
+        {
+            perror ("ERROR :: protocol negotiation") ;
+
+            network_message_destroy (&message) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (ready == 0)
+        {
+            *version = 1u ;
+
+            network_message_destroy (&message) ;
+
+            return TDICE_SUCCESS ;
+        }
+    }
+
+    if (receive_message_from_socket (csocket, &message) != TDICE_SUCCESS)
+    {
+        network_message_destroy (&message) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    extract_message_word (&message, version, 0) ;
+
+    network_message_destroy (&message) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Asks the server to move the connection to a new shared memory segment.
+// Fails only if the socket does not work: if the server cannot use the
+// segment the messages keep going through the socket
+
+static Error_t open_shared_memory (Socket_t *csocket)
+{
+    NetworkMessage_t message ;
+    SharedMemory_t  *shm ;
+    Quantity_t       version, name_length, index ;
+    Error_t          result ;
+
+    if (negotiate_protocol (csocket, &version) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (version < 3u)
+    {
+        fprintf (stderr, "warning: the server does not support shared memory, using the socket\n") ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    shm = (SharedMemory_t *) malloc (sizeof (SharedMemory_t)) ;
+
+    if (shm == NULL)
+    {
+        fprintf (stderr, "Cannot malloc shared memory\n") ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    shared_memory_init (shm) ;
+
+    if (shared_memory_create (shm, csocket->Id) != TDICE_SUCCESS)
+    {
+        fprintf (stderr, "warning: cannot create shared memory, using the socket\n") ;
+
+        free (shm) ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    name_length = strlen (shm->Name) ;
+
+    network_message_init (&message) ;
+    build_message_head   (&message, TDICE_OPEN_SHARED_MEMORY) ;
+    insert_message_word  (&message, &name_length) ;
+
+    for (index = 0u ; index < name_length ; index += sizeof (MessageWord_t))
+
+        insert_message_word (&message, shm->Name + index) ;
+
+    result = send_message_to_socket (csocket, &message) ;
+
+    if (result == TDICE_SUCCESS)
+
+        result = receive_message_from_socket (csocket, &message) ;
+
+    if (result != TDICE_SUCCESS)
+    {
+        network_message_destroy (&message) ;
+        shared_memory_unlink    (shm) ;
+        shared_memory_destroy   (shm) ;
+
+        free (shm) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    extract_message_word (&message, &result, 0) ;
+
+    network_message_destroy (&message) ;
+
+    // The server has attached the segment (or it will never do it)
+
+    shared_memory_unlink (shm) ;
+
+    if (result != TDICE_SUCCESS)
+    {
+        fprintf (stderr, "warning: the server cannot use shared memory, using the socket\n") ;
+
+        shared_memory_destroy (shm) ;
+
+        free (shm) ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    csocket->SharedMemory = shm ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
 Error_t connect_client_to_server
 (
     Socket_t     *csocket,
@@ -128,6 +310,14 @@ Error_t connect_client_to_server
     PortNumber_t  port_number
 )
 {
+    bool shared_memory =
+
+        strncmp (host_name, SHARED_MEMORY_PREFIX, strlen (SHARED_MEMORY_PREFIX)) == 0 ;
+
+    if (shared_memory == true)
+
+        host_name += strlen (SHARED_MEMORY_PREFIX) ;
+
     strcpy (csocket->HostName, host_name) ;
 
     csocket->PortNumber = port_number ;
@@ -154,6 +344,15 @@ Error_t connect_client_to_server
         return TDICE_FAILURE ;
     }
 
+    if (shared_memory == true && open_shared_memory (csocket) != TDICE_SUCCESS)
+    {
+        fprintf (stderr, "ERROR :: shared memory negotiation\n") ;
+
+        socket_close (csocket) ;
+
+        return TDICE_FAILURE ;
+    }
+
     return TDICE_SUCCESS ;
 }
 
@@ -205,6 +404,10 @@ Error_t send_message_to_socket
 
     size_t        length = (size_t) *message->Length * sizeof (MessageWord_t) ;
 
+    if (socket->SharedMemory != NULL)
+
+        return shared_memory_write (socket->SharedMemory, message->Memory, length) ;
+
     // Begin points to th beginning of the message ...
 
     unsigned char *begin = (unsigned char *) message->Memory ;
@@ -246,6 +449,38 @@ Error_t send_message_to_socket
 
 /******************************************************************************/
 
+static Error_t receive_message_from_shared_memory
+(
+    SharedMemory_t   *shm,
+    NetworkMessage_t *message
+)
+{
+    MessageWord_t message_length ;
+
+    if (shared_memory_read (shm, &message_length, sizeof (message_length)) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    if (message_length == 0u)
+    {
+        fprintf (stderr, "ERROR :: read message length failure\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (message_length > message->MaxLength)
+
+        increase_message_memory (message, message_length) ;
+
+    *message->Length = (MessageWord_t) message_length ;
+
+    return shared_memory_read
+
+        (shm, message->MType, (size_t) (message_length - 1u) * sizeof (MessageWord_t)) ;
+}
+
+/******************************************************************************/
+
 Error_t receive_message_from_socket
 (
     Socket_t         *socket,
@@ -254,6 +489,10 @@ Error_t receive_message_from_socket
 {
     MessageWord_t message_length ;
 
+    if (socket->SharedMemory != NULL)
+
+        return receive_message_from_shared_memory (socket->SharedMemory, message) ;
+
     // reads the first word : the number of words to receive
 
     unsigned char *length_begin = (unsigned char *) &message_length ;
@@ -349,8 +588,444 @@ Error_t receive_message_from_socket
 
 /******************************************************************************/
 
+// The number of bytes a buffer reserves at every read
+
+#define SOCKET_BUFFER_CHUNK 65536u
+
+void socket_buffer_init (SocketBuffer_t *buffer)
+{
+    buffer->Memory = NULL ;
+    buffer->Size   = 0u ;
+    buffer->Begin  = 0u ;
+    buffer->End    = 0u ;
+}
+
+/******************************************************************************/
+
+void socket_buffer_destroy (SocketBuffer_t *buffer)
+{
+    free (buffer->Memory) ;
+
+    socket_buffer_init (buffer) ;
+}
+
+/******************************************************************************/
+
+bool socket_buffer_is_empty (SocketBuffer_t *buffer)
+{
+    return buffer->Begin == buffer->End ;
+}
+
+/******************************************************************************/
+
+// Makes room for nbytes after End, moving the bytes not consumed yet at
+// the beginning of the memory before growing it
+
+static Error_t reserve_socket_buffer (SocketBuffer_t *buffer, size_t nbytes)
+{
+    if (buffer->End + nbytes <= buffer->Size)
+
+        return TDICE_SUCCESS ;
+
+    if (buffer->Begin != 0u)
+    {
+        memmove (buffer->Memory, buffer->Memory + buffer->Begin,
+                 buffer->End - buffer->Begin) ;
+
+        buffer->End  -= buffer->Begin ;
+        buffer->Begin = 0u ;
+
+        if (buffer->End + nbytes <= buffer->Size)
+
+            return TDICE_SUCCESS ;
+    }
+
+    size_t new_size = 2u * buffer->Size ;
+
+    if (new_size < buffer->End + nbytes)
+
+        new_size = buffer->End + nbytes ;
+
+    unsigned char *tmp = (unsigned char *) realloc (buffer->Memory, new_size) ;
+
+    if (tmp == NULL)
+    {
+        fprintf (stderr, "Cannot malloc socket buffer\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    buffer->Memory = tmp ;
+    buffer->Size   = new_size ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static Error_t set_socket_blocking (Socket_t *socket, bool blocking)
+{
+    int flags = fcntl (socket->Id, F_GETFL, 0) ;
+
+    if (flags >= 0)
+
+        flags = blocking == true ? flags & ~O_NONBLOCK : flags | O_NONBLOCK ;
+
+    if (flags < 0 || fcntl (socket->Id, F_SETFL, flags) < 0)
+    {
+        perror ("ERROR :: set socket blocking mode") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t socket_set_non_blocking (Socket_t *socket)
+{
+    return set_socket_blocking (socket, false) ;
+}
+
+/******************************************************************************/
+
+Error_t socket_set_blocking (Socket_t *socket)
+{
+    return set_socket_blocking (socket, true) ;
+}
+
+/******************************************************************************/
+
+Error_t read_socket_buffer
+(
+    Socket_t       *socket,
+    SocketBuffer_t *buffer,
+    bool           *hangup
+)
+{
+    *hangup = false ;
+
+    while (1)
+    {
+        if (reserve_socket_buffer (buffer, SOCKET_BUFFER_CHUNK) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        ssize_t bread = read
+
+            (socket->Id, buffer->Memory + buffer->End, buffer->Size - buffer->End) ;
+
+        if (bread > 0)
+        {
+            buffer->End += (size_t) bread ;
+
+            continue ;
+        }
+
+        if (bread == 0)
+        {
+            *hangup = true ;
+
+            return TDICE_SUCCESS ;
+        }
+
+        if (errno == EINTR)
+
+            continue ;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+
+            return TDICE_SUCCESS ;
+
+        perror ("ERROR :: read failure") ;
+
+        return TDICE_FAILURE ;
+    }
+}
+
+/******************************************************************************/
+
+Error_t write_socket_buffer
+(
+    Socket_t       *socket,
+    SocketBuffer_t *buffer
+)
+{
+    if (socket->SharedMemory != NULL)
+    {
+        Error_t error = shared_memory_write
+
+            (socket->SharedMemory, buffer->Memory + buffer->Begin,
+             buffer->End - buffer->Begin) ;
+
+        buffer->Begin = buffer->End = 0u ;
+
+        return error ;
+    }
+
+    while (buffer->Begin != buffer->End)
+    {
+        // MSG_NOSIGNAL: a client that went away must not kill the server
+
+        ssize_t bwritten = send
+
+            (socket->Id, buffer->Memory + buffer->Begin,
+             buffer->End - buffer->Begin, MSG_NOSIGNAL) ;
+
+        if (bwritten < 0)
+        {
+            if (errno == EINTR)
+
+                continue ;
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+
+                return TDICE_SUCCESS ;
+
+            perror ("ERROR :: write message failure") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        buffer->Begin += (size_t) bwritten ;
+    }
+
+    buffer->Begin = buffer->End = 0u ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t extract_message_from_buffer
+(
+    SocketBuffer_t   *buffer,
+    NetworkMessage_t *message,
+    bool             *complete
+)
+{
+    MessageWord_t message_length ;
+
+    size_t available = buffer->End - buffer->Begin ;
+
+    *complete = false ;
+
+    if (available < sizeof (MessageWord_t))
+
+        return TDICE_SUCCESS ;
+
+    memcpy (&message_length, buffer->Memory + buffer->Begin, sizeof (MessageWord_t)) ;
+
+    if (message_length == 0u)
+    {
+        fprintf (stderr, "ERROR :: read message length failure\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    size_t length = (size_t) message_length * sizeof (MessageWord_t) ;
+
+    if (available < length)
+
+        return TDICE_SUCCESS ;
+
+    if (message_length > message->MaxLength)
+
+        increase_message_memory (message, message_length) ;
+
+    memcpy (message->Memory, buffer->Memory + buffer->Begin, length) ;
+
+    buffer->Begin += length ;
+
+    *complete = true ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+bool peek_message_type_in_buffer
+(
+    SocketBuffer_t *buffer,
+    MessageType_t  *type
+)
+{
+    MessageWord_t words [2] ;
+
+    if (buffer->End - buffer->Begin < sizeof (words))
+
+        return false ;
+
+    memcpy (words, buffer->Memory + buffer->Begin, sizeof (words)) ;
+
+    if (buffer->End - buffer->Begin < (size_t) words [0] * sizeof (MessageWord_t))
+
+        return false ;
+
+    *type = (MessageType_t) words [1] ;
+
+    return true ;
+}
+
+/******************************************************************************/
+
+Error_t append_message_to_buffer
+(
+    SocketBuffer_t   *buffer,
+    NetworkMessage_t *message
+)
+{
+    return append_bytes_to_buffer
+
+        (buffer, message->Memory, (size_t) *message->Length * sizeof (MessageWord_t)) ;
+}
+
+/******************************************************************************/
+
+Error_t append_bytes_to_buffer
+(
+    SocketBuffer_t *buffer,
+    const void     *bytes,
+    size_t          nbytes
+)
+{
+    if (reserve_socket_buffer (buffer, nbytes) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    memcpy (buffer->Memory + buffer->End, bytes, nbytes) ;
+
+    buffer->End += nbytes ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// The largest number of bytes of a file sent at once
+
+#define SOCKET_FILE_CHUNK (1024u * 1024u)
+
+// Without a socket, the chunks of the file go through user space
+
+static Error_t send_file_to_shared_memory
+(
+    SharedMemory_t *shm,
+    int             file,
+    off_t          *offset,
+    size_t         *remaining
+)
+{
+    unsigned char *chunk = (unsigned char *) malloc (SOCKET_FILE_CHUNK) ;
+
+    if (chunk == NULL)
+    {
+        fprintf (stderr, "Cannot malloc file chunk\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    while (*remaining > 0)
+    {
+        size_t length = *remaining < SOCKET_FILE_CHUNK ? *remaining : SOCKET_FILE_CHUNK ;
+
+        ssize_t bread = pread (file, chunk, length, *offset) ;
+
+        if (bread < 0 && errno == EINTR)
+
+            continue ;
+
+        if (bread <= 0)
+        {
+            fprintf (stderr, "ERROR :: read file failure\n") ;
+
+            free (chunk) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (shared_memory_write (shm, chunk, (size_t) bread) != TDICE_SUCCESS)
+        {
+            free (chunk) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        *offset    += bread ;
+        *remaining -= (size_t) bread ;
+    }
+
+    free (chunk) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t send_file_to_socket
+(
+    Socket_t *socket,
+    int       file,
+    off_t    *offset,
+    size_t   *remaining
+)
+{
+    if (socket->SharedMemory != NULL)
+
+        return send_file_to_shared_memory (socket->SharedMemory, file, offset, remaining) ;
+
+    while (*remaining > 0)
+    {
+        size_t length = *remaining < SOCKET_FILE_CHUNK ? *remaining : SOCKET_FILE_CHUNK ;
+
+        // sendfile moves the offset forward (# of bytes sent)
+
+        ssize_t bsent = sendfile (socket->Id, file, offset, length) ;
+
+        if (bsent > 0)
+        {
+            *remaining -= (size_t) bsent ;
+
+            continue ;
+        }
+
+        if (bsent == 0)
+        {
+            fprintf (stderr, "ERROR :: file shorter than expected\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (errno == EINTR)
+
+            continue ;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+
+            return TDICE_SUCCESS ;
+
+        perror ("ERROR :: send file failure") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
 Error_t socket_close (Socket_t *socket)
 {
+    if (socket->SharedMemory != NULL)
+    {
+        shared_memory_destroy (socket->SharedMemory) ;
+
+        free (socket->SharedMemory) ;
+
+        socket->SharedMemory = NULL ;
+    }
+
     if (close (socket->Id) != 0)
     {
         perror ("ERROR :: Closing network socket") ;
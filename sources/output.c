@@ -346,3 +346,62 @@ Error_t fill_output_message
 }
 
 /******************************************************************************/
+
+Quantity_t get_inspection_point_temperatures
+(
+    Output_t        *output,
+    Dimensions_t    *dimensions,
+    Temperature_t   *temperatures,
+    OutputInstant_t  output_instant,
+    Temperature_t   *values
+)
+{
+    Quantity_t number = 0u ;
+
+    InspectionPointList_t *list ;
+
+    if (output_instant == TDICE_OUTPUT_INSTANT_FINAL)
+
+        list = &output->InspectionPointListFinal ;
+
+    else if (output_instant == TDICE_OUTPUT_INSTANT_STEP)
+
+        list = &output->InspectionPointListStep ;
+
+    else if (output_instant == TDICE_OUTPUT_INSTANT_SLOT)
+
+        list = &output->InspectionPointListSlot ;
+
+    else
+    {
+        fprintf (stderr, "Error: Wrong ipoint instant %d\n", output_instant) ;
+
+        return number ;
+    }
+
+    InspectionPointListNode_t *ipn ;
+
+    for (ipn  = inspection_point_list_begin (list) ;
+         ipn != NULL ;
+         ipn  = inspection_point_list_next (ipn))
+    {
+        InspectionPoint_t *ipoint = inspection_point_list_data (ipn) ;
+
+        if (ipoint->OType != TDICE_OUTPUT_TYPE_TCELL
+            && ipoint->OType != TDICE_OUTPUT_TYPE_TFLPEL)
+
+            continue ;
+
+        if (values != NULL)
+
+            values [number] = get_inspection_point_temperature
+
+                (ipoint, dimensions, temperatures) ;
+
+        number++ ;
+    }
+
+    return number ;
+}
+
+/******************************************************************************/
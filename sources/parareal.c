@@ -0,0 +1,455 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/free
+#include <string.h> // For the memory function memcpy
+#include <math.h>   // For the math function fabs
+#include <omp.h>
+
+#include "parareal.h"
+
+/******************************************************************************/
+
+void parareal_init (Parareal_t *parareal)
+{
+    system_matrix_init (&parareal->SM_Coarse) ;
+
+    parareal->NWindows       = (Quantity_t) 0u ;
+    parareal->NSlots         = (Quantity_t) 0u ;
+    parareal->Cursor         = (Quantity_t) 0u ;
+    parareal->Size           = (CellIndex_t) 0u ;
+    parareal->States         = NULL ;
+    parareal->Fine           = NULL ;
+    parareal->Coarse         = NULL ;
+    parareal->Sources        = NULL ;
+    parareal->Vector         = NULL ;
+    parareal->SLUMatrix_Fine = NULL ;
+    parareal->NIterations    = (Quantity_t) 0u ;
+
+    parareal->SLUMatrix_Vector.Store = NULL ;
+}
+
+/******************************************************************************/
+
+Error_t parareal_build
+(
+    Parareal_t    *parareal,
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    Quantity_t  window ;
+    Analysis_t  coarse ;
+    CellIndex_t size   = tdata->Size ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT
+        || analysis->PararealWindows == 0u)
+    {
+        fprintf (stderr, "Parareal requires a transient analysis\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    // The propagators assume a source vector that depends only on the slot
+
+    if (tdata->PowerGrid.NLeakages != 0u)
+    {
+        fprintf (stderr, "Parareal cannot be used with leakage power\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    parareal->NWindows = analysis->PararealWindows ;
+    parareal->Size     = size ;
+
+    parareal->States  = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * size * (parareal->NWindows + 1)) ;
+
+    parareal->Fine    = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * size * parareal->NWindows) ;
+
+    parareal->Coarse  = (Temperature_t *) malloc
+
+        (sizeof (Temperature_t) * size * parareal->NWindows) ;
+
+    parareal->Sources = (Source_t *) malloc
+
+        (sizeof (Source_t) * size * parareal->NWindows) ;
+
+    parareal->Vector  = (double *) malloc (sizeof (double) * size) ;
+
+    parareal->SLUMatrix_Fine = (SuperMatrix *) malloc
+
+        (sizeof (SuperMatrix) * parareal->NWindows) ;
+
+    if (   parareal->States  == NULL || parareal->Fine   == NULL
+        || parareal->Coarse  == NULL || parareal->Sources == NULL
+        || parareal->Vector  == NULL || parareal->SLUMatrix_Fine == NULL)
+    {
+        fprintf (stderr, "Cannot malloc parareal windows\n") ;
+
+        free (parareal->States) ;
+        free (parareal->Fine) ;
+        free (parareal->Coarse) ;
+        free (parareal->Sources) ;
+        free (parareal->Vector) ;
+        free (parareal->SLUMatrix_Fine) ;
+
+        parareal_init (parareal) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    for (window = 0u ; window != parareal->NWindows ; window++)
+
+        dCreate_Dense_Matrix  /* Vector B of the fine propagator */
+
+            (&parareal->SLUMatrix_Fine [window], size, 1,
+             parareal->Fine + window * size, size,
+             SLU_DN, SLU_D, SLU_GE) ;
+
+    dCreate_Dense_Matrix  /* Vector B of the coarse propagator */
+
+        (&parareal->SLUMatrix_Vector, size, 1,
+         parareal->Vector, size,
+         SLU_DN, SLU_D, SLU_GE) ;
+
+    /* The coarse propagator covers a whole slot with a single step */
+
+    analysis_init (&coarse) ;
+    analysis_copy (&coarse, analysis) ;
+
+    coarse.StepTime   = analysis->SlotTime ;
+    coarse.SlotLength = 1u ;
+
+    if (system_matrix_build
+
+            (&parareal->SM_Coarse, size,
+             get_number_of_connections (dimensions), analysis->NumOfCores)
+
+        == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc coarse system matrix\n") ;
+
+        system_matrix_init (&parareal->SM_Coarse) ;
+
+        parareal_destroy (parareal) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    fill_system_matrix
+
+        (&parareal->SM_Coarse, &tdata->ThermalGrid, &coarse, dimensions) ;
+
+    if (do_factorization (&parareal->SM_Coarse) == TDICE_FAILURE)
+    {
+        parareal_destroy (parareal) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+void parareal_destroy (Parareal_t *parareal)
+{
+    Quantity_t window ;
+
+    if (parareal->SLUMatrix_Fine != NULL)
+
+        for (window = 0u ; window != parareal->NWindows ; window++)
+
+            Destroy_SuperMatrix_Store (&parareal->SLUMatrix_Fine [window]) ;
+
+    if (parareal->SLUMatrix_Vector.Store != NULL)
+
+        Destroy_SuperMatrix_Store (&parareal->SLUMatrix_Vector) ;
+
+    if (parareal->SM_Coarse.Size != 0)
+
+        system_matrix_destroy (&parareal->SM_Coarse) ;
+
+    free (parareal->States) ;
+    free (parareal->Fine) ;
+    free (parareal->Coarse) ;
+    free (parareal->Sources) ;
+    free (parareal->Vector) ;
+    free (parareal->SLUMatrix_Fine) ;
+
+    parareal_init (parareal) ;
+}
+
+/******************************************************************************/
+
+// Integrates the window from its initial state to the end of the slot,
+// one StepTime after the other, as emulate_step does. The result is
+// stored in the Fine vector of the window.
+
+static Error_t fine_propagator
+(
+    Parareal_t    *parareal,
+    ThermalData_t *tdata,
+    Analysis_t    *analysis,
+    Quantity_t     window
+)
+{
+    CellIndex_t    cell ;
+    Quantity_t     step ;
+    CellIndex_t    size         = parareal->Size ;
+    Temperature_t *temperatures = parareal->Fine    + window * size ;
+    Source_t      *sources      = parareal->Sources + window * size ;
+    Capacity_t    *capacities   = tdata->PowerGrid.CellsCapacities ;
+
+    memcpy (temperatures, parareal->States + window * size,
+            sizeof (Temperature_t) * size) ;
+
+    for (step = 0u ; step != analysis->SlotLength ; step++)
+    {
+        for (cell = 0u ; cell != size ; cell++)
+
+            temperatures [cell] =   sources [cell]
+                                  + (capacities [cell] / analysis->StepTime)
+                                  * temperatures [cell] ;
+
+        if (solve_sparse_linear_system_concurrent
+
+                (&tdata->SM_A, &parareal->SLUMatrix_Fine [window])
+
+            != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Integrates the window from its initial state to the end of the slot
+// with a single step. The result is stored in the working Vector.
+
+static Error_t coarse_propagator
+(
+    Parareal_t    *parareal,
+    ThermalData_t *tdata,
+    Analysis_t    *analysis,
+    Quantity_t     window
+)
+{
+    CellIndex_t    cell ;
+    CellIndex_t    size         = parareal->Size ;
+    Temperature_t *temperatures = parareal->States  + window * size ;
+    Source_t      *sources      = parareal->Sources + window * size ;
+    Capacity_t    *capacities   = tdata->PowerGrid.CellsCapacities ;
+
+    for (cell = 0u ; cell != size ; cell++)
+
+        parareal->Vector [cell] =   sources [cell]
+                                  + (capacities [cell] / analysis->SlotTime)
+                                  * temperatures [cell] ;
+
+    return solve_sparse_linear_system
+
+        (&parareal->SM_Coarse, &parareal->SLUMatrix_Vector) ;
+}
+
+/******************************************************************************/
+
+// Runs the parareal iterations over the next NWindows slots, starting
+// from the temperatures currently stored in tdata
+
+static SimResult_t simulate_windows
+(
+    Parareal_t    *parareal,
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    Quantity_t  window, iteration ;
+    CellIndex_t cell ;
+    CellIndex_t size = parareal->Size ;
+
+    /* Consumes the power values of the next slots */
+
+    for (window = 0u ; window != parareal->NWindows ; window++)
+    {
+        if (update_source_vector (&tdata->PowerGrid, dimensions) == TDICE_FAILURE)
+
+            break ;
+
+        memcpy (parareal->Sources + window * size, tdata->PowerGrid.Sources,
+                sizeof (Source_t) * size) ;
+    }
+
+    parareal->NSlots      = window ;
+    parareal->NIterations = 0u ;
+    parareal->Cursor      = 0u ;
+
+    if (parareal->NSlots == 0u)
+
+        return TDICE_END_OF_SIMULATION ;
+
+    /* First guess: the coarse propagator alone */
+
+    memcpy (parareal->States, tdata->Temperatures, sizeof (Temperature_t) * size) ;
+
+    for (window = 0u ; window != parareal->NSlots ; window++)
+    {
+        if (coarse_propagator (parareal, tdata, analysis, window) != TDICE_SUCCESS)
+
+            return TDICE_SOLVER_ERROR ;
+
+        memcpy (parareal->Coarse + window * size, parareal->Vector,
+                sizeof (Temperature_t) * size) ;
+
+        memcpy (parareal->States + (window + 1) * size, parareal->Vector,
+                sizeof (Temperature_t) * size) ;
+    }
+
+    /* After iteration k the first k + 1 windows match the sequential
+       integration, so both sweeps can start from window k */
+
+    for (iteration = 0u ; iteration != analysis->PararealIterations ; iteration++)
+    {
+        Quantity_t    failures = 0u ;
+        Temperature_t max_diff = 0.0 ;
+
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+        for (window = iteration ; window < parareal->NSlots ; window++)
+
+            if (fine_propagator (parareal, tdata, analysis, window) != TDICE_SUCCESS)
+
+                failures++ ;
+
+        if (failures != 0u)
+
+            return TDICE_SOLVER_ERROR ;
+
+        for (window = iteration ; window != parareal->NSlots ; window++)
+        {
+            Temperature_t *fine   = parareal->Fine   + window * size ;
+            Temperature_t *coarse = parareal->Coarse + window * size ;
+            Temperature_t *next   = parareal->States + (window + 1) * size ;
+
+            if (coarse_propagator (parareal, tdata, analysis, window) != TDICE_SUCCESS)
+
+                return TDICE_SOLVER_ERROR ;
+
+            for (cell = 0u ; cell != size ; cell++)
+            {
+                Temperature_t new_value =
+
+                    parareal->Vector [cell] + fine [cell] - coarse [cell] ;
+
+                if (fabs (new_value - next [cell]) > max_diff)
+
+                    max_diff = fabs (new_value - next [cell]) ;
+
+                next   [cell] = new_value ;
+                coarse [cell] = parareal->Vector [cell] ;
+            }
+        }
+
+        parareal->NIterations = iteration + 1 ;
+
+        if (max_diff < analysis->PararealTolerance
+            || parareal->NIterations >= parareal->NSlots)
+
+            break ;
+    }
+
+    if (iteration == analysis->PararealIterations)
+
+        fprintf (stderr,
+            "Warning: parareal did not converge in %d iterations\n",
+            analysis->PararealIterations) ;
+
+    return TDICE_SLOT_DONE ;
+}
+
+/******************************************************************************/
+
+SimResult_t emulate_parareal
+(
+    Parareal_t    *parareal,
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    CellIndex_t size = parareal->Size ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT
+        || slot_completed (analysis) == false)
+
+        return TDICE_WRONG_CONFIG ;
+
+    if (parareal->Cursor == parareal->NSlots)
+    {
+        SimResult_t result = simulate_windows (parareal, tdata, dimensions, analysis) ;
+
+        if (result != TDICE_SLOT_DONE)
+
+            return result ;
+    }
+
+    /* Leaves tdata and analysis as if the slot was simulated step by step */
+
+    memcpy (tdata->Temperatures,
+            parareal->States + (parareal->Cursor + 1) * size,
+            sizeof (Temperature_t) * size) ;
+
+    memcpy (tdata->PowerGrid.Sources,
+            parareal->Sources + parareal->Cursor * size,
+            sizeof (Source_t) * size) ;
+
+    analysis->CurrentTime += analysis->SlotLength ;
+
+    parareal->Cursor++ ;
+
+    return TDICE_SLOT_DONE ;
+}
+
+/******************************************************************************/
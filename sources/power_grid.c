@@ -57,6 +57,7 @@ void power_grid_init (PowerGrid_t *pgrid)
     pgrid->HeatSinkTopTcs    = NULL ;
     pgrid->HeatSinkBottomTcs = NULL ;
     pgrid->CellsCapacities   = NULL ;
+    pgrid->NLeakages         = (Quantity_t) 0u ;
 }
 
 /******************************************************************************/
@@ -260,6 +261,8 @@ void power_grid_fill
 
                 pgrid->FloorplansProfile [index + tmp] = &stack_element->Pointer.Die->Floorplan ;
 
+                pgrid->NLeakages += stack_element->Pointer.Die->Floorplan.NLeakages ;
+
                 break ;
             }
             case TDICE_STACK_ELEMENT_LAYER :
@@ -1045,6 +1048,188 @@ void update_channel_sources (PowerGrid_t *pgrid, Dimensions_t *dimensions)
 
 /******************************************************************************/
 
+Error_t fill_initial_source_vector
+(
+    PowerGrid_t    *pgrid,
+    Dimensions_t   *dimensions,
+    bool            average
+)
+{
+    Quantity_t layer ;
+
+    // The values repeated at the front of the queues are the ones
+    // consumed by update_source_vector
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                if (repeat_power_values_floorplan
+
+                        (pgrid->FloorplansProfile [layer], average) == TDICE_FAILURE)
+
+                    return TDICE_FAILURE ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+
+    return update_source_vector (pgrid, dimensions) ;
+}
+
+/******************************************************************************/
+
+void get_next_power_values (PowerGrid_t *pgrid, Power_t *pvalues)
+{
+    Quantity_t layer ;
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                pvalues += get_next_power_values_floorplan
+
+                    (pgrid->FloorplansProfile [layer], pvalues) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+}
+
+/******************************************************************************/
+
+void replace_next_power_values (PowerGrid_t *pgrid, Power_t *pvalues)
+{
+    Quantity_t layer ;
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                pvalues += replace_next_power_values_floorplan
+
+                    (pgrid->FloorplansProfile [layer], pvalues) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+}
+
+/******************************************************************************/
+
+Quantity_t get_number_of_power_queues (PowerGrid_t *pgrid)
+{
+    Quantity_t layer, nqueues = 0u ;
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                nqueues += get_number_of_floorplan_elements_floorplan
+
+                    (pgrid->FloorplansProfile [layer]) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+
+    return nqueues ;
+}
+
+/******************************************************************************/
+
+void save_power_values (PowerGrid_t *pgrid, PowersQueue_t *pqueues)
+{
+    Quantity_t layer ;
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                pqueues += save_power_values_floorplan
+
+                    (pgrid->FloorplansProfile [layer], pqueues) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+}
+
+/******************************************************************************/
+
+void restore_power_values (PowerGrid_t *pgrid, PowersQueue_t *pqueues)
+{
+    Quantity_t layer ;
+
+    for (layer = 0u ; layer != pgrid->NLayers ; layer++)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                pqueues += restore_power_values_floorplan
+
+                    (pgrid->FloorplansProfile [layer], pqueues) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+}
+
+/******************************************************************************/
+
 Error_t insert_power_values (PowerGrid_t *pgrid, PowersQueue_t *pvalues)
 {
     Quantity_t layer ;
@@ -1101,3 +1286,71 @@ Error_t insert_power_values (PowerGrid_t *pgrid, PowersQueue_t *pvalues)
 
     return TDICE_SUCCESS ;
 }
+
+/******************************************************************************/
+
+Temperature_t update_leakage_powers
+(
+    PowerGrid_t   *pgrid,
+    Dimensions_t  *dimensions,
+    Temperature_t *temperatures
+)
+{
+    Quantity_t    layer ;
+    Temperature_t change, max_change = 0.0 ;
+
+    for (layer  = 0u ;
+         layer != pgrid->NLayers ;
+         layer++,     temperatures += pgrid->NCellsLayer)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                change = update_leakage_floorplan
+
+                    (pgrid->FloorplansProfile [layer], dimensions, temperatures) ;
+
+                max_change = MAX (max_change, change) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+
+    return max_change ;
+}
+
+/******************************************************************************/
+
+void add_leakage_sources (PowerGrid_t *pgrid, Source_t *sources)
+{
+    Quantity_t layer ;
+
+    for (layer  = 0u ;
+         layer != pgrid->NLayers ;
+         layer++,     sources += pgrid->NCellsLayer)
+    {
+        switch (pgrid->LayersTypeProfile [layer])
+        {
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+
+                fill_leakage_sources_floorplan (pgrid->FloorplansProfile [layer], sources) ;
+
+                break ;
+
+            default :
+
+                break ;
+        }
+    }
+}
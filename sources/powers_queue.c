@@ -201,6 +201,30 @@ bool is_full_powers_queue (PowersQueue_t *pqueue)
 
 /******************************************************************************/
 
+static void grow_powers_queue (PowersQueue_t *pqueue)
+{
+    PowersQueue_t pq ;
+
+    powers_queue_init (&pq) ;
+
+    powers_queue_build (&pq, pqueue->Capacity * (Quantity_t) 2) ;
+
+    powers_queue_copy (&pq, pqueue) ;
+
+    Power_t *tmp = pq.Memory ;
+       pq.Memory = pqueue->Memory ;
+    pqueue->Memory = tmp ;
+
+    pqueue->Capacity = pq.Capacity ;
+    pqueue->Size     = pq.Size ;
+    pqueue->Start    = pq.Start ;
+    pqueue->End      = pq.End ;
+
+    powers_queue_destroy (&pq) ;
+}
+
+/******************************************************************************/
+
 void put_into_powers_queue (PowersQueue_t *pqueue, Power_t power)
 {
     if (pqueue->Memory == NULL)
@@ -211,26 +235,8 @@ void put_into_powers_queue (PowersQueue_t *pqueue, Power_t power)
     }
 
     if (is_full_powers_queue (pqueue))
-    {
-        PowersQueue_t pq ;
 
-        powers_queue_init (&pq) ;
-
-        powers_queue_build (&pq, pqueue->Capacity * (Quantity_t) 2) ;
-
-        powers_queue_copy (&pq, pqueue) ;
-
-        Power_t *tmp = pq.Memory ;
-           pq.Memory = pqueue->Memory ;
-        pqueue->Memory = tmp ;
-
-        pqueue->Capacity = pq.Capacity ;
-        pqueue->Size     = pq.Size ;
-        pqueue->Start    = pq.Start ;
-        pqueue->End      = pq.End ;
-
-        powers_queue_destroy (&pq) ;
-    }
+        grow_powers_queue (pqueue) ;
 
     pqueue->Memory [pqueue->End] = power ;
 
@@ -267,3 +273,43 @@ Power_t get_from_powers_queue (PowersQueue_t *pqueue)
 }
 
 /******************************************************************************/
+
+void put_front_into_powers_queue (PowersQueue_t *pqueue, Power_t power)
+{
+    if (pqueue->Memory == NULL)
+    {
+        fprintf (stderr, "ERROR: put into not-built powers queue\n") ;
+
+        return ;
+    }
+
+    if (is_full_powers_queue (pqueue))
+
+        grow_powers_queue (pqueue) ;
+
+    pqueue->Start = (pqueue->Start + pqueue->Capacity - 1) % pqueue->Capacity ;
+
+    pqueue->Memory [pqueue->Start] = power ;
+
+    pqueue->Size++ ;
+}
+
+/******************************************************************************/
+
+Power_t get_average_powers_queue (PowersQueue_t *pqueue)
+{
+    Quantity_t index ;
+    Power_t    sum = 0.0 ;
+
+    if (pqueue->Memory == NULL || is_empty_powers_queue (pqueue))
+
+        return sum ;
+
+    for (index = 0u ; index != pqueue->Size ; index++)
+
+        sum += pqueue->Memory [(pqueue->Start + index) % pqueue->Capacity] ;
+
+    return sum / pqueue->Size ;
+}
+
+/******************************************************************************/
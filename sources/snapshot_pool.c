@@ -0,0 +1,344 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>  // For the file type FILE
+#include <stdlib.h> // For the memory functions malloc/free
+
+#include "snapshot_pool.h"
+
+/******************************************************************************/
+
+void snapshot_pool_init (SnapshotPool_t *pool)
+{
+    pool->Saved      = NULL ;
+    pool->Free       = NULL ;
+    pool->NFree      = 0u ;
+    pool->LastHandle = 0u ;
+    pool->Memory     = 0u ;
+
+    pthread_mutex_init (&pool->Lock, NULL) ;
+}
+
+/******************************************************************************/
+
+// Frees a snapshot and its state
+
+static void free_snapshot (Snapshot_t *snapshot)
+{
+    thermal_snapshot_destroy (&snapshot->State) ;
+
+    free (snapshot) ;
+}
+
+/******************************************************************************/
+
+// Gives back to the pool (or frees, if the pool is full) a snapshot. The
+// lock must be held
+
+static void release_snapshot (SnapshotPool_t *pool, Snapshot_t *snapshot)
+{
+    if (pool->NFree < TDICE_SNAPSHOT_POOL_SIZE)
+    {
+        snapshot->Next = pool->Free ;
+        pool->Free     = snapshot ;
+
+        pool->NFree++ ;
+
+        return ;
+    }
+
+    free_snapshot (snapshot) ;
+}
+
+/******************************************************************************/
+
+void snapshot_pool_destroy (SnapshotPool_t *pool)
+{
+    while (pool->Saved != NULL)
+    {
+        Snapshot_t *snapshot = pool->Saved ;
+
+        pool->Saved = snapshot->Next ;
+
+        free_snapshot (snapshot) ;
+    }
+
+    while (pool->Free != NULL)
+    {
+        Snapshot_t *snapshot = pool->Free ;
+
+        pool->Free = snapshot->Next ;
+
+        free_snapshot (snapshot) ;
+    }
+
+    pool->NFree  = 0u ;
+    pool->Memory = 0u ;
+
+    pthread_mutex_destroy (&pool->Lock) ;
+}
+
+/******************************************************************************/
+
+size_t snapshot_pool_memory (SnapshotPool_t *pool)
+{
+    pthread_mutex_lock (&pool->Lock) ;
+
+    size_t memory = pool->Memory ;
+
+    pthread_mutex_unlock (&pool->Lock) ;
+
+    return memory ;
+}
+
+/******************************************************************************/
+
+// The number of states saved by a session. The lock must be held
+
+static Quantity_t session_snapshots (SnapshotPool_t *pool, Quantity_t session_id)
+{
+    Snapshot_t *snapshot ;
+    Quantity_t  count = 0u ;
+
+    for (snapshot = pool->Saved ; snapshot != NULL ; snapshot = snapshot->Next)
+
+        if (snapshot->SessionId == session_id)
+
+            count++ ;
+
+    return count ;
+}
+
+/******************************************************************************/
+
+Snapshot_t *snapshot_pool_take (SnapshotPool_t *pool, Quantity_t session_id)
+{
+    Snapshot_t *snapshot ;
+
+    pthread_mutex_lock (&pool->Lock) ;
+
+    if (session_snapshots (pool, session_id) >= TDICE_SESSION_SNAPSHOTS)
+    {
+        pthread_mutex_unlock (&pool->Lock) ;
+
+        fprintf (stderr, "ERROR: session %u saved %u thermal states already\n",
+                 session_id, TDICE_SESSION_SNAPSHOTS) ;
+
+        return NULL ;
+    }
+
+    snapshot = pool->Free ;
+
+    if (snapshot != NULL)
+    {
+        pool->Free = snapshot->Next ;
+
+        pool->NFree-- ;
+    }
+
+    pthread_mutex_unlock (&pool->Lock) ;
+
+    if (snapshot == NULL)
+    {
+        snapshot = (Snapshot_t *) malloc (sizeof (Snapshot_t)) ;
+
+        if (snapshot == NULL)
+        {
+            fprintf (stderr, "Cannot malloc snapshot\n") ;
+
+            return NULL ;
+        }
+
+        thermal_snapshot_init (&snapshot->State) ;
+    }
+
+    return snapshot ;
+}
+
+/******************************************************************************/
+
+void snapshot_pool_give_back (SnapshotPool_t *pool, Snapshot_t *snapshot)
+{
+    pthread_mutex_lock   (&pool->Lock) ;
+    release_snapshot     (pool, snapshot) ;
+    pthread_mutex_unlock (&pool->Lock) ;
+}
+
+/******************************************************************************/
+
+Quantity_t snapshot_pool_add
+(
+    SnapshotPool_t *pool,
+    Snapshot_t     *snapshot,
+    Quantity_t      model_id,
+    Quantity_t      session_id,
+    size_t          budget,
+    size_t          other_memory
+)
+{
+    Quantity_t handle = 0u ;
+
+    pthread_mutex_lock (&pool->Lock) ;
+
+    snapshot->Memory = thermal_snapshot_memory (&snapshot->State) ;
+
+    if (budget != 0u && other_memory + pool->Memory + snapshot->Memory > budget)
+    {
+        fprintf (stderr, "ERROR: the thermal state saved exceeds the memory budget\n") ;
+
+        release_snapshot (pool, snapshot) ;
+    }
+    else
+    {
+        handle = ++pool->LastHandle ;
+
+        snapshot->Handle    = handle ;
+        snapshot->ModelId   = model_id ;
+        snapshot->SessionId = session_id ;
+        snapshot->Next      = pool->Saved ;
+        pool->Saved         = snapshot ;
+
+        pool->Memory += snapshot->Memory ;
+    }
+
+    pthread_mutex_unlock (&pool->Lock) ;
+
+    return handle ;
+}
+
+/******************************************************************************/
+
+Error_t snapshot_pool_restore
+(
+    SnapshotPool_t *pool,
+    Quantity_t      handle,
+    Quantity_t      model_id,
+    ThermalData_t  *tdata,
+    Analysis_t     *analysis
+)
+{
+    Error_t     error = TDICE_FAILURE ;
+    Snapshot_t *snapshot ;
+
+    pthread_mutex_lock (&pool->Lock) ;
+
+    for (snapshot = pool->Saved ; snapshot != NULL ; snapshot = snapshot->Next)
+    {
+        if (snapshot->Handle != handle)
+
+            continue ;
+
+        if (snapshot->ModelId != model_id)
+
+            fprintf (stderr, "ERROR: the snapshot belongs to another model\n") ;
+
+        else
+
+            error = restore_thermal_state (tdata, analysis, &snapshot->State) ;
+
+        break ;
+    }
+
+    pthread_mutex_unlock (&pool->Lock) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+Error_t snapshot_pool_delete (SnapshotPool_t *pool, Quantity_t handle)
+{
+    Error_t      error = TDICE_FAILURE ;
+    Snapshot_t **snapshot ;
+
+    pthread_mutex_lock (&pool->Lock) ;
+
+    for (snapshot = &pool->Saved ; *snapshot != NULL ; snapshot = &(*snapshot)->Next)
+    {
+        if ((*snapshot)->Handle != handle)
+
+            continue ;
+
+        Snapshot_t *deleted = *snapshot ;
+
+        *snapshot = deleted->Next ;
+
+        pool->Memory -= deleted->Memory ;
+
+        release_snapshot (pool, deleted) ;
+
+        error = TDICE_SUCCESS ;
+
+        break ;
+    }
+
+    pthread_mutex_unlock (&pool->Lock) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+void snapshot_pool_delete_session (SnapshotPool_t *pool, Quantity_t session_id)
+{
+    Snapshot_t **snapshot ;
+
+    pthread_mutex_lock (&pool->Lock) ;
+
+    for (snapshot = &pool->Saved ; *snapshot != NULL ; )
+    {
+        Snapshot_t *deleted = *snapshot ;
+
+        if (deleted->SessionId != session_id)
+        {
+            snapshot = &deleted->Next ;
+
+            continue ;
+        }
+
+        *snapshot = deleted->Next ;
+
+        pool->Memory -= deleted->Memory ;
+
+        release_snapshot (pool, deleted) ;
+    }
+
+    pthread_mutex_unlock (&pool->Lock) ;
+}
+
+/******************************************************************************/
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <limits.h> // For the constant PATH_MAX
+#include <stdio.h>  // For the functions fopen/fprintf/rename
+#include <string.h> // For the memory function memset
+#include <time.h>   // For the monotonic clock
+#include <unistd.h> // For the function sysconf
+#include <sys/resource.h>
+
+#include "stats.h"
+
+/******************************************************************************/
+
+void stats_histogram_init (StatsHistogram_t *histogram)
+{
+    memset (histogram, 0, sizeof (StatsHistogram_t)) ;
+}
+
+/******************************************************************************/
+
+uint64_t stats_now (void)
+{
+    struct timespec now ;
+
+    clock_gettime (CLOCK_MONOTONIC, &now) ;
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec ;
+}
+
+/******************************************************************************/
+
+void stats_histogram_add (StatsHistogram_t *histogram, uint64_t nanoseconds)
+{
+    uint64_t   microseconds = nanoseconds / 1000u ;
+    Quantity_t bucket       = 0u ;
+
+    while (bucket != TDICE_STATS_NBUCKETS - 1u && microseconds >= ((uint64_t) 1u << bucket))
+
+        bucket++ ;
+
+    __atomic_add_fetch (&histogram->Count, 1u, __ATOMIC_RELAXED) ;
+    __atomic_add_fetch (&histogram->Sum, nanoseconds, __ATOMIC_RELAXED) ;
+    __atomic_add_fetch (&histogram->Buckets [bucket], 1u, __ATOMIC_RELAXED) ;
+
+    uint64_t max = __atomic_load_n (&histogram->Max, __ATOMIC_RELAXED) ;
+
+    while (   nanoseconds > max
+           && __atomic_compare_exchange_n (&histogram->Max, &max, nanoseconds, false,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED) == false) ;
+}
+
+/******************************************************************************/
+
+void stats_histogram_add_since (StatsHistogram_t *histogram, uint64_t start)
+{
+    if (histogram != NULL)
+
+        stats_histogram_add (histogram, stats_now () - start) ;
+}
+
+/******************************************************************************/
+
+void stats_histogram_print
+
+    (StatsHistogram_t *histogram, FILE *stream, String_t name, String_t labels)
+{
+    Quantity_t bucket ;
+    uint64_t   count = 0u ;
+
+    String_t separator = labels [0] != '\0' ? (String_t) "," : (String_t) "" ;
+
+    for (bucket = 0u ; bucket != TDICE_STATS_NBUCKETS ; bucket++)
+    {
+        count += __atomic_load_n (&histogram->Buckets [bucket], __ATOMIC_RELAXED) ;
+
+        if (bucket == TDICE_STATS_NBUCKETS - 1u)
+
+            fprintf (stream, "%s_bucket{%s%sle=\"+Inf\"} %llu\n",
+                name, labels, separator, (unsigned long long) count) ;
+
+        else
+
+            fprintf (stream, "%s_bucket{%s%sle=\"%g\"} %llu\n",
+                name, labels, separator, ((uint64_t) 1u << bucket) / 1e6,
+                (unsigned long long) count) ;
+    }
+
+    fprintf (stream, "%s_sum{%s} %.9f\n", name, labels,
+        __atomic_load_n (&histogram->Sum, __ATOMIC_RELAXED) / 1e9) ;
+
+    fprintf (stream, "%s_count{%s} %llu\n", name, labels, (unsigned long long) count) ;
+}
+
+/******************************************************************************/
+
+// The names of the requests and of the phases, in the labels of the metrics
+
+static const char *request_names [TDICE_STATS_NREQUESTS] =
+{
+    "exit_simulation",    "reset_thermal_state",   "send_output",
+    "print_output",       "total_number_of_floorplan_elements",
+    "insert_powers",      "simulate_slot",         "simulate_step",
+    "send_output_files",  "simulate_and_send_output",
+    "negotiate_protocol", "send_thermal_state",    "send_thermal_map",
+    "open_shared_memory", "set_bulk_resolution",   "save_thermal_state",
+    "restore_thermal_state", "delete_thermal_state", "speculate_steps",
+    "send_model_status",  "select_model",          "get_stats"
+} ;
+
+static const char *phase_names [TDICE_STATS_NPHASES] =
+
+    { "fill_vector", "solve", "plugin", "output", "message_io" } ;
+
+/******************************************************************************/
+
+void stats_init (Stats_t *stats)
+{
+    memset (stats, 0, sizeof (Stats_t)) ;
+
+    stats->Start = stats_now ( ) ;
+}
+
+/******************************************************************************/
+
+void stats_add_request
+
+    (Stats_t *stats, MessageType_t type, uint64_t start, Error_t error)
+{
+    if ((unsigned) type >= TDICE_STATS_NREQUESTS)
+
+        return ;
+
+    stats_histogram_add_since (&stats->Requests [type], start) ;
+
+    if (error != TDICE_SUCCESS)
+
+        __atomic_add_fetch (&stats->Failures [type], 1u, __ATOMIC_RELAXED) ;
+}
+
+/******************************************************************************/
+
+void stats_print (Stats_t *stats, FILE *stream, StatsGauges_t *gauges)
+{
+    unsigned index ;
+    char     labels [64] ;
+
+    long     resident = 0 ;
+    FILE    *statm    = fopen ("/proc/self/statm", "r") ;
+
+    struct rusage usage ;
+
+    if (statm != NULL)
+    {
+        if (fscanf (statm, "%*d %ld", &resident) != 1)
+
+            resident = 0 ;
+
+        fclose (statm) ;
+    }
+
+    getrusage (RUSAGE_SELF, &usage) ;
+
+    // The peak is sampled by the kernel less often than the current size
+
+    unsigned long resident_bytes = (unsigned long) resident * (unsigned long) sysconf (_SC_PAGESIZE) ;
+    unsigned long resident_peak  = (unsigned long) usage.ru_maxrss * 1024ul ;
+
+    if (resident_peak < resident_bytes)
+
+        resident_peak = resident_bytes ;
+
+    fprintf (stream, "# HELP tdice_request_duration_seconds Time spent serving the requests\n") ;
+    fprintf (stream, "# TYPE tdice_request_duration_seconds histogram\n") ;
+
+    for (index = 0u ; index != TDICE_STATS_NREQUESTS ; index++)
+    {
+        if (__atomic_load_n (&stats->Requests [index].Count, __ATOMIC_RELAXED) == 0u)
+
+            continue ;
+
+        snprintf (labels, sizeof (labels), "request=\"%s\"", request_names [index]) ;
+
+        stats_histogram_print
+
+            (&stats->Requests [index], stream,
+             (String_t) "tdice_request_duration_seconds", labels) ;
+    }
+
+    fprintf (stream, "# HELP tdice_request_max_seconds Longest time spent serving a request\n") ;
+    fprintf (stream, "# TYPE tdice_request_max_seconds gauge\n") ;
+
+    for (index = 0u ; index != TDICE_STATS_NREQUESTS ; index++)
+
+        if (__atomic_load_n (&stats->Requests [index].Count, __ATOMIC_RELAXED) != 0u)
+
+            fprintf (stream, "tdice_request_max_seconds{request=\"%s\"} %.9f\n",
+                request_names [index],
+                __atomic_load_n (&stats->Requests [index].Max, __ATOMIC_RELAXED) / 1e9) ;
+
+    fprintf (stream, "# HELP tdice_request_failures_total Requests that failed\n") ;
+    fprintf (stream, "# TYPE tdice_request_failures_total counter\n") ;
+
+    for (index = 0u ; index != TDICE_STATS_NREQUESTS ; index++)
+
+        if (__atomic_load_n (&stats->Requests [index].Count, __ATOMIC_RELAXED) != 0u)
+
+            fprintf (stream, "tdice_request_failures_total{request=\"%s\"} %lu\n",
+                request_names [index],
+                (unsigned long) __atomic_load_n (&stats->Failures [index], __ATOMIC_RELAXED)) ;
+
+    fprintf (stream, "# HELP tdice_phase_duration_seconds Time spent in each phase of the simulation\n") ;
+    fprintf (stream, "# TYPE tdice_phase_duration_seconds histogram\n") ;
+
+    for (index = 0u ; index != TDICE_STATS_NPHASES ; index++)
+    {
+        snprintf (labels, sizeof (labels), "phase=\"%s\"", phase_names [index]) ;
+
+        stats_histogram_print
+
+            (&stats->Phases [index], stream,
+             (String_t) "tdice_phase_duration_seconds", labels) ;
+    }
+
+    fprintf (stream, "# HELP tdice_sessions Sessions being served\n") ;
+    fprintf (stream, "# TYPE tdice_sessions gauge\n") ;
+    fprintf (stream, "tdice_sessions %u\n", gauges->Sessions) ;
+    fprintf (stream, "# HELP tdice_sessions_peak Most sessions served at the same time\n") ;
+    fprintf (stream, "# TYPE tdice_sessions_peak gauge\n") ;
+    fprintf (stream, "tdice_sessions_peak %u\n", gauges->SessionsPeak) ;
+    fprintf (stream, "# HELP tdice_models Models hosted\n") ;
+    fprintf (stream, "# TYPE tdice_models gauge\n") ;
+    fprintf (stream, "tdice_models %u\n", gauges->Models) ;
+    fprintf (stream, "# HELP tdice_models_memory_bytes Estimated memory of the models ready\n") ;
+    fprintf (stream, "# TYPE tdice_models_memory_bytes gauge\n") ;
+    fprintf (stream, "tdice_models_memory_bytes %lu\n", (unsigned long) gauges->ModelsMemory) ;
+    fprintf (stream, "# HELP tdice_models_memory_peak_bytes Highest estimated memory of the models ready\n") ;
+    fprintf (stream, "# TYPE tdice_models_memory_peak_bytes gauge\n") ;
+    fprintf (stream, "tdice_models_memory_peak_bytes %lu\n", (unsigned long) gauges->ModelsMemoryPeak) ;
+    fprintf (stream, "# HELP tdice_saved_states_memory_bytes Estimated memory of the thermal states saved\n") ;
+    fprintf (stream, "# TYPE tdice_saved_states_memory_bytes gauge\n") ;
+    fprintf (stream, "tdice_saved_states_memory_bytes %lu\n", (unsigned long) gauges->SavedStatesMemory) ;
+    fprintf (stream, "# HELP tdice_resident_memory_bytes Resident memory of the server\n") ;
+    fprintf (stream, "# TYPE tdice_resident_memory_bytes gauge\n") ;
+    fprintf (stream, "tdice_resident_memory_bytes %lu\n", resident_bytes) ;
+    fprintf (stream, "# HELP tdice_resident_memory_peak_bytes Highest resident memory of the server\n") ;
+    fprintf (stream, "# TYPE tdice_resident_memory_peak_bytes gauge\n") ;
+    fprintf (stream, "tdice_resident_memory_peak_bytes %lu\n", resident_peak) ;
+    fprintf (stream, "# HELP tdice_uptime_seconds Time since the server started\n") ;
+    fprintf (stream, "# TYPE tdice_uptime_seconds gauge\n") ;
+    fprintf (stream, "tdice_uptime_seconds %.3f\n", (stats_now ( ) - stats->Start) / 1e9) ;
+}
+
+/******************************************************************************/
+
+Error_t stats_write_file
+
+    (Stats_t *stats, String_t file_name, StatsGauges_t *gauges)
+{
+    char temporary [PATH_MAX] ;
+
+    snprintf (temporary, sizeof (temporary), "%s.tmp", file_name) ;
+
+    FILE *stream = fopen (temporary, "w") ;
+
+    if (stream == NULL)
+    {
+        fprintf (stderr, "error: cannot write %s\n", temporary) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    stats_print (stats, stream, gauges) ;
+
+    if (fclose (stream) != 0 || rename (temporary, file_name) != 0)
+    {
+        fprintf (stderr, "error: cannot write %s\n", file_name) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
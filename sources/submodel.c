@@ -0,0 +1,672 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/free
+#include <string.h> // For the string functions strrchr/strlen
+
+#include "submodel.h"
+#include "macros.h"
+
+/******************************************************************************/
+
+void submodel_init (Submodel_t *submodel)
+{
+    submodel->OriginX              = (ChipDimension_t) 0.0 ;
+    submodel->OriginY              = (ChipDimension_t) 0.0 ;
+    submodel->Size                 = (CellIndex_t) 0u ;
+    submodel->Temperatures         = NULL ;
+    submodel->NBoundaries          = (CellIndex_t) 0u ;
+    submodel->BoundaryCells        = NULL ;
+    submodel->BoundaryConductances = NULL ;
+    submodel->CoarseCells          = NULL ;
+    submodel->CoarseWeights        = NULL ;
+
+    submodel->SLUMatrix_B.Store = NULL ;
+
+    system_matrix_init (&submodel->SM_A) ;
+    thermal_grid_init  (&submodel->ThermalGrid) ;
+    power_grid_init    (&submodel->PowerGrid) ;
+}
+
+/******************************************************************************/
+
+// Replaces the dimensions of the stack with the ones of the region given
+// in the analysis (all the layers are kept)
+
+static Error_t override_dimensions (StackDescription_t *stkd, Analysis_t *analysis)
+{
+    Dimensions_t *dimensions = dimensions_clone (stkd->Dimensions) ;
+
+    if (dimensions == NULL)
+    {
+        fprintf (stderr, "Malloc dimensions failed\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    dimensions->Chip.Length = analysis->SubmodelLength ;
+    dimensions->Chip.Width  = analysis->SubmodelWidth ;
+
+    dimensions->Cell.ChannelLength   = analysis->SubmodelCellLength ;
+    dimensions->Cell.FirstWallLength = analysis->SubmodelCellLength ;
+    dimensions->Cell.LastWallLength  = analysis->SubmodelCellLength ;
+    dimensions->Cell.WallLength      = analysis->SubmodelCellLength ;
+    dimensions->Cell.Width           = analysis->SubmodelCellWidth ;
+
+    dimensions->Grid.NRows    = (analysis->SubmodelWidth  / analysis->SubmodelCellWidth) ;
+    dimensions->Grid.NColumns = (analysis->SubmodelLength / analysis->SubmodelCellLength) ;
+
+    dimensions->Discr_Y = dimensions->Grid.NRows ;
+    dimensions->Discr_X = dimensions->Grid.NColumns ;
+
+    dimensions->Grid.NCells =   get_number_of_layers  (dimensions)
+                              * get_number_of_rows    (dimensions)
+                              * get_number_of_columns (dimensions) ;
+
+    compute_number_of_connections
+
+        (dimensions, 0u, TDICE_CHANNEL_MODEL_NONE, NULL) ;
+
+    dimensions_free (stkd->Dimensions) ;
+
+    stkd->Dimensions = dimensions ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Crops the floorplans of all the dies to the region
+
+static Error_t crop_floorplans (Submodel_t *submodel, StackDescription_t *stkd)
+{
+    StackElementListNode_t *stkeln ;
+
+    for (stkeln  = stack_element_list_begin (&stkd->StackElements) ;
+         stkeln != NULL ;
+         stkeln  = stack_element_list_next (stkeln))
+    {
+        StackElement_t *stkel = stack_element_list_data (stkeln) ;
+
+        if (stkel->SEType != TDICE_STACK_ELEMENT_DIE)
+
+            continue ;
+
+        Error_t result = crop_floorplan
+
+            (&stkel->Pointer.Die->Floorplan, stkd->Dimensions,
+             submodel->OriginX, submodel->OriginY) ;
+
+        if (result == TDICE_FAILURE)
+        {
+            fprintf (stderr, "Cannot crop the floorplan of %s\n", stkel->Id) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Moves the inspection points of a list on the grid of the submodel.
+// Thermal cells out of the region are dropped and the output files get
+// the prefix "submodel_".
+
+static void move_inspection_points
+(
+    Submodel_t            *submodel,
+    InspectionPointList_t *list,
+    Dimensions_t          *dimensions
+)
+{
+    InspectionPointList_t     moved ;
+    InspectionPointListNode_t *ipointn ;
+
+    inspection_point_list_init (&moved) ;
+
+    for (ipointn  = inspection_point_list_begin (list) ;
+         ipointn != NULL ;
+         ipointn  = inspection_point_list_next (ipointn))
+    {
+        InspectionPoint_t *ipoint = inspection_point_list_data (ipointn) ;
+
+        if (ipoint->OType == TDICE_OUTPUT_TYPE_TCELL)
+        {
+            ChipDimension_t xval = ipoint->Xval - submodel->OriginX ;
+            ChipDimension_t yval = ipoint->Yval - submodel->OriginY ;
+
+            if (   xval < 0.0 || xval >= get_chip_length (dimensions)
+                || yval < 0.0 || yval >= get_chip_width  (dimensions))
+            {
+                fprintf (stderr,
+                    "Warning: submodel drops the output T (%.1f, %.1f) out of the region\n",
+                    ipoint->Xval, ipoint->Yval) ;
+
+                continue ;
+            }
+
+            align_tcell (ipoint, xval, yval, dimensions) ;
+
+            // Coordinates are printed in the reference of the coarse model
+
+            ipoint->Xval       += submodel->OriginX ;
+            ipoint->ActualXval += submodel->OriginX ;
+            ipoint->Yval       += submodel->OriginY ;
+            ipoint->ActualYval += submodel->OriginY ;
+        }
+
+        char *name      = ipoint->FileName ;
+        char *separator = strrchr (name, '/') ;
+        char *newname   = (char *) malloc (strlen (name) + sizeof ("submodel_")) ;
+
+        if (newname != NULL)
+        {
+            size_t dirlength = separator == NULL ? 0 : (size_t) (separator - name) + 1 ;
+
+            sprintf (newname, "%.*ssubmodel_%s", (int) dirlength, name, name + dirlength) ;
+
+            string_copy_cstr (&ipoint->FileName, newname) ;
+
+            free (newname) ;
+        }
+
+        inspection_point_list_insert_end (&moved, ipoint) ;
+    }
+
+    inspection_point_list_copy    (list, &moved) ;
+    inspection_point_list_destroy (&moved) ;
+}
+
+/******************************************************************************/
+
+// Index of the cell (along one direction) whose center is the closest one
+// before the coordinate, and the weight of the next cell in the linear
+// interpolation between the two centers
+
+static void bracket_coordinate
+(
+    ChipDimension_t  coordinate,
+    CellIndex_t      ncells,
+    Dimensions_t    *dimensions,
+    ChipDimension_t (*center) (Dimensions_t *, CellIndex_t),
+    CellIndex_t     *index,
+    double          *weight
+)
+{
+    *index  = 0u ;
+    *weight = 0.0 ;
+
+    if (coordinate <= center (dimensions, 0u))
+
+        return ;
+
+    while (*index + 1u < ncells && center (dimensions, *index + 1u) <= coordinate)
+
+        (*index)++ ;
+
+    if (*index + 1u == ncells)
+
+        return ;
+
+    *weight =   (coordinate - center (dimensions, *index))
+              / (center (dimensions, *index + 1u) - center (dimensions, *index)) ;
+}
+
+/******************************************************************************/
+
+// Adds a boundary face to the cell (layer, row, column) of the submodel.
+// The temperature of the face is interpolated at (x, y) in the coarse
+// model (floorplan coordinates).
+
+static void add_boundary
+(
+    Submodel_t      *submodel,
+    Dimensions_t    *dimensions,
+    Dimensions_t    *coarse,
+    CellIndex_t      layer,
+    CellIndex_t      row,
+    CellIndex_t      column,
+    Conductance_t    conductance,
+    ChipDimension_t  x,
+    ChipDimension_t  y
+)
+{
+    CellIndex_t  index    = submodel->NBoundaries++ ;
+    CellIndex_t *cells    = submodel->CoarseCells   + 4u * index ;
+    double      *weights  = submodel->CoarseWeights + 4u * index ;
+
+    CellIndex_t crow, ccolumn ;
+    double      wrow, wcolumn ;
+
+    bracket_coordinate (x, get_number_of_columns (coarse), coarse, get_cell_center_x, &ccolumn, &wcolumn) ;
+    bracket_coordinate (y, get_number_of_rows    (coarse), coarse, get_cell_center_y, &crow,    &wrow) ;
+
+    CellIndex_t nrow    = MIN (crow    + 1u, last_row    (coarse)) ;
+    CellIndex_t ncolumn = MIN (ccolumn + 1u, last_column (coarse)) ;
+
+    cells [0] = get_cell_offset_in_stack (coarse, layer, crow, ccolumn) ;
+    cells [1] = get_cell_offset_in_stack (coarse, layer, crow, ncolumn) ;
+    cells [2] = get_cell_offset_in_stack (coarse, layer, nrow, ccolumn) ;
+    cells [3] = get_cell_offset_in_stack (coarse, layer, nrow, ncolumn) ;
+
+    weights [0] = (1.0 - wcolumn) * (1.0 - wrow) ;
+    weights [1] = wcolumn         * (1.0 - wrow) ;
+    weights [2] = (1.0 - wcolumn) * wrow ;
+    weights [3] = wcolumn         * wrow ;
+
+    submodel->BoundaryCells [index]
+        = get_cell_offset_in_stack (dimensions, layer, row, column) ;
+
+    submodel->BoundaryConductances [index] = conductance ;
+}
+
+/******************************************************************************/
+
+// Collects the faces of the region lying inside the coarse model. Faces on
+// the border of the IC are left adiabatic, as in the coarse model.
+
+static Error_t build_boundaries
+(
+    Submodel_t   *submodel,
+    Dimensions_t *dimensions,
+    Dimensions_t *coarse
+)
+{
+    CellIndex_t layer, row, column ;
+
+    ChipDimension_t west  = submodel->OriginX ;
+    ChipDimension_t south = submodel->OriginY ;
+    ChipDimension_t east  = west  + get_cell_location_x (dimensions, get_number_of_columns (dimensions)) ;
+    ChipDimension_t north = south + get_cell_location_y (dimensions, get_number_of_rows    (dimensions)) ;
+
+    bool has_west  = west  > EPSILON ;
+    bool has_south = south > EPSILON ;
+    bool has_east  = get_chip_length (coarse) - east  > EPSILON ;
+    bool has_north = get_chip_width  (coarse) - north > EPSILON ;
+
+    CellIndex_t nfaces = get_number_of_layers (dimensions)
+                         * (  (has_west  + has_east)  * get_number_of_rows    (dimensions)
+                            + (has_south + has_north) * get_number_of_columns (dimensions)) ;
+
+    submodel->BoundaryCells        = (CellIndex_t *)   malloc (sizeof (CellIndex_t)   * MAX (nfaces, 1u)) ;
+    submodel->BoundaryConductances = (Conductance_t *) malloc (sizeof (Conductance_t) * MAX (nfaces, 1u)) ;
+    submodel->CoarseCells          = (CellIndex_t *)   malloc (sizeof (CellIndex_t)   * MAX (nfaces, 1u) * 4u) ;
+    submodel->CoarseWeights        = (double *)        malloc (sizeof (double)        * MAX (nfaces, 1u) * 4u) ;
+
+    if (   submodel->BoundaryCells == NULL || submodel->BoundaryConductances == NULL
+        || submodel->CoarseCells   == NULL || submodel->CoarseWeights        == NULL)
+
+        return TDICE_FAILURE ;
+
+    ThermalGrid_t *tgrid = &submodel->ThermalGrid ;
+
+    for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
+    {
+        for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+        {
+            ChipDimension_t y = south + get_cell_center_y (dimensions, row) ;
+
+            if (has_west == true)
+
+                add_boundary (submodel, dimensions, coarse, layer, row, first_column (dimensions),
+                    get_conductance_west (tgrid, dimensions, layer, row, first_column (dimensions)),
+                    west, y) ;
+
+            if (has_east == true)
+
+                add_boundary (submodel, dimensions, coarse, layer, row, last_column (dimensions),
+                    get_conductance_east (tgrid, dimensions, layer, row, last_column (dimensions)),
+                    east, y) ;
+        }
+
+        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
+        {
+            ChipDimension_t x = west + get_cell_center_x (dimensions, column) ;
+
+            if (has_south == true)
+
+                add_boundary (submodel, dimensions, coarse, layer, first_row (dimensions), column,
+                    get_conductance_south (tgrid, dimensions, layer, first_row (dimensions), column),
+                    x, south) ;
+
+            if (has_north == true)
+
+                add_boundary (submodel, dimensions, coarse, layer, last_row (dimensions), column,
+                    get_conductance_north (tgrid, dimensions, layer, last_row (dimensions), column),
+                    x, north) ;
+        }
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Adds the boundary conductances to the diagonal of the system matrix
+
+static void add_boundary_conductances (Submodel_t *submodel)
+{
+    SystemMatrix_t *sysmatrix = &submodel->SM_A ;
+    CellIndex_t     index ;
+    LUIndex_t       lnz ;
+
+    for (index = 0u ; index != submodel->NBoundaries ; index++)
+    {
+        CellIndex_t cell = submodel->BoundaryCells [index] ;
+
+        for (lnz  = sysmatrix->ColumnPointers [cell] ;
+             lnz != sysmatrix->ColumnPointers [cell + 1] ;
+             lnz++)
+
+            if (sysmatrix->RowIndices [lnz] == (LUIndex_t) cell)
+            {
+                sysmatrix->Values [lnz] += submodel->BoundaryConductances [index] ;
+
+                break ;
+            }
+    }
+}
+
+/******************************************************************************/
+
+Error_t submodel_build
+(
+    Submodel_t         *submodel,
+    StackDescription_t *stkd,
+    Analysis_t         *analysis,
+    Output_t           *output,
+    Dimensions_t       *dimensions
+)
+{
+    CellIndex_t cell, layer ;
+
+    submodel->OriginX = analysis->SubmodelX ;
+    submodel->OriginY = analysis->SubmodelY ;
+
+    if (   override_dimensions (stkd, analysis) == TDICE_FAILURE
+        || crop_floorplans     (submodel, stkd) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    move_inspection_points (submodel, &output->InspectionPointListFinal, stkd->Dimensions) ;
+    move_inspection_points (submodel, &output->InspectionPointListSlot,  stkd->Dimensions) ;
+    move_inspection_points (submodel, &output->InspectionPointListStep,  stkd->Dimensions) ;
+
+    submodel->Size = get_number_of_cells (stkd->Dimensions) ;
+
+    /* Thermal and power grids of the region */
+
+    if (   thermal_grid_build (&submodel->ThermalGrid, stkd->Dimensions) == TDICE_FAILURE
+        || power_grid_build   (&submodel->PowerGrid,   stkd->Dimensions) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc thermal or power grid\n") ;
+
+        goto failure ;
+    }
+
+    if (thermal_grid_fill (&submodel->ThermalGrid, &stkd->StackElements) == TDICE_FAILURE)
+
+        goto failure ;
+
+    // The material layouts are aligned to the grid of the coarse model
+
+    for (layer = first_layer (stkd->Dimensions) ; layer <= last_layer (stkd->Dimensions) ; layer++)
+
+        if (material_element_list_begin (&submodel->ThermalGrid.LayersProfile [layer].MaterialLayout) != NULL)
+        {
+            fprintf (stderr, "Submodel cannot be used with layers having a material layout\n") ;
+
+            goto failure ;
+        }
+
+    power_grid_fill
+
+        (&submodel->PowerGrid, &submodel->ThermalGrid, &stkd->StackElements, stkd->Dimensions) ;
+
+    if (submodel->PowerGrid.NLeakages != 0u)
+    {
+        fprintf (stderr, "Submodel cannot be used with leakage power\n") ;
+
+        goto failure ;
+    }
+
+    /* Temperatures and SLU vector B */
+
+    submodel->Temperatures = (Temperature_t *) malloc (sizeof (Temperature_t) * submodel->Size) ;
+
+    if (submodel->Temperatures == NULL)
+    {
+        fprintf (stderr, "Cannot malloc temperature array\n") ;
+
+        goto failure ;
+    }
+
+    for (cell = 0u ; cell != submodel->Size ; cell++)
+
+        submodel->Temperatures [cell] = analysis->InitialTemperature ;
+
+    dCreate_Dense_Matrix  /* Vector B */
+
+        (&submodel->SLUMatrix_B, submodel->Size, 1,
+         submodel->Temperatures, submodel->Size,
+         SLU_DN, SLU_D, SLU_GE) ;
+
+    /* Boundary faces */
+
+    if (build_boundaries (submodel, stkd->Dimensions, dimensions) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc submodel boundaries\n") ;
+
+        goto failure ;
+    }
+
+    /* System matrix */
+
+    if (system_matrix_build (&submodel->SM_A, submodel->Size,
+                             get_number_of_connections (stkd->Dimensions),
+                             analysis->NumOfCores) == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Cannot malloc submodel system matrix\n") ;
+
+        system_matrix_init (&submodel->SM_A) ;
+
+        goto failure ;
+    }
+
+    fill_system_matrix
+
+        (&submodel->SM_A, &submodel->ThermalGrid, analysis, stkd->Dimensions) ;
+
+    add_boundary_conductances (submodel) ;
+
+    if (do_factorization (&submodel->SM_A) == TDICE_FAILURE)
+
+        goto failure ;
+
+    fprintf (stdout, "Submodel: %d x %d cells, %d boundary faces\n",
+        get_number_of_rows (stkd->Dimensions), get_number_of_columns (stkd->Dimensions),
+        submodel->NBoundaries) ;
+
+    return TDICE_SUCCESS ;
+
+failure :
+
+    submodel_destroy (submodel) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+void submodel_destroy (Submodel_t *submodel)
+{
+    if (submodel->SLUMatrix_B.Store != NULL)
+
+        Destroy_SuperMatrix_Store (&submodel->SLUMatrix_B) ;
+
+    if (submodel->SM_A.Size != 0)
+
+        system_matrix_destroy (&submodel->SM_A) ;
+
+    thermal_grid_destroy (&submodel->ThermalGrid) ;
+    power_grid_destroy   (&submodel->PowerGrid) ;
+
+    free (submodel->Temperatures) ;
+    free (submodel->BoundaryCells) ;
+    free (submodel->BoundaryConductances) ;
+    free (submodel->CoarseCells) ;
+    free (submodel->CoarseWeights) ;
+
+    submodel_init (submodel) ;
+}
+
+/******************************************************************************/
+
+// Adds to the right hand side the heat entering from the boundary faces
+
+static void add_boundary_sources (Submodel_t *submodel, Temperature_t *temperatures)
+{
+    CellIndex_t index ;
+
+    for (index = 0u ; index != submodel->NBoundaries ; index++)
+    {
+        CellIndex_t *cells   = submodel->CoarseCells   + 4u * index ;
+        double      *weights = submodel->CoarseWeights + 4u * index ;
+
+        Temperature_t boundary =   weights [0] * temperatures [cells [0]]
+                                 + weights [1] * temperatures [cells [1]]
+                                 + weights [2] * temperatures [cells [2]]
+                                 + weights [3] * temperatures [cells [3]] ;
+
+        submodel->Temperatures [submodel->BoundaryCells [index]]
+
+            += submodel->BoundaryConductances [index] * boundary ;
+    }
+}
+
+/******************************************************************************/
+
+SimResult_t submodel_emulate_step
+(
+    Submodel_t    *submodel,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis,
+    Temperature_t *temperatures
+)
+{
+    CellIndex_t cell ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_TRANSIENT)
+
+        return TDICE_WRONG_CONFIG ;
+
+    if (slot_completed (analysis) == true)
+    {
+        Error_t result = update_source_vector (&submodel->PowerGrid, dimensions) ;
+
+        if (result == TDICE_FAILURE)
+
+            return TDICE_END_OF_SIMULATION ;
+    }
+
+    for (cell = 0u ; cell != submodel->Size ; cell++)
+
+        submodel->Temperatures [cell] =   submodel->PowerGrid.Sources [cell]
+                                        + (submodel->PowerGrid.CellsCapacities [cell] / analysis->StepTime)
+                                        * submodel->Temperatures [cell] ;
+
+    add_boundary_sources (submodel, temperatures) ;
+
+    if (solve_sparse_linear_system (&submodel->SM_A, &submodel->SLUMatrix_B) != TDICE_SUCCESS)
+
+        return TDICE_SOLVER_ERROR ;
+
+    increase_by_step_time (analysis) ;
+
+    if (slot_completed (analysis) == false)
+
+        return TDICE_STEP_DONE ;
+
+    else
+
+        return TDICE_SLOT_DONE ;
+}
+
+/******************************************************************************/
+
+SimResult_t submodel_emulate_steady
+(
+    Submodel_t    *submodel,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis,
+    Temperature_t *temperatures
+)
+{
+    CellIndex_t cell ;
+
+    if (analysis->AnalysisType != TDICE_ANALYSIS_TYPE_STEADY)
+
+        return TDICE_WRONG_CONFIG ;
+
+    Error_t result = update_source_vector (&submodel->PowerGrid, dimensions) ;
+
+    if (result == TDICE_FAILURE)
+    {
+        fprintf (stderr,
+
+            "Warning: no power trace given for steady state simulation\n") ;
+
+        return TDICE_END_OF_SIMULATION ;
+    }
+
+    for (cell = 0u ; cell != submodel->Size ; cell++)
+
+        submodel->Temperatures [cell] = submodel->PowerGrid.Sources [cell] ;
+
+    add_boundary_sources (submodel, temperatures) ;
+
+    if (solve_sparse_linear_system (&submodel->SM_A, &submodel->SLUMatrix_B) != TDICE_SUCCESS)
+
+        return TDICE_SOLVER_ERROR ;
+
+    return TDICE_END_OF_SIMULATION ;
+}
+
+/******************************************************************************/
@@ -0,0 +1,1072 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdlib.h> // For the memory functions malloc/calloc/free
+#include <string.h> // For the memory functions memcpy/memset
+#include <math.h>   // For the math function sqrt
+#include <omp.h>
+
+#include "substructure.h"
+
+/******************************************************************************/
+
+// Owner of the thermal cells that belong to the interface
+
+#define INTERFACE_CELL ((CellIndex_t) UINT32_MAX)
+
+// Relative residual and maximum number of iterations of the interface solver
+
+#define INTERFACE_TOLERANCE      1e-10
+#define INTERFACE_MAX_ITERATIONS 1000u
+
+/******************************************************************************/
+
+static void coupling_init (SubstructureCoupling_t *coupling)
+{
+    coupling->NNz     = (Quantity_t) 0u ;
+    coupling->Rows    = NULL ;
+    coupling->Columns = NULL ;
+    coupling->Values  = NULL ;
+}
+
+/******************************************************************************/
+
+static Error_t coupling_build (SubstructureCoupling_t *coupling)
+{
+    coupling->Rows    = (CellIndex_t *) malloc (sizeof (CellIndex_t) * coupling->NNz) ;
+    coupling->Columns = (CellIndex_t *) malloc (sizeof (CellIndex_t) * coupling->NNz) ;
+    coupling->Values  = (SystemMatrixCoeff_t *) malloc
+
+        (sizeof (SystemMatrixCoeff_t) * coupling->NNz) ;
+
+    if (coupling->Rows == NULL || coupling->Columns == NULL || coupling->Values == NULL)
+
+        return TDICE_FAILURE ;
+
+    // NNz is counted again while filling
+
+    coupling->NNz = 0u ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void coupling_destroy (SubstructureCoupling_t *coupling)
+{
+    free (coupling->Rows) ;
+    free (coupling->Columns) ;
+    free (coupling->Values) ;
+
+    coupling_init (coupling) ;
+}
+
+/******************************************************************************/
+
+static void coupling_add
+(
+    SubstructureCoupling_t *coupling,
+    CellIndex_t             row,
+    CellIndex_t             column,
+    SystemMatrixCoeff_t     value
+)
+{
+    coupling->Rows    [coupling->NNz] = row ;
+    coupling->Columns [coupling->NNz] = column ;
+    coupling->Values  [coupling->NNz] = value ;
+
+    coupling->NNz++ ;
+}
+
+/******************************************************************************/
+
+void substructure_init (Substructure_t *sub)
+{
+    sub->Size           = (CellIndex_t) 0u ;
+    sub->NBlocks        = (Quantity_t) 0u ;
+    sub->Blocks         = NULL ;
+    sub->NInstances     = (Quantity_t) 0u ;
+    sub->Instances      = NULL ;
+    sub->NInterface     = (CellIndex_t) 0u ;
+    sub->InterfaceCells = NULL ;
+    sub->Work           = NULL ;
+    sub->Solution       = NULL ;
+    sub->Krylov         = NULL ;
+    sub->NIterations    = (Quantity_t) 0u ;
+    sub->StackElements  = NULL ;
+    sub->Dimensions     = NULL ;
+    sub->NThreads       = (CellIndex_t) 0u ;
+
+    sub->SLUMatrix_Work.Store = NULL ;
+
+    system_matrix_init (&sub->SM_Interface) ;
+}
+
+/******************************************************************************/
+
+// Two dies can share the factorization only if they come from the same
+// die definition and their floorplans have the same geometry
+
+static bool same_die
+(
+    StackElement_t *stkel,
+    StackElement_t *other
+)
+{
+    Die_t *die   = stkel->Pointer.Die ;
+    Die_t *odie  = other->Pointer.Die ;
+
+    if (   die_same_id (die, odie) == false
+        || die->Discr_X != odie->Discr_X
+        || die->Discr_Y != odie->Discr_Y
+        || die->Floorplan.NElements != odie->Floorplan.NElements)
+
+        return false ;
+
+    FloorplanElementListNode_t *flpeln  = floorplan_element_list_begin (&die->Floorplan.ElementsList) ;
+    FloorplanElementListNode_t *oflpeln = floorplan_element_list_begin (&odie->Floorplan.ElementsList) ;
+
+    for ( ; flpeln != NULL && oflpeln != NULL ;
+          flpeln  = floorplan_element_list_next (flpeln),
+          oflpeln = floorplan_element_list_next (oflpeln))
+    {
+        FloorplanElement_t *flpel  = floorplan_element_list_data (flpeln) ;
+        FloorplanElement_t *oflpel = floorplan_element_list_data (oflpeln) ;
+
+        if (flpel->NICElements != oflpel->NICElements)
+
+            return false ;
+
+        ICElementListNode_t *iceln  = ic_element_list_begin (&flpel->ICElements) ;
+        ICElementListNode_t *oiceln = ic_element_list_begin (&oflpel->ICElements) ;
+
+        for ( ; iceln != NULL && oiceln != NULL ;
+              iceln  = ic_element_list_next (iceln),
+              oiceln = ic_element_list_next (oiceln))
+
+            if (ic_element_equal (ic_element_list_data (iceln),
+                                  ic_element_list_data (oiceln)) == false)
+
+                return false ;
+    }
+
+    return true ;
+}
+
+/******************************************************************************/
+
+// Returns true if the coefficients of the interior of instance are exactly
+// the ones already stored in the (filled) system matrix of block
+
+static bool same_coefficients
+(
+    SystemMatrix_t         *sysmatrix,
+    CellIndex_t            *owner,
+    SubstructureInstance_t *instance,
+    Quantity_t              index,
+    SystemMatrix_t         *block
+)
+{
+    CellIndex_t column ;
+    LUIndex_t   nz, bnz = 0 ;
+
+    if (block->Size != (LUIndex_t) instance->NCells)
+
+        return false ;
+
+    for (column = 0u ; column != instance->NCells ; column++)
+    {
+        CellIndex_t gcolumn = instance->FirstCell + column ;
+
+        if (block->ColumnPointers [column] != bnz)
+
+            return false ;
+
+        for (nz  = sysmatrix->ColumnPointers [gcolumn] ;
+             nz != sysmatrix->ColumnPointers [gcolumn + 1] ;
+             nz++)
+        {
+            CellIndex_t row = (CellIndex_t) sysmatrix->RowIndices [nz] ;
+
+            if (owner [row] != index)
+
+                continue ;
+
+            if (   bnz == block->NNz
+                || block->RowIndices [bnz] != (LUIndex_t) (row - instance->FirstCell)
+                || block->Values     [bnz] != sysmatrix->Values [nz])
+
+                return false ;
+
+            bnz++ ;
+        }
+    }
+
+    return bnz == block->NNz ;
+}
+
+/******************************************************************************/
+
+// Copies into dst the coefficients of sysmatrix whose row and column belong
+// to part. Local indexes are taken from map.
+
+static Error_t extract_system_matrix
+(
+    SystemMatrix_t *dst,
+    SystemMatrix_t *sysmatrix,
+    CellIndex_t    *owner,
+    CellIndex_t    *map,
+    CellIndex_t     part,
+    CellIndex_t     size,
+    CellIndex_t     threads
+)
+{
+    CellIndex_t column, local = 0u ;
+    LUIndex_t   nz, nnz = 0 ;
+
+    for (column = 0u ; column != (CellIndex_t) sysmatrix->Size ; column++)
+
+        if (owner [column] == part)
+
+            for (nz  = sysmatrix->ColumnPointers [column] ;
+                 nz != sysmatrix->ColumnPointers [column + 1] ;
+                 nz++)
+
+                if (owner [sysmatrix->RowIndices [nz]] == part)
+
+                    nnz++ ;
+
+    if (system_matrix_build (dst, size, nnz, threads) == TDICE_FAILURE)
+    {
+        system_matrix_init (dst) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    nnz = 0 ;
+
+    dst->ColumnPointers [0] = 0 ;
+
+    for (column = 0u ; column != (CellIndex_t) sysmatrix->Size ; column++)
+    {
+        if (owner [column] != part)
+
+            continue ;
+
+        for (nz  = sysmatrix->ColumnPointers [column] ;
+             nz != sysmatrix->ColumnPointers [column + 1] ;
+             nz++)
+        {
+            CellIndex_t row = (CellIndex_t) sysmatrix->RowIndices [nz] ;
+
+            if (owner [row] != part)
+
+                continue ;
+
+            dst->RowIndices [nnz] = (LUIndex_t) map [row] ;
+            dst->Values     [nnz] = sysmatrix->Values [nz] ;
+
+            nnz++ ;
+        }
+
+        dst->ColumnPointers [++local] = nnz ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Marks the cells of every die stack element with the index of its instance.
+// The top layer of a die is left to the interface when another die lies
+// directly above it, so that interiors never touch each other.
+
+static Quantity_t mark_instances
+(
+    CellIndex_t        *owner,
+    CellIndex_t         size,
+    StackElementList_t *list,
+    Dimensions_t       *dimensions,
+    StackElement_t    **elements
+)
+{
+    StackElementListNode_t *stkeln ;
+    Quantity_t              ninstances = 0u ;
+    CellIndex_t             area       = get_layer_area (dimensions) ;
+    CellIndex_t             cell ;
+
+    for (cell = 0u ; cell != size ; cell++)
+
+        owner [cell] = INTERFACE_CELL ;
+
+    for (stkeln  = stack_element_list_end (list) ;
+         stkeln != NULL ;
+         stkeln  = stack_element_list_prev (stkeln))
+    {
+        StackElement_t *stkel = stack_element_list_data (stkeln) ;
+
+        if (stkel->SEType != TDICE_STACK_ELEMENT_DIE)
+
+            continue ;
+
+        CellIndex_t nlayers = stkel->NLayers ;
+
+        StackElementListNode_t *above = stack_element_list_prev (stkeln) ;
+
+        if (   above != NULL
+            && stack_element_list_data (above)->SEType == TDICE_STACK_ELEMENT_DIE)
+
+            nlayers-- ;
+
+        if (nlayers == 0u)
+
+            continue ;
+
+        for (cell  = stkel->Offset * area ;
+             cell != (stkel->Offset + nlayers) * area ;
+             cell++)
+
+            owner [cell] = ninstances ;
+
+        if (elements != NULL)
+
+            elements [ninstances] = stkel ;
+
+        ninstances++ ;
+    }
+
+    return ninstances ;
+}
+
+/******************************************************************************/
+
+static Error_t split_system_matrix
+(
+    Substructure_t *sub,
+    SystemMatrix_t *sysmatrix
+)
+{
+    CellIndex_t      *owner, *map ;
+    Quantity_t       *firsts ;
+    StackElement_t  **elements ;
+    Quantity_t        index, block ;
+    CellIndex_t       cell ;
+    LUIndex_t         nz ;
+    Error_t           result = TDICE_FAILURE ;
+    CellIndex_t       area   = get_layer_area (sub->Dimensions) ;
+
+    sub->Size = (CellIndex_t) sysmatrix->Size ;
+
+    owner    = (CellIndex_t *) malloc (sizeof (CellIndex_t) * sub->Size) ;
+    map      = (CellIndex_t *) malloc (sizeof (CellIndex_t) * sub->Size) ;
+    firsts   = (Quantity_t *)  malloc (sizeof (Quantity_t)  * sub->StackElements->Size) ;
+    elements = (StackElement_t **) malloc
+
+        (sizeof (StackElement_t *) * sub->StackElements->Size) ;
+
+    if (owner == NULL || map == NULL || firsts == NULL || elements == NULL)
+    {
+        fprintf (stderr, "Cannot malloc substructures\n") ;
+
+        goto free_maps ;
+    }
+
+    sub->NInstances = mark_instances
+
+        (owner, sub->Size, sub->StackElements, sub->Dimensions, elements) ;
+
+    sub->Instances = (SubstructureInstance_t *) calloc
+
+        (sub->NInstances + 1, sizeof (SubstructureInstance_t)) ;
+
+    sub->Blocks = (SubstructureBlock_t *) calloc
+
+        (sub->NInstances + 1, sizeof (SubstructureBlock_t)) ;
+
+    if (sub->Instances == NULL || sub->Blocks == NULL)
+    {
+        fprintf (stderr, "Cannot malloc substructures\n") ;
+
+        goto free_maps ;
+    }
+
+    /* Local indexes: interiors are contiguous, the interface is not */
+
+    for (cell = 0u ; cell != sub->Size ; cell++)
+    {
+        if (owner [cell] == INTERFACE_CELL)
+
+            map [cell] = sub->NInterface++ ;
+
+        else
+
+            map [cell] = cell - elements [owner [cell]]->Offset * area ;
+    }
+
+    /* Factorizes every distinct die and assigns the others to it */
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+
+        coupling_init (&instance->CouplingIn) ;
+        coupling_init (&instance->CouplingOut) ;
+
+        instance->FirstCell = elements [index]->Offset * area ;
+        instance->NCells    = 0u ;
+
+        for (cell = instance->FirstCell ;
+             cell != sub->Size && owner [cell] == index ; cell++)
+
+            instance->NCells++ ;
+
+        for (block = 0u ; block != sub->NBlocks ; block++)
+
+            if (   same_die (elements [index], elements [firsts [block]]) == true
+                && same_coefficients (sysmatrix, owner, instance, index,
+                                      &sub->Blocks [block].SM_A) == true)
+
+                break ;
+
+        if (block == sub->NBlocks)
+        {
+            firsts [block] = index ;
+
+            system_matrix_init (&sub->Blocks [block].SM_A) ;
+
+            if (extract_system_matrix
+
+                    (&sub->Blocks [block].SM_A, sysmatrix, owner, map,
+                     index, instance->NCells, sub->NThreads)
+
+                == TDICE_FAILURE)
+            {
+                fprintf (stderr, "Cannot malloc die system matrix\n") ;
+
+                goto free_maps ;
+            }
+
+            sub->NBlocks++ ;
+
+            if (do_factorization (&sub->Blocks [block].SM_A) == TDICE_FAILURE)
+
+                goto free_maps ;
+        }
+
+        instance->Block  = block ;
+        instance->Column = sub->Blocks [block].NInstances++ ;
+
+        instance->Interior = (Temperature_t *) malloc
+
+            (sizeof (Temperature_t) * instance->NCells) ;
+
+        if (instance->Interior == NULL)
+        {
+            fprintf (stderr, "Cannot malloc die temperatures\n") ;
+
+            goto free_maps ;
+        }
+    }
+
+    /* Collects the coefficients between interiors and interface */
+
+    for (cell = 0u ; cell != sub->Size ; cell++)
+
+        for (nz  = sysmatrix->ColumnPointers [cell] ;
+             nz != sysmatrix->ColumnPointers [cell + 1] ;
+             nz++)
+        {
+            CellIndex_t row = (CellIndex_t) sysmatrix->RowIndices [nz] ;
+
+            if (owner [row] == owner [cell])
+
+                continue ;
+
+            if (owner [row] != INTERFACE_CELL && owner [cell] != INTERFACE_CELL)
+            {
+                fprintf (stderr, "Substructuring: dies touching each other\n") ;
+
+                goto free_maps ;
+            }
+
+            if (owner [row] != INTERFACE_CELL)
+
+                sub->Instances [owner [row]].CouplingIn.NNz++ ;
+
+            else
+
+                sub->Instances [owner [cell]].CouplingOut.NNz++ ;
+        }
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+
+        if (   coupling_build (&sub->Instances [index].CouplingIn)  == TDICE_FAILURE
+            || coupling_build (&sub->Instances [index].CouplingOut) == TDICE_FAILURE)
+        {
+            fprintf (stderr, "Cannot malloc die couplings\n") ;
+
+            goto free_maps ;
+        }
+
+    for (cell = 0u ; cell != sub->Size ; cell++)
+
+        for (nz  = sysmatrix->ColumnPointers [cell] ;
+             nz != sysmatrix->ColumnPointers [cell + 1] ;
+             nz++)
+        {
+            CellIndex_t row = (CellIndex_t) sysmatrix->RowIndices [nz] ;
+
+            if (owner [row] == owner [cell])
+
+                continue ;
+
+            if (owner [row] != INTERFACE_CELL)
+
+                coupling_add (&sub->Instances [owner [row]].CouplingIn,
+                              map [row], map [cell], sysmatrix->Values [nz]) ;
+
+            else
+
+                coupling_add (&sub->Instances [owner [cell]].CouplingOut,
+                              map [row], map [cell], sysmatrix->Values [nz]) ;
+        }
+
+    /* Right hand sides of the dies, solved together */
+
+    for (block = 0u ; block != sub->NBlocks ; block++)
+    {
+        SubstructureBlock_t *sblock = &sub->Blocks [block] ;
+
+        sblock->Vectors = (double *) malloc
+
+            (sizeof (double) * sblock->SM_A.Size * sblock->NInstances) ;
+
+        if (sblock->Vectors == NULL)
+        {
+            fprintf (stderr, "Cannot malloc die vectors\n") ;
+
+            goto free_maps ;
+        }
+
+        dCreate_Dense_Matrix
+
+            (&sblock->SLUMatrix_B, sblock->SM_A.Size, sblock->NInstances,
+             sblock->Vectors, sblock->SM_A.Size,
+             SLU_DN, SLU_D, SLU_GE) ;
+    }
+
+    /* The interface and its own factorization (the preconditioner) */
+
+    if (sub->NInterface != 0u)
+    {
+        sub->InterfaceCells = (CellIndex_t *) malloc (sizeof (CellIndex_t) * sub->NInterface) ;
+        sub->Work           = (double *)      malloc (sizeof (double) * sub->NInterface) ;
+        sub->Solution       = (double *)      calloc (sub->NInterface, sizeof (double)) ;
+        sub->Krylov         = (double *)      malloc (sizeof (double) * sub->NInterface * 9) ;
+
+        if (   sub->InterfaceCells == NULL || sub->Work == NULL
+            || sub->Solution == NULL || sub->Krylov == NULL)
+        {
+            fprintf (stderr, "Cannot malloc interface vectors\n") ;
+
+            goto free_maps ;
+        }
+
+        for (cell = 0u ; cell != sub->Size ; cell++)
+
+            if (owner [cell] == INTERFACE_CELL)
+
+                sub->InterfaceCells [map [cell]] = cell ;
+
+        dCreate_Dense_Matrix
+
+            (&sub->SLUMatrix_Work, sub->NInterface, 1,
+             sub->Work, sub->NInterface,
+             SLU_DN, SLU_D, SLU_GE) ;
+
+        if (extract_system_matrix
+
+                (&sub->SM_Interface, sysmatrix, owner, map,
+                 INTERFACE_CELL, sub->NInterface, sub->NThreads)
+
+            == TDICE_FAILURE)
+        {
+            fprintf (stderr, "Cannot malloc interface system matrix\n") ;
+
+            goto free_maps ;
+        }
+
+        if (do_factorization (&sub->SM_Interface) == TDICE_FAILURE)
+
+            goto free_maps ;
+    }
+
+    result = TDICE_SUCCESS ;
+
+free_maps :
+
+    free (owner) ;
+    free (map) ;
+    free (firsts) ;
+    free (elements) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+Error_t substructure_build
+(
+    Substructure_t     *sub,
+    SystemMatrix_t     *sysmatrix,
+    StackElementList_t *list,
+    Dimensions_t       *dimensions,
+    CellIndex_t         threads
+)
+{
+    if (dimensions->NonUniform == 1)
+    {
+        fprintf (stderr, "Substructuring requires a uniform grid\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    sub->StackElements = list ;
+    sub->Dimensions    = dimensions ;
+    sub->NThreads      = threads ;
+
+    if (split_system_matrix (sub, sysmatrix) == TDICE_FAILURE)
+    {
+        substructure_destroy (sub) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t substructure_update (Substructure_t *sub, SystemMatrix_t *sysmatrix)
+{
+    StackElementList_t *list       = sub->StackElements ;
+    Dimensions_t       *dimensions = sub->Dimensions ;
+    CellIndex_t         threads    = sub->NThreads ;
+
+    substructure_destroy (sub) ;
+
+    return substructure_build (sub, sysmatrix, list, dimensions, threads) ;
+}
+
+/******************************************************************************/
+
+void substructure_destroy (Substructure_t *sub)
+{
+    Quantity_t index ;
+
+    if (sub->Instances != NULL)
+
+        for (index = 0u ; index != sub->NInstances ; index++)
+        {
+            coupling_destroy (&sub->Instances [index].CouplingIn) ;
+            coupling_destroy (&sub->Instances [index].CouplingOut) ;
+
+            free (sub->Instances [index].Interior) ;
+        }
+
+    if (sub->Blocks != NULL)
+
+        for (index = 0u ; index != sub->NBlocks ; index++)
+        {
+            system_matrix_destroy (&sub->Blocks [index].SM_A) ;
+
+            if (sub->Blocks [index].SLUMatrix_B.Store != NULL)
+
+                Destroy_SuperMatrix_Store (&sub->Blocks [index].SLUMatrix_B) ;
+
+            free (sub->Blocks [index].Vectors) ;
+        }
+
+    if (sub->SLUMatrix_Work.Store != NULL)
+
+        Destroy_SuperMatrix_Store (&sub->SLUMatrix_Work) ;
+
+    if (sub->SM_Interface.Size != 0)
+
+        system_matrix_destroy (&sub->SM_Interface) ;
+
+    free (sub->Instances) ;
+    free (sub->Blocks) ;
+    free (sub->InterfaceCells) ;
+    free (sub->Work) ;
+    free (sub->Solution) ;
+    free (sub->Krylov) ;
+
+    substructure_init (sub) ;
+}
+
+/******************************************************************************/
+
+// Solves the interior of every die with the vectors already stored in
+// the blocks. All the instances of a block are solved with a single call.
+
+static Error_t solve_blocks (Substructure_t *sub)
+{
+    Quantity_t block ;
+    Quantity_t failures = 0u ;
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+    for (block = 0u ; block < sub->NBlocks ; block++)
+
+        if (solve_sparse_linear_system_concurrent
+
+                (&sub->Blocks [block].SM_A, &sub->Blocks [block].SLUMatrix_B)
+
+            != TDICE_SUCCESS)
+
+            failures++ ;
+
+    return failures == 0u ? TDICE_SUCCESS : TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+static double *instance_vector (Substructure_t *sub, SubstructureInstance_t *instance)
+{
+    return   sub->Blocks [instance->Block].Vectors
+           + instance->Column * instance->NCells ;
+}
+
+/******************************************************************************/
+
+// out = S in, with S = A_BB - sum_i A_Bi inv(A_ii) A_iB
+
+static Error_t apply_schur_complement (Substructure_t *sub, double *in, double *out)
+{
+    SystemMatrix_t *interface = &sub->SM_Interface ;
+    Quantity_t      index, nz ;
+    CellIndex_t     column ;
+    LUIndex_t       lnz ;
+
+    memset (out, 0, sizeof (double) * sub->NInterface) ;
+
+    for (column = 0u ; column != sub->NInterface ; column++)
+
+        for (lnz  = interface->ColumnPointers [column] ;
+             lnz != interface->ColumnPointers [column + 1] ;
+             lnz++)
+
+            out [interface->RowIndices [lnz]] += interface->Values [lnz] * in [column] ;
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+        SubstructureCoupling_t *coupling = &instance->CouplingIn ;
+        double                 *vector   = instance_vector (sub, instance) ;
+
+        memset (vector, 0, sizeof (double) * instance->NCells) ;
+
+        for (nz = 0u ; nz != coupling->NNz ; nz++)
+
+            vector [coupling->Rows [nz]] += coupling->Values [nz] * in [coupling->Columns [nz]] ;
+    }
+
+    if (solve_blocks (sub) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+        SubstructureCoupling_t *coupling = &instance->CouplingOut ;
+        double                 *vector   = instance_vector (sub, instance) ;
+
+        for (nz = 0u ; nz != coupling->NNz ; nz++)
+
+            out [coupling->Rows [nz]] -= coupling->Values [nz] * vector [coupling->Columns [nz]] ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// out = inv(A_BB) in
+
+static Error_t apply_preconditioner (Substructure_t *sub, double *in, double *out)
+{
+    memcpy (sub->Work, in, sizeof (double) * sub->NInterface) ;
+
+    if (solve_sparse_linear_system (&sub->SM_Interface, &sub->SLUMatrix_Work) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    memcpy (out, sub->Work, sizeof (double) * sub->NInterface) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static double dot_product (double *x, double *y, CellIndex_t size)
+{
+    CellIndex_t index ;
+    double      result = 0.0 ;
+
+    for (index = 0u ; index != size ; index++)
+
+        result += x [index] * y [index] ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Solves S x = g with BiCGSTAB (right preconditioned). The solution of the
+// previous call is used as initial guess.
+
+static Error_t solve_interface (Substructure_t *sub, double *g)
+{
+    CellIndex_t n = sub->NInterface ;
+    CellIndex_t index ;
+    Quantity_t  iteration ;
+
+    double *x    = sub->Solution ;
+    double *r    = sub->Krylov ;
+    double *r0   = sub->Krylov + n ;
+    double *p    = sub->Krylov + n * 2 ;
+    double *v    = sub->Krylov + n * 3 ;
+    double *s    = sub->Krylov + n * 4 ;
+    double *t    = sub->Krylov + n * 5 ;
+    double *phat = sub->Krylov + n * 6 ;
+    double *shat = sub->Krylov + n * 7 ;
+
+    double rho = 1.0, alpha = 1.0, omega = 1.0 ;
+    double norm_g = sqrt (dot_product (g, g, n)) ;
+
+    sub->NIterations = 0u ;
+
+    if (norm_g == 0.0)
+    {
+        memset (x, 0, sizeof (double) * n) ;
+
+        return TDICE_SUCCESS ;
+    }
+
+    if (apply_schur_complement (sub, x, t) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    for (index = 0u ; index != n ; index++)
+    {
+        r  [index] = g [index] - t [index] ;
+        r0 [index] = r [index] ;
+        p  [index] = 0.0 ;
+        v  [index] = 0.0 ;
+    }
+
+    for (iteration = 0u ; iteration != INTERFACE_MAX_ITERATIONS ; iteration++)
+    {
+        if (sqrt (dot_product (r, r, n)) / norm_g < INTERFACE_TOLERANCE)
+
+            break ;
+
+        double rho_new = dot_product (r0, r, n) ;
+
+        if (rho_new == 0.0)
+
+            break ;
+
+        double beta = (rho_new / rho) * (alpha / omega) ;
+
+        for (index = 0u ; index != n ; index++)
+
+            p [index] = r [index] + beta * (p [index] - omega * v [index]) ;
+
+        if (   apply_preconditioner   (sub, p, phat) == TDICE_FAILURE
+            || apply_schur_complement (sub, phat, v) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        alpha = rho_new / dot_product (r0, v, n) ;
+
+        for (index = 0u ; index != n ; index++)
+
+            s [index] = r [index] - alpha * v [index] ;
+
+        if (   apply_preconditioner   (sub, s, shat) == TDICE_FAILURE
+            || apply_schur_complement (sub, shat, t) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        double tt = dot_product (t, t, n) ;
+
+        omega = tt != 0.0 ? dot_product (t, s, n) / tt : 0.0 ;
+
+        for (index = 0u ; index != n ; index++)
+        {
+            x [index] += alpha * phat [index] + omega * shat [index] ;
+            r [index]  = s [index] - omega * t [index] ;
+        }
+
+        rho = rho_new ;
+
+        sub->NIterations++ ;
+
+        if (omega == 0.0)
+
+            break ;
+    }
+
+    if (sqrt (dot_product (r, r, n)) / norm_g >= INTERFACE_TOLERANCE)
+    {
+        fprintf (stderr,
+            "Substructuring: interface did not converge in %d iterations\n",
+            sub->NIterations) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t substructure_solve (Substructure_t *sub, double *b)
+{
+    Quantity_t  index, nz ;
+    CellIndex_t cell ;
+
+    /* y_i = inv(A_ii) b_i */
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+
+        memcpy (instance_vector (sub, instance), b + instance->FirstCell,
+                sizeof (double) * instance->NCells) ;
+    }
+
+    if (solve_blocks (sub) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+
+        memcpy (instance->Interior, instance_vector (sub, instance),
+                sizeof (double) * instance->NCells) ;
+    }
+
+    if (sub->NInterface != 0u)
+    {
+        /* g = b_B - sum_i A_Bi y_i (stored in the last Krylov vector) */
+
+        double *g = sub->Krylov + sub->NInterface * 8 ;
+
+        for (cell = 0u ; cell != sub->NInterface ; cell++)
+
+            g [cell] = b [sub->InterfaceCells [cell]] ;
+
+        for (index = 0u ; index != sub->NInstances ; index++)
+        {
+            SubstructureInstance_t *instance = &sub->Instances [index] ;
+            SubstructureCoupling_t *coupling = &instance->CouplingOut ;
+
+            for (nz = 0u ; nz != coupling->NNz ; nz++)
+
+                g [coupling->Rows [nz]] -=
+
+                    coupling->Values [nz] * instance->Interior [coupling->Columns [nz]] ;
+        }
+
+        /* S x_B = g */
+
+        if (solve_interface (sub, g) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        /* x_i = y_i - inv(A_ii) A_iB x_B */
+
+        for (index = 0u ; index != sub->NInstances ; index++)
+        {
+            SubstructureInstance_t *instance = &sub->Instances [index] ;
+            SubstructureCoupling_t *coupling = &instance->CouplingIn ;
+            double                 *vector   = instance_vector (sub, instance) ;
+
+            memset (vector, 0, sizeof (double) * instance->NCells) ;
+
+            for (nz = 0u ; nz != coupling->NNz ; nz++)
+
+                vector [coupling->Rows [nz]] +=
+
+                    coupling->Values [nz] * sub->Solution [coupling->Columns [nz]] ;
+        }
+
+        if (solve_blocks (sub) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+
+        for (index = 0u ; index != sub->NInstances ; index++)
+        {
+            SubstructureInstance_t *instance = &sub->Instances [index] ;
+            double                 *vector   = instance_vector (sub, instance) ;
+
+            for (cell = 0u ; cell != instance->NCells ; cell++)
+
+                instance->Interior [cell] -= vector [cell] ;
+        }
+    }
+
+    for (index = 0u ; index != sub->NInstances ; index++)
+    {
+        SubstructureInstance_t *instance = &sub->Instances [index] ;
+
+        memcpy (b + instance->FirstCell, instance->Interior,
+                sizeof (double) * instance->NCells) ;
+    }
+
+    for (cell = 0u ; cell != sub->NInterface ; cell++)
+
+        b [sub->InterfaceCells [cell]] = sub->Solution [cell] ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
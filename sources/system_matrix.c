@@ -472,6 +472,34 @@ Error_t do_factorization (SystemMatrix_t *sysmatrix)
 
 /******************************************************************************/
 
+size_t system_matrix_memory (SystemMatrix_t *sysmatrix)
+{
+    size_t n = sysmatrix->Size ;
+
+    if (sysmatrix->Values == NULL)
+
+        return 0u ;
+
+    // The coefficients of A, the permutations and the elimination tree
+
+    size_t memory =   sysmatrix->NNz * (sizeof (SystemMatrixCoeff_t) + sizeof (LUIndex_t))
+                    + (n + 1) * sizeof (LUIndex_t)
+                    + 5 * n * sizeof (int_t) ;
+
+    // The factors use only a part of the memory allocated for them (the
+    // growth factor of SuperLU is an upper bound): the rest is never touched
+
+    if (sysmatrix->SLUMatrix_L.Store != NULL && sysmatrix->SLUMatrix_U.Store != NULL)
+
+        memory +=   ((SCPformat *) sysmatrix->SLUMatrix_L.Store)->nnz * (sizeof (double) + sizeof (int_t))
+                  + ((NCPformat *) sysmatrix->SLUMatrix_U.Store)->nnz * (sizeof (double) + sizeof (int_t))
+                  + 8 * (n + 1) * sizeof (int_t) ;
+
+    return memory ;
+}
+
+/******************************************************************************/
+
 void system_matrix_destroy (SystemMatrix_t *sysmatrix)
 {
     free (sysmatrix->ColumnPointers) ;
@@ -2037,6 +2065,15 @@ skip_west :
     {
         *sysmatrix.Values = get_spreader_capacity(sink) / analysis->StepTime;
     }
+    else
+    {
+        // In steady state the heat flows of the heat sink are evaluated
+        // explicitly: the conductance between the center of the cell and
+        // its top face keeps the system non singular and the same term,
+        // times the last spreader temperature, is added to the rhs
+
+        *sysmatrix.Values = get_spreader_conductance_top_bottom(sink);
+    }
     
     diagonal_pointer = sysmatrix.Values++ ;
 
@@ -2122,194 +2159,222 @@ skip_north :
 
 /******************************************************************************/
 
-void fill_system_matrix
+// Adds the columns of the cells within the rows and columns given (all the
+// layers). Cells are visited in the same order used to number them.
+
+static SystemMatrix_t add_layers_columns
 (
-    SystemMatrix_t *sysmatrix,
+    SystemMatrix_t  sysmatrix,
     ThermalGrid_t  *thermal_grid,
     Analysis_t     *analysis,
-    Dimensions_t   *dimensions
+    Dimensions_t   *dimensions,
+    CellIndex_t     from_row,
+    CellIndex_t     to_row,
+    CellIndex_t     from_column,
+    CellIndex_t     to_column
 )
 {
-// #define PRINT_SYSTEM_MATRIX 1
-#ifdef PRINT_SYSTEM_MATRIX
-    fprintf (stderr,
-        "fill_system_matrix ( l %d r %d c %d )\n",
-        get_number_of_layers  (dimensions),
-        get_number_of_rows    (dimensions),
-        get_number_of_columns (dimensions)) ;
-#endif
+    SystemMatrix_t tmp_matrix = sysmatrix ;
 
-    SystemMatrix_t tmp_matrix ;
+    CellIndex_t lindex ;
 
-    tmp_matrix.Size = sysmatrix->Size ;
-    tmp_matrix.NNz  = sysmatrix->NNz ;
+    for (lindex = 0u ; lindex != thermal_grid->NLayers ; lindex++)
+    {
+        switch (thermal_grid->LayersTypeProfile [lindex])
+        {
+            case TDICE_LAYER_SOLID :
+            case TDICE_LAYER_SOURCE :
+            case TDICE_LAYER_SOLID_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
+            case TDICE_LAYER_SOLID_CONNECTED_TO_SPREADER :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
+            case TDICE_LAYER_SOLID_CONNECTED_TO_PCB :
+            case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
+            {
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-    tmp_matrix.ColumnPointers = sysmatrix->ColumnPointers ;
-    tmp_matrix.RowIndices     = sysmatrix->RowIndices ;
-    tmp_matrix.Values         = sysmatrix->Values ;
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
+                    {
+                        tmp_matrix = add_solid_column
 
-    tmp_matrix.ColumnPointers[0] = 0u ;
+                            (tmp_matrix, thermal_grid, analysis, dimensions,
+                            lindex, row, column) ;
 
-    tmp_matrix.ColumnPointers++ ;
+                    } // FOR_EVERY_COLUMN
+                } // FOR_EVERY_ROW
 
-    if(dimensions->NonUniform==1)
-    {
-        tmp_matrix = add_solid_column_non_uniform(tmp_matrix, thermal_grid, analysis, dimensions) ;
-    }
-    else
-    {
-        CellIndex_t lindex ;
-
-        for (lindex = 0u ; lindex != thermal_grid->NLayers ; lindex++)
-        {
-            switch (thermal_grid->LayersTypeProfile [lindex])
+                break ;
+            }
+            case TDICE_LAYER_CHANNEL_4RM :
             {
-                case TDICE_LAYER_SOLID :
-                case TDICE_LAYER_SOURCE :
-                case TDICE_LAYER_SOLID_CONNECTED_TO_AMBIENT :
-                case TDICE_LAYER_SOURCE_CONNECTED_TO_AMBIENT :
-                case TDICE_LAYER_SOLID_CONNECTED_TO_SPREADER :
-                case TDICE_LAYER_SOURCE_CONNECTED_TO_SPREADER :
-                case TDICE_LAYER_SOLID_CONNECTED_TO_PCB :
-                case TDICE_LAYER_SOURCE_CONNECTED_TO_PCB :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
                     {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
+                        if (IS_CHANNEL_COLUMN (thermal_grid->Channel->ChannelModel, column) == true)
+
+                            tmp_matrix = add_liquid_column_4rm
+
+                                (tmp_matrix, thermal_grid, analysis, dimensions,
+                                lindex, row, column) ;
+
+                        else
+
                             tmp_matrix = add_solid_column
 
                                 (tmp_matrix, thermal_grid, analysis, dimensions,
                                 lindex, row, column) ;
 
-                        } // FOR_EVERY_COLUMN
-                    } // FOR_EVERY_ROW
+                    } // FOR_EVERY_COLUMN
+                }  // FOR_EVERY_ROW
 
-                    break ;
-                }
-                case TDICE_LAYER_CHANNEL_4RM :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+                break ;
+            }
+            case TDICE_LAYER_CHANNEL_2RM :
+            case TDICE_LAYER_PINFINS_INLINE :
+            case TDICE_LAYER_PINFINS_STAGGERED :
+            {
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
                     {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
-                            if (IS_CHANNEL_COLUMN (thermal_grid->Channel->ChannelModel, column) == true)
+                        tmp_matrix = add_liquid_column_2rm
 
-                                tmp_matrix = add_liquid_column_4rm
+                            (tmp_matrix, thermal_grid, analysis, dimensions,
+                            lindex, row, column) ;
 
-                                    (tmp_matrix, thermal_grid, analysis, dimensions,
-                                    lindex, row, column) ;
+                    } // FOR_EVERY_COLUMN
+                }  // FOR_EVERY_ROW
 
-                            else
+                break ;
+            }
+            case TDICE_LAYER_VWALL_CHANNEL :
+            case TDICE_LAYER_VWALL_PINFINS :
+            {
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-                                tmp_matrix = add_solid_column
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
+                    {
+                        tmp_matrix = add_virtual_wall_column_2rm
 
-                                    (tmp_matrix, thermal_grid, analysis, dimensions,
-                                    lindex, row, column) ;
+                            (tmp_matrix, thermal_grid, analysis, dimensions,
+                            thermal_grid->Channel->ChannelModel,
+                            lindex, row, column) ;
 
-                        } // FOR_EVERY_COLUMN
-                    }  // FOR_EVERY_ROW
+                    } // FOR_EVERY_COLUMN
+                }  // FOR_EVERY_ROW
 
-                    break ;
-                }
-                case TDICE_LAYER_CHANNEL_2RM :
-                case TDICE_LAYER_PINFINS_INLINE :
-                case TDICE_LAYER_PINFINS_STAGGERED :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+                break ;
+            }
+            case TDICE_LAYER_TOP_WALL :
+            {
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
                     {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
-                            tmp_matrix = add_liquid_column_2rm
+                        tmp_matrix = add_top_wall_column_2rm
 
-                                (tmp_matrix, thermal_grid, analysis, dimensions,
-                                lindex, row, column) ;
+                            (tmp_matrix, thermal_grid, analysis, dimensions,
+                            lindex, row, column) ;
 
-                        } // FOR_EVERY_COLUMN
-                    }  // FOR_EVERY_ROW
+                    } // FOR_EVERY_COLUMN
+                }  // FOR_EVERY_ROW
 
-                    break ;
-                }
-                case TDICE_LAYER_VWALL_CHANNEL :
-                case TDICE_LAYER_VWALL_PINFINS :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+                break ;
+            }
+            case TDICE_LAYER_BOTTOM_WALL :
+            {
+                CellIndex_t row ;
+                CellIndex_t column ;
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+                for (row = from_row ; row <= to_row ; row++)
+                {
+                    for (column = from_column ; column <= to_column ; column++)
                     {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
-                            tmp_matrix = add_virtual_wall_column_2rm
+                        tmp_matrix = add_bottom_wall_column_2rm
 
-                                (tmp_matrix, thermal_grid, analysis, dimensions,
-                                thermal_grid->Channel->ChannelModel,
-                                lindex, row, column) ;
+                            (tmp_matrix, thermal_grid, analysis, dimensions,
+                            lindex, row, column) ;
 
-                        } // FOR_EVERY_COLUMN
-                    }  // FOR_EVERY_ROW
+                    } // FOR_EVERY_COLUMN
+                }  // FOR_EVERY_ROW
+                break ;
 
-                    break ;
-                }
-                case TDICE_LAYER_TOP_WALL :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+            }
+            case TDICE_LAYER_NONE :
+            {
+                fprintf (stderr, "ERROR: unset layer type\n") ;
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
-                    {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
-                            tmp_matrix = add_top_wall_column_2rm
+                break ;
+            }
+            default :
 
-                                (tmp_matrix, thermal_grid, analysis, dimensions,
-                                lindex, row, column) ;
+                fprintf (stderr, "ERROR: unknown layer type %d\n", thermal_grid->LayersTypeProfile [lindex]) ;
+        }
 
-                        } // FOR_EVERY_COLUMN
-                    }  // FOR_EVERY_ROW
+    }
 
-                    break ;
-                }
-                case TDICE_LAYER_BOTTOM_WALL :
-                {
-                    CellIndex_t row ;
-                    CellIndex_t column ;
+    return tmp_matrix ;
+}
 
-                    for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
-                    {
-                        for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                        {
-                            tmp_matrix = add_bottom_wall_column_2rm
+/******************************************************************************/
 
-                                (tmp_matrix, thermal_grid, analysis, dimensions,
-                                lindex, row, column) ;
+void fill_system_matrix
+(
+    SystemMatrix_t *sysmatrix,
+    ThermalGrid_t  *thermal_grid,
+    Analysis_t     *analysis,
+    Dimensions_t   *dimensions
+)
+{
+// #define PRINT_SYSTEM_MATRIX 1
+#ifdef PRINT_SYSTEM_MATRIX
+    fprintf (stderr,
+        "fill_system_matrix ( l %d r %d c %d )\n",
+        get_number_of_layers  (dimensions),
+        get_number_of_rows    (dimensions),
+        get_number_of_columns (dimensions)) ;
+#endif
 
-                        } // FOR_EVERY_COLUMN
-                    }  // FOR_EVERY_ROW
-                    break ;
+    SystemMatrix_t tmp_matrix ;
 
-                }
-                case TDICE_LAYER_NONE :
-                {
-                    fprintf (stderr, "ERROR: unset layer type\n") ;
+    tmp_matrix.Size = sysmatrix->Size ;
+    tmp_matrix.NNz  = sysmatrix->NNz ;
 
-                    break ;
-                }
-                default :
+    tmp_matrix.ColumnPointers = sysmatrix->ColumnPointers ;
+    tmp_matrix.RowIndices     = sysmatrix->RowIndices ;
+    tmp_matrix.Values         = sysmatrix->Values ;
 
-                    fprintf (stderr, "ERROR: unknown layer type %d\n", thermal_grid->LayersTypeProfile [lindex]) ;
-            }
+    tmp_matrix.ColumnPointers[0] = 0u ;
 
-        }
+    tmp_matrix.ColumnPointers++ ;
+
+    if(dimensions->NonUniform==1)
+    {
+        tmp_matrix = add_solid_column_non_uniform(tmp_matrix, thermal_grid, analysis, dimensions) ;
+    }
+    else
+    {
+        tmp_matrix = add_layers_columns
+
+            (tmp_matrix, thermal_grid, analysis, dimensions,
+             first_row (dimensions), last_row (dimensions),
+             first_column (dimensions), last_column (dimensions)) ;
 
         if(thermal_grid->TopHeatSink && thermal_grid->TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
         {
@@ -2333,6 +2398,39 @@ void fill_system_matrix
 
 /******************************************************************************/
 
+void fill_system_matrix_window
+(
+    SystemMatrix_t *sysmatrix,
+    ThermalGrid_t  *thermal_grid,
+    Analysis_t     *analysis,
+    Dimensions_t   *dimensions,
+    CellIndex_t     from_row,
+    CellIndex_t     to_row,
+    CellIndex_t     from_column,
+    CellIndex_t     to_column
+)
+{
+    SystemMatrix_t tmp_matrix ;
+
+    tmp_matrix.Size = sysmatrix->Size ;
+    tmp_matrix.NNz  = sysmatrix->NNz ;
+
+    tmp_matrix.ColumnPointers = sysmatrix->ColumnPointers ;
+    tmp_matrix.RowIndices     = sysmatrix->RowIndices ;
+    tmp_matrix.Values         = sysmatrix->Values ;
+
+    tmp_matrix.ColumnPointers[0] = 0u ;
+
+    tmp_matrix.ColumnPointers++ ;
+
+    add_layers_columns
+
+        (tmp_matrix, thermal_grid, analysis, dimensions,
+         from_row, to_row, from_column, to_column) ;
+}
+
+/******************************************************************************/
+
 Error_t solve_sparse_linear_system (SystemMatrix_t *sysmatrix, SuperMatrix *b)
 {
     dgstrs
@@ -2354,6 +2452,37 @@ Error_t solve_sparse_linear_system (SystemMatrix_t *sysmatrix, SuperMatrix *b)
 
 /******************************************************************************/
 
+Error_t solve_sparse_linear_system_concurrent (SystemMatrix_t *sysmatrix, SuperMatrix *b)
+{
+    // dgstrs only writes the number of operations of the triangular solve
+    // into the statistics, so a shallow copy with a private ops array is
+    // enough to avoid races on the shared structure
+
+    Gstat_t  gstat = sysmatrix->SLU_MT_Gstat ;
+    flops_t  ops [NPHASES] ;
+    int_t    info = 0 ;
+
+    gstat.ops = ops ;
+
+    dgstrs
+
+        (sysmatrix->SLU_Options.trans, &sysmatrix->SLUMatrix_L, &sysmatrix->SLUMatrix_U,
+         sysmatrix->SLU_Options.perm_r, sysmatrix->SLU_Options.perm_c,
+         b, &gstat, &info) ;
+
+    if (info < 0)
+    {
+        fprintf (stderr,
+            "Error (%ld) while solving linear system\n", info) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
 void system_matrix_print (SystemMatrix_t sysmatrix, String_t file_name)
 {
     FILE* file = fopen (file_name, "w") ;
@@ -37,6 +37,8 @@
  ******************************************************************************/
 
 #include <stdio.h> // For the file type FILE
+#include <string.h> // For the memory function memcpy
+#include <math.h>   // For the math function fabs
 #include <omp.h>
 #include "thermal_data.h"
 #include "macros.h"
@@ -61,8 +63,17 @@ void thermal_data_init (ThermalData_t *tdata)
     thermal_grid_init  (&tdata->ThermalGrid) ;
     power_grid_init    (&tdata->PowerGrid) ;
     system_matrix_init (&tdata->SM_A) ;
+    substructure_init  (&tdata->Substructure) ;
 
     tdata->SLUMatrix_B.Store = NULL ;
+
+    tdata->LeakageVector = NULL ;
+
+    tdata->InitialTemperatures = NULL ;
+
+    tdata->Shared = false ;
+
+    tdata->Phases = NULL ;
 }
 
 /******************************************************************************/
@@ -1030,6 +1041,12 @@ void get_connections_between_layer
 
 /******************************************************************************/
 
+static Error_t initialize_steady_state
+
+    (ThermalData_t *tdata, Dimensions_t *dimensions, Analysis_t *analysis) ;
+
+/******************************************************************************/
+
 Error_t thermal_data_build
 (
     ThermalData_t      *tdata,
@@ -1038,11 +1055,33 @@ Error_t thermal_data_build
     Analysis_t         *analysis,
     MaterialList_t     *materials
 )
+{
+    Error_t result = thermal_data_assemble
+
+        (tdata, stack_elements_list, dimensions, analysis, materials) ;
+
+    if (result == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    return thermal_data_factorize (tdata, stack_elements_list, dimensions, analysis) ;
+}
+
+/******************************************************************************/
+
+Error_t thermal_data_assemble
+(
+    ThermalData_t      *tdata,
+    StackElementList_t *stack_elements_list,
+    Dimensions_t       *dimensions,
+    Analysis_t         *analysis,
+    MaterialList_t     *materials
+)
 {
     Error_t result ;
 
     /// Present time consumption
-    struct timespec start, node1, end;
+    struct timespec start, node1;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
     set_parallel_cores(analysis->NumOfCores);
@@ -1170,6 +1209,59 @@ Error_t thermal_data_build
 
         (&tdata->PowerGrid, &tdata->ThermalGrid, stack_elements_list, dimensions) ;
 
+    // The pluggable heat sink works on the spreader cells in place
+
+    if (   tdata->ThermalGrid.TopHeatSink != NULL
+        && tdata->ThermalGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+    {
+        CellIndex_t offset = get_spreader_cell_offset
+
+            (dimensions, tdata->ThermalGrid.TopHeatSink, 0, 0) ;
+
+        result = register_pluggable_heatsink_buffers
+
+            (tdata->ThermalGrid.TopHeatSink,
+             tdata->Temperatures + offset, tdata->PowerGrid.Sources + offset) ;
+
+        if (result == TDICE_FAILURE)
+        {
+            fprintf (stderr, "Cannot initialize the pluggable heat sink\n") ;
+
+            Destroy_SuperMatrix_Store (&tdata->SLUMatrix_B) ;
+
+            free (tdata->Temperatures) ;
+
+            thermal_grid_destroy (&tdata->ThermalGrid) ;
+            power_grid_destroy   (&tdata->PowerGrid) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    // The initial steady state converges the leakage power as
+    // steady state simulations do
+
+    if (   tdata->PowerGrid.NLeakages != 0u
+        && (   analysis->LeakageIterations > 1u
+            || analysis->InitialState != TDICE_INITIAL_STATE_UNIFORM))
+    {
+        tdata->LeakageVector = (double *) malloc (sizeof (double) * tdata->Size) ;
+
+        if (tdata->LeakageVector == NULL)
+        {
+            fprintf (stderr, "Cannot malloc leakage vector\n") ;
+
+            Destroy_SuperMatrix_Store (&tdata->SLUMatrix_B) ;
+
+            free (tdata->Temperatures) ;
+
+            thermal_grid_destroy (&tdata->ThermalGrid) ;
+            power_grid_destroy   (&tdata->PowerGrid) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
     /// Present time consumption for test
     //fprintf (stdout, "  (1.4) thermal_grid_fill + power_grid_fill took %.5f sec\n",
     //    ( (double)clock() - Time1 ) / CLOCKS_PER_SEC ) ;
@@ -1188,6 +1280,7 @@ Error_t thermal_data_build
         Destroy_SuperMatrix_Store (&tdata->SLUMatrix_B) ;
 
         free (tdata->Temperatures) ;
+        free (tdata->LeakageVector) ;
 
         thermal_grid_destroy (&tdata->ThermalGrid) ;
         power_grid_destroy   (&tdata->PowerGrid) ;
@@ -1209,11 +1302,50 @@ Error_t thermal_data_build
     clock_gettime(CLOCK_MONOTONIC, &node1);
     fprintf (stdout, "\nPreparing thermal data took %.5f sec\n\n",
         (node1.tv_sec - start.tv_sec) + (node1.tv_nsec - start.tv_nsec) / 1e9 ) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t thermal_data_factorize
+(
+    ThermalData_t      *tdata,
+    StackElementList_t *stack_elements_list,
+    Dimensions_t       *dimensions,
+    Analysis_t         *analysis
+)
+{
+    Error_t result ;
+
+    /// Present time consumption
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
     //numofthreads = 50;
     //omp_set_num_threads(numofthreads);
 
-    result = do_factorization (&tdata->SM_A) ;
+    if (   analysis->AnalysisType == TDICE_ANALYSIS_TYPE_TRANSIENT
+        && analysis->InitialState != TDICE_INITIAL_STATE_UNIFORM)
+    {
+        if (initialize_steady_state (tdata, dimensions, analysis) == TDICE_FAILURE)
+        {
+            thermal_data_destroy (tdata) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    if (analysis->Substructuring == true)
+
+        result = substructure_build
+
+            (&tdata->Substructure, &tdata->SM_A, stack_elements_list,
+             dimensions, analysis->NumOfCores) ;
+
+    else
+
+        result = do_factorization (&tdata->SM_A) ;
 
     if (result == TDICE_FAILURE)
     {
@@ -1222,6 +1354,12 @@ Error_t thermal_data_build
         return TDICE_FAILURE ;
     }
 
+    if (analysis->Substructuring == true)
+
+        fprintf (stdout, "Substructuring: %d dies, %d factorized, %d interface cells\n",
+            tdata->Substructure.NInstances, tdata->Substructure.NBlocks,
+            tdata->Substructure.NInterface) ;
+
     /// Present time consumption for test
     clock_gettime(CLOCK_MONOTONIC, &end);
     fprintf (stdout, "Factorization took %.5f sec\n",
@@ -1249,14 +1387,153 @@ Error_t set_parallel_cores (Quantity_t num)
 
 /******************************************************************************/
 
+Error_t thermal_data_share
+(
+    ThermalData_t *tdata,
+    ThermalData_t *shared,
+    Analysis_t    *analysis
+)
+{
+    CellIndex_t layer ;
+
+    if (shared->Substructure.Size != 0u)
+    {
+        fprintf (stderr, "Substructuring cannot be shared between sessions\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (   shared->PowerGrid.TopHeatSink != NULL
+        && shared->PowerGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+    {
+        fprintf (stderr, "A pluggable heat sink cannot be shared between sessions\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    // Everything is shared but the private fields, allocated below
+
+    *tdata = *shared ;
+
+    tdata->Shared                      = true ;
+    tdata->Temperatures                = NULL ;
+    tdata->LeakageVector               = NULL ;
+    tdata->PowerGrid.Sources           = NULL ;
+    tdata->PowerGrid.FloorplansProfile = NULL ;
+    tdata->SLUMatrix_B.Store           = NULL ;
+
+    tdata->Temperatures = (Temperature_t *) malloc (sizeof (Temperature_t) * tdata->Size) ;
+
+    tdata->PowerGrid.Sources = (Source_t *) malloc (sizeof (Source_t) * tdata->Size) ;
+
+    tdata->PowerGrid.FloorplansProfile = (Floorplan_t **) calloc
+
+        (tdata->PowerGrid.NLayers, sizeof (Floorplan_t *)) ;
+
+    if (shared->LeakageVector != NULL)
+
+        tdata->LeakageVector = (double *) malloc (sizeof (double) * tdata->Size) ;
+
+    if (   tdata->Temperatures == NULL
+        || tdata->PowerGrid.Sources == NULL
+        || tdata->PowerGrid.FloorplansProfile == NULL
+        || (shared->LeakageVector != NULL && tdata->LeakageVector == NULL))
+    {
+        fprintf (stderr, "Cannot malloc session thermal data\n") ;
+
+        thermal_data_destroy (tdata) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    reset_thermal_state (tdata, analysis) ;
+
+    memcpy (tdata->PowerGrid.Sources, shared->PowerGrid.Sources,
+            sizeof (Source_t) * tdata->Size) ;
+
+    // The power queues and the leakage state are in the floorplans
+
+    for (layer = 0u ; layer != tdata->PowerGrid.NLayers ; layer++)
+    {
+        if (shared->PowerGrid.FloorplansProfile [layer] == NULL)
+
+            continue ;
+
+        tdata->PowerGrid.FloorplansProfile [layer] =
+
+            floorplan_clone (shared->PowerGrid.FloorplansProfile [layer]) ;
+
+        if (tdata->PowerGrid.FloorplansProfile [layer] == NULL)
+        {
+            fprintf (stderr, "Cannot malloc session floorplan\n") ;
+
+            thermal_data_destroy (tdata) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    dCreate_Dense_Matrix  /* Vector B */
+
+        (&tdata->SLUMatrix_B, tdata->Size, 1,
+         tdata->Temperatures, tdata->Size,
+         SLU_DN, SLU_D, SLU_GE) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+size_t thermal_data_memory (ThermalData_t *tdata)
+{
+    size_t memory = tdata->Size * (sizeof (Temperature_t) + sizeof (Source_t)) ;
+
+    if (tdata->LeakageVector != NULL)
+
+        memory += tdata->Size * sizeof (double) ;
+
+    if (tdata->InitialTemperatures != NULL)
+
+        memory += tdata->Size * sizeof (Temperature_t) ;
+
+    return memory + system_matrix_memory (&tdata->SM_A) ;
+}
+
+/******************************************************************************/
+
 void thermal_data_destroy (ThermalData_t *tdata)
 {
+    if (tdata->Shared == true)
+    {
+        CellIndex_t layer ;
+
+        if (tdata->PowerGrid.FloorplansProfile != NULL)
+
+            for (layer = 0u ; layer != tdata->PowerGrid.NLayers ; layer++)
+
+                floorplan_free (tdata->PowerGrid.FloorplansProfile [layer]) ;
+
+        free (tdata->Temperatures) ;
+        free (tdata->LeakageVector) ;
+        free (tdata->PowerGrid.Sources) ;
+        free (tdata->PowerGrid.FloorplansProfile) ;
+
+        Destroy_SuperMatrix_Store (&tdata->SLUMatrix_B) ;
+
+        thermal_data_init (tdata) ;
+
+        return ;
+    }
+
     free (tdata->Temperatures) ;
+    free (tdata->LeakageVector) ;
+    free (tdata->InitialTemperatures) ;
 
     thermal_grid_destroy (&tdata->ThermalGrid) ;
     power_grid_destroy   (&tdata->PowerGrid) ;
 
     system_matrix_destroy (&tdata->SM_A) ;
+    substructure_destroy  (&tdata->Substructure) ;
 
     Destroy_SuperMatrix_Store (&tdata->SLUMatrix_B) ;
 
@@ -1267,105 +1544,357 @@ void thermal_data_destroy (ThermalData_t *tdata)
 
 void reset_thermal_state (ThermalData_t *tdata, Analysis_t *analysis)
 {
-    init_data (tdata->Temperatures, tdata->Size, analysis->InitialTemperature) ;
+    if (tdata->InitialTemperatures != NULL)
+
+        memcpy (tdata->Temperatures, tdata->InitialTemperatures,
+                sizeof (Temperature_t) * tdata->Size) ;
+
+    else
+
+        init_data (tdata->Temperatures, tdata->Size, analysis->InitialTemperature) ;
 }
 
 /******************************************************************************/
 
-static void fill_system_vector
-(
-    Dimensions_t  *dimensions,
-    HeatSink_t    *topSink,
-    double        *vector,
-    Source_t      *sources,
-    Capacity_t    *capacities,
-    Temperature_t *temperatures,
-    Time_t         step_time
-)
+void thermal_snapshot_init (ThermalSnapshot_t *snapshot)
 {
-#ifdef PRINT_SYSTEM_VECTOR
-    Temperature_t old ;
-#endif
-    if (dimensions->NonUniform == 1)
-    {
-        for (CellIndex_t i = 0; i<dimensions->Cell_list.Size; i++)
-            *vector++ =   *sources++
-                          + (*capacities++ / step_time)
-                          * *temperatures++ ;
-    }
-    else
-    {
-        CellIndex_t layer ;
-        CellIndex_t row ;
-        CellIndex_t column ;
-
-        for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
-        {
-            for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
-            {
-                for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
-                {
+    snapshot->Size              = (CellIndex_t) 0u ;
+    snapshot->Temperatures      = NULL ;
+    snapshot->Sources           = NULL ;
+    snapshot->CurrentTime       = (Quantity_t) 0u ;
+    snapshot->NPowerQueues      = (Quantity_t) 0u ;
+    snapshot->PowerQueues       = NULL ;
+    snapshot->HeatSinkStateSize = 0u ;
+    snapshot->HeatSinkState     = NULL ;
+}
 
-    #ifdef PRINT_SYSTEM_VECTOR
-                    old = *temperatures ;
-    #endif
+/******************************************************************************/
 
-                    *vector++ = *sources++
-                                + (*capacities++ / step_time)
-                                * *temperatures++ ;
+void thermal_snapshot_destroy (ThermalSnapshot_t *snapshot)
+{
+    Quantity_t index ;
 
-    #ifdef PRINT_SYSTEM_VECTOR
-                    fprintf (stderr,
-                        " l %2d r %4d c %4d [%7d] | %e [b] = %e [s] + %e [c] * %e [t]\n",
-                        layer, row, column,
-                        get_cell_offset_in_stack (dimensions, layer, row, column),
-                        *(vector-1), *(sources-1), *(capacities-1), old) ;
-    #endif
+    for (index = 0u ; index != snapshot->NPowerQueues ; index++)
 
-                } // FOR_EVERY_COLUMN
-            } // FOR_EVERY_ROW
-        } // FOR_EVERY_LAYER
-    
-        // Copy the rest of the vector
-        if(topSink && topSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
-        {
-            for(row = 0; row < topSink->NRows; row++)
-            {
-                for(column = 0; column < topSink->NColumns; column++)
-                {
-    #ifdef PRINT_SYSTEM_VECTOR
-                    old = *temperatures ;
-    #endif
+        powers_queue_destroy (&snapshot->PowerQueues [index]) ;
 
-                    *vector++ = *sources++
-                                + (*capacities++ / step_time)
-                                * *temperatures++ ;
+    free (snapshot->PowerQueues) ;
+    free (snapshot->Temperatures) ;
+    free (snapshot->Sources) ;
+    free (snapshot->HeatSinkState) ;
 
-    #ifdef PRINT_SYSTEM_VECTOR
-                    fprintf (stderr,
-                        "      r %4d c %4d [%7d] | %e [b] = %e [s] + %e [c] * %e [t]\n",
-                        row, column,
-                        get_spreader_cell_offset (dimensions, topSink, row, column),
-                        *(vector-1), *(sources-1), *(capacities-1), old) ;
-    #endif
-                }
-            }
-        }
-    }
+    thermal_snapshot_init (snapshot) ;
 }
 
 /******************************************************************************/
 
-static void fill_system_vector_steady
-(
-    Dimensions_t *dimensions,
-    double       *vector,
-    Source_t     *sources
-)
+size_t thermal_snapshot_memory (ThermalSnapshot_t *snapshot)
 {
-    CellIndex_t layer ;
-    CellIndex_t row ;
-    CellIndex_t column ;
+    size_t     memory = snapshot->Size * (sizeof (Temperature_t) + sizeof (Source_t)) ;
+    Quantity_t index ;
+
+    for (index = 0u ; index != snapshot->NPowerQueues ; index++)
+
+        memory += sizeof (PowersQueue_t)
+                  + snapshot->PowerQueues [index].Capacity * sizeof (Power_t) ;
+
+    return memory + snapshot->HeatSinkStateSize ;
+}
+
+/******************************************************************************/
+
+// Returns the pluggable heatsink of the stack, if any
+
+static HeatSink_t *get_pluggable_heatsink (ThermalData_t *tdata)
+{
+    HeatSink_t *hsink = tdata->ThermalGrid.TopHeatSink ;
+
+    if (hsink != NULL && hsink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+
+        return hsink ;
+
+    return NULL ;
+}
+
+/******************************************************************************/
+
+Error_t save_thermal_state
+
+    (ThermalData_t *tdata, Analysis_t *analysis, ThermalSnapshot_t *snapshot)
+{
+    HeatSink_t *hsink   = get_pluggable_heatsink (tdata) ;
+    Quantity_t  nqueues = get_number_of_power_queues (&tdata->PowerGrid) ;
+    size_t      hsize   = 0u ;
+
+    if (hsink != NULL)
+    {
+        hsize = get_pluggable_heatsink_state_size (hsink) ;
+
+        if (hsize == 0u)
+        {
+            fprintf (stderr, "ERROR: heatsink plugin does not support state save\n") ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    // The memory of a snapshot of the same ThermalData is reused as it is
+
+    if (   snapshot->Size         != tdata->Size
+        || snapshot->NPowerQueues != nqueues
+        || snapshot->HeatSinkStateSize != hsize)
+    {
+        Quantity_t index ;
+
+        thermal_snapshot_destroy (snapshot) ;
+
+        snapshot->Temperatures = (Temperature_t *) malloc (sizeof (Temperature_t) * tdata->Size) ;
+        snapshot->Sources      = (Source_t *)      malloc (sizeof (Source_t)      * tdata->Size) ;
+        snapshot->PowerQueues  = (PowersQueue_t *) malloc (sizeof (PowersQueue_t) * (nqueues + 1u)) ;
+
+        if (hsize != 0u)
+
+            snapshot->HeatSinkState = malloc (hsize) ;
+
+        if (   snapshot->Temperatures == NULL || snapshot->Sources == NULL
+            || snapshot->PowerQueues  == NULL
+            || (hsize != 0u && snapshot->HeatSinkState == NULL))
+        {
+            fprintf (stderr, "Cannot malloc thermal snapshot\n") ;
+
+            thermal_snapshot_destroy (snapshot) ;
+
+            return TDICE_FAILURE ;
+        }
+
+        for (index = 0u ; index != nqueues ; index++)
+
+            powers_queue_init (&snapshot->PowerQueues [index]) ;
+
+        snapshot->Size              = tdata->Size ;
+        snapshot->NPowerQueues      = nqueues ;
+        snapshot->HeatSinkStateSize = hsize ;
+    }
+
+    if (hsink != NULL && save_pluggable_heatsink_state (hsink, snapshot->HeatSinkState) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    memcpy (snapshot->Temperatures, tdata->Temperatures,     sizeof (Temperature_t) * tdata->Size) ;
+    memcpy (snapshot->Sources,      tdata->PowerGrid.Sources, sizeof (Source_t)     * tdata->Size) ;
+
+    save_power_values (&tdata->PowerGrid, snapshot->PowerQueues) ;
+
+    snapshot->CurrentTime = analysis->CurrentTime ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+Error_t restore_thermal_state
+
+    (ThermalData_t *tdata, Analysis_t *analysis, ThermalSnapshot_t *snapshot)
+{
+    HeatSink_t *hsink = get_pluggable_heatsink (tdata) ;
+
+    if (   snapshot->Size         != tdata->Size
+        || snapshot->NPowerQueues != get_number_of_power_queues (&tdata->PowerGrid)
+        || (hsink != NULL && snapshot->HeatSinkStateSize != get_pluggable_heatsink_state_size (hsink)))
+    {
+        fprintf (stderr, "ERROR: the snapshot belongs to another stack\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (hsink != NULL && restore_pluggable_heatsink_state (hsink, snapshot->HeatSinkState) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    memcpy (tdata->Temperatures,     snapshot->Temperatures, sizeof (Temperature_t) * tdata->Size) ;
+    memcpy (tdata->PowerGrid.Sources, snapshot->Sources,     sizeof (Source_t)      * tdata->Size) ;
+
+    restore_power_values (&tdata->PowerGrid, snapshot->PowerQueues) ;
+
+    analysis->CurrentTime = snapshot->CurrentTime ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Solves the system with the right hand side stored in the Temperatures
+// array (overwritten with the solution)
+
+static Error_t solve_system (ThermalData_t *tdata)
+{
+    if (tdata->Substructure.Size != 0u)
+
+        return substructure_solve (&tdata->Substructure, tdata->Temperatures) ;
+
+    // The factors of a session are used by the other sessions too
+
+    if (tdata->Shared == true)
+
+        return solve_sparse_linear_system_concurrent (&tdata->SM_A, &tdata->SLUMatrix_B) ;
+
+    return solve_sparse_linear_system (&tdata->SM_A, &tdata->SLUMatrix_B) ;
+}
+
+/******************************************************************************/
+
+// Solves the system adding to the right hand side, stored in the Temperatures
+// array, the leakage power of the floorplan elements evaluated at their last
+// temperatures. While the temperature of the elements changes more than the
+// tolerance, the leakage is evaluated again and the system is solved again
+// with the same factorization
+
+static Error_t solve_system_with_leakage
+(
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    Quantity_t    iteration ;
+    Temperature_t change = 0.0 ;
+
+    if (tdata->PowerGrid.NLeakages == 0u)
+
+        return solve_system (tdata) ;
+
+    if (tdata->LeakageVector != NULL)
+
+        memcpy (tdata->LeakageVector, tdata->Temperatures, sizeof (double) * tdata->Size) ;
+
+    for (iteration = 1u ; ; iteration++)
+    {
+        add_leakage_sources (&tdata->PowerGrid, tdata->Temperatures) ;
+
+        if (solve_system (tdata) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        if (tdata->LeakageVector == NULL)
+
+            return TDICE_SUCCESS ;
+
+        change = update_leakage_powers (&tdata->PowerGrid, dimensions, tdata->Temperatures) ;
+
+        if (change < analysis->LeakageTolerance)
+
+            return TDICE_SUCCESS ;
+
+        if (iteration == analysis->LeakageIterations)
+
+            break ;
+
+        memcpy (tdata->Temperatures, tdata->LeakageVector, sizeof (double) * tdata->Size) ;
+    }
+
+    fprintf (stderr,
+        "Warning: leakage power not converged after %d iterations (%.4f K)\n",
+        analysis->LeakageIterations, change) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+static void fill_system_vector
+(
+    Dimensions_t  *dimensions,
+    HeatSink_t    *topSink,
+    double        *vector,
+    Source_t      *sources,
+    Capacity_t    *capacities,
+    Temperature_t *temperatures,
+    Time_t         step_time
+)
+{
+#ifdef PRINT_SYSTEM_VECTOR
+    Temperature_t old ;
+#endif
+    if (dimensions->NonUniform == 1)
+    {
+        for (CellIndex_t i = 0; i<dimensions->Cell_list.Size; i++)
+            *vector++ =   *sources++
+                          + (*capacities++ / step_time)
+                          * *temperatures++ ;
+    }
+    else
+    {
+        CellIndex_t layer ;
+        CellIndex_t row ;
+        CellIndex_t column ;
+
+        for (layer = first_layer (dimensions) ; layer <= last_layer (dimensions) ; layer++)
+        {
+            for (row = first_row (dimensions) ; row <= last_row (dimensions) ; row++)
+            {
+                for (column = first_column (dimensions) ; column <= last_column (dimensions) ; column++)
+                {
+
+    #ifdef PRINT_SYSTEM_VECTOR
+                    old = *temperatures ;
+    #endif
+
+                    *vector++ = *sources++
+                                + (*capacities++ / step_time)
+                                * *temperatures++ ;
+
+    #ifdef PRINT_SYSTEM_VECTOR
+                    fprintf (stderr,
+                        " l %2d r %4d c %4d [%7d] | %e [b] = %e [s] + %e [c] * %e [t]\n",
+                        layer, row, column,
+                        get_cell_offset_in_stack (dimensions, layer, row, column),
+                        *(vector-1), *(sources-1), *(capacities-1), old) ;
+    #endif
+
+                } // FOR_EVERY_COLUMN
+            } // FOR_EVERY_ROW
+        } // FOR_EVERY_LAYER
+    
+        // Copy the rest of the vector
+        if(topSink && topSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+        {
+            for(row = 0; row < topSink->NRows; row++)
+            {
+                for(column = 0; column < topSink->NColumns; column++)
+                {
+    #ifdef PRINT_SYSTEM_VECTOR
+                    old = *temperatures ;
+    #endif
+
+                    *vector++ = *sources++
+                                + (*capacities++ / step_time)
+                                * *temperatures++ ;
+
+    #ifdef PRINT_SYSTEM_VECTOR
+                    fprintf (stderr,
+                        "      r %4d c %4d [%7d] | %e [b] = %e [s] + %e [c] * %e [t]\n",
+                        row, column,
+                        get_spreader_cell_offset (dimensions, topSink, row, column),
+                        *(vector-1), *(sources-1), *(capacities-1), old) ;
+    #endif
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+static void fill_system_vector_steady
+(
+    Dimensions_t *dimensions,
+    double       *vector,
+    Source_t     *sources
+)
+{
+    CellIndex_t layer ;
+    CellIndex_t row ;
+    CellIndex_t column ;
 
     if (dimensions->NonUniform == 1)
     {
@@ -1396,7 +1925,8 @@ static void fill_system_vector_steady
     }
 }
 
-Error_t pluggable_heatsink(ThermalData_t *tdata, Dimensions_t *dimensions)
+Error_t pluggable_heatsink(ThermalData_t *tdata, Dimensions_t *dimensions,
+                           Analysis_t *analysis)
 {
     // We have something to do only if we're using the pluggable heatsink model
     HeatSink_t *sink = tdata->ThermalGrid.TopHeatSink;
@@ -1412,7 +1942,8 @@ Error_t pluggable_heatsink(ThermalData_t *tdata, Dimensions_t *dimensions)
     
     // Call the pluggable heat sink function to compute the heat flows to
     // the heatsink
-    if(sink->PluggableHeatsink(SpreaderTemperatures,sources))
+    if(pluggable_heatsink_heat_flows(sink,SpreaderTemperatures,sources,
+                                     get_simulated_time(analysis)))
     {
         fprintf(stderr, "Error: pluggable heatsink callback failed\n");
         return TDICE_FAILURE;
@@ -1429,6 +1960,420 @@ Error_t pluggable_heatsink(ThermalData_t *tdata, Dimensions_t *dimensions)
 
 /******************************************************************************/
 
+// Steady state with the pluggable heat sink: maximum number of solutions,
+// tolerance (in Kelvin) on the spreader temperatures and number of previous
+// iterates used by the Anderson acceleration
+
+#define PLUGGABLE_STEADY_ITERATIONS 1000u
+#define PLUGGABLE_STEADY_TOLERANCE  1e-7
+#define ANDERSON_DEPTH              5u
+
+/******************************************************************************/
+
+// Computes the coefficients gamma that minimize || f - dF gamma || through
+// the normal equations, dF storing depth differences of residuals of size n.
+// Returns false if the differences are (numerically) linearly dependent
+
+static bool anderson_coefficients
+(
+    double      *dF,
+    double      *f,
+    CellIndex_t  n,
+    Quantity_t   depth,
+    double      *gamma
+)
+{
+    double matrix [ANDERSON_DEPTH][ANDERSON_DEPTH + 1] ;
+    Quantity_t row, column, pivot ;
+    CellIndex_t i ;
+
+    for (row = 0u ; row != depth ; row++)
+    {
+        for (column = row ; column != depth ; column++)
+        {
+            double dot = 0.0 ;
+
+            for (i = 0u ; i != n ; i++)
+
+                dot += dF [row * n + i] * dF [column * n + i] ;
+
+            matrix [row][column] = matrix [column][row] = dot ;
+        }
+
+        double dot = 0.0 ;
+
+        for (i = 0u ; i != n ; i++)
+
+            dot += dF [row * n + i] * f [i] ;
+
+        matrix [row][depth] = dot ;
+    }
+
+    // Gaussian elimination with partial pivoting
+
+    for (column = 0u ; column != depth ; column++)
+    {
+        pivot = column ;
+
+        for (row = column + 1 ; row != depth ; row++)
+
+            if (fabs (matrix [row][column]) > fabs (matrix [pivot][column]))
+
+                pivot = row ;
+
+        if (fabs (matrix [pivot][column]) < 1e-12 * fabs (matrix [0][0]) || matrix [pivot][column] == 0.0)
+
+            return false ;
+
+        if (pivot != column)
+
+            for (i = 0u ; i <= depth ; i++)
+            {
+                double tmp = matrix [column][i] ;
+
+                matrix [column][i] = matrix [pivot][i] ;
+                matrix [pivot][i]  = tmp ;
+            }
+
+        for (row = column + 1 ; row != depth ; row++)
+        {
+            double factor = matrix [row][column] / matrix [column][column] ;
+
+            for (i = column ; i <= depth ; i++)
+
+                matrix [row][i] -= factor * matrix [column][i] ;
+        }
+    }
+
+    for (row = depth ; row-- != 0u ; )
+    {
+        gamma [row] = matrix [row][depth] ;
+
+        for (column = row + 1 ; column != depth ; column++)
+
+            gamma [row] -= matrix [row][column] * gamma [column] ;
+
+        gamma [row] /= matrix [row][row] ;
+    }
+
+    return true ;
+}
+
+/******************************************************************************/
+
+// Steady state with the pluggable heat sink. The heat flows of the sink are
+// evaluated at the spreader temperatures x and the system (whose spreader
+// cells are connected to their top face) is solved on the same factorization,
+// giving new spreader temperatures g(x). The fixed point x = g(x) is found
+// with Anderson acceleration. On entry the Temperatures array stores the
+// first guess, on exit the solution. The heat sink is given x and returns
+// the heat flows q in the spreader cells of the temperatures and sources,
+// the buffers registered with it
+
+static Error_t solve_steady_pluggable_heatsink
+(
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    HeatSink_t   *sink   = tdata->ThermalGrid.TopHeatSink ;
+    CellIndex_t   offset = get_spreader_cell_offset (dimensions, sink, 0, 0) ;
+    CellIndex_t   n      = sink->NRows * sink->NColumns ;
+    Conductance_t g      = get_spreader_conductance_top_bottom (sink) ;
+
+    Quantity_t    iteration, depth = 0u, column ;
+    Temperature_t residual = 0.0, change = 0.0 ;
+    double        gamma [ANDERSON_DEPTH] ;
+    CellIndex_t   i ;
+    Error_t       result = TDICE_FAILURE ;
+
+    // Without the steady state entry point, the plugin integrates its
+    // own dynamics one step per iteration until it settles (a pseudo
+    // transient). Its state is saved before and restored on exit, so
+    // that the steady state does not advance the plugin
+
+    int (*heatflows)(const double *, double *) =
+
+        sink->PluggableHeatsinkSteady != NULL ?
+            sink->PluggableHeatsinkSteady : sink->PluggableHeatsink ;
+
+    void *state = NULL ;
+
+    if (sink->PluggableHeatsinkSteady == NULL)
+    {
+        size_t size = get_pluggable_heatsink_state_size (sink) ;
+
+        if (size == 0u)
+        {
+            fprintf (stderr,
+                "Error: pluggable heat sink without steady state nor state save/restore\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        state = malloc (size) ;
+
+        if (state == NULL)
+        {
+            fprintf (stderr, "Cannot malloc pluggable heat sink state\n") ;
+
+            return TDICE_FAILURE ;
+        }
+
+        if (save_pluggable_heatsink_state (sink, state) != TDICE_SUCCESS)
+        {
+            free (state) ;
+
+            return TDICE_FAILURE ;
+        }
+    }
+
+    double *sources = (double *) malloc (sizeof (double) * tdata->Size) ;
+    double *x       = (double *) malloc (sizeof (double) * n) ;
+    double *x_old   = (double *) malloc (sizeof (double) * n) ;
+    double *q       = tdata->PowerGrid.Sources + offset ;
+    double *f       = (double *) malloc (sizeof (double) * n) ;
+    double *f_old   = (double *) malloc (sizeof (double) * n) ;
+    double *dX      = (double *) malloc (sizeof (double) * n * ANDERSON_DEPTH) ;
+    double *dF      = (double *) malloc (sizeof (double) * n * ANDERSON_DEPTH) ;
+
+    if (   sources == NULL || x == NULL || x_old == NULL
+        || f == NULL || f_old == NULL || dX == NULL || dF == NULL)
+    {
+        fprintf (stderr, "Cannot malloc steady state pluggable heat sink vectors\n") ;
+
+        goto exit ;
+    }
+
+    memcpy (sources, tdata->PowerGrid.Sources, sizeof (double) * tdata->Size) ;
+    memcpy (x, tdata->Temperatures + offset, sizeof (double) * n) ;
+
+    for (iteration = 0u ; iteration != PLUGGABLE_STEADY_ITERATIONS ; iteration++)
+    {
+        memcpy (tdata->Temperatures + offset, x, sizeof (double) * n) ;
+
+        if (heatflows (tdata->Temperatures + offset, q) != 0)
+        {
+            fprintf (stderr, "Error: pluggable heatsink callback failed\n") ;
+
+            goto exit ;
+        }
+
+        if (tdata->PowerGrid.NLeakages != 0u)
+
+            change = update_leakage_powers (&tdata->PowerGrid, dimensions, tdata->Temperatures) ;
+
+        memcpy (tdata->Temperatures, sources, sizeof (double) * tdata->Size) ;
+
+        if (tdata->PowerGrid.NLeakages != 0u)
+
+            add_leakage_sources (&tdata->PowerGrid, tdata->Temperatures) ;
+
+        // Both 3D-ICE and plugin use passive sign convention
+
+        for (i = 0u ; i != n ; i++)
+
+            tdata->Temperatures [offset + i] += g * x [i] - q [i] ;
+
+        if (solve_system (tdata) != TDICE_SUCCESS)
+
+            goto exit ;
+
+        residual = 0.0 ;
+
+        for (i = 0u ; i != n ; i++)
+        {
+            f [i] = tdata->Temperatures [offset + i] - x [i] ;
+
+            residual = MAX (residual, fabs (f [i])) ;
+        }
+
+        if (   residual < PLUGGABLE_STEADY_TOLERANCE
+            && (tdata->PowerGrid.NLeakages == 0u || change < analysis->LeakageTolerance))
+        {
+            fprintf (stdout, "Pluggable heat sink converged in %d iterations\n", iteration + 1) ;
+
+            result = TDICE_SUCCESS ;
+
+            goto exit ;
+        }
+
+        // Differences with the previous iterate (oldest one overwritten)
+
+        if (iteration != 0u)
+        {
+            column = (iteration - 1) % ANDERSON_DEPTH ;
+
+            for (i = 0u ; i != n ; i++)
+            {
+                dX [column * n + i] = x [i] - x_old [i] ;
+                dF [column * n + i] = f [i] - f_old [i] ;
+            }
+
+            depth = MIN (depth + 1, ANDERSON_DEPTH) ;
+        }
+
+        memcpy (x_old, x, sizeof (double) * n) ;
+        memcpy (f_old, f, sizeof (double) * n) ;
+
+        // x = x + f - (dX + dF) gamma, or a plain fixed point step
+
+        for (i = 0u ; i != n ; i++)
+
+            x [i] += f [i] ;
+
+        if (depth != 0u && anderson_coefficients (dF, f, n, depth, gamma) == true)
+
+            for (column = 0u ; column != depth ; column++)
+
+                for (i = 0u ; i != n ; i++)
+
+                    x [i] -= gamma [column] * (dX [column * n + i] + dF [column * n + i]) ;
+    }
+
+    fprintf (stderr,
+        "Error: pluggable heat sink not converged after %d iterations (%.6f K)\n",
+        PLUGGABLE_STEADY_ITERATIONS, residual) ;
+
+exit :
+
+    if (sources != NULL)
+
+        memcpy (q, sources + offset, sizeof (double) * n) ;
+
+    if (state != NULL && restore_pluggable_heatsink_state (sink, state) != TDICE_SUCCESS)
+
+        result = TDICE_FAILURE ;
+
+    free (state) ;
+
+    free (sources) ;
+    free (x) ;
+    free (x_old) ;
+    free (f) ;
+    free (f_old) ;
+    free (dX) ;
+    free (dF) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Replaces the uniform initial temperature with the steady state solution
+// for the first (or the average) power values of the floorplan elements.
+// The system matrix is filled and factorized for the steady state, and then
+// filled back with the transient coefficients, whose factorization (done by
+// the caller) reuses the same column permutation
+
+static Error_t initialize_steady_state
+(
+    ThermalData_t *tdata,
+    Dimensions_t  *dimensions,
+    Analysis_t    *analysis
+)
+{
+    Analysis_t steady ;
+    Error_t    result ;
+
+    analysis_init (&steady) ;
+    analysis_copy (&steady, analysis) ;
+
+    steady.AnalysisType = TDICE_ANALYSIS_TYPE_STEADY ;
+
+    if (steady.LeakageIterations < 100u)
+
+        steady.LeakageIterations = 100u ;
+
+    if (steady.LeakageTolerance == 0.0)
+
+        steady.LeakageTolerance = (Temperature_t) 0.01 ;
+
+    tdata->InitialTemperatures =
+
+        (Temperature_t *) malloc (sizeof (Temperature_t) * tdata->Size) ;
+
+    if (tdata->InitialTemperatures == NULL)
+    {
+        fprintf (stderr, "Cannot malloc initial temperature array\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    fill_system_matrix (&tdata->SM_A, &tdata->ThermalGrid, &steady, dimensions) ;
+
+    if (do_factorization (&tdata->SM_A) == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    result = fill_initial_source_vector
+
+        (&tdata->PowerGrid, dimensions,
+         analysis->InitialState == TDICE_INITIAL_STATE_STEADY_AVERAGE) ;
+
+    if (result == TDICE_FAILURE)
+    {
+        fprintf (stderr, "Error: no power values for the initial steady state\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (   tdata->ThermalGrid.TopHeatSink
+        && tdata->ThermalGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+
+        result = solve_steady_pluggable_heatsink (tdata, dimensions, &steady) ;
+
+    else
+    {
+        if (tdata->PowerGrid.NLeakages != 0u)
+
+            update_leakage_powers (&tdata->PowerGrid, dimensions, tdata->Temperatures) ;
+
+        fill_system_vector_steady (dimensions, tdata->Temperatures, tdata->PowerGrid.Sources) ;
+
+        result = solve_system_with_leakage (tdata, dimensions, &steady) ;
+    }
+
+    if (result == TDICE_FAILURE)
+
+        return TDICE_FAILURE ;
+
+    memcpy (tdata->InitialTemperatures, tdata->Temperatures,
+            sizeof (Temperature_t) * tdata->Size) ;
+
+    // The leakage power of the transient is evaluated once per step
+
+    if (analysis->LeakageIterations < 2u)
+    {
+        free (tdata->LeakageVector) ;
+
+        tdata->LeakageVector = NULL ;
+    }
+
+    fill_system_matrix (&tdata->SM_A, &tdata->ThermalGrid, analysis, dimensions) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// The clock of the phases of a step (0 if they are not measured)
+
+static uint64_t phase_clock (ThermalData_t *tdata)
+{
+    return tdata->Phases != NULL ? stats_now () : 0u ;
+}
+
+static void record_phase (ThermalData_t *tdata, StatsPhase_t phase, uint64_t nanoseconds)
+{
+    if (tdata->Phases != NULL)
+
+        stats_histogram_add (&tdata->Phases [phase], nanoseconds) ;
+}
+
+/******************************************************************************/
+
 SimResult_t emulate_step
 (
     ThermalData_t  *tdata,
@@ -1440,6 +2385,8 @@ SimResult_t emulate_step
 
         return TDICE_WRONG_CONFIG ;
 
+    uint64_t begin = phase_clock (tdata) ;
+
     if (slot_completed (analysis) == true)
     {
         Error_t result = update_source_vector (&tdata->PowerGrid, dimensions) ;
@@ -1453,16 +2400,39 @@ SimResult_t emulate_step
 
             return TDICE_END_OF_SIMULATION ;
     }
+
+    uint64_t plugin = phase_clock (tdata) ;
     
-    if(pluggable_heatsink(tdata, dimensions) == TDICE_FAILURE)
+    if(pluggable_heatsink(tdata, dimensions, analysis) == TDICE_FAILURE)
         return TDICE_SOLVER_ERROR ;
 
+    uint64_t fill = phase_clock (tdata) ;
+
+    if (   tdata->ThermalGrid.TopHeatSink != NULL
+        && tdata->ThermalGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+
+        record_phase (tdata, TDICE_STATS_PLUGIN, fill - plugin) ;
+
+    // The leakage is evaluated before the temperatures are overwritten
+
+    if (tdata->PowerGrid.NLeakages != 0u)
+
+        update_leakage_powers (&tdata->PowerGrid, dimensions, tdata->Temperatures) ;
+
     fill_system_vector
 
         (dimensions, tdata->ThermalGrid.TopHeatSink, tdata->Temperatures, tdata->PowerGrid.Sources,
          tdata->PowerGrid.CellsCapacities, tdata->Temperatures, analysis->StepTime) ;
 
-    Error_t res = solve_sparse_linear_system (&tdata->SM_A, &tdata->SLUMatrix_B) ;
+    uint64_t solve = phase_clock (tdata) ;
+
+    // The sources of a new slot are part of the vector filled
+
+    record_phase (tdata, TDICE_STATS_FILL_VECTOR, (plugin - begin) + (solve - fill)) ;
+
+    Error_t res = solve_system_with_leakage (tdata, dimensions, analysis) ;
+
+    record_phase (tdata, TDICE_STATS_SOLVE, phase_clock (tdata) - solve) ;
 
     if (res != TDICE_SUCCESS)
 
@@ -1513,11 +2483,6 @@ SimResult_t emulate_steady
 
         return TDICE_WRONG_CONFIG ;
 
-    if(tdata->ThermalGrid.TopHeatSink &&
-       tdata->ThermalGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
-
-        return TDICE_SOLVER_ERROR ; //TODO: support steady state pluggable sink
-
     Error_t result = update_source_vector (&tdata->PowerGrid, dimensions) ;
     #ifdef PRINT_DEBUG_INFO
         printf("sources info:\n");
@@ -1533,16 +2498,48 @@ SimResult_t emulate_steady
         return TDICE_END_OF_SIMULATION ;
     }
 
+    Error_t res;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint64_t fill = phase_clock (tdata) ;
+
+    if(tdata->ThermalGrid.TopHeatSink &&
+       tdata->ThermalGrid.TopHeatSink->SinkModel == TDICE_HEATSINK_TOP_PLUGGABLE)
+    {
+        // The plugin and the solver alternate until they converge
+
+        res = solve_steady_pluggable_heatsink (tdata, dimensions, analysis) ;
+
+        record_phase (tdata, TDICE_STATS_PLUGIN, phase_clock (tdata) - fill) ;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        fprintf (stdout, "Solve took %.5f sec\n",
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9 ) ;
+
+        if (res != TDICE_SUCCESS)
+
+            return TDICE_SOLVER_ERROR ;
+
+        return TDICE_END_OF_SIMULATION ;
+    }
+
+    if (tdata->PowerGrid.NLeakages != 0u)
+
+        update_leakage_powers (&tdata->PowerGrid, dimensions, tdata->Temperatures) ;
+
     fill_system_vector_steady (dimensions, tdata->Temperatures, tdata->PowerGrid.Sources) ;
 
+    uint64_t solve = phase_clock (tdata) ;
+
+    record_phase (tdata, TDICE_STATS_FILL_VECTOR, solve - fill) ;
+
     // String_t temp = "Vector_b.txt" ;
     // Vector_b_print (tdata->Temperatures, dimensions->Grid.NCells, temp) ;
 
-    Error_t res;
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+    res = solve_system_with_leakage (tdata, dimensions, analysis) ;
 
-    res = solve_sparse_linear_system (&tdata->SM_A, &tdata->SLUMatrix_B) ;
+    record_phase (tdata, TDICE_STATS_SOLVE, phase_clock (tdata) - solve) ;
 
     // Time consumption for solving the equation
     clock_gettime(CLOCK_MONOTONIC, &end);
@@ -1566,6 +2563,13 @@ Error_t update_coolant_flow_rate
     CoolantFR_t     new_flow_rate
 )
 {
+    if (tdata->Shared == true)
+    {
+        fprintf (stderr, "The flow rate of a shared system matrix cannot change\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
     tdata->ThermalGrid.Channel->Coolant.FlowRate =
 
         FLOW_RATE_FROM_MLMIN_TO_UM3SEC(new_flow_rate) ;
@@ -1574,7 +2578,13 @@ Error_t update_coolant_flow_rate
 
     fill_system_matrix (&tdata->SM_A, &tdata->ThermalGrid, analysis, dimensions) ;
 
-    if (do_factorization (&tdata->SM_A) == TDICE_FAILURE)
+    if (tdata->Substructure.Size != 0u)
+    {
+        if (substructure_update (&tdata->Substructure, &tdata->SM_A) == TDICE_FAILURE)
+
+            return TDICE_FAILURE ;
+    }
+    else if (do_factorization (&tdata->SM_A) == TDICE_FAILURE)
 
         return TDICE_FAILURE ;
 
@@ -0,0 +1,339 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "model_registry.h"
+#include "snapshot_pool.h"
+#include "stats.h"
+
+// A model is waited for BUILD_DELAY microseconds at a time, BUILD_ATTEMPTS
+// times (30 seconds)
+
+#define BUILD_DELAY    10000u
+#define BUILD_ATTEMPTS 3000u
+
+#define STATS_FILE "server/stats.prom"
+
+// The results are printed here: the modules print their messages on the
+// standard output and error, that are discarded
+
+static FILE *results ;
+
+static unsigned int failed_checks = 0u ;
+
+/******************************************************************************/
+
+static void check (bool condition, String_t what)
+{
+    if (condition == true)
+
+        return ;
+
+    fprintf (results, "%s, ", what) ;
+
+    failed_checks++ ;
+}
+
+/******************************************************************************/
+
+// Waits for a model to be ready (or failed)
+
+static ModelPhase_t wait_model (ModelRegistry_t *registry, Model_t *model)
+{
+    Quantity_t   attempt ;
+    ModelPhase_t phase = model_registry_status (registry, model, NULL) ;
+
+    for (attempt = 0u ; attempt != BUILD_ATTEMPTS && phase < TDICE_MODEL_READY ; attempt++)
+    {
+        usleep (BUILD_DELAY) ;
+
+        phase = model_registry_status (registry, model, NULL) ;
+    }
+
+    return phase ;
+}
+
+/******************************************************************************/
+
+// Acquires the model of a stack file and waits for it. Returns its id, or 0
+
+static Quantity_t build_model (ModelRegistry_t *registry, String_t stk_file)
+{
+    Model_t   *model = model_registry_acquire (registry, stk_file) ;
+    Quantity_t id ;
+
+    if (model == NULL)
+
+        return 0u ;
+
+    id = wait_model (registry, model) == TDICE_MODEL_READY ? model->Id : 0u ;
+
+    model_registry_release (registry, model) ;
+
+    return id ;
+}
+
+/******************************************************************************/
+
+static void check_model_registry (void)
+{
+    ModelRegistry_t registry ;
+    Quantity_t      first, second, third, nmodels ;
+    size_t          memory ;
+
+    model_registry_init (&registry) ;
+
+    if (model_registry_open (&registry, (String_t) "server/stack.stk", 0u, false, NULL) != TDICE_SUCCESS)
+    {
+        check (false, (String_t) "registry not opened") ;
+
+        model_registry_destroy (&registry) ;
+
+        return ;
+    }
+
+    check (model_registry_acquire (&registry, (String_t) "server/../leakage/steady.stk") == NULL,
+           (String_t) "server/../leakage/steady.stk accepted") ;
+
+    first = build_model (&registry, (String_t) "server/stack.stk") ;
+
+    check (first != 0u, (String_t) "server/stack.stk not built") ;
+
+    check (build_model (&registry, (String_t) "server/stack.stk") == first,
+           (String_t) "server/stack.stk built again") ;
+
+    second = build_model (&registry, (String_t) "server/outputs.stk") ;
+
+    check (second != 0u && second != first, (String_t) "server/outputs.stk not built") ;
+
+    model_registry_usage (&registry, &nmodels, &memory, NULL) ;
+
+    check (nmodels == 2u, (String_t) "models released without a budget") ;
+
+    // With room for one model, the one used least recently is released
+
+    registry.Budget = memory - 1u ;
+
+    model_registry_evict (&registry) ;
+
+    model_registry_usage (&registry, &nmodels, NULL, NULL) ;
+
+    check (nmodels == 1u, (String_t) "no model released over the budget") ;
+
+    third = build_model (&registry, (String_t) "server/stack.stk") ;
+
+    check (third != first, (String_t) "the model used least recently kept") ;
+
+    model_registry_usage (&registry, &nmodels, NULL, NULL) ;
+
+    check (nmodels == 1u, (String_t) "two models kept over the budget") ;
+
+    check (build_model (&registry, (String_t) "server/stack.stk") == third,
+           (String_t) "the model used most recently released") ;
+
+    model_registry_destroy (&registry) ;
+}
+
+/******************************************************************************/
+
+// Saves the state of a model in a snapshot of the pool
+
+static Quantity_t save_state
+
+    (SnapshotPool_t *pool, Model_t *model, Quantity_t session_id, size_t budget)
+{
+    Snapshot_t *snapshot = snapshot_pool_take (pool, session_id) ;
+
+    if (snapshot == NULL)
+
+        return 0u ;
+
+    if (save_thermal_state (&model->TData, &model->Analysis, &snapshot->State) != TDICE_SUCCESS)
+    {
+        snapshot_pool_give_back (pool, snapshot) ;
+
+        return 0u ;
+    }
+
+    return snapshot_pool_add (pool, snapshot, model->Id, session_id, budget, 0u) ;
+}
+
+/******************************************************************************/
+
+static void check_snapshot_pool (void)
+{
+    ModelRegistry_t registry ;
+    SnapshotPool_t  pool ;
+    Model_t        *model ;
+    Quantity_t      handle ;
+    size_t          memory ;
+
+    snapshot_pool_init  (&pool) ;
+    model_registry_init (&registry) ;
+
+    model = model_registry_open (&registry, (String_t) "server/stack.stk", 0u, false, &pool) == TDICE_SUCCESS
+
+            ? model_registry_acquire (&registry, (String_t) "server/stack.stk") : NULL ;
+
+    if (model == NULL || wait_model (&registry, model) != TDICE_MODEL_READY)
+    {
+        check (false, (String_t) "no model to save") ;
+
+        if (model != NULL)
+
+            model_registry_release (&registry, model) ;
+
+        model_registry_destroy (&registry) ;
+        snapshot_pool_destroy  (&pool) ;
+
+        return ;
+    }
+
+    handle = save_state (&pool, model, 1u, 0u) ;
+    memory = snapshot_pool_memory (&pool) ;
+
+    check (handle != 0u && memory != 0u, (String_t) "state not saved") ;
+
+    check (snapshot_pool_restore (&pool, handle, model->Id, &model->TData, &model->Analysis) == TDICE_SUCCESS,
+           (String_t) "state not restored") ;
+
+    check (snapshot_pool_restore (&pool, handle, model->Id + 1u, &model->TData, &model->Analysis) != TDICE_SUCCESS,
+           (String_t) "state restored into another model") ;
+
+    check (save_state (&pool, model, 2u, memory + 1u) == 0u,
+           (String_t) "state saved over the budget") ;
+
+    check (save_state (&pool, model, 2u, 0u) > handle,
+           (String_t) "handle reused") ;
+
+    snapshot_pool_delete_session (&pool, 1u) ;
+
+    check (snapshot_pool_restore (&pool, handle, model->Id, &model->TData, &model->Analysis) != TDICE_SUCCESS,
+           (String_t) "state kept after its session") ;
+
+    check (snapshot_pool_memory (&pool) == memory,
+           (String_t) "memory of the states saved") ;
+
+    snapshot_pool_delete_session (&pool, 2u) ;
+
+    check (snapshot_pool_memory (&pool) == 0u,
+           (String_t) "memory of the states deleted") ;
+
+    model_registry_release (&registry, model) ;
+    model_registry_destroy (&registry) ;
+    snapshot_pool_destroy  (&pool) ;
+}
+
+/******************************************************************************/
+
+static void check_stats (void)
+{
+    Stats_t       stats ;
+    StatsGauges_t gauges = { 2u, 3u, 1u, 4096u, 8192u, 0u } ;
+    char         *text   = NULL ;
+    size_t        length = 0u ;
+    FILE         *stream = open_memstream (&text, &length) ;
+
+    if (stream == NULL)
+    {
+        check (false, (String_t) "no stream") ;
+
+        return ;
+    }
+
+    stats_init (&stats) ;
+
+    stats_add_request (&stats, TDICE_INSERT_POWERS, stats_now ( ), TDICE_SUCCESS) ;
+    stats_add_request (&stats, TDICE_INSERT_POWERS, stats_now ( ), TDICE_SUCCESS) ;
+    stats_add_request (&stats, TDICE_INSERT_POWERS, stats_now ( ), TDICE_FAILURE) ;
+    stats_add_request (&stats, (MessageType_t) TDICE_STATS_NREQUESTS, stats_now ( ), TDICE_SUCCESS) ;
+
+    stats_print (&stats, stream, &gauges) ;
+
+    fclose (stream) ;
+
+    check (strstr (text, "\ntdice_request_duration_seconds_count{request=\"insert_powers\"} 3\n") != NULL,
+           (String_t) "no count of the requests") ;
+
+    check (strstr (text, "\ntdice_request_failures_total{request=\"insert_powers\"} 1\n") != NULL,
+           (String_t) "no count of the failures") ;
+
+    check (strstr (text, "request=\"simulate_step\"") == NULL,
+           (String_t) "requests not served printed") ;
+
+    check (   strstr (text, "\ntdice_sessions 2\n") != NULL
+           && strstr (text, "\ntdice_sessions_peak 3\n") != NULL
+           && strstr (text, "\ntdice_models_memory_peak_bytes 8192\n") != NULL,
+           (String_t) "no gauges") ;
+
+    free (text) ;
+
+    check (   stats_write_file (&stats, (String_t) STATS_FILE, &gauges) == TDICE_SUCCESS
+           && access (STATS_FILE, R_OK) == 0
+           && access (STATS_FILE ".tmp", F_OK) != 0,
+           (String_t) "statistics not written") ;
+
+    remove (STATS_FILE) ;
+}
+
+/******************************************************************************/
+
+int main (void)
+{
+    results = fdopen (dup (STDOUT_FILENO), "w") ;
+
+    if (   results == NULL
+        || freopen ("/dev/null", "w", stdout) == NULL
+        || freopen ("/dev/null", "w", stderr) == NULL)
+
+        return EXIT_FAILURE ;
+
+    check_model_registry ( ) ;
+    check_snapshot_pool  ( ) ;
+    check_stats          ( ) ;
+
+    fprintf (results, "%u failed checks\n", failed_checks) ;
+
+    fclose (results) ;
+
+    return failed_checks == 0u ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
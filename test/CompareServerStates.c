@@ -0,0 +1,1269 @@
+/******************************************************************************
+ * This file is part of 3D-ICE, version 4.0 .                                 *
+ *                                                                            *
+ * 3D-ICE is free software: you can  redistribute it and/or  modify it  under *
+ * the terms of the  GNU General  Public  License as  published by  the  Free *
+ * Software  Foundation, either  version  3  of  the License,  or  any  later *
+ * version.                                                                   *
+ *                                                                            *
+ * 3D-ICE is  distributed  in the hope  that it will  be useful, but  WITHOUT *
+ * ANY  WARRANTY; without  even the  implied warranty  of MERCHANTABILITY  or *
+ * FITNESS  FOR A PARTICULAR  PURPOSE. See the GNU General Public License for *
+ * more details.                                                              *
+ *                                                                            *
+ * You should have  received a copy of  the GNU General  Public License along *
+ * with 3D-ICE. If not, see <http://www.gnu.org/licenses/>.                   *
+ *                                                                            *
+ *                             Copyright (C) 2021                             *
+ *   Embedded Systems Laboratory - Ecole Polytechnique Federale de Lausanne   *
+ *                            All Rights Reserved.                            *
+ *                                                                            *
+ * Authors: Arvind Sridhar              Alessandro Vincenzi                   *
+ *          Giseong Bak                 Martino Ruggiero                      *
+ *          Thomas Brunschwiler         Eder Zulian                           *
+ *          Federico Terraneo           Darong Huang                          *
+ *          Kai Zhu                     Luis Costero                          *
+ *          Marina Zapater              David Atienza                         *
+ *                                                                            *
+ * For any comment, suggestion or request  about 3D-ICE, please  register and *
+ * write to the mailing list (see http://listes.epfl.ch/doc.cgi?liste=3d-ice) *
+ * Any usage  of 3D-ICE  for research,  commercial or other  purposes must be *
+ * properly acknowledged in the resulting products or publications.           *
+ *                                                                            *
+ * EPFL-STI-IEL-ESL                     Mail : 3d-ice@listes.epfl.ch          *
+ * Batiment ELG, ELG 130                       (SUBSCRIPTION IS NECESSARY)    *
+ * Station 11                                                                 *
+ * 1015 Lausanne, Switzerland           Url  : http://esl.epfl.ch/3d-ice      *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+
+#include "network_socket.h"
+#include "network_message.h"
+
+// The number of slots simulated. After the first half, the resolution of
+// the delta encoded thermal states changes and the thermal state is saved
+
+#define NSLOTS  12u
+#define HALF    (NSLOTS / 2u)
+
+// The time (in microseconds) given to the server to simulate a step ahead
+
+#define SPECULATION_WAIT 20000u
+
+// The server may not listen yet: the connection is tried again every
+// CONNECT_DELAY microseconds, CONNECT_ATTEMPTS times (30 seconds)
+
+#define CONNECT_DELAY    100000u
+#define CONNECT_ATTEMPTS 300u
+
+/******************************************************************************/
+
+// Connects to the server, waiting for it to listen
+
+static Error_t connect_to_server
+(
+    Socket_t     *client_socket,
+    String_t      server_ip,
+    PortNumber_t  server_port
+)
+{
+    Quantity_t attempt ;
+
+    client_socket->Address.sin_family = AF_INET ;
+    client_socket->Address.sin_port   = htons (server_port) ;
+
+    if (inet_pton (AF_INET, server_ip, &client_socket->Address.sin_addr) <= 0)
+    {
+        fprintf (stdout, "Wrong server address %s\n", server_ip) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    for (attempt = 0u ; attempt != CONNECT_ATTEMPTS ; attempt++)
+    {
+        if (open_client_socket (client_socket) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        if (connect (client_socket->Id, (struct sockaddr *) &client_socket->Address,
+                     sizeof (struct sockaddr_in)) == 0)
+
+            return TDICE_SUCCESS ;
+
+        close (client_socket->Id) ;
+
+        usleep (CONNECT_DELAY) ;
+    }
+
+    fprintf (stdout, "Cannot connect to the server\n") ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// The power values change every three slots
+
+static float power_value (Quantity_t slot, Quantity_t element)
+{
+    return (float) ((slot / 3u + element) % 4u) * 2.5f ;
+}
+
+/******************************************************************************/
+
+// Sends a request and, if reply is not NULL, receives its reply
+
+static Error_t exchange
+(
+    Socket_t         *client_socket,
+    NetworkMessage_t *request,
+    NetworkMessage_t *reply
+)
+{
+    Error_t error = send_message_to_socket (client_socket, request) ;
+
+    network_message_destroy (request) ;
+
+    if (error != TDICE_SUCCESS || reply == NULL)
+
+        return error ;
+
+    network_message_init (reply) ;
+
+    error = receive_message_from_socket (client_socket, reply) ;
+
+    if (error != TDICE_SUCCESS)
+
+        network_message_destroy (reply) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+// Sends a request with one word, whose reply is an Error_t
+
+static Error_t request_word
+(
+    Socket_t      *client_socket,
+    MessageType_t  type,
+    void          *word
+)
+{
+    NetworkMessage_t request, reply ;
+    Error_t result = TDICE_FAILURE ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, type) ;
+    insert_message_word  (&request, word) ;
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &result, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Inserts the power values of a slot
+
+static Error_t insert_powers
+(
+    Socket_t   *client_socket,
+    Quantity_t  nflpel,
+    Quantity_t  slot
+)
+{
+    NetworkMessage_t request, reply ;
+    Error_t          error = TDICE_FAILURE ;
+    Quantity_t       index ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_INSERT_POWERS) ;
+    insert_message_word  (&request, &nflpel) ;
+
+    for (index = 0u ; index != nflpel ; index++)
+    {
+        float power = power_value (slot, index) ;
+
+        insert_message_word (&request, &power) ;
+    }
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &error, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+// Inserts the power values of a slot and simulates it one step at a time,
+// waiting before each request if wait is not 0
+
+static Error_t simulate_slot
+(
+    Socket_t   *client_socket,
+    Quantity_t  nflpel,
+    Quantity_t  slot,
+    useconds_t  wait
+)
+{
+    NetworkMessage_t request, reply ;
+    SimResult_t result = TDICE_STEP_DONE ;
+
+    if (wait != 0u)    usleep (wait) ;
+
+    if (insert_powers (client_socket, nflpel, slot) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    while (result == TDICE_STEP_DONE)
+    {
+        if (wait != 0u)    usleep (wait) ;
+
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_SIMULATE_STEP) ;
+
+        if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        if (extract_message_word (&reply, &result, 0) != TDICE_SUCCESS)
+
+            result = TDICE_SOLVER_ERROR ;
+
+        network_message_destroy (&reply) ;
+    }
+
+    return result == TDICE_SLOT_DONE ? TDICE_SUCCESS : TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Receives the temperatures of all the thermal cells, as doubles or delta
+// encoded, and the number of cells if ncells is 0
+
+static Error_t receive_state
+(
+    Socket_t        *client_socket,
+    BulkType_t       type,
+    BulkReference_t *reference,
+    float           *time,
+    double          *temperatures,
+    Quantity_t      *ncells
+)
+{
+    NetworkMessage_t request, reply ;
+    Quantity_t index = 1u ;
+    Error_t    error ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_SEND_THERMAL_STATE) ;
+    insert_message_word  (&request, &type) ;
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, time, 0) ;
+
+    if (*ncells == 0u)
+
+        error = extract_message_word (&reply, ncells, 2) ;
+
+    else if (type == TDICE_BULK_DELTA)
+
+        error = extract_message_bulk_delta (&reply, &index, reference, temperatures, *ncells) ;
+
+    else
+
+        error = extract_message_bulk (&reply, &index, temperatures, *ncells) ;
+
+    network_message_destroy (&reply) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+// Largest difference between two thermal states
+
+static double max_difference (double *state1, double *state2, Quantity_t ncells)
+{
+    double tmp, max = 0.0 ;
+    Quantity_t index ;
+
+    for (index = 0u ; index != ncells ; index++)
+    {
+        tmp = fabs (state1 [index] - state2 [index]) ;
+
+        if (tmp > max)    max = tmp ;
+    }
+
+    return max ;
+}
+
+/******************************************************************************/
+
+// Receives the thermal state of each slot in full and delta encoded.
+// The decoded temperatures must be rounded to the resolution, which
+// changes halfway (and a key frame is sent again)
+
+static Error_t compare_delta
+(
+    Socket_t   *client_socket,
+    Quantity_t  nflpel,
+    Quantity_t  ncells,
+    double     *expected,
+    double     *state
+)
+{
+    BulkReference_t reference ;
+    Quantity_t      slot ;
+    float           time, resolution = (float) TDICE_BULK_RESOLUTION ;
+    double          tmp, max = 0.0, time_max = 0.0 ;
+
+    bulk_reference_init (&reference) ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+    {
+        if (slot == HALF)
+        {
+            resolution /= 10.0f ;
+
+            if (request_word (client_socket, TDICE_SET_BULK_RESOLUTION, &resolution) != TDICE_SUCCESS)
+
+                goto error ;
+        }
+
+        if (   simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS
+            || receive_state (client_socket, TDICE_BULK_DOUBLE, NULL,
+                              &time, expected, &ncells) != TDICE_SUCCESS
+            || receive_state (client_socket, TDICE_BULK_DELTA, &reference,
+                              &time, state, &ncells) != TDICE_SUCCESS)
+
+            goto error ;
+
+        // Measured in multiples of the resolution, at most 0.5
+
+        tmp = max_difference (expected, state, ncells) / resolution ;
+
+        if (tmp > max) { max = tmp ; time_max = time ; }
+    }
+
+    fprintf (stdout, "%.3f (@%.3f)\n", max, time_max) ;
+
+    bulk_reference_destroy (&reference) ;
+
+    return TDICE_SUCCESS ;
+
+error :
+
+    fprintf (stdout, "Request failed at slot %d\n", slot) ;
+
+    bulk_reference_destroy (&reference) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Saves the thermal state of the server and receives its handle
+
+static Error_t save_state (Socket_t *client_socket, Quantity_t *handle)
+{
+    NetworkMessage_t request, reply ;
+    Error_t          result ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_SAVE_THERMAL_STATE) ;
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &result, 0) ;
+    extract_message_word (&reply, handle,  1) ;
+
+    network_message_destroy (&reply) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Saves the thermal state halfway and simulates the second half. Then the
+// state is restored and the second half simulated again, twice: the
+// temperatures must be the same
+
+static Error_t compare_snapshot
+(
+    Socket_t   *client_socket,
+    Quantity_t  nflpel,
+    Quantity_t  ncells,
+    double     *expected,
+    double     *state
+)
+{
+    Quantity_t slot, handle, round ;
+    float      time ;
+    double     tmp, max = 0.0, time_max = 0.0 ;
+
+    for (slot = 0u ; slot != HALF ; slot++)
+
+        if (simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS)
+
+            goto error ;
+
+    if (save_state (client_socket, &handle) != TDICE_SUCCESS)
+
+        goto error ;
+
+    for (slot = HALF ; slot != NSLOTS ; slot++)
+
+        if (   simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS
+            || receive_state (client_socket, TDICE_BULK_DOUBLE, NULL, &time,
+                              expected + (slot - HALF) * ncells, &ncells) != TDICE_SUCCESS)
+
+            goto error ;
+
+    for (round = 0u ; round != 2u ; round++)
+    {
+        if (request_word (client_socket, TDICE_RESTORE_THERMAL_STATE, &handle) != TDICE_SUCCESS)
+
+            goto error ;
+
+        for (slot = HALF ; slot != NSLOTS ; slot++)
+        {
+            if (   simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS
+                || receive_state (client_socket, TDICE_BULK_DOUBLE, NULL,
+                                  &time, state, &ncells) != TDICE_SUCCESS)
+
+                goto error ;
+
+            tmp = max_difference (expected + (slot - HALF) * ncells, state, ncells) ;
+
+            if (tmp > max) { max = tmp ; time_max = time ; }
+        }
+    }
+
+    fprintf (stdout, "%.6f (@%.3f)\n", max, time_max) ;
+
+    return TDICE_SUCCESS ;
+
+error :
+
+    fprintf (stdout, "Request failed at slot %d\n", slot) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Simulates the slots without and then, from the same saved state, with the
+// speculative steps, waiting before each request while the server simulates
+// ahead: the temperatures must be the same
+
+static Error_t compare_speculation
+(
+    Socket_t   *client_socket,
+    Quantity_t  nflpel,
+    Quantity_t  ncells,
+    double     *expected,
+    double     *state
+)
+{
+    Quantity_t slot = 0u, handle, speculate = 1u ;
+    float      time ;
+    double     tmp, max = 0.0, time_max = 0.0 ;
+
+    if (save_state (client_socket, &handle) != TDICE_SUCCESS)
+
+        goto error ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+
+        if (   simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS
+            || receive_state (client_socket, TDICE_BULK_DOUBLE, NULL, &time,
+                              expected + slot * ncells, &ncells) != TDICE_SUCCESS)
+
+            goto error ;
+
+    slot = 0u ;
+
+    if (   request_word (client_socket, TDICE_RESTORE_THERMAL_STATE, &handle) != TDICE_SUCCESS
+        || request_word (client_socket, TDICE_SPECULATE_STEPS, &speculate) != TDICE_SUCCESS)
+
+        goto error ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+    {
+        if (   simulate_slot (client_socket, nflpel, slot, SPECULATION_WAIT) != TDICE_SUCCESS
+            || receive_state (client_socket, TDICE_BULK_DOUBLE, NULL,
+                              &time, state, &ncells) != TDICE_SUCCESS)
+
+            goto error ;
+
+        tmp = max_difference (expected + slot * ncells, state, ncells) ;
+
+        if (tmp > max) { max = tmp ; time_max = time ; }
+    }
+
+    fprintf (stdout, "%.6f (@%.3f)\n", max, time_max) ;
+
+    return TDICE_SUCCESS ;
+
+error :
+
+    fprintf (stdout, "Request failed at slot %d\n", slot) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Appends the words of a reply, from the word first on, to the ones stored
+
+static Error_t store_words
+(
+    NetworkMessage_t  *reply,
+    Quantity_t         first,
+    MessageWord_t    **words,
+    Quantity_t        *nwords
+)
+{
+    if (*reply->Length < 2u + first)
+
+        return TDICE_FAILURE ;
+
+    Quantity_t     length = *reply->Length - 2u - first ;
+    MessageWord_t *tmp    = (MessageWord_t *) realloc
+
+        (*words, sizeof (MessageWord_t) * (*nwords + length)) ;
+
+    if (tmp == NULL)
+    {
+        fprintf (stdout, "Cannot malloc the outputs\n") ;
+
+        return TDICE_FAILURE ;
+    }
+
+    memcpy (tmp + *nwords, reply->Content + first, sizeof (MessageWord_t) * length) ;
+
+    *words   = tmp ;
+    *nwords += length ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Simulates the slots with separate requests to insert the powers, simulate
+// the slot and send each output. Then, from the same saved state, with one
+// TDICE_SIMULATE_AND_SEND_OUTPUT request per slot: the outputs (the
+// temperatures of the inspection points and the thermal map) must be the
+// same, word by word
+
+#define NOUTPUTS 2u
+
+static Error_t compare_compound (Socket_t *client_socket, Quantity_t nflpel)
+{
+    NetworkMessage_t request, reply ;
+    MessageWord_t   *expected = NULL, *outputs = NULL ;
+    Quantity_t       slot = 0u, handle, index, nip ;
+    Quantity_t       nexpected = 0u, noutputs = 0u, ndifferent ;
+    Quantity_t       count = 1u, nout = NOUTPUTS ;
+    MessageType_t    unit = TDICE_SIMULATE_SLOT ;
+    SimResult_t      result ;
+    Error_t          error ;
+
+    OutputInstant_t  instant  = TDICE_OUTPUT_INSTANT_SLOT ;
+    OutputQuantity_t quantity = TDICE_OUTPUT_QUANTITY_NONE ;
+    OutputType_t     types [NOUTPUTS] = { TDICE_OUTPUT_TYPE_TCELL, TDICE_OUTPUT_TYPE_TMAP } ;
+
+    if (save_state (client_socket, &handle) != TDICE_SUCCESS)
+
+        goto error ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+    {
+        if (insert_powers (client_socket, nflpel, slot) != TDICE_SUCCESS)
+
+            goto error ;
+
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_SIMULATE_SLOT) ;
+
+        if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+            goto error ;
+
+        extract_message_word (&reply, &result, 0) ;
+
+        network_message_destroy (&reply) ;
+
+        if (result != TDICE_SLOT_DONE)
+
+            goto error ;
+
+        // The time is left out, the number of inspection points and their
+        // values are kept
+
+        for (index = 0u ; index != NOUTPUTS ; index++)
+        {
+            network_message_init (&request) ;
+            build_message_head   (&request, TDICE_SEND_OUTPUT) ;
+            insert_message_word  (&request, &instant) ;
+            insert_message_word  (&request, &types [index]) ;
+            insert_message_word  (&request, &quantity) ;
+
+            if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+                goto error ;
+
+            extract_message_word (&reply, &nip, 1) ;
+
+            error = nip != 0u ? store_words (&reply, 1u, &expected, &nexpected) : TDICE_FAILURE ;
+
+            network_message_destroy (&reply) ;
+
+            if (error != TDICE_SUCCESS)
+
+                goto error ;
+        }
+    }
+
+    slot = 0u ;
+
+    if (request_word (client_socket, TDICE_RESTORE_THERMAL_STATE, &handle) != TDICE_SUCCESS)
+
+        goto error ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+    {
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_SIMULATE_AND_SEND_OUTPUT) ;
+        insert_message_word  (&request, &nflpel) ;
+
+        for (index = 0u ; index != nflpel ; index++)
+        {
+            float power = power_value (slot, index) ;
+
+            insert_message_word (&request, &power) ;
+        }
+
+        insert_message_word (&request, &unit) ;
+        insert_message_word (&request, &count) ;
+        insert_message_word (&request, &nout) ;
+
+        for (index = 0u ; index != NOUTPUTS ; index++)
+        {
+            insert_message_word (&request, &instant) ;
+            insert_message_word (&request, &types [index]) ;
+            insert_message_word (&request, &quantity) ;
+        }
+
+        if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+            goto error ;
+
+        extract_message_word (&reply, &result, 0) ;
+
+        // The result, the time and the number of outputs are left out
+
+        error = result == TDICE_SLOT_DONE ? store_words (&reply, 3u, &outputs, &noutputs) : TDICE_FAILURE ;
+
+        network_message_destroy (&reply) ;
+
+        if (error != TDICE_SUCCESS)
+
+            goto error ;
+    }
+
+    ndifferent = nexpected > noutputs ? nexpected - noutputs : noutputs - nexpected ;
+
+    for (index = 0u ; index != nexpected && index != noutputs ; index++)
+
+        if (expected [index] != outputs [index])    ndifferent++ ;
+
+    fprintf (stdout, "%d different words\n", ndifferent) ;
+
+    free (expected) ;
+    free (outputs) ;
+
+    return TDICE_SUCCESS ;
+
+error :
+
+    fprintf (stdout, "Request failed at slot %d\n", slot) ;
+
+    free (expected) ;
+    free (outputs) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Inserts a string as | length | bytes |, padded to a whole number of words
+
+static Error_t insert_message_string (NetworkMessage_t *request, String_t string)
+{
+    MessageWord_t words [16] = { 0u } ;
+    Quantity_t    length = strlen (string), index ;
+
+    if (length > sizeof (words))
+
+        return TDICE_FAILURE ;
+
+    memcpy (words, string, length) ;
+
+    insert_message_word (request, &length) ;
+
+    for (index = 0u ; index * sizeof (MessageWord_t) < length ; index++)
+
+        insert_message_word (request, &words [index]) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Requests the bytes of one output file and appends them to the ones stored,
+// together with the offset of the first one. The reply must have one file
+
+#define WORDS(nbytes) (((nbytes) + sizeof (MessageWord_t) - 1u) / sizeof (MessageWord_t))
+
+static Error_t receive_file
+(
+    Socket_t           *client_socket,
+    OutputFilesMode_t   mode,
+    Quantity_t          max_bytes,
+    uint64_t           *offset,
+    String_t            name,
+    char              **bytes,
+    Quantity_t         *nbytes,
+    Quantity_t         *length
+)
+{
+    NetworkMessage_t request, reply ;
+    Quantity_t       name_length, nfiles = 0u ;
+    Error_t          error = TDICE_FAILURE ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_SEND_OUTPUT_FILES) ;
+    insert_message_word  (&request, &mode) ;
+    insert_message_word  (&request, &max_bytes) ;
+    insert_message_word  (&request, (MessageWord_t *) offset) ;
+    insert_message_word  (&request, (MessageWord_t *) offset + 1) ;
+
+    if (insert_message_string (&request, name) != TDICE_SUCCESS)
+    {
+        network_message_destroy (&request) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &nfiles, 0) ;
+
+    if (nfiles == 1u)
+    {
+        extract_message_word (&reply, &name_length,              1) ;
+        extract_message_word (&reply, length,                    2) ;
+        extract_message_word (&reply, (MessageWord_t *) offset,     3) ;
+        extract_message_word (&reply, (MessageWord_t *) offset + 1, 4) ;
+
+        char *tmp = (char *) realloc (*bytes, *nbytes + *length + 1u) ;
+
+        if (tmp != NULL)
+        {
+            memcpy (tmp + *nbytes, reply.Content + 5u + WORDS (name_length), *length) ;
+
+            *bytes   = tmp ;
+            *nbytes += *length ;
+
+            error = TDICE_SUCCESS ;
+        }
+    }
+
+    network_message_destroy (&reply) ;
+
+    return error ;
+}
+
+/******************************************************************************/
+
+// Reads a whole file
+
+static char *read_file (String_t name, Quantity_t *nbytes)
+{
+    FILE *file  = fopen (name, "r") ;
+    char *bytes = NULL ;
+
+    if (file == NULL)
+
+        return NULL ;
+
+    fseek (file, 0, SEEK_END) ;
+
+    *nbytes = (Quantity_t) ftell (file) ;
+
+    fseek (file, 0, SEEK_SET) ;
+
+    bytes = (char *) malloc (*nbytes + 1u) ;
+
+    if (bytes != NULL && fread (bytes, 1u, *nbytes, file) != *nbytes)
+    {
+        free (bytes) ;
+
+        bytes = NULL ;
+    }
+
+    fclose (file) ;
+
+    return bytes ;
+}
+
+/******************************************************************************/
+
+// Number of bytes that differ between two strings of bytes, counting the
+// ones missing in the shorter one
+
+static Quantity_t different_bytes
+(
+    char *bytes1, Quantity_t nbytes1,
+    char *bytes2, Quantity_t nbytes2
+)
+{
+    Quantity_t index, ndifferent ;
+
+    ndifferent = nbytes1 > nbytes2 ? nbytes1 - nbytes2 : nbytes2 - nbytes1 ;
+
+    for (index = 0u ; index != nbytes1 && index != nbytes2 ; index++)
+
+        if (bytes1 [index] != bytes2 [index])    ndifferent++ ;
+
+    return ndifferent ;
+}
+
+/******************************************************************************/
+
+// Prints the outputs of each slot and, every three slots, follows one of the
+// output files with TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST, in chunks of at
+// most FILE_CHUNK bytes, until there is nothing new. The bytes received must
+// be the ones of the file, and so must the ones received from half the file
+// on with TDICE_OUTPUT_FILES_FROM_OFFSET
+
+#define FILE_NAME  "server/node1.txt"
+#define FILE_CHUNK 100u
+
+static Error_t compare_files (Socket_t *client_socket, Quantity_t nflpel)
+{
+    NetworkMessage_t request ;
+    OutputInstant_t  instant = TDICE_OUTPUT_INSTANT_SLOT ;
+    char            *received = NULL, *tail = NULL, *expected = NULL ;
+    Quantity_t       slot = 0u, nreceived = 0u, ntail = 0u, nexpected = 0u ;
+    Quantity_t       length, ndifferent = 0u ;
+    uint64_t         offset ;
+
+    for (slot = 0u ; slot != NSLOTS ; slot++)
+    {
+        if (simulate_slot (client_socket, nflpel, slot, 0u) != TDICE_SUCCESS)
+
+            goto error ;
+
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_PRINT_OUTPUT) ;
+        insert_message_word  (&request, &instant) ;
+
+        if (exchange (client_socket, &request, NULL) != TDICE_SUCCESS)
+
+            goto error ;
+
+        if (slot % 3u != 2u)
+
+            continue ;
+
+        // Each chunk must start where the previous one ended
+
+        do
+        {
+            offset = 0u ;
+
+            if (receive_file (client_socket, TDICE_OUTPUT_FILES_SINCE_LAST_REQUEST,
+                              FILE_CHUNK, &offset, FILE_NAME,
+                              &received, &nreceived, &length) != TDICE_SUCCESS)
+
+                goto error ;
+
+            if (offset + length != nreceived || length > FILE_CHUNK)
+
+                ndifferent++ ;
+
+        } while (length != 0u) ;
+    }
+
+    expected = read_file (FILE_NAME, &nexpected) ;
+
+    if (expected == NULL || nexpected == 0u)
+    {
+        fprintf (stdout, "Cannot read %s\n", FILE_NAME) ;
+
+        goto error ;
+    }
+
+    ndifferent += different_bytes (expected, nexpected, received, nreceived) ;
+
+    offset = nexpected / 2u ;
+
+    if (receive_file (client_socket, TDICE_OUTPUT_FILES_FROM_OFFSET,
+                      0u, &offset, FILE_NAME,
+                      &tail, &ntail, &length) != TDICE_SUCCESS)
+
+        goto error ;
+
+    if (offset != nexpected / 2u)
+
+        ndifferent++ ;
+
+    ndifferent += different_bytes
+
+        (expected + nexpected / 2u, nexpected - nexpected / 2u, tail, ntail) ;
+
+    fprintf (stdout, "%d different bytes\n", ndifferent) ;
+
+    free (received) ;
+    free (tail) ;
+    free (expected) ;
+
+    return TDICE_SUCCESS ;
+
+error :
+
+    fprintf (stdout, "Request failed at slot %d\n", slot) ;
+
+    free (received) ;
+    free (tail) ;
+    free (expected) ;
+
+    return TDICE_FAILURE ;
+}
+
+/******************************************************************************/
+
+// Selects a model and receives the Error_t of the reply
+
+static Error_t select_model (Socket_t *client_socket, String_t stk_file)
+{
+    NetworkMessage_t request, reply ;
+    Error_t          result = TDICE_FAILURE ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_SELECT_MODEL) ;
+
+    if (insert_message_string (&request, stk_file) != TDICE_SUCCESS)
+    {
+        network_message_destroy (&request) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &result, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    return result ;
+}
+
+/******************************************************************************/
+
+// Selects models outside the directory of the stack file of the server, one
+// missing and one existing, and then a model inside it. Only the last one
+// must be accepted, and its build followed until it is ready
+
+#define NREJECTED 2u
+
+static Error_t check_select (Socket_t *client_socket)
+{
+    NetworkMessage_t request, reply ;
+    ModelPhase_t     phase = TDICE_MODEL_PARSING ;
+    Quantity_t       index, nwrong = 0u ;
+
+    String_t rejected [NREJECTED] = { "../x.stk", "server/../leakage/steady.stk" } ;
+
+    for (index = 0u ; index != NREJECTED ; index++)
+
+        if (select_model (client_socket, rejected [index]) == TDICE_SUCCESS)
+        {
+            fprintf (stdout, "%s accepted, ", rejected [index]) ;
+
+            nwrong++ ;
+        }
+
+    if (select_model (client_socket, "server/outputs.stk") != TDICE_SUCCESS)
+    {
+        fprintf (stdout, "server/outputs.stk rejected, ") ;
+
+        nwrong++ ;
+    }
+
+    for (index = 0u ; index != CONNECT_ATTEMPTS ; index++)
+    {
+        network_message_init (&request) ;
+        build_message_head   (&request, TDICE_SEND_MODEL_STATUS) ;
+
+        if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+            return TDICE_FAILURE ;
+
+        extract_message_word (&reply, &phase, 0) ;
+
+        network_message_destroy (&reply) ;
+
+        if (phase == TDICE_MODEL_READY || phase == TDICE_MODEL_FAILED)
+
+            break ;
+
+        usleep (CONNECT_DELAY) ;
+    }
+
+    if (phase != TDICE_MODEL_READY)
+    {
+        fprintf (stdout, "model not ready, ") ;
+
+        nwrong++ ;
+    }
+
+    fprintf (stdout, "%d wrong replies\n", nwrong) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+// Simulates a slot (of ten steps) and receives the statistics of the server:
+// the lines expected must be there, whole
+
+#define NLINES 5u
+
+static Error_t check_stats (Socket_t *client_socket, Quantity_t nflpel)
+{
+    NetworkMessage_t request, reply ;
+    Quantity_t       length = 0u, index, nmissing = 0u ;
+    char            *text, *line ;
+
+    String_t lines [NLINES] =
+    {
+        "tdice_request_duration_seconds_count{request=\"insert_powers\"} 1\n",
+        "tdice_request_duration_seconds_count{request=\"simulate_step\"} 10\n",
+        "tdice_request_failures_total{request=\"simulate_step\"} 0\n",
+        "tdice_sessions 1\n",
+        "tdice_models 1\n"
+    } ;
+
+    if (simulate_slot (client_socket, nflpel, 0u, 0u) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_GET_STATS) ;
+
+    if (exchange (client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        return TDICE_FAILURE ;
+
+    extract_message_word (&reply, &length, 0) ;
+
+    text = (char *) malloc (length + 1u) ;
+
+    // The text follows its length, padded to a whole number of words
+
+    if (text == NULL || 1u + WORDS (length) > *reply.Length - 2u)
+    {
+        network_message_destroy (&reply) ;
+
+        free (text) ;
+
+        return TDICE_FAILURE ;
+    }
+
+    memcpy (text, reply.Content + 1u, length) ;
+
+    text [length] = '\0' ;
+
+    network_message_destroy (&reply) ;
+
+    for (index = 0u ; index != NLINES ; index++)
+    {
+        line = strstr (text, lines [index]) ;
+
+        if (line == NULL || (line != text && line [-1] != '\n'))
+        {
+            fprintf (stdout, "no %.*s, ", (int) strlen (lines [index]) - 1, lines [index]) ;
+
+            nmissing++ ;
+        }
+    }
+
+    fprintf (stdout, "%d missing lines\n", nmissing) ;
+
+    free (text) ;
+
+    return TDICE_SUCCESS ;
+}
+
+/******************************************************************************/
+
+int main(int argc, char** argv)
+{
+    Socket_t         client_socket ;
+    NetworkMessage_t request, reply ;
+
+    Quantity_t nflpel, version, ncells = 0u ;
+    double    *expected, *state ;
+    float      time ;
+    Error_t    result ;
+
+    // Checks if there are the all the arguments
+    ////////////////////////////////////////////////////////////////////////////
+
+    if (argc != 4)
+    {
+        fprintf (stdout, "Usage: \"%s server_ip server_port delta|snapshot|speculation|compound|files|select|stats\"\n", argv[0]) ;
+
+        return EXIT_FAILURE ;
+    }
+
+    // Connects to the server, negotiates the version of the protocol and
+    // asks the number of floorplan elements. The model is selected before
+    // that, since the session then uses it
+    ////////////////////////////////////////////////////////////////////////////
+
+    socket_init (&client_socket) ;
+
+    if (connect_to_server (&client_socket, (String_t) argv[1], (PortNumber_t) atoi (argv[2])) != TDICE_SUCCESS)
+
+        return EXIT_FAILURE ;
+
+    if (negotiate_protocol (&client_socket, &version) != TDICE_SUCCESS)
+
+        goto socket_error ;
+
+    if (version != TDICE_PROTOCOL_VERSION)
+    {
+        fprintf (stdout, "Server using version %d of the protocol\n", version) ;
+
+        goto socket_error ;
+    }
+
+    if (strcmp (argv[3], "select") == 0)
+    {
+        result = check_select (&client_socket) ;
+
+        goto exit_simulation ;
+    }
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_TOTAL_NUMBER_OF_FLOORPLAN_ELEMENTS) ;
+
+    if (exchange (&client_socket, &request, &reply) != TDICE_SUCCESS)
+
+        goto socket_error ;
+
+    extract_message_word (&reply, &nflpel, 0) ;
+
+    network_message_destroy (&reply) ;
+
+    // The number of thermal cells, and the states of all the slots
+    ////////////////////////////////////////////////////////////////////////////
+
+    if (receive_state (&client_socket, TDICE_BULK_DOUBLE, NULL, &time, NULL, &ncells) != TDICE_SUCCESS)
+
+        goto socket_error ;
+
+    expected = (double *) malloc (sizeof (double) * ncells * NSLOTS) ;
+    state    = (double *) malloc (sizeof (double) * ncells) ;
+
+    if (expected == NULL || state == NULL)
+
+        result = TDICE_FAILURE ;
+
+    else if (strcmp (argv[3], "delta") == 0)
+
+        result = compare_delta (&client_socket, nflpel, ncells, expected, state) ;
+
+    else if (strcmp (argv[3], "snapshot") == 0)
+
+        result = compare_snapshot (&client_socket, nflpel, ncells, expected, state) ;
+
+    else if (strcmp (argv[3], "speculation") == 0)
+
+        result = compare_speculation (&client_socket, nflpel, ncells, expected, state) ;
+
+    else if (strcmp (argv[3], "compound") == 0)
+
+        result = compare_compound (&client_socket, nflpel) ;
+
+    else if (strcmp (argv[3], "files") == 0)
+
+        result = compare_files (&client_socket, nflpel) ;
+
+    else if (strcmp (argv[3], "stats") == 0)
+
+        result = check_stats (&client_socket, nflpel) ;
+
+    else
+    {
+        fprintf (stdout, "Unknown comparison %s\n", argv[3]) ;
+
+        result = TDICE_FAILURE ;
+    }
+
+    free (expected) ;
+    free (state) ;
+
+    // Closes the session
+    ////////////////////////////////////////////////////////////////////////////
+
+exit_simulation :
+
+    network_message_init (&request) ;
+    build_message_head   (&request, TDICE_EXIT_SIMULATION) ;
+
+    exchange (&client_socket, &request, NULL) ;
+
+    socket_close (&client_socket) ;
+
+    return result == TDICE_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE ;
+
+socket_error :
+
+    socket_close (&client_socket) ;
+
+    return EXIT_FAILURE ;
+}